@@ -35,6 +35,7 @@
 #define FI_TYPE__MMDD               FI_TYPE__MM FI_TYPE__DD
 #define FI_TYPE__HHMINSS            FI_TYPE__HH FI_TYPE__MIN FI_TYPE__SS
 #define FI_TYPE__MMDDYYHHMMSS       FI_TYPE__MM FI_TYPE__DD FI_TYPE__YY FI_TYPE__HH FI_TYPE__MIN FI_TYPE__SS
+#define FI_TYPE__MMDDHHMMSS         FI_TYPE__MM FI_TYPE__DD FI_TYPE__HH FI_TYPE__MIN FI_TYPE__SS
 
 #define FI_TYPE__LLVAR              FI_TYPE__LL FI_TYPE__VAR
 #define FI_TYPE__LLLVAR             FI_TYPE__LLL FI_TYPE__VAR
@@ -114,6 +115,27 @@ struct fi_field_info
 	unsigned char format[32];
 };
 
+// Maximum number of conformance rules (one per mti).
+#define FI_CONFORMANCE_RULES_MAX 64
+
+/**
+ * Conformance rule of one mti, fields as 128 bits masks with the bitmaps bits order:
+ * field 1 is the most significant bit of mask[0] and field 128 is the least significant bit of mask[1].
+ */
+struct fi_conformance_rule
+{
+	char mti[FI_MTI_LEN_BYTES + 1];
+	unsigned long long required[2];
+	unsigned long long forbidden[2];
+};
+
+/**
+ * Fields info and conformance rules (opaque). The current spec is replaced atomically by fi_init_field_info,
+ * fi_set_field_info and fi_set_conformance_rule: readers never lock, and a replaced spec is released when no reader
+ * holds it anymore (each thread keeps the last spec it used until its next lookup or its exit).
+ */
+struct fi_spec;
+
 /**
  * Initialize fields info.
  * @param[in] mode The operation mode of fields info, you should use the following defines:
@@ -157,6 +179,14 @@ int fi_is_valid_field(int field);
  */
 int fi_is_valid_field_value(int field, const char *data);
 
+/**
+ * @brief Validate field data length (data may have any byte, i.e. 'b' fields).
+ * @param[in] field The field number to be validated.
+ * @param[in] length The length of field data.
+ * @return Returns 1 if length is valid or 0 if invalid.
+ */
+int fi_is_valid_field_length(int field, int length);
+
 /**
  * @brief Validate if field has variable length.
  * @param[in] field The field number to be validated.
@@ -164,6 +194,42 @@ int fi_is_valid_field_value(int field, const char *data);
  */
 int fi_is_variable_field_length(int field);
 
+/**
+ * @brief Replace info of field (i.e. dialects), the current spec is copied, changed and published without pausing readers.
+ * @param[in] field The field number.
+ * @param[in] fi_field The field info.
+ * @return Returns 0 to success or -1 case error.
+ */
+int fi_set_field_info(int field, const struct fi_field_info *fi_field);
+
+/**
+ * @brief Acquire current spec, so one message can be processed with the same spec even if it is replaced meanwhile.
+ * @return Returns the current spec, it must be released with fi_spec_release.
+ */
+const struct fi_spec *fi_spec_acquire();
+
+/**
+ * @brief Release spec acquired by fi_spec_acquire.
+ * @param[in] spec The spec.
+ */
+void fi_spec_release(const struct fi_spec *spec);
+
+/**
+ * @brief Gets info from field of acquired spec.
+ * @param[in] spec The spec.
+ * @param[in] field The field number.
+ * @param[out] fi_field The struct fi_field_info when info will be stored.
+ * @return Returns 0 to success or -1 case error.
+ */
+int fi_spec_get_field_info(const struct fi_spec *spec, int field, struct fi_field_info *fi_field);
+
+/**
+ * @brief Gets generation of acquired spec (see fi_get_generation).
+ * @param[in] spec The spec.
+ * @return Returns the spec generation.
+ */
+unsigned int fi_spec_get_generation(const struct fi_spec *spec);
+
 /**
  * @brief Gets info from field.
  * @param[in] field The field number to be recovered.
@@ -186,4 +252,46 @@ int fi_get_field_length(int field);
  */
 int fi_get_size_length_of_variable_field(int field);
 
+/**
+ * @brief Gets size of length prefix of variable field info (number of digits of field max length, i.e. 3 for 999).
+ * @param[in] fi_field The field info.
+ * @return Returns the field size of length.
+ */
+int fi_field_size_of_length(const struct fi_field_info *fi_field);
+
+/**
+ * @brief Gets generation of fields info, it changes every time the spec is replaced (fi_init_field_info, fi_set_field_info, fi_set_conformance_rule).
+ * @return Returns the fields info generation.
+ */
+unsigned int fi_get_generation();
+
+/**
+ * @brief Set conformance rule of mti (replacing the current one), default rules of common messages are loaded by fi_init_field_info.
+ * @param[in] mti The mti.
+ * @param[in] required The mandatory fields.
+ * @param[in] required_count The number of mandatory fields.
+ * @param[in] forbidden The fields that must not be present.
+ * @param[in] forbidden_count The number of forbidden fields.
+ * @return Returns 0 to success or -1 case error (invalid mti or field, or too many rules).
+ */
+int fi_set_conformance_rule(const char *mti, const int *required, int required_count, const int *forbidden, int forbidden_count);
+
+/**
+ * @brief Gets conformance rule of mti.
+ * @param[in] mti The mti.
+ * @param[out] rule The conformance rule.
+ * @return Returns 0 to success or -1 case there is no rule for mti.
+ */
+int fi_get_conformance_rule(const char *mti, struct fi_conformance_rule *rule);
+
+/**
+ * @brief Check bitmaps against conformance rule of mti.
+ * @param[in] mti The mti.
+ * @param[in] bitmap The first and second bitmaps as 128 bits mask (see struct fi_conformance_rule).
+ * @param[out] missing The mandatory fields not present (128 bits mask).
+ * @param[out] unexpected The forbidden fields present (128 bits mask).
+ * @return Returns 0 case bitmaps conform, 1 case they do not conform or -1 case there is no rule for mti.
+ */
+int fi_check_conformance(const char *mti, const unsigned long long *bitmap, unsigned long long *missing, unsigned long long *unexpected);
+
 #endif
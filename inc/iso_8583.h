@@ -1,6 +1,39 @@
 #ifndef ISO8583_H_
 #define ISO8583_H_
 
+#include <time.h>
+#include <sys/uio.h>
+
+#include "fields_info.h"
+#include "iso_charset.h"
+#include "iso_mac.h"
+
+// Time zones of date/time fields:
+#define ISO_TIME_LOCAL  0 // Local time;
+#define ISO_TIME_UTC    1 // UTC (i.e. field 7, transmission date and time).
+
+// Frame of messages generated by iso_generate_batch:
+#define ISO_FRAME_NONE      0 // Messages back-to-back (i.e. fixed layouts);
+#define ISO_FRAME_BINARY_2  1 // 2 bytes length header (big endian), as ISO_CAPTURE_BINARY;
+#define ISO_FRAME_BINARY_4  2 // 4 bytes length header (big endian);
+#define ISO_FRAME_ASCII_4   3 // 4 decimal digits length header;
+#define ISO_FRAME_NEWLINE   4 // Message followed by '\n', as ISO_CAPTURE_ASCII.
+
+// Fields up to this length are copied to the scratch buffer by iso_generate_message_iov.
+#define ISO_IOV_INLINE_MAX  32
+
+// Saved message, its fields data are shared copy-on-write with the current message and other saved messages
+// (i.e. fan-out: decode once, save, then for each destination load, change some fields and generate).
+struct iso_message
+{
+	char mti[FI_MTI_LEN_BYTES + 1];
+	char first_bitmap[FI_BITMAP_LEN_BYTES];
+	char second_bitmap[FI_BITMAP_LEN_BYTES];
+	char *fields[FI_NUM_FIELD_MAX];
+	int field_lengths[FI_NUM_FIELD_MAX];
+	int fields_packed_size;
+};
+
 /**
  * @brief Generates hex string from binary data.
  * @param[in] bin The binary data to be converted.
@@ -25,7 +58,8 @@ void iso_hex_str_to_bin(const char *hex_str, unsigned int length, unsigned char
 int iso_init(int iso_version);
 
 /**
- * @brief Release all internal memory allocated by other functions.
+ * @brief Release all internal memory allocated by other functions. The current message is per thread
+ * (the spec, charset and auto padding are shared), so each thread that used it must call iso_release before it exits.
  */
 void iso_release();
 
@@ -41,6 +75,21 @@ void iso_enable_auto_padding();
  */
 void iso_disable_auto_padding();
 
+/**
+ * @brief Set the character set of packed messages, used by iso_generate_message and iso_decode_message.
+ * Mti, bitmaps, length prefixes and fields data are converted, except data of 'b' fields.
+ * The charset is per thread, as the current message (pipeline workers use the charset of the thread that created it).
+ * @param[in] charset ISO_CHARSET_ASCII (default) or ISO_CHARSET_EBCDIC.
+ * @return Returns 0 to success or -1 case charset is invalid.
+ */
+int iso_set_charset(int charset);
+
+/**
+ * @brief Gets the character set of packed messages of the calling thread.
+ * @return Returns ISO_CHARSET_ASCII or ISO_CHARSET_EBCDIC.
+ */
+int iso_get_charset();
+
 /**
  * @brief Set message mti.
  * @param[in] mti The message mti.
@@ -64,6 +113,15 @@ int iso_get_mti(char *mti);
  */
 int iso_add_field(int field, const char *data, int length);
 
+/**
+ * @brief Add field in iso message with explicit length, data can have any byte (i.e. 'b' fields), it is not padded.
+ * @param[in] field The field number.
+ * @param[in] data The field data.
+ * @param[in] length The field data length.
+ * @return Returns 0 if field was added or -1 case error.
+ */
+int iso_add_field_bytes(int field, const char *data, int length);
+
 /**
  * @brief Retrieve a value of field.
  * @param[in] field The field number.
@@ -72,6 +130,90 @@ int iso_add_field(int field, const char *data, int length);
  */
 int iso_get_field(int field, char *data);
 
+/**
+ * @brief Gets pointer to field data and its length, without copy. The data is valid until the field is changed,
+ * removed or released and it is null terminated (but it may have zero bytes, i.e. 'b' fields).
+ * @param[in] field The field number.
+ * @param[out] data The pointer to field data.
+ * @param[out] length The field data length.
+ * @return Returns 0 if field is set or -1 case error.
+ */
+int iso_get_field_view(int field, const char **data, int *length);
+
+/**
+ * @brief Set numeric ('n') field from integer, fixed length fields are zero padded and variable length fields have only the value digits.
+ * @param[in] field The field number (i.e. 3, 4, 11).
+ * @param[in] value The field value.
+ * @return Returns 0 if field was set or -1 case error (field is not numeric or value does not fit in the field length).
+ */
+int iso_set_field_u64(int field, unsigned long long value);
+
+/**
+ * @brief Gets numeric field as integer.
+ * @param[in] field The field number.
+ * @param[out] value The field value.
+ * @return Returns 0 to success or -1 case error (field is not set, has other character than digits or overflows).
+ */
+int iso_get_field_u64(int field, unsigned long long *value);
+
+/**
+ * @brief Set amount ('x+n') field, 'C' (credit) for positive amounts or 'D' (debit) for negative ones, followed by zero padded digits.
+ * @param[in] field The field number (i.e. 28 - 31).
+ * @param[in] amount The amount in minor units.
+ * @return Returns 0 if field was set or -1 case error (field is not an amount or amount does not fit in the field length).
+ */
+int iso_set_field_amount(int field, long long amount);
+
+/**
+ * @brief Gets amount ('x+n') field, negative for 'D' (debit).
+ * @param[in] field The field number.
+ * @param[out] amount The amount in minor units.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_get_field_amount(int field, long long *amount);
+
+/**
+ * @brief Set date/time field from broken-down time, according field format (i.e. field 7 "MMDDhhmmss", 12 "hhmmss", 13 "MMDD").
+ * @param[in] field The field number.
+ * @param[in] tm The broken-down time.
+ * @return Returns 0 if field was set or -1 case error (field has no date/time format or time has negative values, i.e. year before 1900).
+ */
+int iso_set_field_tm(int field, const struct tm *tm);
+
+/**
+ * @brief Set date/time field from time, according field format. The time is formatted by a per thread cache of the
+ * last second (one for each zone), so only changed digits are formatted and localtime/gmtime is called once per minute.
+ * @param[in] field The field number.
+ * @param[in] time The time.
+ * @param[in] zone ISO_TIME_LOCAL or ISO_TIME_UTC.
+ * @return Returns 0 if field was set or -1 case error (field has no date/time format).
+ */
+int iso_set_field_time(int field, time_t time, int zone);
+
+/**
+ * @brief Set date/time field from current time, see iso_set_field_time.
+ * @param[in] field The field number.
+ * @param[in] zone ISO_TIME_LOCAL or ISO_TIME_UTC.
+ * @return Returns 0 if field was set or -1 case error (field has no date/time format).
+ */
+int iso_set_field_now(int field, int zone);
+
+/**
+ * @brief Gets date/time field, only members of tm present in the field format are changed (years are 2000 - 2099).
+ * @param[in] field The field number.
+ * @param[out] tm The broken-down time.
+ * @return Returns 0 to success or -1 case error (field is not set, has no date/time format or has invalid value).
+ */
+int iso_get_field_tm(int field, struct tm *tm);
+
+/**
+ * @brief Check message fields against conformance rule of its mti (see fi_set_conformance_rule).
+ * @param[out] missing The mandatory fields not set, 128 bits mask with bitmaps bits order (field 1 is the most significant bit of missing[0]).
+ * @param[out] unexpected The forbidden fields set, 128 bits mask.
+ * @return Returns 0 case message conforms, 1 case it does not conform or -1 case there is no rule for message mti.
+ */
+int iso_check_conformance(unsigned long long *missing, unsigned long long *unexpected);
+
 /**
  * @brief Remove field from iso message.
  * @param[in] field The field number.
@@ -93,6 +235,45 @@ int iso_is_set_field(int field);
  */
 int iso_generate_message(char *message);
 
+/**
+ * @brief Gets the exact length of the message generated by iso_generate_message (without null terminator),
+ * it is updated when fields are added or removed, so it is not computed from fields data.
+ * @return Returns the packed message length.
+ */
+int iso_packed_size();
+
+/**
+ * @brief Generate iso message into buffer with capacity, without null terminator (i.e. to pack many messages in one buffer).
+ * @param[out] message The buffer where the message will be stored.
+ * @param[in] capacity The buffer capacity.
+ * @return Returns the message length or -1 case error (i.e. message length exceeds capacity, nothing is written).
+ */
+int iso_generate_message_bounded(char *message, int capacity);
+
+/**
+ * @brief Generate iso message with MAC into buffer with capacity, without null terminator. The MAC field (64, or 128 case
+ * there is a second bitmap) is set with the MAC computed while the message is packed, so it is in the current message too.
+ * @param[out] message The buffer where the message will be stored.
+ * @param[in] capacity The buffer capacity.
+ * @param[in] mac The MAC initialized by iso_mac_init (its state is changed, so threads need their own copy).
+ * @return Returns the message length or -1 case error (i.e. MAC field length does not fit the MAC or message length exceeds capacity),
+ * on error the current message is unchanged or, case packing failed, it is without the MAC field.
+ */
+int iso_generate_message_mac(char *message, int capacity, struct iso_mac *mac);
+
+/**
+ * @brief Generate iso message as iovec array, to be sent with writev or sendmsg without copying fields data.
+ * Mti, bitmaps, length prefixes and small fields (up to ISO_IOV_INLINE_MAX bytes) are copied to the scratch buffer,
+ * other fields data are referenced in place (they are copied case they need charset conversion), so the iovec
+ * array is valid until fields are changed, removed or released. The message is not null terminated.
+ * @param[out] iov The iovec array.
+ * @param[in] iov_count The iovec array length.
+ * @param[out] scratch The buffer to store the copied data.
+ * @param[in] scratch_length The scratch buffer length, iso_packed_size() bytes is always enough (copied data is part of the message).
+ * @return Returns the number of used iovec or -1 case error (i.e. iovec array or scratch buffer are too small).
+ */
+int iso_generate_message_iov(struct iovec *iov, int iov_count, char *scratch, int scratch_length);
+
 /**
  * @brief Decode iso message and fill internal fields.
  * @param[in] message The message to be decoded.
@@ -100,4 +281,63 @@ int iso_generate_message(char *message);
  */
 int iso_decode_message(const char *message);
 
+/**
+ * @brief Decode iso message with explicit length (message can have zero bytes in 'b' fields) and fill internal fields.
+ * @param[in] message The message to be decoded.
+ * @param[in] length The message length.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_decode_message_bytes(const char *message, int length);
+
+/**
+ * @brief Decode iso message with explicit length and verify its MAC (field 64, or 128 case there is a second bitmap),
+ * the MAC is computed while the message is decoded. Hex MAC fields are compared with uppercase digits.
+ * @param[in] message The message to be decoded.
+ * @param[in] length The message length.
+ * @param[in] mac The MAC initialized by iso_mac_init (its state is changed, so threads need their own copy).
+ * @return Returns 0 case MAC is valid, 1 case MAC field is missing or invalid (the message is decoded) or -1 case error.
+ */
+int iso_decode_message_mac(const char *message, int length, struct iso_mac *mac);
+
+/**
+ * @brief Save current message, fields data are not copied (they are shared until changed).
+ * @param[out] message The saved message, it must be released with iso_message_release.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_message_save(struct iso_message *message);
+
+/**
+ * @brief Replace current message by saved message, fields data are not copied, only changed fields are allocated.
+ * @param[in] message The saved message (it is not changed, so it can be loaded many times).
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_message_load(const struct iso_message *message);
+
+/**
+ * @brief Clone saved message, fields data are shared.
+ * @param[in] source The saved message.
+ * @param[out] clone The cloned message, it must be released with iso_message_release.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_message_clone(const struct iso_message *source, struct iso_message *clone);
+
+/**
+ * @brief Release saved message, fields data are released by their last reference.
+ * @param[in] message The saved message.
+ */
+void iso_message_release(struct iso_message *message);
+
+/**
+ * @brief Generate saved messages back-to-back into one buffer, each one with frame header (i.e. to send many messages at once).
+ * Messages are packed directly from their fields, the current message is not changed.
+ * @param[in] messages The saved messages (see iso_message_save).
+ * @param[in] count The number of messages.
+ * @param[in] frame The frame (ISO_FRAME_*).
+ * @param[out] buffer The buffer where the messages will be stored (not null terminated).
+ * @param[in] capacity The buffer capacity.
+ * @param[out] offsets Optional vector with count positions to store the offset of each frame in the buffer.
+ * @return Returns the length of generated messages or -1 case error (i.e. invalid message or buffer is too small).
+ */
+int iso_generate_batch(const struct iso_message *messages, int count, int frame, char *buffer, int capacity, int *offsets);
+
 #endif
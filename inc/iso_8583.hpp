@@ -0,0 +1,812 @@
+#ifndef ISO8583_HPP_
+#define ISO8583_HPP_
+
+// Header-only C++17 layer of the iso 8583 codec: field specs are constexpr tables (copy of fields_info.c), fields are
+// addressed by compile-time numbers (iso::field<4>) with typed values and encode/decode are specialized per field,
+// so there are no runtime spec lookups. Messages are wire compatible with iso_generate_message (ASCII charset).
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace iso
+{
+
+enum class version
+{
+	iso1987,
+	iso1993
+};
+
+// Field data types (see FI_TYPE__* in fields_info.h).
+enum class data_type : unsigned char
+{
+	a, n, p, s, an, as, ns, anp, ans, b, z, xn
+};
+
+struct field_spec
+{
+	data_type type;
+	bool variable;
+	int length;         // Fixed length or maximum length of variable fields.
+	int size_of_length; // Length prefix digits of variable fields (LL or LLL).
+};
+
+constexpr int mti_length = 4;
+constexpr int bitmap_bits = 64;
+constexpr int bitmap_hex_length = 16;
+constexpr int max_field = 128;
+
+template<version V>
+struct spec;
+
+template<>
+struct spec<version::iso1987>
+{
+	static constexpr std::array<field_spec, max_field> fields =
+	{{
+		{data_type::b,   false,  64, 0}, //   1: secondary bitmap
+		{data_type::n,   true,   19, 2}, //   2: primary account number
+		{data_type::n,   false,   6, 0}, //   3: processing code
+		{data_type::n,   false,  12, 0}, //   4: amount, transaction
+		{data_type::n,   false,  12, 0}, //   5: amount, reconciliation
+		{data_type::n,   false,  12, 0}, //   6: amount, cardholder biling
+		{data_type::n,   false,  10, 0}, //   7: date and time, transmission
+		{data_type::n,   false,   8, 0}, //   8: amount, cardholder biling fee
+		{data_type::n,   false,   8, 0}, //   9: conversion rate, settlement
+		{data_type::n,   false,   8, 0}, //  10: conversion rate, cardholder biling
+		{data_type::n,   false,   6, 0}, //  11: system trace audit number
+		{data_type::n,   false,   6, 0}, //  12: date and time, local transaction
+		{data_type::n,   false,   4, 0}, //  13: date, local transaction
+		{data_type::n,   false,   4, 0}, //  14: date, expiration
+		{data_type::n,   false,   4, 0}, //  15: date, settlement
+		{data_type::n,   false,   4, 0}, //  16: date, conversion
+		{data_type::n,   false,   4, 0}, //  17: date, capture
+		{data_type::n,   false,   4, 0}, //  18: merchant type
+		{data_type::n,   false,   3, 0}, //  19: country code, acquiring institution
+		{data_type::n,   false,   3, 0}, //  20: country code, primary account number
+		{data_type::n,   false,   3, 0}, //  21: country code, forwarding institution
+		{data_type::an,  false,   3, 0}, //  22: point of service data code
+		{data_type::n,   false,   3, 0}, //  23: card sequence number
+		{data_type::n,   false,   3, 0}, //  24: function code
+		{data_type::n,   false,   2, 0}, //  25: point of sale condition code
+		{data_type::n,   false,   2, 0}, //  26: point of sale capture code
+		{data_type::n,   false,   1, 0}, //  27: authorization identification response length
+		{data_type::xn,  false,   8, 0}, //  28: amount, transaction fee
+		{data_type::xn,  false,   8, 0}, //  29: amount, settlement fee
+		{data_type::xn,  false,   8, 0}, //  30: amount, transaction processing fee
+		{data_type::xn,  false,   8, 0}, //  31: amount, settlement processing fee
+		{data_type::n,   true,   11, 2}, //  32: acquirer institution identification code
+		{data_type::n,   true,   11, 2}, //  33: fowarding institution identification code
+		{data_type::ns,  true,   28, 2}, //  34: primary account number, extended
+		{data_type::z,   true,   37, 2}, //  35: track 2 data
+		{data_type::n,   true,  104, 3}, //  36: track 3 data
+		{data_type::an,  false,  12, 0}, //  37: retrieval reference number
+		{data_type::an,  false,   6, 0}, //  38: authorization identificarion response
+		{data_type::an,  false,   2, 0}, //  39: response code
+		{data_type::an,  false,   3, 0}, //  40: service restriction code
+		{data_type::ans, false,   8, 0}, //  41: card acceptor terminal idetification
+		{data_type::ans, false,  15, 0}, //  42: card acceptor identification code
+		{data_type::ans, false,  40, 0}, //  43: card acceptor name/location
+		{data_type::an,  true,   25, 2}, //  44: aditional response data
+		{data_type::an,  true,   76, 2}, //  45: track 1 data
+		{data_type::an,  true,  999, 3}, //  46: addicional data (iso)
+		{data_type::an,  true,  999, 3}, //  47: additional data, national
+		{data_type::an,  true,  999, 3}, //  48: additional data, private
+		{data_type::an,  false,   3, 0}, //  49: currency code, transaction
+		{data_type::an,  false,   3, 0}, //  50: currency code, settlement
+		{data_type::an,  false,   3, 0}, //  51: currency code, cardholder biling
+		{data_type::b,   false,   8, 0}, //  52: personal identification number (PIN) data
+		{data_type::n,   false,  16, 0}, //  53: security related control information
+		{data_type::an,  true,  120, 3}, //  54: amounts, additional
+		{data_type::ans, true,  999, 3}, //  55: integrated circuit card system related data
+		{data_type::ans, true,  999, 3}, //  56: reserved (iso)
+		{data_type::ans, true,  999, 3}, //  57: reserved for national use
+		{data_type::ans, true,  999, 3}, //  58: reserved for national use
+		{data_type::ans, true,  999, 3}, //  59: reserved for national use
+		{data_type::ans, true,  999, 3}, //  60: reserved for national use
+		{data_type::ans, true,  999, 3}, //  61: reserved for private use
+		{data_type::ans, true,  999, 3}, //  62: reserved for private use
+		{data_type::ans, true,  999, 3}, //  63: reserved for private use
+		{data_type::b,   false,  16, 0}, //  64: message authentication code (mac)
+		{data_type::b,   false,   1, 0}, //  65: extended bitmap indicator
+		{data_type::n,   false,   1, 0}, //  66: settlement code
+		{data_type::n,   false,   2, 0}, //  67: extended payment code
+		{data_type::n,   false,   3, 0}, //  68: country code, receiving institution
+		{data_type::n,   false,   3, 0}, //  69: country code, settlement institution
+		{data_type::n,   false,   3, 0}, //  70: network management institution code
+		{data_type::n,   false,   4, 0}, //  71: message number
+		{data_type::n,   false,   4, 0}, //  72: last message number
+		{data_type::n,   false,   6, 0}, //  73: date, action
+		{data_type::n,   false,  10, 0}, //  74: credits, number
+		{data_type::n,   false,  10, 0}, //  75: credits, reversal number
+		{data_type::n,   false,  10, 0}, //  76: debits, number
+		{data_type::n,   false,  10, 0}, //  77: debits, reversal number
+		{data_type::n,   false,  10, 0}, //  78: transfer number
+		{data_type::n,   false,  10, 0}, //  79: transfer, reversal number
+		{data_type::n,   false,  10, 0}, //  80: inquiries, number
+		{data_type::n,   false,  10, 0}, //  81: authorizations, number
+		{data_type::n,   false,  12, 0}, //  82: credits, processing fee amount
+		{data_type::n,   false,  12, 0}, //  83: credits, transaction fee amount
+		{data_type::n,   false,  12, 0}, //  84: debits, processing fee amount
+		{data_type::n,   false,  12, 0}, //  85: debits, transaction fee amount
+		{data_type::n,   false,  16, 0}, //  86: credits, total amount
+		{data_type::n,   false,  16, 0}, //  87: credits, reversal amount
+		{data_type::n,   false,  16, 0}, //  88: debits, total amount
+		{data_type::n,   false,  16, 0}, //  89: debits, reversal amount
+		{data_type::n,   false,  42, 0}, //  90: original data elements
+		{data_type::an,  false,   1, 0}, //  91: file update code
+		{data_type::an,  false,   2, 0}, //  92: file securiry code
+		{data_type::an,  false,   5, 0}, //  93: response indicator
+		{data_type::an,  false,   7, 0}, //  94: service indicator
+		{data_type::an,  false,  42, 0}, //  95: replacement amounts
+		{data_type::b,   false,  64, 0}, //  96: message securiry code
+		{data_type::xn,  false,  16, 0}, //  97: amount, net settlement
+		{data_type::ans, false,  25, 0}, //  98: payee
+		{data_type::n,   true,   11, 2}, //  99: settlement institution identification code
+		{data_type::n,   true,   11, 2}, // 100: receiving institution identification code
+		{data_type::ans, true,   17, 2}, // 101: file name
+		{data_type::ans, true,   28, 2}, // 102: account identification 1
+		{data_type::ans, true,   28, 2}, // 103: account identification 2
+		{data_type::ans, true,  100, 3}, // 104: transaction description
+		{data_type::ans, true,  999, 3}, // 105: reversed for ISO use
+		{data_type::ans, true,  999, 3}, // 106: reversed for ISO use
+		{data_type::ans, true,  999, 3}, // 107: reversed for ISO use
+		{data_type::ans, true,  999, 3}, // 108: reversed for ISO use
+		{data_type::ans, true,  999, 3}, // 109: reversed for ISO use
+		{data_type::ans, true,  999, 3}, // 110: reversed for ISO use
+		{data_type::ans, true,  999, 3}, // 111: reversed for ISO use
+		{data_type::ans, true,  999, 3}, // 112: reversed for national use
+		{data_type::ans, true,  999, 3}, // 113: reversed for national use
+		{data_type::ans, true,  999, 3}, // 114: reversed for national use
+		{data_type::ans, true,  999, 3}, // 115: reversed for national use
+		{data_type::ans, true,  999, 3}, // 116: reversed for national use
+		{data_type::ans, true,  999, 3}, // 117: reversed for national use
+		{data_type::ans, true,  999, 3}, // 118: reversed for national use
+		{data_type::ans, true,  999, 3}, // 119: reversed for national use
+		{data_type::ans, true,  999, 3}, // 120: reversed for private use
+		{data_type::ans, true,  999, 3}, // 121: reversed for private use
+		{data_type::ans, true,  999, 3}, // 122: reversed for private use
+		{data_type::ans, true,  999, 3}, // 123: reversed for private use
+		{data_type::ans, true,  999, 3}, // 124: reversed for private use
+		{data_type::ans, true,  999, 3}, // 125: reversed for private use
+		{data_type::ans, true,  999, 3}, // 126: reversed for private use
+		{data_type::ans, true,  999, 3}, // 127: reversed for private use
+		{data_type::b,   false,  64, 0}, // 128: message authentication code
+	}};
+};
+
+template<>
+struct spec<version::iso1993>
+{
+	static constexpr std::array<field_spec, max_field> fields =
+	{{
+		{data_type::b,   false,   8, 0}, //   1: secondary bitmap (optional)
+		{data_type::n,   true,   19, 2}, //   2: primary account number
+		{data_type::n,   false,   6, 0}, //   3: processing code
+		{data_type::n,   false,  12, 0}, //   4: amount, transaction
+		{data_type::n,   false,  12, 0}, //   5: amount, reconciliation
+		{data_type::n,   false,  12, 0}, //   6: amount, cardholder biling
+		{data_type::n,   false,  10, 0}, //   7: date and time, transmission
+		{data_type::n,   false,   8, 0}, //   8: amount, cardholder biling fee
+		{data_type::n,   false,   8, 0}, //   9: conversion rate, reconciliation
+		{data_type::n,   false,   8, 0}, //  10: conversion rate, cardholder biling
+		{data_type::n,   false,   6, 0}, //  11: system trace audit number
+		{data_type::n,   false,  12, 0}, //  12: date and time, local transaction
+		{data_type::n,   false,   4, 0}, //  13: date, effective
+		{data_type::n,   false,   4, 0}, //  14: date, expiration
+		{data_type::n,   false,   6, 0}, //  15: date, settlement
+		{data_type::n,   false,   4, 0}, //  16: date, conversion
+		{data_type::n,   false,   4, 0}, //  17: date, capture
+		{data_type::n,   false,   4, 0}, //  18: merchant type
+		{data_type::n,   false,   3, 0}, //  19: country code, acquiring institution
+		{data_type::n,   false,   3, 0}, //  20: country code, primary account number
+		{data_type::n,   false,   3, 0}, //  21: country code, forwarding institution
+		{data_type::an,  false,  12, 0}, //  22: point of service data code
+		{data_type::n,   false,   3, 0}, //  23: card sequence number
+		{data_type::n,   false,   3, 0}, //  24: function code
+		{data_type::n,   false,   4, 0}, //  25: message reason code
+		{data_type::n,   false,   4, 0}, //  26: card receptor business code
+		{data_type::n,   false,   1, 0}, //  27: approval code length
+		{data_type::n,   false,   6, 0}, //  28: date, reconciliation
+		{data_type::n,   false,   3, 0}, //  29: reconciliation indicator
+		{data_type::n,   false,  24, 0}, //  30: amount original
+		{data_type::ans, true,   99, 2}, //  31: acquirer reference data
+		{data_type::n,   true,   11, 2}, //  32: acquirer institution identification code
+		{data_type::n,   true,   11, 2}, //  33: fowarding institution identification code
+		{data_type::ns,  true,   28, 2}, //  34: primary account number, extended
+		{data_type::z,   false,  37, 0}, //  35: track 2 data
+		{data_type::z,   false, 104, 0}, //  36: track 3 data
+		{data_type::anp, false,  12, 0}, //  37: retrieval reference number
+		{data_type::anp, false,   6, 0}, //  38: approval code
+		{data_type::n,   false,   3, 0}, //  39: action code
+		{data_type::n,   false,   3, 0}, //  40: service code
+		{data_type::ans, false,   8, 0}, //  41: card acceptor terminal idetification
+		{data_type::ans, false,  15, 0}, //  42: card acceptor identification code
+		{data_type::ans, true,   99, 2}, //  43: card acceptor name/location
+		{data_type::ans, true,   99, 2}, //  44: aditional response data
+		{data_type::ans, true,   76, 2}, //  45: track 1 data
+		{data_type::ans, true,  204, 3}, //  46: amounts, fees
+		{data_type::ans, true,  999, 3}, //  47: additional data, national
+		{data_type::ans, true,  999, 3}, //  48: additional data, private
+		{data_type::an,  false,   3, 0}, //  49: currency code, transaction
+		{data_type::an,  false,   3, 0}, //  50: currency code, reconciliation
+		{data_type::an,  false,   3, 0}, //  51: currency code, cardholder biling
+		{data_type::b,   false,   8, 0}, //  52: personal identification number (PIN) data
+		{data_type::b,   true,   48, 2}, //  53: security related control information
+		{data_type::ans, true,  120, 3}, //  54: amounts, additional
+		{data_type::b,   true,  255, 3}, //  55: integrated circuit card system related data
+		{data_type::n,   true,   35, 2}, //  56: original data elements
+		{data_type::n,   false,   3, 0}, //  57: authorization life cycle code
+		{data_type::n,   true,   11, 2}, //  58: authorizing agent institution identification code
+		{data_type::ans, true,  999, 3}, //  59: transport data
+		{data_type::ans, true,  999, 3}, //  60: reserved for national use
+		{data_type::ans, true,  999, 3}, //  61: reserved for national use
+		{data_type::ans, true,  999, 3}, //  62: reserved for national use
+		{data_type::ans, true,  999, 3}, //  63: reserved for national use
+		{data_type::b,   false,   8, 0}, //  64: message authentication code field
+		{data_type::b,   false,   8, 0}, //  65: reserved for ISO use
+		{data_type::ans, true,  204, 3}, //  66: amounts, origial fees
+		{data_type::n,   false,   2, 0}, //  67: extended payment data
+		{data_type::n,   false,   3, 0}, //  68: country code, receiving institution
+		{data_type::n,   false,   3, 0}, //  69: country code, settlement institution
+		{data_type::n,   false,   3, 0}, //  70: country code, authorizing agent institution
+		{data_type::n,   false,   8, 0}, //  71: message number
+		{data_type::ans, true,  999, 3}, //  72: data record
+		{data_type::n,   false,   6, 0}, //  73: date, action
+		{data_type::n,   false,  10, 0}, //  74: credits, number
+		{data_type::n,   false,  10, 0}, //  75: credits, reversal number
+		{data_type::n,   false,  10, 0}, //  76: debits, number
+		{data_type::n,   false,  10, 0}, //  77: debits, reversal number
+		{data_type::n,   false,  10, 0}, //  78: transfer number
+		{data_type::n,   false,  10, 0}, //  79: transfer, reversal number
+		{data_type::n,   false,  10, 0}, //  80: inquiries, number
+		{data_type::n,   false,  10, 0}, //  81: authorizations, number
+		{data_type::n,   false,  10, 0}, //  82: inquiries, reversal number
+		{data_type::n,   false,  10, 0}, //  83: payments, number
+		{data_type::n,   false,  10, 0}, //  84: payments, reversal number
+		{data_type::n,   false,  10, 0}, //  85: fee collections, number
+		{data_type::n,   false,  16, 0}, //  86: credits, amount
+		{data_type::n,   false,  16, 0}, //  87: credits, reversal amount
+		{data_type::n,   false,  16, 0}, //  88: debits, amount
+		{data_type::n,   false,  16, 0}, //  89: debits, reversal amount
+		{data_type::n,   false,  10, 0}, //  90: authorizations, reversal number
+		{data_type::n,   false,   3, 0}, //  91: country code, transaction destination institution
+		{data_type::n,   false,   3, 0}, //  92: country code, transaction originator institution
+		{data_type::n,   true,   11, 2}, //  93: transaction destination institution identification code
+		{data_type::n,   true,   11, 2}, //  94: transaction originator institution identification code
+		{data_type::ans, true,   99, 2}, //  95: card issuer reference data
+		{data_type::b,   true,  999, 3}, //  96: key management data
+		{data_type::xn,  false,  16, 0}, //  97: amount, net reconciliation
+		{data_type::ans, false,  25, 0}, //  98: payee
+		{data_type::an,  true,   11, 2}, //  99: settlement institution identification code
+		{data_type::n,   true,   11, 2}, // 100: receiving institution identification code
+		{data_type::ans, true,   17, 2}, // 101: file name
+		{data_type::ans, true,   28, 2}, // 102: account identification 1
+		{data_type::ans, true,   28, 2}, // 103: account identification 2
+		{data_type::ans, true,  100, 3}, // 104: transaction description
+		{data_type::n,   false,  16, 0}, // 105: credits, chargeback amount
+		{data_type::n,   false,  16, 0}, // 106: debits, chargeback amount
+		{data_type::n,   false,  10, 0}, // 107: credits, chargeback number
+		{data_type::n,   false,  10, 0}, // 108: debits, chargeback number
+		{data_type::ans, true,   84, 2}, // 109: credits, fee amounts
+		{data_type::ans, true,   84, 2}, // 110: debits, fee amounts
+		{data_type::ans, true,  999, 3}, // 111: reversed for ISO use
+		{data_type::ans, true,  999, 3}, // 112: reversed for ISO use
+		{data_type::ans, true,  999, 3}, // 113: reversed for ISO use
+		{data_type::ans, true,  999, 3}, // 114: reversed for ISO use
+		{data_type::ans, true,  999, 3}, // 115: reversed for ISO use
+		{data_type::ans, true,  999, 3}, // 116: reversed for national use
+		{data_type::ans, true,  999, 3}, // 117: reversed for national use
+		{data_type::ans, true,  999, 3}, // 118: reversed for national use
+		{data_type::ans, true,  999, 3}, // 119: reversed for national use
+		{data_type::ans, true,  999, 3}, // 120: reversed for national use
+		{data_type::ans, true,  999, 3}, // 121: reversed for national use
+		{data_type::ans, true,  999, 3}, // 122: reversed for national use
+		{data_type::ans, true,  999, 3}, // 123: reversed for private use
+		{data_type::ans, true,  999, 3}, // 124: reversed for private use
+		{data_type::ans, true,  999, 3}, // 125: reversed for private use
+		{data_type::ans, true,  999, 3}, // 126: reversed for private use
+		{data_type::ans, true,  999, 3}, // 127: reversed for private use
+		{data_type::b,   false,   8, 0}, // 128: message authentication code field
+	}};
+};
+
+// Binary ('b') field data.
+struct bytes
+{
+	const unsigned char *data;
+	std::size_t size;
+};
+
+// Fixed fields shorter than their length are padded like iso_enable_auto_padding: left with '0' or right with ' '.
+constexpr bool pads_left(data_type type)
+{
+	return type == data_type::n || type == data_type::an || type == data_type::ns || type == data_type::anp || type == data_type::ans;
+}
+
+template<int N, version V = version::iso1987>
+struct field
+{
+	static_assert(N >= 2 && N <= max_field, "invalid field number (field 1 is the second bitmap)");
+
+	static constexpr int number = N;
+	static constexpr field_spec info = spec<V>::fields[N - 1];
+
+	// Fixed numeric fields up to 19 digits are integers, 'b' fields are bytes and other ones are strings.
+	static constexpr bool is_integer = info.type == data_type::n && !info.variable && info.length <= 19;
+	static constexpr bool is_bytes = info.type == data_type::b;
+
+	using value_type = std::conditional_t<is_integer, std::uint64_t, std::conditional_t<is_bytes, bytes, std::string_view>>;
+};
+
+template<version V = version::iso1987>
+class message
+{
+public:
+	bool set_mti(std::string_view mti)
+	{
+		if(mti.size() != mti_length || !all_digits(mti.data(), mti.size()))
+		{
+			return false;
+		}
+
+		mti_.assign(mti);
+
+		return true;
+	}
+
+	std::string_view mti() const
+	{
+		return mti_;
+	}
+
+	// Set field from string literal, value length is checked at compile time.
+	template<int N, std::size_t S>
+	void set(const char (&value)[S])
+	{
+		using F = field<N, V>;
+
+		static_assert(S - 1 <= static_cast<std::size_t>(F::info.length), "value exceeds field length");
+
+		store<N>(value, S - 1);
+	}
+
+	// Set field from string, returns false case value exceeds field length.
+	template<int N>
+	bool set(std::string_view value)
+	{
+		using F = field<N, V>;
+
+		if(value.size() > static_cast<std::size_t>(F::info.length))
+		{
+			return false;
+		}
+
+		store<N>(value.data(), value.size());
+
+		return true;
+	}
+
+	// Set numeric field from integer, fixed fields are zero padded. Returns false case value exceeds field length.
+	template<int N>
+	bool set(std::uint64_t value)
+	{
+		using F = field<N, V>;
+
+		static_assert(F::is_integer, "field is not an integer field");
+
+		char digits[F::info.length];
+		int i = F::info.length;
+
+		while(i > 0)
+		{
+			digits[--i] = static_cast<char>('0' + (value % 10));
+			value /= 10;
+		}
+
+		if(value != 0)
+		{
+			return false;
+		}
+
+		store<N>(digits, F::info.length);
+
+		return true;
+	}
+
+	// Set binary field, returns false case value exceeds field length.
+	template<int N>
+	bool set(bytes value)
+	{
+		using F = field<N, V>;
+
+		static_assert(F::is_bytes, "field is not a binary field");
+
+		if(value.size > static_cast<std::size_t>(F::info.length))
+		{
+			return false;
+		}
+
+		store<N>(reinterpret_cast<const char *>(value.data), value.size);
+
+		return true;
+	}
+
+	// Gets field value, std::nullopt case field is not set (or integer field has other character than digits).
+	template<int N>
+	std::optional<typename field<N, V>::value_type> get() const
+	{
+		using F = field<N, V>;
+
+		const std::string &data = fields_[N - 1];
+
+		if(!present_[N - 1])
+		{
+			return std::nullopt;
+		}
+
+		if constexpr(F::is_integer)
+		{
+			std::uint64_t value = 0;
+
+			if(!all_digits(data.data(), data.size()))
+			{
+				return std::nullopt;
+			}
+
+			for(char digit : data)
+			{
+				value = (value * 10) + static_cast<std::uint64_t>(digit - '0');
+			}
+
+			return value;
+		}
+		else if constexpr(F::is_bytes)
+		{
+			return bytes{reinterpret_cast<const unsigned char *>(data.data()), data.size()};
+		}
+		else
+		{
+			return std::string_view(data);
+		}
+	}
+
+	template<int N>
+	bool has() const
+	{
+		static_assert(N >= 2 && N <= max_field, "invalid field number");
+
+		return present_[N - 1];
+	}
+
+	template<int N>
+	void remove()
+	{
+		static_assert(N >= 2 && N <= max_field, "invalid field number");
+
+		present_[N - 1] = false;
+		fields_[N - 1].clear();
+	}
+
+	void clear()
+	{
+		mti_.clear();
+		present_.reset();
+
+		for(std::string &data : fields_)
+		{
+			data.clear();
+		}
+	}
+
+	// Encode message into buffer (without null terminator), returns the message length or 0 case error.
+	std::size_t encode(char *buffer, std::size_t capacity) const
+	{
+		char *position = buffer;
+		char *end = buffer + capacity;
+		bool second_bitmap = has_second_bitmap();
+
+		if(mti_.size() != mti_length || capacity < mti_length + (bitmap_hex_length * (second_bitmap ? 2 : 1)))
+		{
+			return 0;
+		}
+
+		std::memcpy(position, mti_.data(), mti_length);
+		position += mti_length;
+
+		write_bitmap(position, 0, second_bitmap);
+		position += bitmap_hex_length;
+
+		if(second_bitmap)
+		{
+			write_bitmap(position, bitmap_bits, false);
+			position += bitmap_hex_length;
+		}
+
+		if(!encode_fields(position, end, std::make_index_sequence<max_field - 1>()))
+		{
+			return 0;
+		}
+
+		return static_cast<std::size_t>(position - buffer);
+	}
+
+	std::string encode() const
+	{
+		std::string buffer(packed_size(), '\0');
+
+		buffer.resize(encode(buffer.data(), buffer.size()));
+
+		return buffer;
+	}
+
+	// Decode message, returns false case message is invalid (message is cleared).
+	bool decode(const char *buffer, std::size_t length)
+	{
+		const char *position = buffer;
+		const char *end = buffer + length;
+		std::bitset<max_field> bitmap;
+
+		clear();
+
+		if(length < mti_length + bitmap_hex_length || !all_digits(buffer, mti_length) || !read_bitmap(buffer + mti_length, bitmap, 0))
+		{
+			return false;
+		}
+
+		position += mti_length + bitmap_hex_length;
+
+		if(bitmap[0] && (end - position < bitmap_hex_length || !read_bitmap(position, bitmap, bitmap_bits)))
+		{
+			return false;
+		}
+
+		position += bitmap[0] ? bitmap_hex_length : 0;
+
+		if(!decode_fields(position, end, bitmap, std::make_index_sequence<max_field - 1>()) || position != end)
+		{
+			clear();
+			return false;
+		}
+
+		mti_.assign(buffer, mti_length);
+
+		return true;
+	}
+
+	bool decode(std::string_view buffer)
+	{
+		return decode(buffer.data(), buffer.size());
+	}
+
+	// Gets the encoded message length.
+	std::size_t packed_size() const
+	{
+		std::size_t size = mti_length + (bitmap_hex_length * (has_second_bitmap() ? 2 : 1));
+		int i = 0;
+
+		for(i = 1; i < max_field; i++)
+		{
+			if(present_[i])
+			{
+				size += spec<V>::fields[i].size_of_length + fields_[i].size();
+			}
+		}
+
+		return size;
+	}
+
+private:
+	static bool all_digits(const char *data, std::size_t length)
+	{
+		std::size_t i = 0;
+
+		for(i = 0; i < length; i++)
+		{
+			if(static_cast<unsigned int>(data[i] - '0') > 9)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static int hex_value(char hex)
+	{
+		if(hex >= '0' && hex <= '9') { return hex - '0'; }
+		if(hex >= 'A' && hex <= 'F') { return hex - 'A' + 10; }
+		if(hex >= 'a' && hex <= 'f') { return hex - 'a' + 10; }
+
+		return -1;
+	}
+
+	template<int N>
+	void store(const char *data, std::size_t length)
+	{
+		using F = field<N, V>;
+
+		std::string &value = fields_[N - 1];
+
+		if constexpr(!F::info.variable)
+		{
+			std::size_t padding = static_cast<std::size_t>(F::info.length) - length;
+
+			if constexpr(pads_left(F::info.type))
+			{
+				value.assign(padding, '0');
+				value.append(data, length);
+			}
+			else
+			{
+				value.assign(data, length);
+				value.append(padding, ' ');
+			}
+		}
+		else
+		{
+			value.assign(data, length);
+		}
+
+		present_[N - 1] = true;
+	}
+
+	bool has_second_bitmap() const
+	{
+		int i = 0;
+
+		for(i = bitmap_bits; i < max_field; i++)
+		{
+			if(present_[i])
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void write_bitmap(char *position, int first_field, bool bit_one) const
+	{
+		static const char hex[] = "0123456789ABCDEF";
+		int nibble = 0;
+		int i = 0;
+
+		for(i = 0; i < bitmap_hex_length; i++)
+		{
+			nibble = (present_[first_field + (i * 4)] << 3) | (present_[first_field + (i * 4) + 1] << 2) |
+				(present_[first_field + (i * 4) + 2] << 1) | present_[first_field + (i * 4) + 3];
+			position[i] = hex[nibble | ((i == 0 && bit_one) ? 8 : 0)];
+		}
+	}
+
+	static bool read_bitmap(const char *position, std::bitset<max_field> &bitmap, int first_field)
+	{
+		int nibble = 0;
+		int i = 0;
+
+		for(i = 0; i < bitmap_hex_length; i++)
+		{
+			nibble = hex_value(position[i]);
+			if(nibble < 0)
+			{
+				return false;
+			}
+
+			bitmap[first_field + (i * 4)] = (nibble & 8) != 0;
+			bitmap[first_field + (i * 4) + 1] = (nibble & 4) != 0;
+			bitmap[first_field + (i * 4) + 2] = (nibble & 2) != 0;
+			bitmap[first_field + (i * 4) + 3] = (nibble & 1) != 0;
+		}
+
+		return true;
+	}
+
+	template<int N>
+	bool encode_field(char *&position, char *end) const
+	{
+		using F = field<N, V>;
+
+		const std::string &data = fields_[N - 1];
+		std::size_t length = data.size();
+		int i = 0;
+
+		if(!present_[N - 1])
+		{
+			return true;
+		}
+
+		if(static_cast<std::size_t>(end - position) < F::info.size_of_length + length)
+		{
+			return false;
+		}
+
+		if constexpr(F::info.variable)
+		{
+			for(i = F::info.size_of_length - 1; i >= 0; i--, length /= 10)
+			{
+				position[i] = static_cast<char>('0' + (length % 10));
+			}
+
+			position += F::info.size_of_length;
+		}
+
+		std::memcpy(position, data.data(), data.size());
+		position += data.size();
+
+		return true;
+	}
+
+	template<std::size_t... I>
+	bool encode_fields(char *&position, char *end, std::index_sequence<I...>) const
+	{
+		return (encode_field<static_cast<int>(I) + 2>(position, end) && ...);
+	}
+
+	template<int N>
+	bool decode_field(const char *&position, const char *end, const std::bitset<max_field> &bitmap)
+	{
+		using F = field<N, V>;
+
+		std::size_t length = F::info.length;
+		int i = 0;
+
+		if(!bitmap[N - 1])
+		{
+			return true;
+		}
+
+		if constexpr(F::info.variable)
+		{
+			if(end - position < F::info.size_of_length || !all_digits(position, F::info.size_of_length))
+			{
+				return false;
+			}
+
+			for(i = 0, length = 0; i < F::info.size_of_length; i++)
+			{
+				length = (length * 10) + static_cast<std::size_t>(position[i] - '0');
+			}
+
+			position += F::info.size_of_length;
+
+			if(length > static_cast<std::size_t>(F::info.length))
+			{
+				return false;
+			}
+		}
+
+		if(static_cast<std::size_t>(end - position) < length)
+		{
+			return false;
+		}
+
+		fields_[N - 1].assign(position, length);
+		present_[N - 1] = true;
+		position += length;
+
+		return true;
+	}
+
+	template<std::size_t... I>
+	bool decode_fields(const char *&position, const char *end, const std::bitset<max_field> &bitmap, std::index_sequence<I...>)
+	{
+		return (decode_field<static_cast<int>(I) + 2>(position, end, bitmap) && ...);
+	}
+
+	std::string mti_;
+	std::bitset<max_field> present_;
+	std::array<std::string, max_field> fields_;
+};
+
+}
+
+#endif
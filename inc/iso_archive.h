@@ -0,0 +1,124 @@
+#ifndef ISO_ARCHIVE_H_
+#define ISO_ARCHIVE_H_
+
+#include "fields_info.h"
+#include "iso_filter.h"
+
+// Compact archive of packed messages, stored in blocks of up to ISO_ARCHIVE_BLOCK_MESSAGES messages.
+// In each block:
+//     - mti and fields 18, 22, 41 and 49 are dictionary encoded;
+//     - fields 11 (stan) and 7 (transmission date and time) are delta encoded from previous message;
+//     - the remaining bytes of message are stored as they are.
+// Each block has a summary (mti dictionary, bitmaps of fields and min/max of fields 11 and 7), so readers
+// can skip blocks without reading their messages. Messages are rebuilt byte by byte as they were written,
+// messages that can not be parsed with the current spec are stored without encoding.
+// The archive must be read with the same spec (fi_init_field_info) used to write it.
+//
+// File format (integers are little endian, varint is LEB128 and signed values are zigzag encoded):
+//     header:    char[8] magic "ISOARC01", u64 spec fingerprint;
+//     block:     u32 message count, u32 body length, u8[16] bitmap or, u8[16] bitmap and,
+//                u8 flags (1: stan range, 2: time range, 4: mti dictionary overflow),
+//                u64 stan min, u64 stan max, u64 time min, u64 time max,
+//                u8 mti count, char[4][mti count] mtis, body;
+//     body:      for each dictionary field: varint count, {varint length, bytes}[count];
+//                for each message: varint mti index, u8 flags, [varint stan delta], [varint time delta],
+//                [varint dictionary index][dictionary fields], varint residual length, residual bytes.
+
+#define ISO_ARCHIVE_MAGIC               "ISOARC01"
+#define ISO_ARCHIVE_MAGIC_LEN           8
+#define ISO_ARCHIVE_BLOCK_MESSAGES      4096
+#define ISO_ARCHIVE_MTI_DICT_MAX        64
+#define ISO_ARCHIVE_DICT_MAX            256
+
+/**
+ * Struct to store the summary of one block.
+ */
+struct iso_archive_block_info
+{
+	int message_count;
+	int body_length;
+	unsigned char bitmap_or[FI_BITMAP_LEN_BYTES * 2];  // Fields set in at least one message.
+	unsigned char bitmap_and[FI_BITMAP_LEN_BYTES * 2]; // Fields set in all messages.
+	int has_stan_range;                                // All messages with field 11 have it in the range.
+	unsigned long long stan_min;
+	unsigned long long stan_max;
+	int has_time_range;                                // All messages with field 7 have it in the range.
+	unsigned long long time_min;
+	unsigned long long time_max;
+	int mti_overflow;                                  // Some mti of block is not in the dictionary.
+	int mti_count;
+	char mtis[ISO_ARCHIVE_MTI_DICT_MAX][FI_MTI_LEN_BYTES];
+};
+
+/**
+ * Opaque struct of archive writer.
+ */
+struct iso_archive_writer;
+
+/**
+ * Opaque struct of archive reader.
+ */
+struct iso_archive_reader;
+
+/**
+ * @brief Create archive file, field info must be initialized before.
+ * @param[in] path The archive file path.
+ * @return Returns the archive writer or NULL case error.
+ */
+struct iso_archive_writer *iso_archive_create(const char *path);
+
+/**
+ * @brief Append packed message in the archive.
+ * @param[in] writer The archive writer.
+ * @param[in] message The packed message.
+ * @param[in] length The packed message length.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_archive_write(struct iso_archive_writer *writer, const char *message, int length);
+
+/**
+ * @brief Write pending block and close archive.
+ * @param[in] writer The archive writer.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_archive_close(struct iso_archive_writer *writer);
+
+/**
+ * @brief Open archive file, field info must be initialized before with the same spec used to write it.
+ * @param[in] path The archive file path.
+ * @return Returns the archive reader or NULL case error.
+ */
+struct iso_archive_reader *iso_archive_open(const char *path);
+
+/**
+ * @brief Read summary of next block, its messages are only read by iso_archive_read.
+ * @param[in] reader The archive reader.
+ * @param[out] info The block summary.
+ * @return Returns 1 case there is a block, 0 at the end of archive or -1 case error.
+ */
+int iso_archive_next_block(struct iso_archive_reader *reader, struct iso_archive_block_info *info);
+
+/**
+ * @brief Read next message of current block.
+ * @param[in] reader The archive reader.
+ * @param[out] message The buffer to store the packed message.
+ * @param[in] capacity The buffer capacity.
+ * @return Returns the message length, 0 at the end of block or -1 case error (corrupt block is not read anymore, go to next block).
+ */
+int iso_archive_read(struct iso_archive_reader *reader, char *message, int capacity);
+
+/**
+ * @brief Close archive reader.
+ * @param[in] reader The archive reader.
+ */
+void iso_archive_close_reader(struct iso_archive_reader *reader);
+
+/**
+ * @brief Check, using only block summary, if some message of block can match the filter.
+ * @param[in] info The block summary.
+ * @param[in] filter The compiled filter.
+ * @return Returns 1 case block may have matching messages or 0 if it can be skipped.
+ */
+int iso_archive_block_may_match(const struct iso_archive_block_info *info, const struct iso_filter *filter);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef ISO_CAPTURE_H_
+#define ISO_CAPTURE_H_
+
+#include <stddef.h>
+
+// Capture files are memory mapped (read only), messages are returned as pointers into the mapping.
+
+// Capture formats:
+#define ISO_CAPTURE_ASCII           0 // One packed message per line ('\n' or "\r\n"), empty lines are skipped;
+#define ISO_CAPTURE_BINARY          1 // Each packed message is preceded by 2 bytes length (big endian).
+
+#define ISO_CAPTURE_BINARY_HEADER   2
+
+/**
+ * Struct to store an opened capture file.
+ */
+struct iso_capture
+{
+	int fd;
+	int format;
+	const char *data;
+	size_t size;
+};
+
+/**
+ * @brief Open and map capture file.
+ * @param[in] path The capture file path.
+ * @param[in] format The capture format (ISO_CAPTURE_ASCII or ISO_CAPTURE_BINARY).
+ * @param[out] capture The opened capture.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_capture_open(const char *path, int format, struct iso_capture *capture);
+
+/**
+ * @brief Unmap and close capture file.
+ * @param[in] capture The capture to be closed.
+ */
+void iso_capture_close(struct iso_capture *capture);
+
+/**
+ * @brief Gets message starting at offset (offset of its line or length header).
+ * @param[in] capture The capture.
+ * @param[in] offset The offset of message.
+ * @param[out] message The pointer to message inside capture.
+ * @param[out] length The message length.
+ * @return Returns the offset of next message (after empty lines), 0 at the end of capture or -1 case error.
+ */
+long long iso_capture_next(const struct iso_capture *capture, long long offset, const char **message, int *length);
+
+/**
+ * @brief Split capture in chunks at message boundaries, to be processed in parallel.
+ * @param[in] capture The capture.
+ * @param[in] chunks The number of chunks.
+ * @param[out] offsets Vector with chunks + 1 positions, chunk i starts at offsets[i] and ends at offsets[i + 1].
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_capture_split(const struct iso_capture *capture, int chunks, long long *offsets);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef ISO_CHARSET_H_
+#define ISO_CHARSET_H_
+
+#include <stddef.h>
+
+// Character sets of packed messages (mti, bitmaps, length prefixes and all fields except 'b' fields):
+#define ISO_CHARSET_ASCII       0 // ASCII (default);
+#define ISO_CHARSET_EBCDIC      1 // EBCDIC, code page 037.
+
+/**
+ * @brief Convert ASCII data to EBCDIC (code page 037), source and destination can be the same buffer.
+ * @param[in] src The ASCII data.
+ * @param[out] dst The converted EBCDIC data, same length of source.
+ * @param[in] length The data length.
+ */
+void iso_charset_ascii_to_ebcdic(const char *src, char *dst, size_t length);
+
+/**
+ * @brief Convert EBCDIC (code page 037) data to ASCII, source and destination can be the same buffer.
+ * @param[in] src The EBCDIC data.
+ * @param[out] dst The converted ASCII data, same length of source.
+ * @param[in] length The data length.
+ */
+void iso_charset_ebcdic_to_ascii(const char *src, char *dst, size_t length);
+
+#endif
@@ -0,0 +1,392 @@
+#ifndef ISO_CLIENT_HPP_
+#define ISO_CLIENT_HPP_
+
+// Header-only C++20 async client of request/response exchanges: co_await client.send(request) suspends the coroutine
+// until its response arrives or the request times out, so thousands of requests are pipelined over few connections
+// without a thread per request. Responses are matched to requests by the correlation table (iso_correlation.h) with
+// mti class and fields 11, 37 and 41, expired requests resume their coroutines with exchange_status::timeout (i.e. to
+// send the 0400 reversal).
+// Connections are driven by the thread calling run_once, which writes queued requests, reads responses and resumes
+// coroutines. Messages are framed with 2 bytes length header (big endian, as ISO_FRAME_BINARY_2).
+// NOTE: The correlation table locates key fields with the spec loaded by iso_init, it must be the client version.
+
+#include <chrono>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include "iso_8583.hpp"
+
+extern "C"
+{
+#include "iso_correlation.h"
+}
+
+namespace iso
+{
+
+enum class exchange_status
+{
+	ok,
+	timeout,
+	send_error,       // Request could not be queued (invalid request, duplicated key or there is no open connection).
+	invalid_response  // Response was matched but could not be decoded.
+};
+
+template<version V = version::iso1987>
+struct exchange_result
+{
+	exchange_status status = exchange_status::send_error;
+	message<V> response;
+
+	explicit operator bool() const
+	{
+		return status == exchange_status::ok;
+	}
+};
+
+// Coroutine started by its call and destroyed when it finishes, the caller does not wait for it.
+struct task
+{
+	struct promise_type
+	{
+		task get_return_object() noexcept
+		{
+			return {};
+		}
+
+		std::suspend_never initial_suspend() noexcept
+		{
+			return {};
+		}
+
+		std::suspend_never final_suspend() noexcept
+		{
+			return {};
+		}
+
+		void return_void() noexcept
+		{
+		}
+
+		void unhandled_exception() noexcept
+		{
+			std::terminate();
+		}
+	};
+};
+
+template<version V = version::iso1987>
+class client
+{
+	// Request waiting response, it lives in the awaiter (so in the suspended coroutine frame).
+	struct pending
+	{
+		std::coroutine_handle<> handle;
+		exchange_result<V> result;
+	};
+
+	struct connection
+	{
+		int socket;
+		std::string output; // Framed requests not written yet.
+		std::string input;  // Received bytes, with partial frame.
+	};
+
+public:
+	static constexpr int key_fields[] = {11, 37, 41};
+	static constexpr std::size_t frame_header_length = 2;
+	static constexpr std::size_t max_frame_length = 0xFFFF;
+
+	class send_awaiter
+	{
+	public:
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+
+		bool await_suspend(std::coroutine_handle<> handle)
+		{
+			state_.handle = handle;
+
+			return owner_.start(request_, timeout_ms_, state_);
+		}
+
+		exchange_result<V> await_resume()
+		{
+			return std::move(state_.result);
+		}
+
+	private:
+		friend class client;
+
+		send_awaiter(client &owner, std::string request, unsigned int timeout_ms)
+			: owner_(owner), request_(std::move(request)), timeout_ms_(timeout_ms)
+		{
+		}
+
+		client &owner_;
+		std::string request_;
+		unsigned int timeout_ms_;
+		pending state_;
+	};
+
+	// Sockets must be connected and non-blocking, they are not closed by the client.
+	// Capacity is the expected number of requests in flight (it sizes the correlation table).
+	explicit client(const std::vector<int> &sockets, unsigned int timeout_ms = 30000, int capacity = 4096)
+		: timeout_ms_(timeout_ms), start_(std::chrono::steady_clock::now())
+	{
+		for(int socket : sockets)
+		{
+			connections_.push_back({socket, {}, {}});
+		}
+
+		table_ = iso_corr_create(capacity, key_fields, sizeof(key_fields) / sizeof(key_fields[0]));
+	}
+
+	// Requests in flight are dropped, their coroutines are not resumed (run until in_flight is zero before).
+	~client()
+	{
+		iso_corr_destroy(table_);
+	}
+
+	client(const client &) = delete;
+	client &operator=(const client &) = delete;
+
+	// Send request (it is encoded now and written by the next run_once), co_await the result.
+	send_awaiter send(const message<V> &request)
+	{
+		return send(request, timeout_ms_);
+	}
+
+	send_awaiter send(const message<V> &request, unsigned int timeout_ms)
+	{
+		return send_awaiter(*this, request.encode(), timeout_ms);
+	}
+
+	// Write requests, read responses, expire requests and resume their coroutines, waiting up to wait_ms for
+	// connections events. Returns the number of resumed coroutines or -1 case error (poll failed or all connections are closed).
+	int run_once(int wait_ms)
+	{
+		std::vector<pending *> ready;
+		std::vector<pollfd> events;
+		int result = 0;
+
+		for(connection &c : connections_)
+		{
+			if(c.socket >= 0 && !c.output.empty())
+			{
+				flush(c);
+			}
+			events.push_back({c.socket, static_cast<short>(POLLIN | (c.output.empty() ? 0 : POLLOUT)), 0});
+		}
+
+		if(open_connections() == 0)
+		{
+			result = -1;
+		}
+		else if(poll(events.data(), events.size(), wait_ms) < 0 && errno != EINTR)
+		{
+			result = -1;
+		}
+
+		for(std::size_t i = 0; result == 0 && i < events.size(); i++)
+		{
+			if(events[i].revents & POLLOUT)
+			{
+				flush(connections_[i]);
+			}
+			if(events[i].revents & (POLLIN | POLLHUP | POLLERR))
+			{
+				receive(connections_[i], ready);
+			}
+		}
+
+		expired_ = &ready;
+		iso_corr_advance(table_, now(), &client::expire, this);
+		expired_ = nullptr;
+
+		// Coroutines are resumed after all events, they may send new requests.
+		in_flight_ -= ready.size();
+		for(pending *p : ready)
+		{
+			p->handle.resume();
+		}
+
+		return (result < 0) ? result : static_cast<int>(ready.size());
+	}
+
+	std::size_t in_flight() const
+	{
+		return in_flight_;
+	}
+
+	// Number of responses without request (i.e. they arrived after timeout).
+	std::size_t unmatched() const
+	{
+		return unmatched_;
+	}
+
+private:
+	bool start(const std::string &request, unsigned int timeout_ms, pending &state)
+	{
+		iso_corr_key key;
+		connection *target = nullptr;
+		std::size_t i = 0;
+
+		for(i = 0; target == nullptr && i < connections_.size(); i++)
+		{
+			connection &c = connections_[next_++ % connections_.size()];
+			target = (c.socket >= 0) ? &c : nullptr;
+		}
+
+		if(table_ == nullptr || target == nullptr || request.empty() || request.size() > max_frame_length ||
+			iso_corr_key_from_raw(table_, request.data(), static_cast<int>(request.size()), &key) != 0 ||
+			iso_corr_insert(table_, &key, request.data(), static_cast<int>(request.size()), now(), timeout_ms, &state) != 0)
+		{
+			state.result.status = exchange_status::send_error;
+			return false;
+		}
+
+		target->output.push_back(static_cast<char>((request.size() >> 8) & 0xFF));
+		target->output.push_back(static_cast<char>(request.size() & 0xFF));
+		target->output.append(request);
+		in_flight_++;
+
+		return true;
+	}
+
+	// Write queued requests until socket buffer is full.
+	void flush(connection &c)
+	{
+		std::size_t written = 0;
+		ssize_t length = 0;
+
+		while(written < c.output.size())
+		{
+			length = write(c.socket, c.output.data() + written, c.output.size() - written);
+			if(length <= 0)
+			{
+				if(length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+				{
+					break;
+				}
+				// Requests of closed connection are not answered, they expire.
+				close_connection(c);
+				return;
+			}
+			written += static_cast<std::size_t>(length);
+		}
+
+		c.output.erase(0, written);
+	}
+
+	// Read available bytes and match complete frames.
+	void receive(connection &c, std::vector<pending *> &ready)
+	{
+		char buffer[16384];
+		std::size_t position = 0;
+		std::size_t length = 0;
+		ssize_t received = 0;
+		bool closed = false;
+
+		while((received = read(c.socket, buffer, sizeof(buffer))) > 0)
+		{
+			c.input.append(buffer, static_cast<std::size_t>(received));
+		}
+
+		// End of stream or read error (errno is only set when read fails), frames received before it are still matched.
+		closed = (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR));
+
+		while(c.input.size() - position >= frame_header_length)
+		{
+			length = (static_cast<unsigned char>(c.input[position]) << 8) | static_cast<unsigned char>(c.input[position + 1]);
+			if(c.input.size() - position - frame_header_length < length)
+			{
+				break;
+			}
+
+			match(c.input.data() + position + frame_header_length, length, ready);
+			position += frame_header_length + length;
+		}
+
+		c.input.erase(0, position);
+
+		if(closed)
+		{
+			close_connection(c);
+		}
+	}
+
+	void match(const char *response, std::size_t length, std::vector<pending *> &ready)
+	{
+		iso_corr_key key;
+		void *user_data = nullptr;
+		pending *p = nullptr;
+
+		if(iso_corr_key_from_raw(table_, response, static_cast<int>(length), &key) != 0 || iso_corr_match(table_, &key, &user_data) != 0)
+		{
+			unmatched_++;
+			return;
+		}
+
+		p = static_cast<pending *>(user_data);
+		p->result.status = p->result.response.decode(response, length) ? exchange_status::ok : exchange_status::invalid_response;
+		ready.push_back(p);
+	}
+
+	static void expire(const iso_corr_key *, const char *, int, void *user_data, void *context)
+	{
+		client *self = static_cast<client *>(context);
+		pending *p = static_cast<pending *>(user_data);
+
+		p->result.status = exchange_status::timeout;
+		self->expired_->push_back(p);
+	}
+
+	void close_connection(connection &c)
+	{
+		c.socket = -1;
+		c.output.clear();
+		c.input.clear();
+	}
+
+	std::size_t open_connections() const
+	{
+		std::size_t count = 0;
+
+		for(const connection &c : connections_)
+		{
+			count += (c.socket >= 0) ? 1 : 0;
+		}
+
+		return count;
+	}
+
+	// Ticks of the correlation table are milliseconds since client creation.
+	unsigned long long now() const
+	{
+		return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_).count());
+	}
+
+	std::vector<connection> connections_;
+	iso_corr_table *table_ = nullptr;
+	unsigned int timeout_ms_;
+	std::chrono::steady_clock::time_point start_;
+	std::vector<pending *> *expired_ = nullptr;
+	std::size_t next_ = 0;
+	std::size_t in_flight_ = 0;
+	std::size_t unmatched_ = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef ISO_COLUMNAR_H_
+#define ISO_COLUMNAR_H_
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "fields_info.h"
+
+// Column oriented export of packed messages, one column per requested field plus the mti column.
+// Fields are located with iso_raw functions, so messages are never decoded into the internal fields.
+//
+// Binary file format (all integers are little endian):
+//     header:
+//         char[8]  magic "ISOCOL01";
+//         u32      row count;
+//         u32      column count (mti column included, it is always the first one);
+//     column directory, one entry per column:
+//         u16      field number (0 for mti column);
+//         u16      fixed length (0 for variable length fields);
+//         u64      data length;
+//     column data, one entry per column (same order of directory):
+//         u8[(row count + 7) / 8] validity bitmap, bit (row % 8) of byte (row / 8) is set when the field is present;
+//         u32[row count + 1]      offsets of each row in data (only for variable length fields);
+//         u8[data length]         data, fixed length fields use (fixed length) bytes per row, filled with spaces when not present.
+
+#define ISO_COLUMNAR_MAGIC          "ISOCOL01"
+#define ISO_COLUMNAR_MAGIC_LEN      8
+#define ISO_COLUMNAR_MTI_FIELD      0
+
+/**
+ * Struct to store one column.
+ */
+struct iso_column
+{
+	int field;
+	int fixed_length;        // Spec length of fixed length fields, 0 for variable length fields.
+	unsigned char *validity; // One bit per row.
+	unsigned int *offsets;   // Variable length fields only, row count + 1 offsets.
+	char *data;
+	size_t data_length;
+	size_t data_capacity;
+};
+
+/**
+ * Struct to store the columns of exported messages.
+ */
+struct iso_columnar
+{
+	int row_count;
+	int row_capacity;
+	int column_count;
+	int last_field;
+	struct iso_column columns[FI_NUM_FIELD_MAX + 1];
+};
+
+/**
+ * @brief Initialize columnar export, field info must be initialized before.
+ * @param[out] columnar The columnar export.
+ * @param[in] fields The fields to be exported.
+ * @param[in] field_count The number of fields.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_columnar_init(struct iso_columnar *columnar, const int *fields, int field_count);
+
+/**
+ * @brief Release memory allocated by columnar export.
+ * @param[in] columnar The columnar export.
+ */
+void iso_columnar_release(struct iso_columnar *columnar);
+
+/**
+ * @brief Append packed message as new row.
+ * @param[in] columnar The columnar export.
+ * @param[in] message The packed message.
+ * @param[in] length The packed message length.
+ * @return Returns 0 to success or -1 case error (message is invalid or there is no memory).
+ */
+int iso_columnar_append(struct iso_columnar *columnar, const char *message, int length);
+
+/**
+ * @brief Append all rows of other columnar export with the same fields (i.e. exported by other thread).
+ * @param[in] columnar The columnar export.
+ * @param[in] other The columnar export to be appended.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_columnar_concat(struct iso_columnar *columnar, const struct iso_columnar *other);
+
+/**
+ * @brief Write columns in the binary format.
+ * @param[in] columnar The columnar export.
+ * @param[in] file The output file.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_columnar_write_binary(const struct iso_columnar *columnar, FILE *file);
+
+/**
+ * @brief Write rows in csv format, with header line (mti and field numbers).
+ * @param[in] columnar The columnar export.
+ * @param[in] file The output file.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_columnar_write_csv(const struct iso_columnar *columnar, FILE *file);
+
+#endif
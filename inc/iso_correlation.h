@@ -0,0 +1,124 @@
+#ifndef ISO_CORRELATION_H_
+#define ISO_CORRELATION_H_
+
+// Table of in-flight requests, used to match responses to their requests.
+// The key is the mti class (version, class and function without the response bit) plus a configurable tuple of fields,
+// i.e. {11, 37, 41} (system trace audit number, retrieval reference number and terminal identification).
+// The table is split in shards, each one with its own lock, hash buckets and timer wheel, so it can be shared between threads.
+
+#define ISO_CORR_SHARDS             64
+#define ISO_CORR_WHEEL_SLOTS        512
+#define ISO_CORR_MAX_KEY_FIELDS     8
+#define ISO_CORR_KEY_MAX            128
+
+/**
+ * Struct to store the correlation key of a message.
+ */
+struct iso_corr_key
+{
+	char data[ISO_CORR_KEY_MAX];
+	int length;
+	unsigned long long hash;
+};
+
+/**
+ * Opaque struct of correlation table.
+ */
+struct iso_corr_table;
+
+/**
+ * Callback called for each expired request (candidate to reversal).
+ * @param[in] key The request key.
+ * @param[in] request The packed request message.
+ * @param[in] length The packed request message length.
+ * @param[in] user_data The user data informed at insertion.
+ * @param[in] context The context informed to iso_corr_advance.
+ */
+typedef void (*iso_corr_expired_cb)(const struct iso_corr_key *key, const char *request, int length, void *user_data, void *context);
+
+/**
+ * @brief Create correlation table.
+ * @param[in] capacity The expected number of in-flight requests (used to size hash buckets).
+ * @param[in] key_fields The fields used to compose the key.
+ * @param[in] key_field_count The number of key fields (up to ISO_CORR_MAX_KEY_FIELDS).
+ * @return Returns the table or NULL case error.
+ */
+struct iso_corr_table *iso_corr_create(int capacity, const int *key_fields, int key_field_count);
+
+/**
+ * @brief Release table and all pending entries.
+ * @param[in] table The correlation table.
+ */
+void iso_corr_destroy(struct iso_corr_table *table);
+
+/**
+ * @brief Compose key from packed message, without decoding it.
+ * @param[in] table The correlation table.
+ * @param[in] message The packed message.
+ * @param[in] length The packed message length.
+ * @param[out] key The message key.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_corr_key_from_raw(const struct iso_corr_table *table, const char *message, int length, struct iso_corr_key *key);
+
+/**
+ * @brief Compose key from the current iso message (generated or decoded with iso_8583 functions).
+ * @param[in] table The correlation table.
+ * @param[out] key The message key.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_corr_key_from_message(const struct iso_corr_table *table, struct iso_corr_key *key);
+
+/**
+ * @brief Insert request in the table.
+ * @param[in] table The correlation table.
+ * @param[in] key The request key.
+ * @param[in] request The packed request message, a copy is stored to be used case the request expires.
+ * @param[in] length The packed request message length.
+ * @param[in] now The current tick, same clock of iso_corr_advance (the table does not need to be advanced before).
+ * @param[in] timeout The timeout in ticks, the request expires at now + timeout.
+ * @param[in] user_data The user data to be returned when request is matched or expired.
+ * @return Returns 0 to success or -1 case error (i.e. there is another request with same key).
+ */
+int iso_corr_insert(struct iso_corr_table *table, const struct iso_corr_key *key, const char *request, int length, unsigned long long now,
+	unsigned int timeout, void *user_data);
+
+/**
+ * @brief Find and remove request from table.
+ * @param[in] table The correlation table.
+ * @param[in] key The response key.
+ * @param[out] user_data The user data informed at insertion (can be NULL).
+ * @return Returns 0 case request was found or -1 if there is no request with this key.
+ */
+int iso_corr_match(struct iso_corr_table *table, const struct iso_corr_key *key, void **user_data);
+
+/**
+ * @brief Advance the timer wheels until the informed tick, removing expired requests.
+ * @param[in] table The correlation table.
+ * @param[in] now The current tick (i.e. seconds of a monotonic clock), must be non decreasing.
+ * @param[in] callback The callback called for each expired request (can be NULL).
+ * @param[in] context The context to be informed to callback.
+ * @return Returns the number of expired requests.
+ */
+int iso_corr_advance(struct iso_corr_table *table, unsigned long long now, iso_corr_expired_cb callback, void *context);
+
+/**
+ * @brief Gets the number of in-flight requests.
+ * @param[in] table The correlation table.
+ * @return Returns the number of requests in the table.
+ */
+int iso_corr_count(struct iso_corr_table *table);
+
+/**
+ * @brief Build reversal (x400) message from request, with original data elements filled from request.
+ * Only transaction and routing data elements (i.e. 2, 3, 4, 7, 11, 32, 37, 41, 49) are kept, card security data
+ * (PIN block and tracks) are never copied to the reversal.
+ * NOTE: This function uses iso_decode_message and iso_generate_message, so it replaces the current iso message.
+ * @param[in] request The packed request message.
+ * @param[in] length The packed request message length.
+ * @param[out] reversal The buffer to store the reversal message.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_corr_make_reversal(const char *request, int length, char *reversal);
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef ISO_FILTER_H_
+#define ISO_FILTER_H_
+
+// Filter expressions are evaluated directly on the packed message (see iso_raw.h), without decoding it.
+//
+// Expression syntax:
+//     expression := clause { '&' clause }
+//     clause     := term { '|' term }
+//     term       := [ '!' ] ( mti=MTI | has(N) | N=VALUE | N^VALUE | N:MIN..MAX )
+//
+// Where:
+//     mti=0200          -> mti is equal to 0200, 'x' matches any digit (i.e. mti=02x0);
+//     has(32)           -> field 32 is set in the bitmap;
+//     3=000000          -> field 3 is equal to 000000;
+//     2^411111          -> field 2 starts with 411111;
+//     4:000000001000..000000005000 -> field 4 is in the range (numeric compare when both limits are digits);
+//
+// I.e.: "mti=02x0 & 3^00 & 2^411111|2^522222 & !has(55)"
+
+#define ISO_FILTER_MAX_TERMS    32
+#define ISO_FILTER_MAX_VALUE    64
+
+// Filter term operations:
+#define ISO_FILTER_OP_MTI       0
+#define ISO_FILTER_OP_HAS       1
+#define ISO_FILTER_OP_EQUAL     2
+#define ISO_FILTER_OP_PREFIX    3
+#define ISO_FILTER_OP_RANGE     4
+
+/**
+ * Struct to store one compiled term of filter.
+ */
+struct iso_filter_term
+{
+	int op;
+	int field;
+	int negate;
+	int clause; // Terms of the same clause are or'ed, clauses are and'ed.
+	char value[ISO_FILTER_MAX_VALUE + 1];
+	int value_length;
+	char value_max[ISO_FILTER_MAX_VALUE + 1];
+	int value_max_length;
+};
+
+/**
+ * Struct to store a compiled filter.
+ */
+struct iso_filter
+{
+	struct iso_filter_term terms[ISO_FILTER_MAX_TERMS];
+	int term_count;
+	int clause_count;
+	int last_field; // Last field which data is needed by filter, 0 case only mti and bitmap are needed.
+};
+
+/**
+ * @brief Compile filter expression.
+ * @param[in] expression The filter expression.
+ * @param[out] filter The compiled filter.
+ * @return Returns 0 to success or -1 case expression is invalid.
+ */
+int iso_filter_compile(const char *expression, struct iso_filter *filter);
+
+/**
+ * @brief Evaluate compiled filter on packed message.
+ * @param[in] filter The compiled filter.
+ * @param[in] message The packed message.
+ * @param[in] length The packed message length.
+ * @return Returns 1 case message matches the filter, 0 if it does not match or -1 case message is invalid.
+ */
+int iso_filter_match(const struct iso_filter *filter, const char *message, int length);
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef ISO_INDEX_H_
+#define ISO_INDEX_H_
+
+#include <stddef.h>
+
+#include "fields_info.h"
+
+// Secondary index of capture files (see iso_capture.h), from key (values of one or more fields) to message offset.
+// The index is an open addressing hash table (linear probing) stored in a file, it is memory mapped to lookup,
+// so each found message costs one random read of the capture file. Only the key hash is stored in the index
+// (i.e. PAN values are not written), keys are checked against the message read from the capture.
+// Messages without some key field are not indexed.
+//
+// Keys are the field values separated by '|', i.e. key fields 11,41 -> "000123|TERM0001".
+//
+// File format (integers are little endian):
+//     header (64 bytes):
+//         char[8]  magic "ISOIDX01";
+//         u32      capture format;
+//         u32      key field count;
+//         u16[8]   key fields;
+//         u64      slot count (power of 2);
+//         u64      entry count;
+//         u64      capture size when index was built;
+//         u8[8]    reserved;
+//     slots, slot count entries:
+//         u64      key hash (FNV-1a);
+//         u64      message offset + 1 (0 for empty slot).
+
+#define ISO_INDEX_MAGIC             "ISOIDX01"
+#define ISO_INDEX_MAGIC_LEN         8
+#define ISO_INDEX_HEADER_LEN        64
+#define ISO_INDEX_SLOT_LEN          16
+#define ISO_INDEX_MAX_KEY_FIELDS    8
+#define ISO_INDEX_MAX_KEY           256
+#define ISO_INDEX_KEY_SEPARATOR     '|'
+
+/**
+ * Struct to store an opened index and its capture file.
+ */
+struct iso_index
+{
+	int fd;
+	int capture_fd;
+	int format;
+	int key_fields[ISO_INDEX_MAX_KEY_FIELDS];
+	int key_field_count;
+	int last_field;
+	const unsigned char *data;
+	size_t size;
+	unsigned long long slot_count;
+	unsigned long long entry_count;
+};
+
+/**
+ * @brief Build key from packed message.
+ * @param[in] key_fields The key fields.
+ * @param[in] key_field_count The number of key fields.
+ * @param[in] message The packed message.
+ * @param[in] length The packed message length.
+ * @param[out] key The key (not null terminated).
+ * @param[in] capacity The key buffer capacity.
+ * @return Returns the key length or -1 case some key field is not set or message is invalid.
+ */
+int iso_index_key_from_raw(const int *key_fields, int key_field_count, const char *message, int length, char *key, int capacity);
+
+/**
+ * @brief Build index of capture file, field info must be initialized before.
+ * @param[in] capture_path The capture file path.
+ * @param[in] format The capture format (ISO_CAPTURE_ASCII or ISO_CAPTURE_BINARY).
+ * @param[in] key_fields The key fields.
+ * @param[in] key_field_count The number of key fields.
+ * @param[in] index_path The index file path.
+ * @return Returns the number of indexed messages or -1 case error.
+ */
+long long iso_index_build(const char *capture_path, int format, const int *key_fields, int key_field_count, const char *index_path);
+
+/**
+ * @brief Open index and its capture file, field info must be initialized before.
+ * @param[in] index_path The index file path.
+ * @param[in] capture_path The capture file path.
+ * @param[out] index The opened index.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_index_open(const char *index_path, const char *capture_path, struct iso_index *index);
+
+/**
+ * @brief Close index and its capture file.
+ * @param[in] index The opened index.
+ */
+void iso_index_close(struct iso_index *index);
+
+/**
+ * @brief Read message at offset of capture file (one read).
+ * @param[in] index The opened index.
+ * @param[in] offset The message offset.
+ * @param[out] message The buffer to store the packed message.
+ * @param[in] capacity The buffer capacity, FI_LEN_MAX_ISO + ISO_CAPTURE_BINARY_HEADER reads any message.
+ * @return Returns the message length or -1 case error.
+ */
+int iso_index_read(const struct iso_index *index, long long offset, char *message, int capacity);
+
+/**
+ * @brief Find next message with key, call it until it returns 0 to get all messages with the same key.
+ * @param[in] index The opened index.
+ * @param[in] key The key.
+ * @param[in] key_length The key length.
+ * @param[in,out] cursor The lookup state, must be 0 in the first call.
+ * @param[out] message The buffer to store the packed message.
+ * @param[in] capacity The buffer capacity.
+ * @param[out] offset The message offset (can be NULL).
+ * @return Returns the message length, 0 case there is no more messages or -1 case error.
+ */
+int iso_index_find(const struct iso_index *index, const char *key, int key_length, unsigned long long *cursor, char *message, int capacity, long long *offset);
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef ISO_JOURNAL_H_
+#define ISO_JOURNAL_H_
+
+#include <stddef.h>
+
+// Store-and-forward journal of packed messages (i.e. x220 advices and x420 reversal advices), kept until they are
+// acknowledged by their response. Messages are appended to memory-mapped segment files of a directory, appends only
+// copy into the mapping and iso_journal_commit makes them durable with one msync for all messages appended by all
+// threads since the last commit (group commit), instead of one fsync per message.
+// Acknowledgements are records of the journal too, so pending messages (appended and not acknowledged) are replayed
+// in order when the journal is opened again. Segments with only acknowledged messages are removed by iso_journal_compact.
+// Responses are matched to pending messages by the correlation table (iso_correlation.h), with key fields informed at open,
+// so the journal uses the spec initialized by iso_init.
+//
+// Segment file "<directory>/<segment number, 16 hex digits>.jnl" (integers are little endian):
+//     header:  char[8] magic "ISOJNL01", u64 segment number, u64 first message id, u64 reserved;
+//     records: u32 record length (header and data), u32 crc32 (from id to the end of data), u64 id, u32 type (1: message, 2: ack),
+//              u32 reserved, data (packed message), padding to ISO_JOURNAL_ALIGN bytes;
+//     end:     zero record length (segments are preallocated with zeros), torn records fail the crc. The rest of segment
+//              after the end (or a torn record) is cleared when the journal is opened.
+
+#define ISO_JOURNAL_MAGIC               "ISOJNL01"
+#define ISO_JOURNAL_MAGIC_LEN           8
+#define ISO_JOURNAL_HEADER_LEN          32
+#define ISO_JOURNAL_RECORD_HEADER_LEN   24
+#define ISO_JOURNAL_ALIGN               8
+#define ISO_JOURNAL_SEGMENT_MIN         (64 * 1024)
+#define ISO_JOURNAL_SEGMENT_DEFAULT     (64 * 1024 * 1024)
+
+/**
+ * Opaque struct of journal.
+ */
+struct iso_journal;
+
+/**
+ * @brief Open journal directory (it is created case it does not exist), replaying its segments to find pending messages.
+ * @param[in] directory The journal directory.
+ * @param[in] segment_size The size of new segments (0 to ISO_JOURNAL_SEGMENT_DEFAULT), it limits the message length.
+ * @param[in] key_fields The fields used to match responses (i.e. {11, 37, 41}).
+ * @param[in] key_field_count The number of key fields.
+ * @return Returns the journal or NULL case error.
+ */
+struct iso_journal *iso_journal_open(const char *directory, size_t segment_size, const int *key_fields, int key_field_count);
+
+/**
+ * @brief Commit appended records and close journal.
+ * @param[in] journal The journal.
+ * @return Returns 0 to success or -1 case commit failed.
+ */
+int iso_journal_close(struct iso_journal *journal);
+
+/**
+ * @brief Append packed message (i.e. generated by iso_generate_message), it is durable only after iso_journal_commit.
+ * @param[in] journal The journal.
+ * @param[in] message The packed message.
+ * @param[in] length The packed message length.
+ * @return Returns the message id (ids are increasing, starting at 1) or 0 case error.
+ */
+unsigned long long iso_journal_append(struct iso_journal *journal, const char *message, int length);
+
+/**
+ * @brief Make durable all records appended before the call. Concurrent callers wait the same msync.
+ * @param[in] journal The journal.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_journal_commit(struct iso_journal *journal);
+
+/**
+ * @brief Acknowledge pending message (the ack is durable after iso_journal_commit, until there it may be replayed again).
+ * @param[in] journal The journal.
+ * @param[in] id The message id.
+ * @return Returns 0 to success or -1 case message is not pending.
+ */
+int iso_journal_ack(struct iso_journal *journal, unsigned long long id);
+
+/**
+ * @brief Acknowledge pending message matched by response (i.e. 0230 of a 0220).
+ * @param[in] journal The journal.
+ * @param[in] response The packed response.
+ * @param[in] length The packed response length.
+ * @param[out] id The acknowledged message id (can be NULL).
+ * @return Returns 1 case response matched a pending message, 0 if it did not match or -1 case error.
+ */
+int iso_journal_ack_response(struct iso_journal *journal, const char *response, int length, unsigned long long *id);
+
+/**
+ * @brief Gets next pending message in journal order (i.e. to retry them from the oldest one).
+ * The message points into the segment mapping, it is valid until the message is acknowledged and the journal compacted.
+ * @param[in] journal The journal.
+ * @param[in] after_id The id of previous pending message (0 to start from the oldest one).
+ * @param[out] message The pointer to packed message.
+ * @param[out] length The packed message length.
+ * @param[out] id The message id.
+ * @return Returns 1 case there is a pending message, 0 if there is not or -1 case error.
+ */
+int iso_journal_next_pending(struct iso_journal *journal, unsigned long long after_id, const char **message, int *length, unsigned long long *id);
+
+/**
+ * @brief Gets the number of pending messages.
+ * @param[in] journal The journal.
+ * @return Returns the number of pending messages.
+ */
+int iso_journal_pending_count(struct iso_journal *journal);
+
+/**
+ * @brief Remove committed segments older than the oldest pending message.
+ * @param[in] journal The journal.
+ * @return Returns the number of removed segments or -1 case error.
+ */
+int iso_journal_compact(struct iso_journal *journal);
+
+#endif
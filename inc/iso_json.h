@@ -0,0 +1,33 @@
+#ifndef ISO_JSON_H_
+#define ISO_JSON_H_
+
+// Transcoding between packed iso messages and compact json:
+//   {"mti":"0200","2":"4111111111111111","3":"000000","52":"0123456789ABCDEF"}
+// Keys are field numbers, 'b' fields are hex strings and other bytes out of printable ascii are escaped as \u00XX.
+// With ISO_JSON_DESCRIPTIONS fields are objects: "2":{"value":"4111111111111111","description":"primary account number"}.
+
+// Flags of iso_json_from_message.
+#define ISO_JSON_DESCRIPTIONS   1 // Add field descriptions (fi_field_info.description).
+
+/**
+ * @brief Generate json from packed message (ASCII charset), without decoding it into the internal fields.
+ * It does not use global state of iso_8583 module, so it can be called from any thread.
+ * @param[in] message The packed message.
+ * @param[in] length The packed message length.
+ * @param[out] json The buffer where the null terminated json will be stored.
+ * @param[in] capacity The json buffer capacity.
+ * @param[in] flags Zero or ISO_JSON_DESCRIPTIONS.
+ * @return Returns the json length (without null terminator) or -1 case error (invalid message or json exceeds capacity).
+ */
+int iso_json_from_message(const char *message, int length, char *json, int capacity, int flags);
+
+/**
+ * @brief Parse json (both forms of iso_json_from_message) into the internal fields, replacing the current message,
+ * so it can be generated with iso_generate_message. Field descriptions are ignored.
+ * @param[in] json The json.
+ * @param[in] length The json length.
+ * @return Returns 0 to success or -1 case error (invalid json, field or field length).
+ */
+int iso_json_to_message(const char *json, int length);
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef ISO_MAC_H_
+#define ISO_MAC_H_
+
+// Message authentication codes of fields 64 and 128, computed in software while the message is packed or decoded
+// (see iso_generate_message_mac and iso_decode_message_mac), so MACed messages are walked only once.
+// The MAC covers the packed bytes before the MAC field (mti, bitmaps and fields, as they are on the wire) and it is
+// the last field: 64 case message has no second bitmap or 128 otherwise.
+// Algorithms are pluggable (struct iso_mac_algorithm), the library has:
+//     - iso_mac_retail: ISO 9797-1 MAC algorithm 3 (ANSI X9.19 retail MAC), padding method 1, double length DES key;
+//     - iso_mac_aes_cmac: AES-CMAC (NIST SP 800-38B, RFC 4493), 128, 192 or 256 bits AES key.
+// The MAC field gets the leftmost bytes of MAC case its length is not greater than the MAC length (i.e. 8 bytes of
+// 1993 version), or the leftmost hex digits of MAC case it is up to double of MAC length (i.e. 16 digits of field 64 of 1987 version).
+
+#define ISO_MAC_BLOCK_MAX       16
+#define ISO_MAC_KEY_MAX         32
+#define ISO_MAC_SCHEDULE_MAX    64 // 32 bits words of key schedule.
+
+struct iso_mac;
+
+/**
+ * Struct with the functions of a MAC algorithm.
+ */
+struct iso_mac_algorithm
+{
+	const char *name;
+	int block_length;
+	int mac_length;
+	int (*set_key)(struct iso_mac *mac, const unsigned char *key, int length);          // Returns 0 or -1 case key length is invalid.
+	void (*update)(struct iso_mac *mac, const unsigned char *data, int length);         // Called only with whole blocks, the last block is kept for final.
+	void (*final)(struct iso_mac *mac, const unsigned char *block, int length, unsigned char *output); // Last block (0 - block_length bytes).
+};
+
+/**
+ * Struct to store MAC key schedule and state, data is buffered in blocks before it is passed to the algorithm.
+ */
+struct iso_mac
+{
+	const struct iso_mac_algorithm *algorithm;
+	unsigned int schedule[ISO_MAC_SCHEDULE_MAX];
+	unsigned char subkeys[2][ISO_MAC_BLOCK_MAX];
+	unsigned char chain[ISO_MAC_BLOCK_MAX];
+	unsigned char buffer[ISO_MAC_BLOCK_MAX];
+	int buffered;
+	int rounds;
+};
+
+extern const struct iso_mac_algorithm iso_mac_retail;
+extern const struct iso_mac_algorithm iso_mac_aes_cmac;
+
+/**
+ * @brief Initialize MAC with algorithm and key, the key schedule is computed once and used by all messages.
+ * @param[out] mac The MAC.
+ * @param[in] algorithm The MAC algorithm (i.e. &iso_mac_retail).
+ * @param[in] key The key.
+ * @param[in] length The key length (16 bytes to retail MAC, 16, 24 or 32 bytes to AES-CMAC).
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_mac_init(struct iso_mac *mac, const struct iso_mac_algorithm *algorithm, const unsigned char *key, int length);
+
+/**
+ * @brief Start MAC of new message.
+ * @param[in] mac The MAC.
+ */
+void iso_mac_reset(struct iso_mac *mac);
+
+/**
+ * @brief Absorb message bytes.
+ * @param[in] mac The MAC.
+ * @param[in] data The data.
+ * @param[in] length The data length.
+ */
+void iso_mac_update(struct iso_mac *mac, const unsigned char *data, int length);
+
+/**
+ * @brief Finish MAC of message.
+ * @param[in] mac The MAC.
+ * @param[out] output The buffer to store the MAC (algorithm mac_length bytes).
+ * @return Returns the MAC length.
+ */
+int iso_mac_final(struct iso_mac *mac, unsigned char *output);
+
+/**
+ * @brief Compute MAC of data in one call.
+ * @param[in] mac The MAC.
+ * @param[in] data The data.
+ * @param[in] length The data length.
+ * @param[out] output The buffer to store the MAC (algorithm mac_length bytes).
+ * @return Returns the MAC length.
+ */
+int iso_mac_compute(struct iso_mac *mac, const unsigned char *data, int length, unsigned char *output);
+
+/**
+ * @brief Format MAC as the data of MAC field, according field length (see header comment).
+ * @param[in] mac The MAC.
+ * @param[in] value The MAC computed by iso_mac_final.
+ * @param[in] field_length The MAC field length.
+ * @param[out] data The buffer to store field data (field_length bytes).
+ * @return Returns 0 to success or -1 case field length does not fit the MAC.
+ */
+int iso_mac_format_field(const struct iso_mac *mac, const unsigned char *value, int field_length, char *data);
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef ISO_PIPELINE_H_
+#define ISO_PIPELINE_H_
+
+// Pipeline of inbound messages: decode, handle and encode stages run on a pool of worker threads and responses
+// are delivered to their connection in the order requests were submitted on it.
+// Each worker has its own queue (requests are queued to the worker of their connection, so a connection tends to
+// stay on one core) and idle workers steal from the others. The stages use the current message of the worker thread
+// (iso_decode_message_bytes, the handler with iso_get_field/iso_add_field and iso_generate_message_bounded).
+// Completed responses wait in a reorder window of their connection until the previous ones are delivered.
+
+#define ISO_PIPELINE_WORKERS_MAX    64
+#define ISO_PIPELINE_QUEUE_LEN      1024 // Requests queued per worker.
+#define ISO_PIPELINE_WINDOW         64   // Requests in flight per connection.
+
+// Stages measured by iso_pipeline_get_stats:
+#define ISO_PIPELINE_STAGE_QUEUE    0 // From submit until a worker takes the request;
+#define ISO_PIPELINE_STAGE_DECODE   1 // Decode of request;
+#define ISO_PIPELINE_STAGE_HANDLE   2 // Handler;
+#define ISO_PIPELINE_STAGE_ENCODE   3 // Encode of response;
+#define ISO_PIPELINE_STAGE_REORDER  4 // From encode until delivery (waiting previous responses of the connection).
+#define ISO_PIPELINE_STAGES         5
+
+/**
+ * Opaque struct of pipeline.
+ */
+struct iso_pipeline;
+
+/**
+ * Struct with the request being handled, the decoded request is the current message of the worker thread.
+ */
+struct iso_pipeline_context
+{
+	int connection;                // Connection of request.
+	unsigned long long sequence;   // Request number in its connection (starting at 0).
+	const char *request;           // Packed request.
+	int request_length;            // Packed request length.
+	int worker;                    // Worker index (i.e. to use per worker resources).
+};
+
+/**
+ * Struct with pipeline counters and stage latencies (in nanoseconds).
+ */
+struct iso_pipeline_stats
+{
+	unsigned long long submitted;
+	unsigned long long delivered;      // Responses delivered (requests without response are not counted).
+	unsigned long long decode_errors;
+	unsigned long long handle_errors;  // Handler returned error or response could not be encoded.
+	unsigned long long stolen;         // Requests run by other worker than the one they were queued to.
+	int queue_depth;                   // Requests waiting a worker.
+	int reorder_depth;                 // Requests in flight (queued, running or waiting delivery).
+	unsigned long long stage_count[ISO_PIPELINE_STAGES];
+	unsigned long long stage_total_ns[ISO_PIPELINE_STAGES];
+	unsigned long long stage_max_ns[ISO_PIPELINE_STAGES];
+};
+
+/**
+ * Handler called by worker thread with the request decoded in the current message, it builds the response in
+ * the current message (i.e. iso_set_mti, iso_add_field, iso_remove_field).
+ * @param[in] context The request context.
+ * @param[in] user_data The user data informed at creation.
+ * @return Returns 1 to send the current message as response, 0 case there is no response or -1 case error.
+ */
+typedef int (*iso_pipeline_handler_cb)(const struct iso_pipeline_context *context, void *user_data);
+
+/**
+ * Callback called with the responses of a connection in the order of their requests, responses of one connection
+ * are never delivered concurrently (responses of distinct connections may be).
+ * @param[in] connection The connection of request.
+ * @param[in] sequence The request number in its connection.
+ * @param[in] response The packed response (not null terminated), valid only during the call.
+ * @param[in] length The packed response length.
+ * @param[in] user_data The user data informed at creation.
+ */
+typedef void (*iso_pipeline_output_cb)(int connection, unsigned long long sequence, const char *response, int length, void *user_data);
+
+/**
+ * @brief Create pipeline and start its workers. The spec must be initialized (iso_init) before, workers use the
+ * charset of the calling thread (iso_set_charset).
+ * @param[in] workers The number of worker threads (up to ISO_PIPELINE_WORKERS_MAX).
+ * @param[in] connections The number of connections, they are numbered from 0 to connections - 1.
+ * @param[in] handler The handler of requests.
+ * @param[in] output The callback to deliver responses.
+ * @param[in] user_data The user data to be informed to callbacks.
+ * @return Returns the pipeline or NULL case error.
+ */
+struct iso_pipeline *iso_pipeline_create(int workers, int connections, iso_pipeline_handler_cb handler, iso_pipeline_output_cb output, void *user_data);
+
+/**
+ * @brief Stop workers, after running all submitted requests, and release pipeline.
+ * @param[in] pipeline The pipeline.
+ */
+void iso_pipeline_destroy(struct iso_pipeline *pipeline);
+
+/**
+ * @brief Submit request of connection, the request is copied. Requests of one connection must be submitted by one thread at time.
+ * @param[in] pipeline The pipeline.
+ * @param[in] connection The connection of request.
+ * @param[in] request The packed request.
+ * @param[in] length The packed request length.
+ * @return Returns 0 to success, 1 case connection has ISO_PIPELINE_WINDOW requests in flight or worker queue is full
+ * (the caller should retry later, i.e. stop reading the connection) or -1 case error.
+ */
+int iso_pipeline_submit(struct iso_pipeline *pipeline, int connection, const char *request, int length);
+
+/**
+ * @brief Gets pipeline counters, queue depths and stage latencies (counters are read without lock, so they are approximated).
+ * @param[in] pipeline The pipeline.
+ * @param[out] stats The pipeline stats.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_pipeline_get_stats(struct iso_pipeline *pipeline, struct iso_pipeline_stats *stats);
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef ISO_RAW_H_
+#define ISO_RAW_H_
+
+// Functions to inspect packed iso messages directly, without decoding them into the internal fields.
+// They do not use any global state of iso_8583 module, so they can be called from any thread.
+
+struct fi_spec;
+
+/**
+ * Struct to store the location of a field in the packed message.
+ */
+struct iso_raw_field
+{
+	int offset; // Offset of field data (after length prefix) from the start of message, -1 if field is not set.
+	int length; // Length of field data.
+};
+
+/**
+ * @brief Gets mti from packed message.
+ * @param[in] message The packed message.
+ * @param[in] length The packed message length.
+ * @param[out] mti The buffer to store the mti (FI_MTI_LEN_BYTES + 1 bytes).
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_raw_get_mti(const char *message, int length, char *mti);
+
+/**
+ * @brief Check if field is up in the bitmap of packed message.
+ * @param[in] message The packed message.
+ * @param[in] length The packed message length.
+ * @param[in] field The field number.
+ * @return Returns 1 case field is set, 0 if it is not set or -1 case error.
+ */
+int iso_raw_is_set_field(const char *message, int length, int field);
+
+/**
+ * @brief Locate fields in the packed message, walking it only until last_field.
+ * Fixed length fields are skipped using the spec length, only length prefix of variable fields are read.
+ * @param[in] message The packed message.
+ * @param[in] length The packed message length.
+ * @param[in] last_field The last field number to be located (FI_NUM_FIELD_MAX to locate all fields).
+ * @param[out] fields Vector with FI_NUM_FIELD_MAX positions (index is field - 1) to store fields location.
+ * @return Returns the offset after last located field or -1 case error.
+ */
+int iso_raw_index_message(const char *message, int length, int last_field, struct iso_raw_field *fields);
+
+/**
+ * @brief Locate fields in the packed message using the given spec (see iso_raw_index_message).
+ * @param[in] spec The spec acquired by fi_spec_acquire (i.e. the same one used to read the located fields).
+ * @param[in] message The packed message.
+ * @param[in] length The packed message length.
+ * @param[in] last_field The last field number to be located (FI_NUM_FIELD_MAX to locate all fields).
+ * @param[out] fields Vector with FI_NUM_FIELD_MAX positions (index is field - 1) to store fields location.
+ * @return Returns the offset after last located field or -1 case error.
+ */
+int iso_raw_spec_index_message(const struct fi_spec *spec, const char *message, int length, int last_field, struct iso_raw_field *fields);
+
+/**
+ * @brief Locate one field in the packed message.
+ * @param[in] message The packed message.
+ * @param[in] length The packed message length.
+ * @param[in] field The field number.
+ * @param[out] raw_field The field location.
+ * @return Returns 1 case field was found, 0 if it is not set or -1 case error.
+ */
+int iso_raw_find_field(const char *message, int length, int field, struct iso_raw_field *raw_field);
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef ISO_SHM_RING_H_
+#define ISO_SHM_RING_H_
+
+#include <stddef.h>
+
+#include "fields_info.h"
+
+// Ring of packed messages in shared memory (shm_open), to hand messages between processes without sockets.
+// Many producers and one consumer (MPSC): producers reserve slots with one CAS, each slot has a sequence number
+// that publishes it, so push and pop do not lock and do not call the kernel. Futex is only used to sleep when the
+// ring is empty (consumer) or full (producers), and to wake them up.
+//
+// Each slot carries the packed message plus its field offsets table (computed by the producer), so the consumer
+// gets field views without parsing the message.
+//
+// Shared memory layout:
+//     header (ISO_SHM_RING_HEADER_LEN bytes, counters in their own cache lines):
+//         char[8]  magic "ISOSHM01";
+//         u32      slot count (power of 2);
+//         u32      slot size (multiple of ISO_SHM_RING_LINE);
+//         u64      head (next position to be reserved by producers);
+//         u64      tail (next position to be consumed);
+//         u32      item signal and consumer waiting flag (futex);
+//         u32      space signal and producers waiting counter (futex);
+//     slots, slot count entries:
+//         u64      sequence (position when free, position + 1 when published);
+//         u32      message length;
+//         u16[128] fields data offset (0xFFFF case field is not set);
+//         u16[128] fields data length;
+//         char[]   packed message.
+
+#define ISO_SHM_RING_MAGIC          "ISOSHM01"
+#define ISO_SHM_RING_MAGIC_LEN      8
+#define ISO_SHM_RING_LINE           64
+#define ISO_SHM_RING_HEADER_LEN     (ISO_SHM_RING_LINE * 5)
+#define ISO_SHM_RING_SLOT_HEADER    (ISO_SHM_RING_LINE * 9)
+#define ISO_SHM_RING_NO_FIELD       0xFFFF
+
+/**
+ * Struct to store a mapped ring.
+ */
+struct iso_shm_ring
+{
+	int fd;
+	unsigned char *data;
+	size_t size;
+	unsigned int slot_count;
+	unsigned int slot_size;
+};
+
+/**
+ * Struct to store a message being consumed, it points into the ring slot until iso_shm_ring_release.
+ */
+struct iso_shm_message
+{
+	const char *message;
+	int length;
+	const unsigned short *offsets;
+	const unsigned short *lengths;
+	unsigned long long position;
+};
+
+/**
+ * @brief Create ring in shared memory (replacing one with the same name).
+ * @param[in] name The shared memory name, i.e. "/iso_auth".
+ * @param[in] slot_count The number of slots (rounded up to power of 2).
+ * @param[in] slot_size The slot size, message capacity is slot_size - ISO_SHM_RING_SLOT_HEADER (rounded up to ISO_SHM_RING_LINE).
+ * @param[out] ring The ring.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_shm_ring_create(const char *name, unsigned int slot_count, unsigned int slot_size, struct iso_shm_ring *ring);
+
+/**
+ * @brief Open ring created by other process.
+ * @param[in] name The shared memory name.
+ * @param[out] ring The ring.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_shm_ring_open(const char *name, struct iso_shm_ring *ring);
+
+/**
+ * @brief Unmap ring (the shared memory is kept until iso_shm_ring_unlink).
+ * @param[in] ring The ring.
+ */
+void iso_shm_ring_close(struct iso_shm_ring *ring);
+
+/**
+ * @brief Remove shared memory name, processes that mapped the ring keep using it.
+ * @param[in] name The shared memory name.
+ * @return Returns 0 to success or -1 case error.
+ */
+int iso_shm_ring_unlink(const char *name);
+
+/**
+ * @brief Push packed message (ASCII charset) with its field offsets table. It can be called by many producers.
+ * @param[in] ring The ring.
+ * @param[in] message The packed message.
+ * @param[in] length The packed message length.
+ * @param[in] timeout_ms Time to wait while ring is full, zero to not wait or negative to wait forever.
+ * @return Returns 0 to success, 1 case ring is full (after timeout) or -1 case error (invalid message or it exceeds slot capacity).
+ */
+int iso_shm_ring_push(struct iso_shm_ring *ring, const char *message, int length, int timeout_ms);
+
+/**
+ * @brief Gets next message, it is kept in the ring until iso_shm_ring_release. Only one consumer can call it.
+ * @param[in] ring The ring.
+ * @param[out] message The message view.
+ * @param[in] timeout_ms Time to wait while ring is empty, zero to not wait or negative to wait forever.
+ * @return Returns 1 case there is a message, 0 case ring is empty (after timeout) or -1 case error.
+ */
+int iso_shm_ring_peek(struct iso_shm_ring *ring, struct iso_shm_message *message, int timeout_ms);
+
+/**
+ * @brief Release message got by iso_shm_ring_peek, its slot can be reused by producers.
+ * @param[in] ring The ring.
+ * @param[in] message The message view.
+ */
+void iso_shm_ring_release(struct iso_shm_ring *ring, const struct iso_shm_message *message);
+
+/**
+ * @brief Gets field data of message view, without parsing the message.
+ * @param[in] message The message view.
+ * @param[in] field The field number.
+ * @param[out] data The pointer to field data (not null terminated).
+ * @param[out] length The field data length.
+ * @return Returns 1 case field is set, 0 if it is not set or -1 case error.
+ */
+int iso_shm_ring_get_field(const struct iso_shm_message *message, int field, const char **data, int *length);
+
+#endif
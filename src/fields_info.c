@@ -1,20 +1,63 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sched.h>
+#include <pthread.h>
 
 #include "fields_info.h"
 #include "debug.h"
 
-static void fi_load_iso_1987();
-static void fi_load_iso_1993();
-static void fi_load_iso_2003();
+struct fi_spec;
 
-static struct fi_field_info fields_info[FI_NUM_FIELD_MAX];
+static void fi_load_iso_1987(struct fi_spec *spec);
+static void fi_load_iso_1993(struct fi_spec *spec);
+static void fi_load_iso_2003(struct fi_spec *spec);
+static void fi_load_conformance_1987(struct fi_spec *spec);
+static void fi_load_conformance_1993(struct fi_spec *spec);
 
 #define MTI_1 "012"      // {"0", "1", "2"}                          First position;
 #define MTI_2 "12345678" // {"1", "2", "3", "4", "5", "6", "7", "8"} Second position;
 #define MTI_3 "01234567" // {"0", "1", "2", "3", "4", "5", "6", "7"} Third position;
 #define MTI_4 "012345"   // {"0", "1", "2", "3", "4", "5"}           Fourth position.
 
+// Number of valid mti (combinations of MTI_1 - MTI_4 positions).
+#define MTI_COMBINATIONS (3 * 8 * 8 * 6)
+
+// Fields info and conformance rules, the current spec is replaced as a whole and readers may still use the previous one.
+struct fi_spec
+{
+	int references;
+	unsigned int generation;
+	struct fi_field_info fields_info[FI_NUM_FIELD_MAX];
+	struct fi_conformance_rule conformance_rules[FI_CONFORMANCE_RULES_MAX];
+	int conformance_rule_count;
+	unsigned char conformance_index[MTI_COMBINATIONS]; // Rule index plus one by mti, zero case there is no rule.
+};
+
+// Spec used before fi_init_field_info (all fields are empty), it is never released.
+static struct fi_spec empty_spec;
+
+// Current spec, read through the thread cache (see fi_thread_spec) or inside read-side sections (see fi_read_lock).
+static struct fi_spec *current_spec = &empty_spec;
+
+// Read-side epoch and number of readers of each epoch parity, the writer waits readers of the previous epoch before
+// releasing its reference of a spec. Only fi_spec_acquire enters read-side sections, so lookups do not touch them.
+static unsigned int spec_epoch = 0;
+static int spec_readers[2];
+
+// Spec cached by each thread (holds a reference), valid while it is still the current spec (see fi_thread_spec).
+static _Thread_local const struct fi_spec *thread_spec = NULL;
+
+// Key to release the spec cached by a thread when it exits.
+static pthread_key_t thread_spec_key;
+static pthread_once_t thread_spec_once = PTHREAD_ONCE_INIT;
+
+// Serializes writers (fi_init_field_info, fi_set_field_info and fi_set_conformance_rule).
+static pthread_mutex_t spec_writer_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Incremented every time a spec is published, so cached data derived from it can be invalidated.
+static unsigned int spec_generation = 0;
+
 int fi_is_valid_mti(const char *mti)
 {
 	char mti_1 = 0;
@@ -38,31 +81,178 @@ int fi_is_valid_mti(const char *mti)
 	return 0;
 }
 
+// Enter read-side section, the current spec is not released until fi_read_unlock. Returns the epoch to leave the section.
+static unsigned int fi_read_lock()
+{
+	unsigned int epoch = 0;
+
+	for(;;)
+	{
+		epoch = __atomic_load_n(&spec_epoch, __ATOMIC_SEQ_CST);
+		__atomic_add_fetch(&spec_readers[epoch & 1], 1, __ATOMIC_SEQ_CST);
+
+		// Writer may have moved to the next epoch before it saw this reader.
+		if(__atomic_load_n(&spec_epoch, __ATOMIC_SEQ_CST) == epoch)
+		{
+			return epoch;
+		}
+
+		__atomic_sub_fetch(&spec_readers[epoch & 1], 1, __ATOMIC_SEQ_CST);
+	}
+}
+
+// Leave read-side section.
+static void fi_read_unlock(unsigned int epoch)
+{
+	__atomic_sub_fetch(&spec_readers[epoch & 1], 1, __ATOMIC_RELEASE);
+}
+
+// Release reference of spec, it is freed by the last one.
+static void fi_spec_unref(struct fi_spec *spec)
+{
+	if(spec != &empty_spec && __atomic_sub_fetch(&spec->references, 1, __ATOMIC_ACQ_REL) == 0)
+	{
+		free(spec);
+	}
+}
+
+// Release spec cached by an exiting thread.
+static void fi_thread_spec_destroy(void *spec)
+{
+	fi_spec_release((const struct fi_spec *) spec);
+
+	// Later destructors (of other keys) can still get the spec, it is acquired again instead of released twice.
+	thread_spec = NULL;
+}
+
+// Create key of thread cached spec (once).
+static void fi_thread_spec_key_create()
+{
+	pthread_key_create(&thread_spec_key, fi_thread_spec_destroy);
+}
+
+// Gets current spec through the thread cache. The cached spec can not be released (or its address reused) while
+// this thread holds it, so the fast path is a single load of current spec, without writes to shared counters.
+static const struct fi_spec *fi_thread_spec()
+{
+	const struct fi_spec *spec = thread_spec;
+
+	if(spec != NULL && spec == __atomic_load_n(&current_spec, __ATOMIC_ACQUIRE))
+	{
+		return spec;
+	}
+
+	// Spec was replaced: take a reference of the new one (read-side section) and drop the previous one.
+	pthread_once(&thread_spec_once, fi_thread_spec_key_create);
+
+	spec = fi_spec_acquire();
+	pthread_setspecific(thread_spec_key, (void *) spec);
+	fi_spec_release(thread_spec);
+	thread_spec = spec;
+
+	return spec;
+}
+
+// Allocate spec copy of current one (or empty), must be called with writer lock.
+static struct fi_spec *fi_spec_create(int copy_current)
+{
+	struct fi_spec *spec = (struct fi_spec *) malloc(sizeof(struct fi_spec));
+
+	if(spec == NULL)
+	{
+		return NULL;
+	}
+
+	memset(spec, 0, sizeof(struct fi_spec));
+
+	// References of current spec are changed by readers, so only the tables are copied.
+	if(copy_current)
+	{
+		memcpy(spec->fields_info, current_spec->fields_info, sizeof(spec->fields_info));
+		memcpy(spec->conformance_rules, current_spec->conformance_rules, sizeof(spec->conformance_rules));
+		memcpy(spec->conformance_index, current_spec->conformance_index, sizeof(spec->conformance_index));
+		spec->conformance_rule_count = current_spec->conformance_rule_count;
+	}
+
+	spec->references = 1;
+	spec->generation = ++spec_generation;
+
+	return spec;
+}
+
+// Publish spec as current one, wait readers of the previous one and release it. Must be called with writer lock.
+static void fi_spec_publish(struct fi_spec *spec)
+{
+	struct fi_spec *previous = __atomic_exchange_n(&current_spec, spec, __ATOMIC_SEQ_CST);
+	unsigned int epoch = __atomic_load_n(&spec_epoch, __ATOMIC_SEQ_CST);
+
+	// New readers enter the next epoch and see the new spec.
+	__atomic_store_n(&spec_epoch, epoch + 1, __ATOMIC_SEQ_CST);
+
+	while(__atomic_load_n(&spec_readers[epoch & 1], __ATOMIC_SEQ_CST) != 0)
+	{
+		sched_yield();
+	}
+
+	// Specs acquired by fi_spec_acquire are released by their last reference.
+	fi_spec_unref(previous);
+}
+
+// Gets index of mti (0 to MTI_COMBINATIONS - 1) or -1 case mti is invalid.
+static int fi_get_mti_index(const char *mti)
+{
+	if(mti == NULL || !fi_is_valid_mti(mti))
+	{
+		return -1;
+	}
+
+	return (((((int) (strchr(MTI_1, mti[0]) - MTI_1) * 8) + (int) (strchr(MTI_2, mti[1]) - MTI_2)) * 8 +
+		(int) (strchr(MTI_3, mti[2]) - MTI_3)) * 6) + (int) (strchr(MTI_4, mti[3]) - MTI_4);
+}
+
+// Add field in 128 bits mask, same bits order of bitmaps (field 1 is the most significant bit of mask[0]).
+static int fi_add_in_mask(unsigned long long *mask, int field)
+{
+	if(!fi_is_valid_field(field))
+	{
+		return -1;
+	}
+
+	mask[(field - 1) / 64] |= 1ULL << (63 - ((field - 1) % 64));
+
+	return 0;
+}
+
 int fi_is_valid_field(int field)
 {
 	return (field >= FI_NUM_FIELD_MIN && field <= FI_NUM_FIELD_MAX);
 }
 
 int fi_is_valid_field_value(int field, const char *data)
+{
+	if(data != NULL)
+	{
+		return fi_is_valid_field_length(field, strlen(data));
+	}
+
+	return 0;
+}
+
+int fi_is_valid_field_length(int field, int length)
 {
 	struct fi_field_info fi_field;
-	int value_len = 0;
 
-	if(data != NULL && fi_is_valid_field(field))
+	if(length > 0 && fi_is_valid_field(field))
 	{
 		fi_get_field_info(field, &fi_field);
-		value_len = strlen(data);
 
-		if(value_len > 0)
+		if(fi_field.is_variable_field && length <= fi_field.length)
 		{
-			if(fi_field.is_variable_field && value_len <= fi_field.length)
-			{
-				return 1;
-			}
-			else if(value_len == fi_field.length)
-			{
-				return 1;
-			}
+			return 1;
+		}
+		else if(length == fi_field.length)
+		{
+			return 1;
 		}
 	}
 
@@ -86,13 +276,80 @@ int fi_get_field_info(int field, struct fi_field_info *fi_field)
 {
 	if(fi_is_valid_field(field))
 	{
-		*fi_field = fields_info[field - 1];
+		*fi_field = fi_thread_spec()->fields_info[field - 1];
+
+		return 0;
+	}
+
+	return -1;
+}
+
+int fi_set_field_info(int field, const struct fi_field_info *fi_field)
+{
+	struct fi_spec *spec = NULL;
+
+	if(!fi_is_valid_field(field) || fi_field == NULL)
+	{
+		return -1;
+	}
+
+	pthread_mutex_lock(&spec_writer_lock);
+
+	spec = fi_spec_create(1);
+	if(spec == NULL)
+	{
+		pthread_mutex_unlock(&spec_writer_lock);
+		return -1;
+	}
+
+	spec->fields_info[field - 1] = *fi_field;
+	fi_spec_publish(spec);
+
+	pthread_mutex_unlock(&spec_writer_lock);
+
+	return 0;
+}
+
+const struct fi_spec *fi_spec_acquire()
+{
+	struct fi_spec *spec = NULL;
+	unsigned int epoch = fi_read_lock();
+
+	spec = __atomic_load_n(&current_spec, __ATOMIC_SEQ_CST);
+	if(spec != &empty_spec)
+	{
+		__atomic_add_fetch(&spec->references, 1, __ATOMIC_RELAXED);
+	}
+
+	fi_read_unlock(epoch);
+
+	return spec;
+}
+
+void fi_spec_release(const struct fi_spec *spec)
+{
+	if(spec != NULL)
+	{
+		fi_spec_unref((struct fi_spec *) spec);
+	}
+}
+
+int fi_spec_get_field_info(const struct fi_spec *spec, int field, struct fi_field_info *fi_field)
+{
+	if(spec != NULL && fi_is_valid_field(field))
+	{
+		*fi_field = spec->fields_info[field - 1];
 		return 0;
 	}
 
 	return -1;
 }
 
+unsigned int fi_spec_get_generation(const struct fi_spec *spec)
+{
+	return (spec != NULL) ? spec->generation : 0;
+}
+
 int fi_get_field_length(int field)
 {
 	struct fi_field_info fi_field;
@@ -106,15 +363,140 @@ int fi_get_field_length(int field)
 	return -1;
 }
 
+// Set conformance rule of mti in spec (not published yet).
+static int fi_spec_set_conformance_rule(struct fi_spec *spec, const char *mti, const int *required, int required_count, const int *forbidden, int forbidden_count)
+{
+	struct fi_conformance_rule rule;
+	int index = fi_get_mti_index(mti);
+	int i = 0;
+
+	if(index < 0 || (required == NULL && required_count > 0) || (forbidden == NULL && forbidden_count > 0))
+	{
+		return -1;
+	}
+
+	memset(&rule, 0, sizeof(rule));
+	memcpy(rule.mti, mti, FI_MTI_LEN_BYTES);
+
+	for(i = 0; i < required_count; i++)
+	{
+		if(fi_add_in_mask(rule.required, required[i]) != 0)
+		{
+			return -1;
+		}
+	}
+
+	for(i = 0; i < forbidden_count; i++)
+	{
+		if(fi_add_in_mask(rule.forbidden, forbidden[i]) != 0)
+		{
+			return -1;
+		}
+	}
+
+	// Field 1 only tells there is a second bitmap.
+	rule.required[0] &= ~(1ULL << 63);
+	rule.forbidden[0] &= ~(1ULL << 63);
+
+	if(spec->conformance_index[index] == 0)
+	{
+		if(spec->conformance_rule_count >= FI_CONFORMANCE_RULES_MAX)
+		{
+			return -1;
+		}
+
+		spec->conformance_index[index] = (unsigned char) ++spec->conformance_rule_count;
+	}
+
+	spec->conformance_rules[spec->conformance_index[index] - 1] = rule;
+
+	return 0;
+}
+
+int fi_set_conformance_rule(const char *mti, const int *required, int required_count, const int *forbidden, int forbidden_count)
+{
+	struct fi_spec *spec = NULL;
+
+	pthread_mutex_lock(&spec_writer_lock);
+
+	spec = fi_spec_create(1);
+	if(spec == NULL || fi_spec_set_conformance_rule(spec, mti, required, required_count, forbidden, forbidden_count) != 0)
+	{
+		free(spec);
+		pthread_mutex_unlock(&spec_writer_lock);
+		return -1;
+	}
+
+	fi_spec_publish(spec);
+
+	pthread_mutex_unlock(&spec_writer_lock);
+
+	return 0;
+}
+
+int fi_get_conformance_rule(const char *mti, struct fi_conformance_rule *rule)
+{
+	const struct fi_spec *spec = NULL;
+	int index = fi_get_mti_index(mti);
+
+	if(index < 0 || rule == NULL)
+	{
+		return -1;
+	}
+
+	spec = fi_thread_spec();
+	if(spec->conformance_index[index] > 0)
+	{
+		*rule = spec->conformance_rules[spec->conformance_index[index] - 1];
+		return 0;
+	}
+
+	return -1;
+}
+
+int fi_check_conformance(const char *mti, const unsigned long long *bitmap, unsigned long long *missing, unsigned long long *unexpected)
+{
+	struct fi_conformance_rule rule;
+
+	if(bitmap == NULL || missing == NULL || unexpected == NULL || fi_get_conformance_rule(mti, &rule) != 0)
+	{
+		return -1;
+	}
+
+	missing[0] = rule.required[0] & ~bitmap[0];
+	missing[1] = rule.required[1] & ~bitmap[1];
+	unexpected[0] = rule.forbidden[0] & bitmap[0];
+	unexpected[1] = rule.forbidden[1] & bitmap[1];
+
+	return ((missing[0] | missing[1] | unexpected[0] | unexpected[1]) != 0);
+}
+
+unsigned int fi_get_generation()
+{
+	return fi_thread_spec()->generation;
+}
+
+int fi_field_size_of_length(const struct fi_field_info *fi_field)
+{
+	int size_of_length = 1;
+	int length = 0;
+
+	// Number of digits of length (i.e. 3 for 999).
+	for(length = fi_field->length; length >= 10; length /= 10)
+	{
+		size_of_length++;
+	}
+
+	return size_of_length;
+}
+
 int fi_get_size_length_of_variable_field(int field)
 {
 	struct fi_field_info fi_field;
-	char int_str[8];
 
-	if(fi_is_variable_field_length(field) > -1 && fi_get_field_info(field, &fi_field) == 0)
+	if(fi_get_field_info(field, &fi_field) == 0)
 	{
-		sprintf(int_str, "%d", fi_field.length);
-		return strlen(int_str);
+		return fi_field_size_of_length(&fi_field);
 	}
 
 	return -1;
@@ -137,298 +519,387 @@ struct fi_field_info fi_mount_field_info(const char *type, int is_variable_field
 
 int fi_init_field_info(int iso_version)
 {
+	struct fi_spec *spec = NULL;
 	int ret = -1;
 
+	pthread_mutex_lock(&spec_writer_lock);
+
+	spec = fi_spec_create(0);
+	if(spec == NULL)
+	{
+		pthread_mutex_unlock(&spec_writer_lock);
+		return -1;
+	}
+
 	switch(iso_version)
 	{
 		case FI_ISO8583_1987:
-			fi_load_iso_1987();
+			fi_load_iso_1987(spec);
+			fi_load_conformance_1987(spec);
 			debug_print("ISO 1987 loaded successfully\n");
 			ret = 0;
 			break;
 		case FI_ISO8583_1993:
-			fi_load_iso_1993();
+			fi_load_iso_1993(spec);
+			fi_load_conformance_1993(spec);
 			debug_print("ISO 1993 loaded successfully\n");
 			ret = 0;
 			break;
 		case FI_ISO8583_2003:
-			fi_load_iso_2003();
-			debug_print("Error: ISO 1993 not implemented yet\n");
+			fi_load_iso_2003(spec);
+			debug_print("Error: ISO 2003 not implemented yet\n");
 			break;
 		default:
 			break;
 	}
 
+	// Messages being processed with the previous spec keep it until they release it.
+	if(ret == 0)
+	{
+		fi_spec_publish(spec);
+	}
+	else
+	{
+		free(spec);
+	}
+
+	pthread_mutex_unlock(&spec_writer_lock);
+
 	return ret;
 }
 
 // Load fields info for ISO8583:1987.
-static void fi_load_iso_1987()
-{
-	fields_info[0]   = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,  64, "secondary bitmap", "");
-	fields_info[1]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   19, "primary account number", FI_TYPE__LLVAR);
-	fields_info[2]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "processing code", "");
-	fields_info[3]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "amount, transaction", "");
-	fields_info[4]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "amount, reconciliation", "");
-	fields_info[5]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "amount, cardholder biling", "");
-	fields_info[6]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "date and time, transmission", FI_TYPE__MMDDYYHHMMSS);
-	fields_info[7]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   8, "amount, cardholder biling fee", "");
-	fields_info[8]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   8, "conversion rate, settlement", "");
-	fields_info[9]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   8, "conversion rate, cardholder biling", "");
-	fields_info[10]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "system trace audit number", "");
-	fields_info[11]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "date and time, local transaction", FI_TYPE__HHMINSS);
-	fields_info[12]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, local transaction", FI_TYPE__MMDD);
-	fields_info[13]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, expiration", "");
-	fields_info[14]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, settlement", "");
-	fields_info[15]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, conversion", "");
-	fields_info[16]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, capture", "");
-	fields_info[17]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "merchant type", "");
-	fields_info[18]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, acquiring institution", "");
-	fields_info[19]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, primary account number", "");
-	fields_info[20]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, forwarding institution", "");
-	fields_info[21]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   3, "point of service data code", "");
-	fields_info[22]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "card sequence number", "");
-	fields_info[23]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "function code", "");
-	fields_info[24]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   2, "point of sale condition code", "");
-	fields_info[25]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   2, "point of sale capture code", "");
-	fields_info[26]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   1, "authorization identification response length", "");
-	fields_info[27]  = fi_mount_field_info(FI_TYPE__XN,  FI_VARIABLE_FIELD_FALSE,   8, "amount, transaction fee", "");
-	fields_info[28]  = fi_mount_field_info(FI_TYPE__XN,  FI_VARIABLE_FIELD_FALSE,   8, "amount, settlement fee", "");
-	fields_info[29]  = fi_mount_field_info(FI_TYPE__XN,  FI_VARIABLE_FIELD_FALSE,   8, "amount, transaction processing fee", "");
-	fields_info[30]  = fi_mount_field_info(FI_TYPE__XN,  FI_VARIABLE_FIELD_FALSE,   8, "amount, settlement processing fee", "");
-	fields_info[31]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "acquirer institution identification code", FI_TYPE__LLVAR);
-	fields_info[32]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "fowarding institution identification code", FI_TYPE__LLVAR);
-	fields_info[33]  = fi_mount_field_info(FI_TYPE__NS,  FI_VARIABLE_FIELD_TRUE,   28, "primary account number, extended", FI_TYPE__LLVAR);
-	fields_info[34]  = fi_mount_field_info(FI_TYPE__Z,   FI_VARIABLE_FIELD_TRUE,   37, "track 2 data", FI_TYPE__LLVAR);
-	fields_info[35]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,  104, "track 3 data", FI_TYPE__LLLVAR);
-	fields_info[36]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,  12, "retrieval reference number", "");
-	fields_info[37]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   6, "authorization identificarion response", "");
-	fields_info[38]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   2, "response code", "");
-	fields_info[39]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   3, "service restriction code", "");
-	fields_info[40]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_FALSE,   8, "card acceptor terminal idetification", "");
-	fields_info[41]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_FALSE,  15, "card acceptor identification code", "");
-	fields_info[42]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_FALSE,  40, "card acceptor name/location", FI_TYPE__LLVAR);
-	fields_info[43]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_TRUE,   25, "aditional response data", FI_TYPE__LLVAR);
-	fields_info[44]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_TRUE,   76, "track 1 data", FI_TYPE__LLVAR);
-	fields_info[45]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_TRUE,  999, "addicional data (iso)", FI_TYPE__LLLVAR);
-	fields_info[46]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_TRUE,  999, "additional data, national", FI_TYPE__LLLVAR);
-	fields_info[47]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_TRUE,  999, "additional data, private", FI_TYPE__LLLVAR);
-	fields_info[48]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   3, "currency code, transaction", "");
-	fields_info[49]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   3, "currency code, settlement", "");
-	fields_info[50]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   3, "currency code, cardholder biling", "");
-	fields_info[51]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,   8, "personal identification number (PIN) data", "");
-	fields_info[52]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "security related control information", FI_TYPE__LLVAR);
-	fields_info[53]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_TRUE,  120, "amounts, additional", FI_TYPE__LLLVAR);
-	fields_info[54]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "integrated circuit card system related data", FI_TYPE__LLLVAR);
-	fields_info[55]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved (iso)", FI_TYPE__LLLVAR);
-	fields_info[56]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for national use", FI_TYPE__LLLVAR);
-	fields_info[57]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for national use", FI_TYPE__LLLVAR);
-	fields_info[58]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for national use", FI_TYPE__LLLVAR);
-	fields_info[59]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for national use", FI_TYPE__LLLVAR);
-	fields_info[60]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for private use", FI_TYPE__LLLVAR);
-	fields_info[61]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for private use", FI_TYPE__LLLVAR);
-	fields_info[62]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for private use", FI_TYPE__LLLVAR);
-	fields_info[63]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,  16, "message authentication code (mac)", "");
-	fields_info[64]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,   1, "extended bitmap indicator", "");
-	fields_info[65]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   1, "settlement code", "");
-	fields_info[66]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   2, "extended payment code", "");
-	fields_info[67]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, receiving institution", "");
-	fields_info[68]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, settlement institution", "");
-	fields_info[69]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "network management institution code", "");
-	fields_info[70]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "message number", "");
-	fields_info[71]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "last message number", "");
-	fields_info[72]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "date, action", FI_TYPE__YYMMDD);
-	fields_info[73]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "credits, number", "");
-	fields_info[74]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "credits, reversal number", "");
-	fields_info[75]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "debits, number", "");
-	fields_info[76]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "debits, reversal number", "");
-	fields_info[77]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "transfer number", "");
-	fields_info[78]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "transfer, reversal number", "");
-	fields_info[79]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "inquiries, number", "");
-	fields_info[80]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "authorizations, number", "");
-	fields_info[81]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "credits, processing fee amount", "");
-	fields_info[82]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "credits, transaction fee amount", "");
-	fields_info[83]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "debits, processing fee amount", "");
-	fields_info[84]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "debits, transaction fee amount", "");
-	fields_info[85]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "credits, total amount", "");
-	fields_info[86]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "credits, reversal amount", "");
-	fields_info[87]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "debits, total amount", "");
-	fields_info[88]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "debits, reversal amount", "");
-	fields_info[89]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  42, "original data elements", "");
-	fields_info[90]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   1, "file update code", "");
-	fields_info[91]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   2, "file securiry code", "");
-	fields_info[92]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   5, "response indicator", "");
-	fields_info[93]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   7, "service indicator", "");
-	fields_info[94]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,  42, "replacement amounts", "");
-	fields_info[95]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,  64, "message securiry code", "");
-	fields_info[96]  = fi_mount_field_info(FI_TYPE__XN,  FI_VARIABLE_FIELD_FALSE,  16, "amount, net settlement", "");
-	fields_info[97]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_FALSE,  25, "payee", "");
-	fields_info[98]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "settlement institution identification code", FI_TYPE__LLVAR);
-	fields_info[99]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "receiving institution identification code", FI_TYPE__LLVAR);
-	fields_info[100] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   17, "file name", FI_TYPE__LLVAR);
-	fields_info[101] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   28, "account identification 1", FI_TYPE__LLVAR);
-	fields_info[102] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   28, "account identification 2", FI_TYPE__LLVAR);
-	fields_info[103] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  100, "transaction description", FI_TYPE__LLLVAR);
-	fields_info[104] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
-	fields_info[105] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
-	fields_info[106] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
-	fields_info[107] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
-	fields_info[108] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
-	fields_info[109] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
-	fields_info[110] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
-	fields_info[111] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
-	fields_info[112] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
-	fields_info[113] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
-	fields_info[114] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
-	fields_info[115] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
-	fields_info[116] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
-	fields_info[117] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
-	fields_info[118] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
-	fields_info[119] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
-	fields_info[120] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
-	fields_info[121] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
-	fields_info[122] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
-	fields_info[123] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
-	fields_info[124] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
-	fields_info[125] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
-	fields_info[126] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
-	fields_info[127] = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,  64, "message authentication code", "");
+static void fi_load_iso_1987(struct fi_spec *spec)
+{
+	spec->fields_info[0]   = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,  64, "secondary bitmap", "");
+	spec->fields_info[1]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   19, "primary account number", FI_TYPE__LLVAR);
+	spec->fields_info[2]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "processing code", "");
+	spec->fields_info[3]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "amount, transaction", "");
+	spec->fields_info[4]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "amount, reconciliation", "");
+	spec->fields_info[5]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "amount, cardholder biling", "");
+	spec->fields_info[6]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "date and time, transmission", FI_TYPE__MMDDHHMMSS);
+	spec->fields_info[7]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   8, "amount, cardholder biling fee", "");
+	spec->fields_info[8]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   8, "conversion rate, settlement", "");
+	spec->fields_info[9]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   8, "conversion rate, cardholder biling", "");
+	spec->fields_info[10]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "system trace audit number", "");
+	spec->fields_info[11]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "date and time, local transaction", FI_TYPE__HHMINSS);
+	spec->fields_info[12]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, local transaction", FI_TYPE__MMDD);
+	spec->fields_info[13]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, expiration", "");
+	spec->fields_info[14]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, settlement", "");
+	spec->fields_info[15]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, conversion", "");
+	spec->fields_info[16]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, capture", "");
+	spec->fields_info[17]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "merchant type", "");
+	spec->fields_info[18]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, acquiring institution", "");
+	spec->fields_info[19]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, primary account number", "");
+	spec->fields_info[20]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, forwarding institution", "");
+	spec->fields_info[21]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   3, "point of service data code", "");
+	spec->fields_info[22]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "card sequence number", "");
+	spec->fields_info[23]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "function code", "");
+	spec->fields_info[24]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   2, "point of sale condition code", "");
+	spec->fields_info[25]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   2, "point of sale capture code", "");
+	spec->fields_info[26]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   1, "authorization identification response length", "");
+	spec->fields_info[27]  = fi_mount_field_info(FI_TYPE__XN,  FI_VARIABLE_FIELD_FALSE,   8, "amount, transaction fee", "");
+	spec->fields_info[28]  = fi_mount_field_info(FI_TYPE__XN,  FI_VARIABLE_FIELD_FALSE,   8, "amount, settlement fee", "");
+	spec->fields_info[29]  = fi_mount_field_info(FI_TYPE__XN,  FI_VARIABLE_FIELD_FALSE,   8, "amount, transaction processing fee", "");
+	spec->fields_info[30]  = fi_mount_field_info(FI_TYPE__XN,  FI_VARIABLE_FIELD_FALSE,   8, "amount, settlement processing fee", "");
+	spec->fields_info[31]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "acquirer institution identification code", FI_TYPE__LLVAR);
+	spec->fields_info[32]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "fowarding institution identification code", FI_TYPE__LLVAR);
+	spec->fields_info[33]  = fi_mount_field_info(FI_TYPE__NS,  FI_VARIABLE_FIELD_TRUE,   28, "primary account number, extended", FI_TYPE__LLVAR);
+	spec->fields_info[34]  = fi_mount_field_info(FI_TYPE__Z,   FI_VARIABLE_FIELD_TRUE,   37, "track 2 data", FI_TYPE__LLVAR);
+	spec->fields_info[35]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,  104, "track 3 data", FI_TYPE__LLLVAR);
+	spec->fields_info[36]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,  12, "retrieval reference number", "");
+	spec->fields_info[37]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   6, "authorization identificarion response", "");
+	spec->fields_info[38]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   2, "response code", "");
+	spec->fields_info[39]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   3, "service restriction code", "");
+	spec->fields_info[40]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_FALSE,   8, "card acceptor terminal idetification", "");
+	spec->fields_info[41]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_FALSE,  15, "card acceptor identification code", "");
+	spec->fields_info[42]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_FALSE,  40, "card acceptor name/location", FI_TYPE__LLVAR);
+	spec->fields_info[43]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_TRUE,   25, "aditional response data", FI_TYPE__LLVAR);
+	spec->fields_info[44]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_TRUE,   76, "track 1 data", FI_TYPE__LLVAR);
+	spec->fields_info[45]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_TRUE,  999, "addicional data (iso)", FI_TYPE__LLLVAR);
+	spec->fields_info[46]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_TRUE,  999, "additional data, national", FI_TYPE__LLLVAR);
+	spec->fields_info[47]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_TRUE,  999, "additional data, private", FI_TYPE__LLLVAR);
+	spec->fields_info[48]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   3, "currency code, transaction", "");
+	spec->fields_info[49]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   3, "currency code, settlement", "");
+	spec->fields_info[50]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   3, "currency code, cardholder biling", "");
+	spec->fields_info[51]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,   8, "personal identification number (PIN) data", "");
+	spec->fields_info[52]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "security related control information", FI_TYPE__LLVAR);
+	spec->fields_info[53]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_TRUE,  120, "amounts, additional", FI_TYPE__LLLVAR);
+	spec->fields_info[54]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "integrated circuit card system related data", FI_TYPE__LLLVAR);
+	spec->fields_info[55]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved (iso)", FI_TYPE__LLLVAR);
+	spec->fields_info[56]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[57]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[58]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[59]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[60]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for private use", FI_TYPE__LLLVAR);
+	spec->fields_info[61]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for private use", FI_TYPE__LLLVAR);
+	spec->fields_info[62]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for private use", FI_TYPE__LLLVAR);
+	spec->fields_info[63]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,  16, "message authentication code (mac)", "");
+	spec->fields_info[64]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,   1, "extended bitmap indicator", "");
+	spec->fields_info[65]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   1, "settlement code", "");
+	spec->fields_info[66]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   2, "extended payment code", "");
+	spec->fields_info[67]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, receiving institution", "");
+	spec->fields_info[68]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, settlement institution", "");
+	spec->fields_info[69]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "network management institution code", "");
+	spec->fields_info[70]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "message number", "");
+	spec->fields_info[71]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "last message number", "");
+	spec->fields_info[72]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "date, action", FI_TYPE__YYMMDD);
+	spec->fields_info[73]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "credits, number", "");
+	spec->fields_info[74]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "credits, reversal number", "");
+	spec->fields_info[75]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "debits, number", "");
+	spec->fields_info[76]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "debits, reversal number", "");
+	spec->fields_info[77]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "transfer number", "");
+	spec->fields_info[78]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "transfer, reversal number", "");
+	spec->fields_info[79]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "inquiries, number", "");
+	spec->fields_info[80]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "authorizations, number", "");
+	spec->fields_info[81]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "credits, processing fee amount", "");
+	spec->fields_info[82]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "credits, transaction fee amount", "");
+	spec->fields_info[83]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "debits, processing fee amount", "");
+	spec->fields_info[84]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "debits, transaction fee amount", "");
+	spec->fields_info[85]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "credits, total amount", "");
+	spec->fields_info[86]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "credits, reversal amount", "");
+	spec->fields_info[87]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "debits, total amount", "");
+	spec->fields_info[88]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "debits, reversal amount", "");
+	spec->fields_info[89]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  42, "original data elements", "");
+	spec->fields_info[90]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   1, "file update code", "");
+	spec->fields_info[91]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   2, "file securiry code", "");
+	spec->fields_info[92]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   5, "response indicator", "");
+	spec->fields_info[93]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   7, "service indicator", "");
+	spec->fields_info[94]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,  42, "replacement amounts", "");
+	spec->fields_info[95]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,  64, "message securiry code", "");
+	spec->fields_info[96]  = fi_mount_field_info(FI_TYPE__XN,  FI_VARIABLE_FIELD_FALSE,  16, "amount, net settlement", "");
+	spec->fields_info[97]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_FALSE,  25, "payee", "");
+	spec->fields_info[98]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "settlement institution identification code", FI_TYPE__LLVAR);
+	spec->fields_info[99]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "receiving institution identification code", FI_TYPE__LLVAR);
+	spec->fields_info[100] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   17, "file name", FI_TYPE__LLVAR);
+	spec->fields_info[101] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   28, "account identification 1", FI_TYPE__LLVAR);
+	spec->fields_info[102] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   28, "account identification 2", FI_TYPE__LLVAR);
+	spec->fields_info[103] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  100, "transaction description", FI_TYPE__LLLVAR);
+	spec->fields_info[104] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
+	spec->fields_info[105] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
+	spec->fields_info[106] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
+	spec->fields_info[107] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
+	spec->fields_info[108] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
+	spec->fields_info[109] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
+	spec->fields_info[110] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
+	spec->fields_info[111] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[112] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[113] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[114] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[115] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[116] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[117] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[118] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[119] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
+	spec->fields_info[120] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
+	spec->fields_info[121] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
+	spec->fields_info[122] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
+	spec->fields_info[123] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
+	spec->fields_info[124] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
+	spec->fields_info[125] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
+	spec->fields_info[126] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
+	spec->fields_info[127] = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,  64, "message authentication code", "");
 }
 
 // Load fields info for ISO8583:1993.
-static void fi_load_iso_1993()
-{
-	fields_info[0]   = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,   8, "secondary bitmap (optional)", "");
-	fields_info[1]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   19, "primary account number", FI_TYPE__LLVAR);
-	fields_info[2]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "processing code", "");
-	fields_info[3]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "amount, transaction", "");
-	fields_info[4]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "amount, reconciliation", "");
-	fields_info[5]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "amount, cardholder biling", "");
-	fields_info[6]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "date and time, transmission", FI_TYPE__MMDDYYHHMMSS);
-	fields_info[7]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   8, "amount, cardholder biling fee", "");
-	fields_info[8]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   8, "conversion rate, reconciliation", "");
-	fields_info[9]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   8, "conversion rate, cardholder biling", "");
-	fields_info[10]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "system trace audit number", "");
-	fields_info[11]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "date and time, local transaction", FI_TYPE__MMDDYYHHMMSS);
-	fields_info[12]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, effective", FI_TYPE__YYMM);
-	fields_info[13]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, expiration", FI_TYPE__YYMM);
-	fields_info[14]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "date, settlement", FI_TYPE__YYMMDD);
-	fields_info[15]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, conversion", FI_TYPE__MMDD);
-	fields_info[16]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, capture", FI_TYPE__MMDD);
-	fields_info[17]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "merchant type", "");
-	fields_info[18]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, acquiring institution", "");
-	fields_info[19]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, primary account number", "");
-	fields_info[20]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, forwarding institution", "");
-	fields_info[21]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,  12, "point of service data code", "");
-	fields_info[22]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "card sequence number", "");
-	fields_info[23]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "function code", "");
-	fields_info[24]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "message reason code", "");
-	fields_info[25]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "card receptor business code", "");
-	fields_info[26]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   1, "approval code length", "");
-	fields_info[27]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "date, reconciliation", FI_TYPE__YYMMDD);
-	fields_info[28]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "reconciliation indicator", "");
-	fields_info[29]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  24, "amount original", "");
-	fields_info[30]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   99, "acquirer reference data", FI_TYPE__LLVAR);
-	fields_info[31]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "acquirer institution identification code", FI_TYPE__LLVAR);
-	fields_info[32]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "fowarding institution identification code", FI_TYPE__LLVAR);
-	fields_info[33]  = fi_mount_field_info(FI_TYPE__NS,  FI_VARIABLE_FIELD_TRUE,   28, "primary account number, extended", FI_TYPE__LLVAR);
-	fields_info[34]  = fi_mount_field_info(FI_TYPE__Z,   FI_VARIABLE_FIELD_FALSE,  37, "track 2 data", FI_TYPE__LLVAR);
-	fields_info[35]  = fi_mount_field_info(FI_TYPE__Z,   FI_VARIABLE_FIELD_FALSE, 104, "track 3 data", FI_TYPE__LLLVAR);
-	fields_info[36]  = fi_mount_field_info(FI_TYPE__ANP, FI_VARIABLE_FIELD_FALSE,  12, "retrieval reference number", "");
-	fields_info[37]  = fi_mount_field_info(FI_TYPE__ANP, FI_VARIABLE_FIELD_FALSE,   6, "approval code", "");
-	fields_info[38]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "action code", "");
-	fields_info[39]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "service code", "");
-	fields_info[40]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_FALSE,   8, "card acceptor terminal idetification", "");
-	fields_info[41]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_FALSE,  15, "card acceptor identification code", "");
-	fields_info[42]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   99, "card acceptor name/location", FI_TYPE__LLVAR);
-	fields_info[43]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   99, "aditional response data", FI_TYPE__LLVAR);
-	fields_info[44]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   76, "track 1 data", FI_TYPE__LLVAR);
-	fields_info[45]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  204, "amounts, fees", FI_TYPE__LLLVAR);
-	fields_info[46]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "additional data, national", FI_TYPE__LLLVAR);
-	fields_info[47]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "additional data, private", FI_TYPE__LLLVAR);
-	fields_info[48]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   3, "currency code, transaction", "");
-	fields_info[49]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   3, "currency code, reconciliation", "");
-	fields_info[50]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   3, "currency code, cardholder biling", "");
-	fields_info[51]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,   8, "personal identification number (PIN) data", "");
-	fields_info[52]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_TRUE,   48, "security related control information", FI_TYPE__LLVAR);
-	fields_info[53]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  120, "amounts, additional", FI_TYPE__LLLVAR);
-	fields_info[54]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_TRUE,  255, "integrated circuit card system related data", FI_TYPE__LLLVAR);
-	fields_info[55]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   35, "original data elements", FI_TYPE__LLVAR);
-	fields_info[56]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "authorization life cycle code", "");
-	fields_info[57]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "authorizing agent institution identification code", FI_TYPE__LLVAR);
-	fields_info[58]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "transport data", FI_TYPE__LLVAR);
-	fields_info[59]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for national use", FI_TYPE__LLLVAR);
-	fields_info[60]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for national use", FI_TYPE__LLLVAR);
-	fields_info[61]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for national use", FI_TYPE__LLLVAR);
-	fields_info[62]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for national use", FI_TYPE__LLLVAR);
-	fields_info[63]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,   8, "message authentication code field", "");
-	fields_info[64]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,   8, "reserved for ISO use", "");
-	fields_info[65]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  204, "amounts, origial fees", FI_TYPE__LLLVAR);
-	fields_info[66]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   2, "extended payment data", "");
-	fields_info[67]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, receiving institution", "");
-	fields_info[68]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, settlement institution", "");
-	fields_info[69]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, authorizing agent institution", "");
-	fields_info[70]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   8, "message number", "");
-	fields_info[71]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "data record", FI_TYPE__LLLVAR);
-	fields_info[72]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "date, action", FI_TYPE__YYMMDD);
-	fields_info[73]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "credits, number", "");
-	fields_info[74]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "credits, reversal number", "");
-	fields_info[75]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "debits, number", "");
-	fields_info[76]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "debits, reversal number", "");
-	fields_info[77]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "transfer number", "");
-	fields_info[78]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "transfer, reversal number", "");
-	fields_info[79]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "inquiries, number", "");
-	fields_info[80]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "authorizations, number", "");
-	fields_info[81]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "inquiries, reversal number", "");
-	fields_info[82]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "payments, number", "");
-	fields_info[83]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "payments, reversal number", "");
-	fields_info[84]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "fee collections, number", "");
-	fields_info[85]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "credits, amount", "");
-	fields_info[86]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "credits, reversal amount", "");
-	fields_info[87]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "debits, amount", "");
-	fields_info[88]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "debits, reversal amount", "");
-	fields_info[89]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "authorizations, reversal number", "");
-	fields_info[90]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, transaction destination institution", "");
-	fields_info[91]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, transaction originator institution", "");
-	fields_info[92]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "transaction destination institution identification code", FI_TYPE__LLVAR);
-	fields_info[93]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "transaction originator institution identification code", FI_TYPE__LLVAR);
-	fields_info[94]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   99, "card issuer reference data", FI_TYPE__LLVAR);
-	fields_info[95]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_TRUE,  999, "key management data", FI_TYPE__LLLVAR);
-	fields_info[96]  = fi_mount_field_info(FI_TYPE__XN,  FI_VARIABLE_FIELD_FALSE,  16, "amount, net reconciliation", "");
-	fields_info[97]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_FALSE,  25, "payee", "");
-	fields_info[98]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_TRUE,   11, "settlement institution identification code", FI_TYPE__LLVAR);
-	fields_info[99]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "receiving institution identification code", FI_TYPE__LLVAR);
-	fields_info[100] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   17, "file name", FI_TYPE__LLVAR);
-	fields_info[101] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   28, "account identification 1", FI_TYPE__LLVAR);
-	fields_info[102] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   28, "account identification 2", FI_TYPE__LLVAR);
-	fields_info[103] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  100, "transaction description", FI_TYPE__LLLVAR);
-	fields_info[104] = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "credits, chargeback amount", "");
-	fields_info[105] = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "debits, chargeback amount", "");
-	fields_info[106] = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "credits, chargeback number", "");
-	fields_info[107] = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "debits, chargeback number", "");
-	fields_info[108] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   84, "credits, fee amounts", FI_TYPE__LLVAR);
-	fields_info[109] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   84, "debits, fee amounts", FI_TYPE__LLVAR);
-	fields_info[110] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
-	fields_info[111] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
-	fields_info[112] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
-	fields_info[113] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
-	fields_info[114] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
-	fields_info[115] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
-	fields_info[116] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
-	fields_info[117] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
-	fields_info[118] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
-	fields_info[119] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
-	fields_info[120] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
-	fields_info[121] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
-	fields_info[122] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
-	fields_info[123] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
-	fields_info[124] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
-	fields_info[125] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
-	fields_info[126] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
-	fields_info[127] = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,   8, "message authentication code field", "");
+static void fi_load_iso_1993(struct fi_spec *spec)
+{
+	spec->fields_info[0]   = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,   8, "secondary bitmap (optional)", "");
+	spec->fields_info[1]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   19, "primary account number", FI_TYPE__LLVAR);
+	spec->fields_info[2]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "processing code", "");
+	spec->fields_info[3]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "amount, transaction", "");
+	spec->fields_info[4]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "amount, reconciliation", "");
+	spec->fields_info[5]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "amount, cardholder biling", "");
+	spec->fields_info[6]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "date and time, transmission", FI_TYPE__MMDDHHMMSS);
+	spec->fields_info[7]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   8, "amount, cardholder biling fee", "");
+	spec->fields_info[8]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   8, "conversion rate, reconciliation", "");
+	spec->fields_info[9]   = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   8, "conversion rate, cardholder biling", "");
+	spec->fields_info[10]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "system trace audit number", "");
+	spec->fields_info[11]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  12, "date and time, local transaction", FI_TYPE__MMDDYYHHMMSS);
+	spec->fields_info[12]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, effective", FI_TYPE__YYMM);
+	spec->fields_info[13]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, expiration", FI_TYPE__YYMM);
+	spec->fields_info[14]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "date, settlement", FI_TYPE__YYMMDD);
+	spec->fields_info[15]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, conversion", FI_TYPE__MMDD);
+	spec->fields_info[16]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "date, capture", FI_TYPE__MMDD);
+	spec->fields_info[17]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "merchant type", "");
+	spec->fields_info[18]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, acquiring institution", "");
+	spec->fields_info[19]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, primary account number", "");
+	spec->fields_info[20]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, forwarding institution", "");
+	spec->fields_info[21]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,  12, "point of service data code", "");
+	spec->fields_info[22]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "card sequence number", "");
+	spec->fields_info[23]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "function code", "");
+	spec->fields_info[24]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "message reason code", "");
+	spec->fields_info[25]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   4, "card receptor business code", "");
+	spec->fields_info[26]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   1, "approval code length", "");
+	spec->fields_info[27]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "date, reconciliation", FI_TYPE__YYMMDD);
+	spec->fields_info[28]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "reconciliation indicator", "");
+	spec->fields_info[29]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  24, "amount original", "");
+	spec->fields_info[30]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   99, "acquirer reference data", FI_TYPE__LLVAR);
+	spec->fields_info[31]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "acquirer institution identification code", FI_TYPE__LLVAR);
+	spec->fields_info[32]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "fowarding institution identification code", FI_TYPE__LLVAR);
+	spec->fields_info[33]  = fi_mount_field_info(FI_TYPE__NS,  FI_VARIABLE_FIELD_TRUE,   28, "primary account number, extended", FI_TYPE__LLVAR);
+	spec->fields_info[34]  = fi_mount_field_info(FI_TYPE__Z,   FI_VARIABLE_FIELD_FALSE,  37, "track 2 data", FI_TYPE__LLVAR);
+	spec->fields_info[35]  = fi_mount_field_info(FI_TYPE__Z,   FI_VARIABLE_FIELD_FALSE, 104, "track 3 data", FI_TYPE__LLLVAR);
+	spec->fields_info[36]  = fi_mount_field_info(FI_TYPE__ANP, FI_VARIABLE_FIELD_FALSE,  12, "retrieval reference number", "");
+	spec->fields_info[37]  = fi_mount_field_info(FI_TYPE__ANP, FI_VARIABLE_FIELD_FALSE,   6, "approval code", "");
+	spec->fields_info[38]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "action code", "");
+	spec->fields_info[39]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "service code", "");
+	spec->fields_info[40]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_FALSE,   8, "card acceptor terminal idetification", "");
+	spec->fields_info[41]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_FALSE,  15, "card acceptor identification code", "");
+	spec->fields_info[42]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   99, "card acceptor name/location", FI_TYPE__LLVAR);
+	spec->fields_info[43]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   99, "aditional response data", FI_TYPE__LLVAR);
+	spec->fields_info[44]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   76, "track 1 data", FI_TYPE__LLVAR);
+	spec->fields_info[45]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  204, "amounts, fees", FI_TYPE__LLLVAR);
+	spec->fields_info[46]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "additional data, national", FI_TYPE__LLLVAR);
+	spec->fields_info[47]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "additional data, private", FI_TYPE__LLLVAR);
+	spec->fields_info[48]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   3, "currency code, transaction", "");
+	spec->fields_info[49]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   3, "currency code, reconciliation", "");
+	spec->fields_info[50]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_FALSE,   3, "currency code, cardholder biling", "");
+	spec->fields_info[51]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,   8, "personal identification number (PIN) data", "");
+	spec->fields_info[52]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_TRUE,   48, "security related control information", FI_TYPE__LLVAR);
+	spec->fields_info[53]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  120, "amounts, additional", FI_TYPE__LLLVAR);
+	spec->fields_info[54]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_TRUE,  255, "integrated circuit card system related data", FI_TYPE__LLLVAR);
+	spec->fields_info[55]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   35, "original data elements", FI_TYPE__LLVAR);
+	spec->fields_info[56]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "authorization life cycle code", "");
+	spec->fields_info[57]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "authorizing agent institution identification code", FI_TYPE__LLVAR);
+	spec->fields_info[58]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "transport data", FI_TYPE__LLVAR);
+	spec->fields_info[59]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[60]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[61]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[62]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reserved for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[63]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,   8, "message authentication code field", "");
+	spec->fields_info[64]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,   8, "reserved for ISO use", "");
+	spec->fields_info[65]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  204, "amounts, origial fees", FI_TYPE__LLLVAR);
+	spec->fields_info[66]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   2, "extended payment data", "");
+	spec->fields_info[67]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, receiving institution", "");
+	spec->fields_info[68]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, settlement institution", "");
+	spec->fields_info[69]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, authorizing agent institution", "");
+	spec->fields_info[70]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   8, "message number", "");
+	spec->fields_info[71]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "data record", FI_TYPE__LLLVAR);
+	spec->fields_info[72]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   6, "date, action", FI_TYPE__YYMMDD);
+	spec->fields_info[73]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "credits, number", "");
+	spec->fields_info[74]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "credits, reversal number", "");
+	spec->fields_info[75]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "debits, number", "");
+	spec->fields_info[76]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "debits, reversal number", "");
+	spec->fields_info[77]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "transfer number", "");
+	spec->fields_info[78]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "transfer, reversal number", "");
+	spec->fields_info[79]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "inquiries, number", "");
+	spec->fields_info[80]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "authorizations, number", "");
+	spec->fields_info[81]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "inquiries, reversal number", "");
+	spec->fields_info[82]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "payments, number", "");
+	spec->fields_info[83]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "payments, reversal number", "");
+	spec->fields_info[84]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "fee collections, number", "");
+	spec->fields_info[85]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "credits, amount", "");
+	spec->fields_info[86]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "credits, reversal amount", "");
+	spec->fields_info[87]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "debits, amount", "");
+	spec->fields_info[88]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "debits, reversal amount", "");
+	spec->fields_info[89]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "authorizations, reversal number", "");
+	spec->fields_info[90]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, transaction destination institution", "");
+	spec->fields_info[91]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,   3, "country code, transaction originator institution", "");
+	spec->fields_info[92]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "transaction destination institution identification code", FI_TYPE__LLVAR);
+	spec->fields_info[93]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "transaction originator institution identification code", FI_TYPE__LLVAR);
+	spec->fields_info[94]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   99, "card issuer reference data", FI_TYPE__LLVAR);
+	spec->fields_info[95]  = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_TRUE,  999, "key management data", FI_TYPE__LLLVAR);
+	spec->fields_info[96]  = fi_mount_field_info(FI_TYPE__XN,  FI_VARIABLE_FIELD_FALSE,  16, "amount, net reconciliation", "");
+	spec->fields_info[97]  = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_FALSE,  25, "payee", "");
+	spec->fields_info[98]  = fi_mount_field_info(FI_TYPE__AN,  FI_VARIABLE_FIELD_TRUE,   11, "settlement institution identification code", FI_TYPE__LLVAR);
+	spec->fields_info[99]  = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_TRUE,   11, "receiving institution identification code", FI_TYPE__LLVAR);
+	spec->fields_info[100] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   17, "file name", FI_TYPE__LLVAR);
+	spec->fields_info[101] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   28, "account identification 1", FI_TYPE__LLVAR);
+	spec->fields_info[102] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   28, "account identification 2", FI_TYPE__LLVAR);
+	spec->fields_info[103] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  100, "transaction description", FI_TYPE__LLLVAR);
+	spec->fields_info[104] = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "credits, chargeback amount", "");
+	spec->fields_info[105] = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  16, "debits, chargeback amount", "");
+	spec->fields_info[106] = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "credits, chargeback number", "");
+	spec->fields_info[107] = fi_mount_field_info(FI_TYPE__N,   FI_VARIABLE_FIELD_FALSE,  10, "debits, chargeback number", "");
+	spec->fields_info[108] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   84, "credits, fee amounts", FI_TYPE__LLVAR);
+	spec->fields_info[109] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,   84, "debits, fee amounts", FI_TYPE__LLVAR);
+	spec->fields_info[110] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
+	spec->fields_info[111] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
+	spec->fields_info[112] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
+	spec->fields_info[113] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
+	spec->fields_info[114] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for ISO use", FI_TYPE__LLLVAR);
+	spec->fields_info[115] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[116] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[117] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[118] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[119] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[120] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[121] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for national use", FI_TYPE__LLLVAR);
+	spec->fields_info[122] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
+	spec->fields_info[123] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
+	spec->fields_info[124] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
+	spec->fields_info[125] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
+	spec->fields_info[126] = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_TRUE,  999, "reversed for private use", FI_TYPE__LLLVAR);
+	spec->fields_info[127] = fi_mount_field_info(FI_TYPE__B,   FI_VARIABLE_FIELD_FALSE,   8, "message authentication code field", "");
 }
 
 // Load fields info for ISO8583:2003.
-static void fi_load_iso_2003()
+static void fi_load_iso_2003(struct fi_spec *spec)
+{
+	(void) spec;
+}
+
+// Add default conformance rule in spec with field lists terminated by 0.
+static void fi_add_conformance_rule(struct fi_spec *spec, const char *mti, const int *required, const int *forbidden)
+{
+	int required_count = 0;
+	int forbidden_count = 0;
+
+	while(required[required_count] != 0)
+	{
+		required_count++;
+	}
+
+	while(forbidden[forbidden_count] != 0)
+	{
+		forbidden_count++;
+	}
+
+	fi_spec_set_conformance_rule(spec, mti, required, required_count, forbidden, forbidden_count);
+}
+
+// Load default conformance rules for ISO8583:1987 (mandatory fields of common messages).
+static void fi_load_conformance_1987(struct fi_spec *spec)
+{
+	static const int none[]          = {0};
+	static const int response_code[] = {39, 0};
+
+	static const int required_0100[] = {3, 4, 7, 11, 41, 49, 0};
+	static const int required_0110[] = {3, 4, 7, 11, 39, 41, 49, 0};
+	static const int required_0400[] = {3, 4, 7, 11, 41, 49, 90, 0};
+	static const int required_0410[] = {3, 4, 7, 11, 39, 41, 49, 0};
+	static const int required_0800[] = {7, 11, 70, 0};
+	static const int required_0810[] = {7, 11, 39, 70, 0};
+
+	fi_add_conformance_rule(spec, "0100", required_0100, response_code);
+	fi_add_conformance_rule(spec, "0110", required_0110, none);
+	fi_add_conformance_rule(spec, "0200", required_0100, response_code);
+	fi_add_conformance_rule(spec, "0210", required_0110, none);
+	fi_add_conformance_rule(spec, "0400", required_0400, none);
+	fi_add_conformance_rule(spec, "0410", required_0410, none);
+	fi_add_conformance_rule(spec, "0800", required_0800, response_code);
+	fi_add_conformance_rule(spec, "0810", required_0810, none);
+}
+
+// Load default conformance rules for ISO8583:1993 (mandatory fields of common messages).
+static void fi_load_conformance_1993(struct fi_spec *spec)
 {
+	static const int none[]          = {0};
+	static const int action_code[]   = {39, 0};
+
+	static const int required_1100[] = {3, 4, 11, 12, 24, 41, 49, 0};
+	static const int required_1110[] = {3, 4, 11, 12, 39, 41, 49, 0};
+	static const int required_1420[] = {3, 4, 11, 12, 24, 41, 49, 56, 0};
+	static const int required_1804[] = {11, 12, 24, 0};
+	static const int required_1814[] = {11, 12, 24, 39, 0};
+
+	fi_add_conformance_rule(spec, "1100", required_1100, action_code);
+	fi_add_conformance_rule(spec, "1110", required_1110, none);
+	fi_add_conformance_rule(spec, "1200", required_1100, action_code);
+	fi_add_conformance_rule(spec, "1210", required_1110, none);
+	fi_add_conformance_rule(spec, "1420", required_1420, none);
+	fi_add_conformance_rule(spec, "1430", required_1110, none);
+	fi_add_conformance_rule(spec, "1804", required_1804, action_code);
+	fi_add_conformance_rule(spec, "1814", required_1814, none);
 }
@@ -1,75 +1,521 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
+#include <time.h>
 
 #include "iso_8583.h"
+#include "iso_charset.h"
 #include "fields_info.h"
 #include "debug.h"
 
 #define ISO_MASK (unsigned char) 128 // 1000 0000
 #define ISO_BITS (unsigned char)   8
 
+// C/D sign of 'x+n' amount fields.
+#define ISO_AMOUNT_CREDIT   'C'
+#define ISO_AMOUNT_DEBIT    'D'
+
+// Date/time format tokens (see fields_info.h), also the order of clock cache digits.
+#define ISO_TIME_YY         0
+#define ISO_TIME_MM         1
+#define ISO_TIME_DD         2
+#define ISO_TIME_HH         3
+#define ISO_TIME_MIN        4
+#define ISO_TIME_SS         5
+#define ISO_TIME_TOKENS     6
+#define ISO_TIME_TOKEN_LEN  2
+#define ISO_TIME_FORMAT_MAX 16
+#define ISO_TIME_ZONES      2
+#define ISO_TIME_MINUTE     60
+
+// Number of decode plans cached per thread (direct mapped by bitmaps fingerprint).
+#define ISO_PLAN_CACHE_SIZE 32
+
+// Struct: State of iovec generation.
+struct _iso_iov_state
+{
+	struct iovec *iov;
+	int iov_count;
+	int iov_used;
+	char *scratch;
+	int scratch_length;
+	int scratch_used;
+	int length;
+};
+
+// Struct: Header of field data buffer, buffers are shared (copy-on-write) between current message and saved ones.
+struct _iso_field_buffer
+{
+	int references;
+	int reserved;
+	char data[];
+};
+
+// Struct: Field of decode plan.
+struct _iso_plan_field
+{
+	unsigned char field;
+	unsigned char size_of_length; // Zero to fixed fields.
+	unsigned char is_binary;
+	unsigned char reserved;
+	int length;                   // Fixed length or maximum length of variable fields.
+	int offset;                   // Offset from the first field to fixed fields before the first variable one.
+};
+
+// Struct: Decode plan of one message layout (fields info generation and bitmaps), fields are in packing order.
+struct _iso_plan
+{
+	int valid;
+	unsigned int generation;
+	char bitmaps[FI_BITMAP_LEN_BYTES * 2];
+	int field_count;
+	int fixed_count;  // Number of fixed fields before the first variable one.
+	int fixed_length; // Length of fixed fields before the first variable one.
+	struct _iso_plan_field fields[FI_NUM_FIELD_MAX];
+};
+
+// Current message (mti, bitmaps and fields) is per thread, so threads decode and generate messages independently.
+
 // String: Stores the mti.
-static char glb_mti[FI_MTI_LEN_BYTES + 1];
+static _Thread_local char glb_mti[FI_MTI_LEN_BYTES + 1];
 
 // Byte Vector: Store the first bitmap;
-static char glb_first_bitmap[FI_BITMAP_LEN_BYTES];
+static _Thread_local char glb_first_bitmap[FI_BITMAP_LEN_BYTES];
 
 // Byte Vector: Store the second bitmap;
-static char glb_second_bitmap[FI_BITMAP_LEN_BYTES];
-
-// String: Store the iso message;
-static char glb_iso_pack[FI_LEN_MAX_ISO + 1];
+static _Thread_local char glb_second_bitmap[FI_BITMAP_LEN_BYTES];
 
 // Pointer Vector: Store the fields data.
-static char *glb_fields[FI_NUM_FIELD_MAX];
+static _Thread_local char *glb_fields[FI_NUM_FIELD_MAX];
+
+// Int Vector: Store the fields data length.
+static _Thread_local int glb_field_lengths[FI_NUM_FIELD_MAX];
 
 // Auto padding flag.
 static int glb_auto_padding = 0;
 
+// Character set of packed messages, per thread as the current message.
+static _Thread_local int glb_charset = ISO_CHARSET_ASCII;
+
+// Packed size of fields 2-128 (length prefixes included), updated when fields are added or removed.
+static _Thread_local int glb_fields_packed_size = 0;
+
+// String: Decimal digit pairs "00" to "99".
+static const char glb_digit_pairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+// String Vector: Date/time format tokens, indexed by ISO_TIME_* defines.
+static const char *glb_time_tokens[ISO_TIME_TOKENS] = {FI_TYPE__YY, FI_TYPE__MM, FI_TYPE__DD, FI_TYPE__HH, FI_TYPE__MIN, FI_TYPE__SS};
+
+// Struct: Formatted clock of the last used second, digits are only updated when they change.
+struct _iso_clock_cache
+{
+	int valid;
+	time_t second;
+	struct tm tm;
+	char digits[ISO_TIME_TOKENS][ISO_TIME_TOKEN_LEN];
+};
+
+// Per thread clock cache, one for each time zone (ISO_TIME_LOCAL and ISO_TIME_UTC).
+static _Thread_local struct _iso_clock_cache glb_clock_cache[ISO_TIME_ZONES];
+
+// Per thread cache of decode plans.
+static _Thread_local struct _iso_plan glb_plans[ISO_PLAN_CACHE_SIZE];
+
 // Function prototype.
 static int _iso_has_second_bitmap();
+static int _iso_add_in_bitmap(int field);
 
-// Appends new_str to end of original original_str.
-static void _iso_append_str_data(char *original_str, const char *new_str)
+// Appends data to packed message, converting it to the message character set ('b' fields are never converted).
+static int _iso_pack_data(char *message, int *position, const char *data, int length, int convert)
 {
-	char msg[FI_LEN_MAX_ISO];
+	if(length < 0 || *position + length > FI_LEN_MAX_ISO)
+	{
+		debug_print("Error: [%s]: Message exceeds maximum length!\n", __FUNCTION__);
+		return -1;
+	}
 
-	// Create new buffer with original_str and new_str.
-	sprintf(msg, "%s%s", original_str, new_str);
+	if(convert && glb_charset == ISO_CHARSET_EBCDIC)
+	{
+		iso_charset_ascii_to_ebcdic(data, message + *position, length);
+	}
+	else
+	{
+		memcpy(message + *position, data, length);
+	}
 
-	sprintf(original_str, "%s", msg);
+	*position += length;
+
+	return 0;
 }
 
-// Appends new_str in hex format to end of original original_str.
-static void _iso_append_hex_data(char *original_str, const unsigned char *new_str, unsigned int length)
+// Appends length prefix of variable field to packed message.
+static int _iso_pack_length(char *message, int *position, int length, int size_of_length)
 {
-	char msg[FI_LEN_MAX_ISO];
-	char buffer[1024];
+	char buffer[8];
+	int i = 0;
+
+	for(i = size_of_length - 1; i >= 0; i--)
+	{
+		buffer[i] = '0' + (length % 10);
+		length /= 10;
+	}
+
+	if(length > 0)
+	{
+		debug_print("Error: [%s]: Field length exceeds its length prefix!\n", __FUNCTION__);
+		return -1;
+	}
+
+	return _iso_pack_data(message, position, buffer, size_of_length, 1);
+}
+
+// Copies 'length' bytes of packed message into output (null terminated), converting it from the message character set.
+static void _iso_copy_data(const char *data, char *output, int length, int convert)
+{
+	if(convert && glb_charset == ISO_CHARSET_EBCDIC)
+	{
+		iso_charset_ebcdic_to_ascii(data, output, length);
+	}
+	else
+	{
+		memcpy(output, data, length);
+	}
+
+	output[length] = '\0';
+}
+
+// Extracts 'length' bytes of packed message into output, converting it from the message character set.
+static int _iso_unpack_data(const char *message, int message_length, int *position, char *output, int length, int convert)
+{
+	if(length < 0 || *position + length > message_length)
+	{
+		debug_print("Error: [%s]: Truncated ISO message!\n", __FUNCTION__);
+		return -1;
+	}
+
+	_iso_copy_data(message + *position, output, length, convert);
+	*position += length;
+
+	return 0;
+}
+
+// Appends data to iovec array, copying it to the scratch buffer (merged with previous copied data) or referencing it in place.
+static int _iso_iov_append(struct _iso_iov_state *state, const char *data, int length, int convert)
+{
+	struct iovec *last = (state->iov_used > 0) ? &state->iov[state->iov_used - 1] : NULL;
+	char *scratch = state->scratch + state->scratch_used;
+	int copy = (length <= ISO_IOV_INLINE_MAX) || (convert && glb_charset != ISO_CHARSET_ASCII);
+
+	if(length < 0 || state->length + length > FI_LEN_MAX_ISO)
+	{
+		debug_print("Error: [%s]: Message exceeds maximum length!\n", __FUNCTION__);
+		return -1;
+	}
+
+	if(copy && state->scratch_used + length > state->scratch_length)
+	{
+		debug_print("Error: [%s]: No space in scratch buffer!\n", __FUNCTION__);
+		return -1;
+	}
+
+	if(copy && last != NULL && (char *) last->iov_base + last->iov_len == scratch)
+	{
+		_iso_pack_data(state->scratch, &state->scratch_used, data, length, convert);
+		last->iov_len += length;
+		state->length += length;
+		return 0;
+	}
+
+	if(state->iov_used >= state->iov_count)
+	{
+		debug_print("Error: [%s]: No space in iovec array!\n", __FUNCTION__);
+		return -1;
+	}
+
+	if(copy)
+	{
+		_iso_pack_data(state->scratch, &state->scratch_used, data, length, convert);
+		state->iov[state->iov_used].iov_base = scratch;
+	}
+	else
+	{
+		state->iov[state->iov_used].iov_base = (void *) data;
+	}
+
+	state->iov[state->iov_used].iov_len = length;
+	state->iov_used++;
+	state->length += length;
+
+	return 0;
+}
+
+// Gets packed size of field data with its length prefix (case it is variable).
+static int _iso_field_packed_size(int field, int length)
+{
+	if(fi_is_variable_field_length(field) > 0)
+	{
+		return fi_get_size_length_of_variable_field(field) + length;
+	}
+
+	return length;
+}
+
+// Allocate field data buffer with one reference and null terminator.
+static char *_iso_field_alloc(int length)
+{
+	struct _iso_field_buffer *buffer = (struct _iso_field_buffer *) malloc(sizeof(struct _iso_field_buffer) + length + 1);
+
+	if(buffer == NULL)
+	{
+		return NULL;
+	}
+
+	buffer->references = 1;
+	buffer->data[length] = '\0';
+
+	return buffer->data;
+}
+
+// Gets header of field data buffer.
+static struct _iso_field_buffer *_iso_field_header(const char *data)
+{
+	return (struct _iso_field_buffer *) (data - offsetof(struct _iso_field_buffer, data));
+}
+
+// Add reference to field data buffer.
+static char *_iso_field_ref(char *data)
+{
+	if(data != NULL)
+	{
+		__atomic_add_fetch(&_iso_field_header(data)->references, 1, __ATOMIC_RELAXED);
+	}
+
+	return data;
+}
+
+// Remove reference of field data buffer, it is released by the last one.
+static void _iso_field_unref(char *data)
+{
+	if(data != NULL && __atomic_sub_fetch(&_iso_field_header(data)->references, 1, __ATOMIC_ACQ_REL) == 0)
+	{
+		free(_iso_field_header(data));
+	}
+}
+
+// Check if field data buffer is shared with saved messages (so it can not be changed in place).
+static int _iso_field_is_shared(const char *data)
+{
+	return __atomic_load_n(&_iso_field_header(data)->references, __ATOMIC_ACQUIRE) > 1;
+}
+
+// Gets buffer for field data with length (the current one is reused case it has the same length and it is not shared) and add it in the bitmap.
+static char *_iso_reserve_field(int field, int length)
+{
+	char *field_value = NULL;
+
+	if(glb_fields[field - 1] != NULL && glb_field_lengths[field - 1] == length && !_iso_field_is_shared(glb_fields[field - 1]))
+	{
+		return glb_fields[field - 1];
+	}
+
+	field_value = _iso_field_alloc(length);
+	if(field_value == NULL)
+	{
+		return NULL;
+	}
+
+	// Replaced value is released.
+	if(glb_fields[field - 1] != NULL)
+	{
+		glb_fields_packed_size -= _iso_field_packed_size(field, glb_field_lengths[field - 1]);
+		_iso_field_unref(glb_fields[field - 1]);
+	}
+
+	glb_fields[field - 1] = field_value;
+	glb_field_lengths[field - 1] = length;
+	glb_fields_packed_size += _iso_field_packed_size(field, length);
+
+	_iso_add_in_bitmap(field);
+
+	return field_value;
+}
+
+// Store copy of field data (replacing the previous one) and add it in the bitmap.
+static int _iso_store_field(int field, const char *data, int length)
+{
+	char *field_value = _iso_reserve_field(field, length);
+
+	if(field_value == NULL)
+	{
+		return -1;
+	}
+
+	memmove(field_value, data, length);
+
+	return 0;
+}
+
+// Gets number of decimal digits of value.
+static int _iso_count_digits(unsigned long long value)
+{
+	int digits = 1;
+
+	while(value >= 10)
+	{
+		value /= 10;
+		digits++;
+	}
+
+	return digits;
+}
+
+// Write value as 'length' digits (zero padded), two digits at a time from the end, value must fit.
+static void _iso_format_digits(unsigned long long value, char *data, int length)
+{
+	while(length >= 2)
+	{
+		length -= 2;
+		memcpy(data + length, glb_digit_pairs + ((value % 100) * 2), 2);
+		value /= 100;
+	}
+
+	if(length == 1)
+	{
+		data[0] = '0' + (char) (value % 10);
+	}
+}
+
+// Parse decimal digits, returns -1 case there is other character or value overflows.
+static int _iso_parse_digits(const char *data, int length, unsigned long long *value)
+{
+	unsigned long long digit = 0;
+	int i = 0;
+
+	if(length <= 0)
+	{
+		return -1;
+	}
+
+	*value = 0;
+	for(i = 0; i < length; i++)
+	{
+		digit = (unsigned char) data[i] - '0';
+		if(digit > 9 || *value > (ULLONG_MAX - digit) / 10)
+		{
+			return -1;
+		}
+		*value = (*value * 10) + digit;
+	}
+
+	return 0;
+}
+
+// Gets value of date/time token from broken-down time.
+static int _iso_time_token_value(const struct tm *tm, int token)
+{
+	switch(token)
+	{
+		case ISO_TIME_YY:  return tm->tm_year % 100;
+		case ISO_TIME_MM:  return tm->tm_mon + 1;
+		case ISO_TIME_DD:  return tm->tm_mday;
+		case ISO_TIME_HH:  return tm->tm_hour;
+		case ISO_TIME_MIN: return tm->tm_min;
+		default:           return tm->tm_sec;
+	}
+}
+
+// Parse date/time format of field into tokens, returns the number of tokens or -1 case field has no date/time format.
+static int _iso_time_format(int field, int *tokens)
+{
+	struct fi_field_info fi_field;
+	const char *format = NULL;
+	int count = 0;
+	int i = 0;
+
+	if(fi_get_field_info(field, &fi_field) != 0 || fi_field.is_variable_field || strlen((const char *) fi_field.format) != fi_field.length)
+	{
+		return -1;
+	}
+
+	for(format = (const char *) fi_field.format; *format != '\0'; format += ISO_TIME_TOKEN_LEN)
+	{
+		for(i = 0; i < ISO_TIME_TOKENS; i++)
+		{
+			if(strncmp(format, glb_time_tokens[i], ISO_TIME_TOKEN_LEN) == 0)
+			{
+				break;
+			}
+		}
 
-	iso_bin_to_hex_str(new_str, length, buffer);
+		if(i == ISO_TIME_TOKENS || count >= ISO_TIME_FORMAT_MAX)
+		{
+			return -1;
+		}
 
-	// Create new buffer with original_str and new_str.
-	sprintf(msg, "%s%s", original_str, buffer);
+		tokens[count++] = i;
+	}
 
-	sprintf(original_str, "%s", msg);
+	return (count > 0) ? count : -1;
 }
 
-// Extract 'length' bytes from original_str and store it in the output.
-static void _iso_extract_str_data(char *original_str, unsigned int length, char *output)
+// Update clock cache to the second, only seconds digits are updated while it is in the same minute.
+static const struct _iso_clock_cache *_iso_clock_update(time_t second, int zone)
 {
-	char msg[FI_LEN_MAX_ISO];
+	struct _iso_clock_cache *cache = &glb_clock_cache[zone];
+	struct tm tm;
+	int i = 0;
+
+	if(cache->valid && second == cache->second)
+	{
+		return cache;
+	}
+
+	if(cache->valid && second > cache->second && second - cache->second < ISO_TIME_MINUTE - cache->tm.tm_sec)
+	{
+		cache->tm.tm_sec += (int) (second - cache->second);
+		memcpy(cache->digits[ISO_TIME_SS], glb_digit_pairs + (cache->tm.tm_sec * 2), ISO_TIME_TOKEN_LEN);
+	}
+	else
+	{
+		if((zone == ISO_TIME_UTC ? gmtime_r(&second, &tm) : localtime_r(&second, &tm)) == NULL)
+		{
+			return NULL;
+		}
+
+		for(i = 0; i < ISO_TIME_TOKENS; i++)
+		{
+			if(!cache->valid || _iso_time_token_value(&tm, i) != _iso_time_token_value(&cache->tm, i))
+			{
+				memcpy(cache->digits[i], glb_digit_pairs + (_iso_time_token_value(&tm, i) * 2), ISO_TIME_TOKEN_LEN);
+			}
+		}
+
+		cache->tm = tm;
+		cache->valid = 1;
+	}
 
-	// Extract 'length' bytes and put into msg buffer
-	memcpy(msg, original_str, length);
-	msg[length] = '\0';
-	sprintf(output, "%s", msg);
+	cache->second = second;
 
-	// Clean extracted data from original string.
-	memcpy(msg, original_str, strlen(original_str));
-	msg[strlen(original_str)] = '\0';
-	sprintf(original_str, "%s", msg + length);
+	return cache;
+}
+
+// Check if field data is binary ('b' fields).
+static int _iso_is_binary_field(const struct fi_field_info *fi_field)
+{
+	return (strcmp((const char *) fi_field->type, (const char *) FI_TYPE__B) == 0);
 }
 
 // Update the bit one of first bitmap.
@@ -125,7 +571,7 @@ static int _iso_add_in_bitmap(int field)
 
 	if(fi_is_valid_field(field))
 	{
-		if(field < FI_BITMAP_LEN_BITS)
+		if(field <= FI_BITMAP_LEN_BITS)
 		{
 			bitmap = glb_first_bitmap;
 		}
@@ -158,7 +604,7 @@ static int _iso_remove_from_bitmap(int field)
 
 	if(fi_is_valid_field(field))
 	{
-		if(field < FI_BITMAP_LEN_BITS)
+		if(field <= FI_BITMAP_LEN_BITS)
 		{
 			bitmap = glb_first_bitmap;
 		}
@@ -196,21 +642,16 @@ static int _iso_has_second_bitmap()
 	return 0;
 }
 
-// Check if bitmap is valid.
+// Check if bitmap is valid (FI_BITMAP_HEX_BYTES hex digits).
 static int _iso_is_valid_bitmap(const char *bmp_hex_str)
 {
 	int i = 0;
 	char l = 0;
 
-	if(strlen(bmp_hex_str) % 2)
-	{
-		return 0;
-	}
-
-	for(i = 0; i < strlen(bmp_hex_str); i++)
+	for(i = 0; i < FI_BITMAP_HEX_BYTES; i++)
 	{
 		l = *(bmp_hex_str + i);
-		if(isxdigit(l) == 0)
+		if(isxdigit((unsigned char) l) == 0)
 		{
 			return 0;
 		}
@@ -224,7 +665,7 @@ static int _iso_decode_bitmap(const char *bmp_hex_str, char *output)
 {
 	if(_iso_is_valid_bitmap(bmp_hex_str))
 	{
-		iso_hex_str_to_bin(bmp_hex_str, strlen(bmp_hex_str), (unsigned char *) output);
+		iso_hex_str_to_bin(bmp_hex_str, FI_BITMAP_HEX_BYTES, (unsigned char *) output);
 		return 0;
 	}
 
@@ -243,7 +684,7 @@ static int _iso_decode_second_bitmap(const char *bmp_hex_str)
 	return _iso_decode_bitmap(bmp_hex_str, glb_second_bitmap);
 }
 
-// Cleans the internal variables, never call this function before release fields memory with free function.
+// Cleans the internal variables, never call this function before release fields memory with _iso_field_unref function.
 static void _iso_clear_internal_vars()
 {
 	int i = 0;
@@ -251,12 +692,14 @@ static void _iso_clear_internal_vars()
 	memset(glb_mti, 0, sizeof(glb_mti));
 	memset(glb_first_bitmap, 0, sizeof(glb_first_bitmap));
 	memset(glb_second_bitmap, 0, sizeof(glb_second_bitmap));
-	memset(glb_iso_pack, 0, sizeof(glb_iso_pack));
 
 	for(i = 0; i < FI_NUM_FIELD_MAX; i++)
 	{
 		glb_fields[i] = NULL;
+		glb_field_lengths[i] = 0;
 	}
+
+	glb_fields_packed_size = 0;
 }
 
 // Insert padding left in the string.
@@ -361,11 +804,8 @@ void iso_release()
 
 	for(i = 0; i < FI_NUM_FIELD_MAX; i++)
 	{
-		if(glb_fields[i] != NULL)
-		{
-			free(glb_fields[i]);
-			glb_fields[i] = NULL;
-		}
+		_iso_field_unref(glb_fields[i]);
+		glb_fields[i] = NULL;
 	}
 
 	_iso_clear_internal_vars();
@@ -381,6 +821,24 @@ void iso_disable_auto_padding()
 	glb_auto_padding = 0;
 }
 
+int iso_set_charset(int charset)
+{
+	if(charset == ISO_CHARSET_ASCII || charset == ISO_CHARSET_EBCDIC)
+	{
+		glb_charset = charset;
+		return 0;
+	}
+
+	debug_print("Error: [%s]: Invalid charset (%d)\n", __FUNCTION__, charset);
+
+	return -1;
+}
+
+int iso_get_charset()
+{
+	return glb_charset;
+}
+
 int iso_set_mti(const char *mti)
 {
 	if(fi_is_valid_mti(mti))
@@ -408,7 +866,6 @@ int iso_get_mti(char *mti)
 // Auto padding only fill fields with fixed length!
 int iso_add_field(int field, const char *data, int length)
 {
-	char *field_value = NULL;
 	struct fi_field_info fi_field;
 	char buffer[1024];
 
@@ -435,20 +892,9 @@ int iso_add_field(int field, const char *data, int length)
 		}
 	}
 
-	if(fi_is_valid_field_value(field, data))
+	if(fi_is_valid_field_value(field, data) && _iso_store_field(field, data, length) == 0)
 	{
-		field_value = (char *) malloc(length + 1);
-		if(field_value)
-		{
-			memcpy(field_value, data, length);
-			field_value[length] = '\0';
-
-			glb_fields[field - 1] = field_value;
-
-			_iso_add_in_bitmap(field);
-
-			return 0;
-		}
+		return 0;
 	}
 
 	debug_print("Error: [%s]: Invalid field number (%d)\n", __FUNCTION__, field);
@@ -456,7 +902,7 @@ int iso_add_field(int field, const char *data, int length)
 	return -1;
 }
 
-int iso_get_field(int field, char *data)
+int iso_add_field_bytes(int field, const char *data, int length)
 {
 	if(field == 1)
 	{
@@ -464,16 +910,17 @@ int iso_get_field(int field, char *data)
 		return -1;
 	}
 
-	if(fi_is_valid_field(field) && glb_fields[field - 1] != NULL)
+	if(data != NULL && fi_is_valid_field_length(field, length) && _iso_store_field(field, data, length) == 0)
 	{
-		sprintf(data,"%s", glb_fields[field - 1]);
 		return 0;
 	}
 
+	debug_print("Error: [%s]: Invalid field (%d) or length (%d)\n", __FUNCTION__, field, length);
+
 	return -1;
 }
 
-int iso_remove_field(int field)
+int iso_get_field(int field, char *data)
 {
 	if(field == 1)
 	{
@@ -483,144 +930,1053 @@ int iso_remove_field(int field)
 
 	if(fi_is_valid_field(field) && glb_fields[field - 1] != NULL)
 	{
-		free(glb_fields[field - 1]);
-		glb_fields[field - 1] = NULL;
-
-		_iso_remove_from_bitmap(field);
-
+		memcpy(data, glb_fields[field - 1], glb_field_lengths[field - 1] + 1);
 		return 0;
 	}
 
-	debug_print("Error: [%s]: Invalid field number (%d)\n", __FUNCTION__, field);
-
 	return -1;
 }
 
-int iso_is_set_field(int field)
+int iso_get_field_view(int field, const char **data, int *length)
 {
-	if(fi_is_valid_field(field))
+	if(field == 1 || data == NULL || length == NULL)
 	{
-		return (glb_fields[field - 1] != NULL);
+		return -1;
 	}
 
-	return 0;
-}
-
-int iso_generate_message(char *message)
+	if(fi_is_valid_field(field) && glb_fields[field - 1] != NULL)
+	{
+		*data = glb_fields[field - 1];
+		*length = glb_field_lengths[field - 1];
+		return 0;
+	}
+
+	return -1;
+}
+
+int iso_set_field_u64(int field, unsigned long long value)
+{
+	struct fi_field_info fi_field;
+	char *data = NULL;
+	int length = 0;
+
+	if(field == 1 || fi_get_field_info(field, &fi_field) != 0 || strcmp((const char *) fi_field.type, FI_TYPE__N) != 0)
+	{
+		debug_print("Error: [%s]: Field (%d) is not numeric!\n", __FUNCTION__, field);
+		return -1;
+	}
+
+	// Fixed length fields are zero padded, variable length fields have only the value digits.
+	length = _iso_count_digits(value);
+	if(length > fi_field.length)
+	{
+		debug_print("Error: [%s]: Value does not fit in field (%d)!\n", __FUNCTION__, field);
+		return -1;
+	}
+	if(!fi_field.is_variable_field)
+	{
+		length = fi_field.length;
+	}
+
+	data = _iso_reserve_field(field, length);
+	if(data == NULL)
+	{
+		return -1;
+	}
+
+	_iso_format_digits(value, data, length);
+
+	return 0;
+}
+
+int iso_get_field_u64(int field, unsigned long long *value)
+{
+	if(field == 1 || value == NULL || !fi_is_valid_field(field) || glb_fields[field - 1] == NULL)
+	{
+		return -1;
+	}
+
+	return _iso_parse_digits(glb_fields[field - 1], glb_field_lengths[field - 1], value);
+}
+
+int iso_set_field_amount(int field, long long amount)
+{
+	struct fi_field_info fi_field;
+	unsigned long long value = 0;
+	char *data = NULL;
+
+	if(fi_get_field_info(field, &fi_field) != 0 || strcmp((const char *) fi_field.type, FI_TYPE__XN) != 0 || fi_field.is_variable_field)
+	{
+		debug_print("Error: [%s]: Field (%d) is not an amount!\n", __FUNCTION__, field);
+		return -1;
+	}
+
+	// Magnitude of negative amount without overflow.
+	value = (amount < 0) ? (0ULL - (unsigned long long) amount) : (unsigned long long) amount;
+	if(_iso_count_digits(value) > fi_field.length - 1)
+	{
+		debug_print("Error: [%s]: Amount does not fit in field (%d)!\n", __FUNCTION__, field);
+		return -1;
+	}
+
+	data = _iso_reserve_field(field, fi_field.length);
+	if(data == NULL)
+	{
+		return -1;
+	}
+
+	data[0] = (amount < 0) ? ISO_AMOUNT_DEBIT : ISO_AMOUNT_CREDIT;
+	_iso_format_digits(value, data + 1, fi_field.length - 1);
+
+	return 0;
+}
+
+int iso_get_field_amount(int field, long long *amount)
+{
+	struct fi_field_info fi_field;
+	unsigned long long value = 0;
+	const char *data = NULL;
+
+	if(amount == NULL || field == 1 || fi_get_field_info(field, &fi_field) != 0 || strcmp((const char *) fi_field.type, FI_TYPE__XN) != 0)
+	{
+		debug_print("Error: [%s]: Field (%d) is not an amount!\n", __FUNCTION__, field);
+		return -1;
+	}
+
+	if(glb_fields[field - 1] == NULL || glb_field_lengths[field - 1] < 2)
+	{
+		return -1;
+	}
+
+	data = glb_fields[field - 1];
+	if((data[0] != ISO_AMOUNT_CREDIT && data[0] != ISO_AMOUNT_DEBIT) ||
+		_iso_parse_digits(data + 1, glb_field_lengths[field - 1] - 1, &value) != 0 || value > LLONG_MAX)
+	{
+		return -1;
+	}
+
+	*amount = (data[0] == ISO_AMOUNT_DEBIT) ? -(long long) value : (long long) value;
+
+	return 0;
+}
+
+int iso_set_field_tm(int field, const struct tm *tm)
+{
+	int tokens[ISO_TIME_FORMAT_MAX];
+	int count = 0;
+	char *data = NULL;
+	int i = 0;
+
+	count = (field == 1 || tm == NULL) ? -1 : _iso_time_format(field, tokens);
+	if(count < 0)
+	{
+		debug_print("Error: [%s]: Field (%d) has no date/time format!\n", __FUNCTION__, field);
+		return -1;
+	}
+
+	// Negative values (i.e. years before 1900) have no two digits representation.
+	for(i = 0; i < count; i++)
+	{
+		if(_iso_time_token_value(tm, tokens[i]) < 0)
+		{
+			debug_print("Error: [%s]: Invalid date/time of field (%d)!\n", __FUNCTION__, field);
+			return -1;
+		}
+	}
+
+	data = _iso_reserve_field(field, count * ISO_TIME_TOKEN_LEN);
+	if(data == NULL)
+	{
+		return -1;
+	}
+
+	for(i = 0; i < count; i++)
+	{
+		memcpy(data + (i * ISO_TIME_TOKEN_LEN), glb_digit_pairs + ((_iso_time_token_value(tm, tokens[i]) % 100) * 2), ISO_TIME_TOKEN_LEN);
+	}
+
+	return 0;
+}
+
+int iso_set_field_time(int field, time_t time, int zone)
+{
+	const struct _iso_clock_cache *cache = NULL;
+	int tokens[ISO_TIME_FORMAT_MAX];
+	int count = 0;
+	char *data = NULL;
+	int i = 0;
+
+	count = (field == 1 || (zone != ISO_TIME_LOCAL && zone != ISO_TIME_UTC)) ? -1 : _iso_time_format(field, tokens);
+	if(count < 0)
+	{
+		debug_print("Error: [%s]: Field (%d) has no date/time format!\n", __FUNCTION__, field);
+		return -1;
+	}
+
+	cache = _iso_clock_update(time, zone);
+	if(cache == NULL)
+	{
+		return -1;
+	}
+
+	data = _iso_reserve_field(field, count * ISO_TIME_TOKEN_LEN);
+	if(data == NULL)
+	{
+		return -1;
+	}
+
+	for(i = 0; i < count; i++)
+	{
+		memcpy(data + (i * ISO_TIME_TOKEN_LEN), cache->digits[tokens[i]], ISO_TIME_TOKEN_LEN);
+	}
+
+	return 0;
+}
+
+int iso_set_field_now(int field, int zone)
+{
+	return iso_set_field_time(field, time(NULL), zone);
+}
+
+int iso_get_field_tm(int field, struct tm *tm)
+{
+	int tokens[ISO_TIME_FORMAT_MAX];
+	unsigned long long value = 0;
+	int count = 0;
+	int i = 0;
+
+	count = (field == 1 || tm == NULL || !fi_is_valid_field(field) || glb_fields[field - 1] == NULL) ? -1 : _iso_time_format(field, tokens);
+	if(count < 0 || glb_field_lengths[field - 1] != count * ISO_TIME_TOKEN_LEN)
+	{
+		return -1;
+	}
+
+	for(i = 0; i < count; i++)
+	{
+		if(_iso_parse_digits(glb_fields[field - 1] + (i * ISO_TIME_TOKEN_LEN), ISO_TIME_TOKEN_LEN, &value) != 0)
+		{
+			return -1;
+		}
+
+		switch(tokens[i])
+		{
+			case ISO_TIME_YY:
+				tm->tm_year = 100 + (int) value; // Years 2000 - 2099.
+				break;
+			case ISO_TIME_MM:
+				if(value < 1 || value > 12) { return -1; }
+				tm->tm_mon = (int) value - 1;
+				break;
+			case ISO_TIME_DD:
+				if(value < 1 || value > 31) { return -1; }
+				tm->tm_mday = (int) value;
+				break;
+			case ISO_TIME_HH:
+				if(value > 23) { return -1; }
+				tm->tm_hour = (int) value;
+				break;
+			case ISO_TIME_MIN:
+				if(value > 59) { return -1; }
+				tm->tm_min = (int) value;
+				break;
+			default:
+				if(value > 59) { return -1; }
+				tm->tm_sec = (int) value;
+				break;
+		}
+	}
+
+	return 0;
+}
+
+int iso_check_conformance(unsigned long long *missing, unsigned long long *unexpected)
+{
+	unsigned long long bitmap[2] = {0, 0};
+	int i = 0;
+
+	for(i = 0; i < FI_BITMAP_LEN_BYTES; i++)
+	{
+		bitmap[0] = (bitmap[0] << ISO_BITS) | (unsigned char) glb_first_bitmap[i];
+		bitmap[1] = (bitmap[1] << ISO_BITS) | (unsigned char) glb_second_bitmap[i];
+	}
+
+	return fi_check_conformance(glb_mti, bitmap, missing, unexpected);
+}
+
+int iso_remove_field(int field)
+{
+	if(field == 1)
+	{
+		debug_print("Error: [%s]: Reserved use for field (%d)!\n", __FUNCTION__, field);
+		return -1;
+	}
+
+	if(fi_is_valid_field(field) && glb_fields[field - 1] != NULL)
+	{
+		glb_fields_packed_size -= _iso_field_packed_size(field, glb_field_lengths[field - 1]);
+
+		_iso_field_unref(glb_fields[field - 1]);
+		glb_fields[field - 1] = NULL;
+		glb_field_lengths[field - 1] = 0;
+
+		_iso_remove_from_bitmap(field);
+
+		return 0;
+	}
+
+	debug_print("Error: [%s]: Invalid field number (%d)\n", __FUNCTION__, field);
+
+	return -1;
+}
+
+int iso_is_set_field(int field)
+{
+	if(fi_is_valid_field(field))
+	{
+		return (glb_fields[field - 1] != NULL);
+	}
+
+	return 0;
+}
+
+// Check mti and prepare bitmaps to be packed: first bitmap as hex string and the second one in the field 1 (case there is one).
+static int _iso_prepare_bitmaps(char *first_bitmap)
+{
+	if(strlen(glb_mti) != FI_MTI_LEN_BYTES)
+	{
+		return -1;
+	}
+
+	if(_iso_has_second_bitmap())
+	{
+		if(glb_fields[0] == NULL || _iso_field_is_shared(glb_fields[0]))
+		{
+			_iso_field_unref(glb_fields[0]);
+			glb_fields[0] = _iso_field_alloc(FI_BITMAP_HEX_BYTES);
+			if(glb_fields[0] == NULL)
+			{
+				return -1;
+			}
+		}
+
+		iso_bin_to_hex_str((const unsigned char *) glb_second_bitmap, FI_BITMAP_LEN_BYTES, glb_fields[0]);
+		glb_field_lengths[0] = FI_BITMAP_HEX_BYTES;
+		_iso_add_in_bitmap(1);
+	}
+	else if(glb_fields[0] != NULL)
+	{
+		_iso_field_unref(glb_fields[0]);
+		glb_fields[0] = NULL;
+		glb_field_lengths[0] = 0;
+		glb_first_bitmap[0] &= ~ISO_MASK;
+	}
+
+	iso_bin_to_hex_str((const unsigned char *) glb_first_bitmap, FI_BITMAP_LEN_BYTES, first_bitmap);
+
+	return 0;
+}
+
+// Pack message parts into buffer (without null terminator) with spec, returns the message length or -1 case error.
+// Field 1 is packed from the second bitmap (fields[0] is not used), so the parts are not changed.
+// Case mac is informed, packed bytes are absorbed while they are packed and the MAC field (64 or 128) data is replaced by the MAC.
+static int _iso_pack_parts(const struct fi_spec *spec, char *message, const char *mti, const char *first_bitmap, const char *second_bitmap,
+	char *const *fields, const int *field_lengths, struct iso_mac *mac)
+{
+	unsigned char mac_value[ISO_MAC_BLOCK_MAX];
+	int i = 0;
+	int length = 0;
+	int position = 0;
+	int start = 0;
+	int mac_field = 0;
+	int has_second_bitmap = 0;
+	struct fi_field_info fi_field;
+	char bitmap[FI_BITMAP_LEN_BYTES];
+	char bitmap_hex[FI_BITMAP_HEX_BYTES + 1];
+
+	if(strlen(mti) != FI_MTI_LEN_BYTES)
+	{
+		return -1;
+	}
+
+	for(i = 0; i < FI_BITMAP_LEN_BYTES; i++)
+	{
+		has_second_bitmap |= (second_bitmap[i] != 0);
+	}
+
+	// Bit one of first bitmap tells there is a second bitmap.
+	memcpy(bitmap, first_bitmap, FI_BITMAP_LEN_BYTES);
+	bitmap[0] = has_second_bitmap ? (bitmap[0] | ISO_MASK) : (bitmap[0] & ~ISO_MASK);
+
+	// Add mti and bitmaps to iso message, the second bitmap (field 1) is hex string as the first one.
+	iso_bin_to_hex_str((const unsigned char *) bitmap, FI_BITMAP_LEN_BYTES, bitmap_hex);
+	if(_iso_pack_data(message, &position, mti, FI_MTI_LEN_BYTES, 1) != 0 ||
+		_iso_pack_data(message, &position, bitmap_hex, FI_BITMAP_HEX_BYTES, 1) != 0)
+	{
+		return -1;
+	}
+
+	if(has_second_bitmap)
+	{
+		iso_bin_to_hex_str((const unsigned char *) second_bitmap, FI_BITMAP_LEN_BYTES, bitmap_hex);
+		if(_iso_pack_data(message, &position, bitmap_hex, FI_BITMAP_HEX_BYTES, 1) != 0)
+		{
+			return -1;
+		}
+	}
+
+	if(mac != NULL)
+	{
+		mac_field = has_second_bitmap ? FI_NUM_FIELD_MAX : FI_NUM_FIELD_MAX / 2;
+		iso_mac_reset(mac);
+		iso_mac_update(mac, (const unsigned char *) message, position);
+	}
+
+	// Add fields 2 - 128.
+	for(i = 1; i < FI_NUM_FIELD_MAX; i++)
+	{
+		if(fields[i] != NULL && fi_spec_get_field_info(spec, i + 1, &fi_field) == 0)
+		{
+			length = field_lengths[i];
+			start = position;
+
+			// MAC field is the last one, all previous bytes were absorbed.
+			if(i + 1 == mac_field)
+			{
+				iso_mac_final(mac, mac_value);
+				if(iso_mac_format_field(mac, mac_value, length, fields[i]) != 0)
+				{
+					debug_print("Error: [%s]: Invalid length of MAC field (%d)!\n", __FUNCTION__, length);
+					return -1;
+				}
+			}
+
+			if(fi_field.is_variable_field && _iso_pack_length(message, &position, length, fi_field_size_of_length(&fi_field)) != 0)
+			{
+				return -1;
+			}
+
+			if(_iso_pack_data(message, &position, fields[i], length, !_iso_is_binary_field(&fi_field)) != 0)
+			{
+				return -1;
+			}
+
+			if(mac_field > i + 1)
+			{
+				iso_mac_update(mac, (const unsigned char *) message + start, position - start);
+			}
+		}
+	}
+
+	return position;
+}
+
+// Pack message into buffer (without null terminator), returns the message length or -1 case error.
+static int _iso_pack_message(char *message)
+{
+	const struct fi_spec *spec = NULL;
+	char bitmap[FI_BITMAP_HEX_BYTES + 1];
+	int length = 0;
+
+	// Keeps field 1 in sync with the second bitmap.
+	if(_iso_prepare_bitmaps(bitmap) != 0)
+	{
+		return -1;
+	}
+
+	spec = fi_spec_acquire();
+	length = _iso_pack_parts(spec, message, glb_mti, glb_first_bitmap, glb_second_bitmap, glb_fields, glb_field_lengths, NULL);
+	fi_spec_release(spec);
+
+	return length;
+}
+
+int iso_packed_size()
+{
+	return FI_MTI_LEN_BYTES + FI_BITMAP_HEX_BYTES + (_iso_has_second_bitmap() ? FI_BITMAP_HEX_BYTES : 0) + glb_fields_packed_size;
+}
+
+int iso_generate_message(char *message)
+{
+	int length = 0;
+
+	if(message == NULL)
+	{
+		return -1;
+	}
+
+	length = _iso_pack_message(message);
+	if(length < 0)
+	{
+		return -1;
+	}
+
+	message[length] = '\0';
+
+	debug_print("Message generated!\n", __FUNCTION__);
+
+	return 0;
+}
+
+int iso_generate_message_bounded(char *message, int capacity)
+{
+	int size = iso_packed_size();
+
+	if(message == NULL || size > capacity)
+	{
+		debug_print("Error: [%s]: Message length (%d) exceeds capacity (%d)!\n", __FUNCTION__, size, capacity);
+		return -1;
+	}
+
+	return _iso_pack_message(message);
+}
+
+int iso_generate_message_mac(char *message, int capacity, struct iso_mac *mac)
+{
+	const struct fi_spec *spec = NULL;
+	struct fi_field_info fi_field;
+	char bitmap[FI_BITMAP_HEX_BYTES + 1];
+	int mac_field = _iso_has_second_bitmap() ? FI_NUM_FIELD_MAX : FI_NUM_FIELD_MAX / 2;
+	int length = 0;
+
+	if(message == NULL || mac == NULL || mac->algorithm == NULL || fi_get_field_info(mac_field, &fi_field) != 0 ||
+		fi_field.is_variable_field || fi_field.length > mac->algorithm->mac_length * 2)
+	{
+		debug_print("Error: [%s]: Invalid MAC or MAC field (%d)!\n", __FUNCTION__, mac_field);
+		return -1;
+	}
+
+	// Packed size with the MAC field (replacing the current one) is checked before the current message is changed.
+	length = iso_packed_size() + _iso_field_packed_size(mac_field, fi_field.length);
+	if(glb_fields[mac_field - 1] != NULL)
+	{
+		length -= _iso_field_packed_size(mac_field, glb_field_lengths[mac_field - 1]);
+	}
+	if(length > capacity)
+	{
+		debug_print("Error: [%s]: Message length (%d) exceeds capacity (%d)!\n", __FUNCTION__, length, capacity);
+		return -1;
+	}
+
+	// Placeholder of MAC field, so the bitmap and the packed size are final before the MAC is computed.
+	if(_iso_reserve_field(mac_field, fi_field.length) == NULL)
+	{
+		return -1;
+	}
+
+	spec = fi_spec_acquire();
+	length = (_iso_prepare_bitmaps(bitmap) == 0) ? _iso_pack_parts(spec, message, glb_mti, glb_first_bitmap, glb_second_bitmap, glb_fields, glb_field_lengths, mac) : -1;
+	fi_spec_release(spec);
+
+	// Placeholder is not left in the current message.
+	if(length < 0)
+	{
+		iso_remove_field(mac_field);
+	}
+
+	return length;
+}
+
+int iso_generate_message_iov(struct iovec *iov, int iov_count, char *scratch, int scratch_length)
 {
 	int i = 0;
 	int real_i = 0;
+	int length = 0;
 	int size_of_length = 0;
-	char format[16];
+	struct fi_field_info fi_field;
+	struct _iso_iov_state state;
+	char bitmap[FI_BITMAP_HEX_BYTES + 1];
+	char prefix[8];
 
-	if(message == NULL || strlen(glb_mti) != FI_MTI_LEN_BYTES)
+	if(iov == NULL || iov_count <= 0 || scratch == NULL || scratch_length < 0 || _iso_prepare_bitmaps(bitmap) != 0)
 	{
 		return -1;
 	}
 
-	// Add mti to iso message.
-	_iso_append_str_data(glb_iso_pack, glb_mti);
+	memset(&state, 0, sizeof(state));
+	state.iov = iov;
+	state.iov_count = iov_count;
+	state.scratch = scratch;
+	state.scratch_length = scratch_length;
 
-	// Add first bitmap to iso message.
-	_iso_append_hex_data(glb_iso_pack, (const unsigned char *) glb_first_bitmap, FI_BITMAP_LEN_BYTES);
+	// Add mti and first bitmap to iso message.
+	if(_iso_iov_append(&state, glb_mti, FI_MTI_LEN_BYTES, 1) != 0 ||
+		_iso_iov_append(&state, bitmap, FI_BITMAP_HEX_BYTES, 1) != 0)
+	{
+		return -1;
+	}
 
-	// Add second bitmap to iso message (case there is one), it will be stored in the field 1.
-	if(_iso_has_second_bitmap())
+	// Add fields, the second bitmap (field 1) is hex string as the first one.
+	for(i = 0; i < FI_NUM_FIELD_MAX; i++)
 	{
-		glb_fields[0] = (char *) malloc(FI_BITMAP_HEX_BYTES + 1);
-		if(glb_fields[0] != NULL)
+		real_i = i + 1;
+
+		if(glb_fields[i] != NULL && fi_get_field_info(real_i, &fi_field) == 0)
 		{
-			*glb_fields[0] = '\0';
+			length = glb_field_lengths[i];
+
+			if(fi_field.is_variable_field)
+			{
+				size_of_length = 0;
+				if(_iso_pack_length(prefix, &size_of_length, length, fi_get_size_length_of_variable_field(real_i)) != 0 ||
+					_iso_iov_append(&state, prefix, size_of_length, 0) != 0)
+				{
+					return -1;
+				}
+			}
 
-			_iso_append_hex_data(glb_fields[0], (const unsigned char *) glb_second_bitmap, FI_BITMAP_LEN_BYTES);
-			_iso_add_in_bitmap(1);
+			if(_iso_iov_append(&state, glb_fields[i], length, (real_i == 1) || !_iso_is_binary_field(&fi_field)) != 0)
+			{
+				return -1;
+			}
 		}
 	}
 
-	// Add fields.
-	for(i = 0; i < FI_NUM_FIELD_MAX; i++)
+	return state.iov_used;
+}
+
+// Gets decode plan of current bitmaps from the per thread cache, it is built case it is not cached.
+static const struct _iso_plan *_iso_get_plan()
+{
+	struct _iso_plan *plan = NULL;
+	struct fi_field_info fi_field;
+	struct _iso_plan_field *plan_field = NULL;
+	const struct fi_spec *spec = NULL;
+	unsigned int generation = fi_get_generation();
+	unsigned int hash = 2166136261U ^ generation;
+	int i = 0;
+
+	// Fingerprint of bitmaps (FNV-1a).
+	for(i = 0; i < FI_BITMAP_LEN_BYTES; i++)
 	{
-		real_i = i + 1;
+		hash = (hash ^ (unsigned char) glb_first_bitmap[i]) * 16777619U;
+		hash = (hash ^ (unsigned char) glb_second_bitmap[i]) * 16777619U;
+	}
+
+	plan = &glb_plans[hash % ISO_PLAN_CACHE_SIZE];
+	if(plan->valid && plan->generation == generation && memcmp(plan->bitmaps, glb_first_bitmap, FI_BITMAP_LEN_BYTES) == 0 &&
+		memcmp(plan->bitmaps + FI_BITMAP_LEN_BYTES, glb_second_bitmap, FI_BITMAP_LEN_BYTES) == 0)
+	{
+		return plan;
+	}
+
+	// Plan is built from one spec, even if it is replaced meanwhile.
+	spec = fi_spec_acquire();
 
-		if(glb_fields[i] != NULL)
+	plan->valid = 0;
+	plan->generation = fi_spec_get_generation(spec);
+	memcpy(plan->bitmaps, glb_first_bitmap, FI_BITMAP_LEN_BYTES);
+	memcpy(plan->bitmaps + FI_BITMAP_LEN_BYTES, glb_second_bitmap, FI_BITMAP_LEN_BYTES);
+	plan->field_count = 0;
+	plan->fixed_count = 0;
+	plan->fixed_length = 0;
+
+	// Field 1 (second bitmap) is decoded with the first one.
+	for(i = 2; i <= FI_NUM_FIELD_MAX; i++)
+	{
+		if(_iso_is_up_field(i) > 0)
 		{
-			if(fi_is_variable_field_length(real_i))
+			if(fi_spec_get_field_info(spec, i, &fi_field) != 0)
 			{
-				size_of_length = fi_get_size_length_of_variable_field(real_i);
-				sprintf(format, "%%0%dd", size_of_length);
-				sprintf(glb_iso_pack + strlen(glb_iso_pack), format, strlen(glb_fields[i]));
+				fi_spec_release(spec);
+				return NULL;
 			}
 
-			_iso_append_str_data(glb_iso_pack, (const char *) glb_fields[i]);
+			plan_field = &plan->fields[plan->field_count++];
+			plan_field->field = (unsigned char) i;
+			plan_field->size_of_length = fi_field.is_variable_field ? (unsigned char) fi_field_size_of_length(&fi_field) : 0;
+			plan_field->is_binary = (unsigned char) _iso_is_binary_field(&fi_field);
+			plan_field->length = fi_field.length;
+			plan_field->offset = plan->fixed_length;
+
+			if(plan_field->size_of_length == 0 && plan->fixed_count == plan->field_count - 1)
+			{
+				plan->fixed_count++;
+				plan->fixed_length += plan_field->length;
+			}
 		}
 	}
 
-	sprintf(message, "%s", glb_iso_pack);
+	plan->valid = 1;
 
-	debug_print("Message generated!\n", __FUNCTION__);
+	fi_spec_release(spec);
 
-	return 0;
+	return plan;
 }
 
 int iso_decode_message(const char *message)
 {
+	if(message == NULL)
+	{
+		return -1;
+	}
+
+	return iso_decode_message_bytes(message, strlen(message));
+}
+
+// Decode message into current message, case mac is informed the bytes before the MAC field (64 or 128) are absorbed
+// while they are decoded and the MAC is stored in mac_value (when the message has the MAC field).
+static int _iso_decode_message(const char *message, int message_length, struct iso_mac *mac, unsigned char *mac_value)
+{
+	const struct _iso_plan *plan = NULL;
+	const struct _iso_plan_field *plan_field = NULL;
 	int i = 0;
-	struct fi_field_info _fi_field;
+	int j = 0;
 	int length = 0;
-	char msg_to_decode[FI_LEN_MAX_ISO];
-	char buffer[1024];
+	int position = 0;
+	int start = 0;
+	int mac_field = 0;
+	char buffer[FI_BITMAP_HEX_BYTES + 1];
 
-	iso_release();
+	if(message == NULL || message_length < 0)
+	{
+		return -1;
+	}
 
-	// Copy original message to internal buffer.
-	sprintf(msg_to_decode, "%s", message);
+	iso_release();
 
 	// Extract mti.
-	_iso_extract_str_data(msg_to_decode, FI_MTI_LEN_BYTES, glb_mti);
-	if(!fi_is_valid_mti(glb_mti))
+	if(_iso_unpack_data(message, message_length, &position, glb_mti, FI_MTI_LEN_BYTES, 1) != 0 || !fi_is_valid_mti(glb_mti))
 	{
 		debug_print("Error: [%s]: Invalid ISO message!\n", __FUNCTION__);
 		return -1;
 	}
 
 	// Extract first bitmap.
-	_iso_extract_str_data(msg_to_decode, FI_BITMAP_HEX_BYTES, buffer);
-	_iso_decode_first_bitmap(buffer);
+	if(_iso_unpack_data(message, message_length, &position, buffer, FI_BITMAP_HEX_BYTES, 1) != 0 || _iso_decode_first_bitmap(buffer) != 0)
+	{
+		debug_print("Error: [%s]: Invalid ISO message!\n", __FUNCTION__);
+		return -1;
+	}
 
 	// If there is second bitmap we will to extract it also (aka field 1).
 	if(_iso_is_up_bit_one())
 	{
-		_iso_extract_str_data(msg_to_decode, FI_BITMAP_HEX_BYTES, buffer);
-		_iso_decode_second_bitmap(buffer);
+		if(_iso_unpack_data(message, message_length, &position, buffer, FI_BITMAP_HEX_BYTES, 1) != 0 || _iso_decode_second_bitmap(buffer) != 0)
+		{
+			debug_print("Error: [%s]: Invalid ISO message!\n", __FUNCTION__);
+			return -1;
+		}
 	}
 
-	// Extract fields (skip field 1).
-	for(i = 2; i <= FI_NUM_FIELD_MAX; i++)
+	plan = _iso_get_plan();
+	if(plan == NULL || message_length - position < plan->fixed_length)
 	{
-		if(_iso_is_up_field(i) > 0)
+		debug_print("Error: [%s]: Invalid ISO message!\n", __FUNCTION__);
+		iso_release();
+		return -1;
+	}
+
+	if(mac != NULL)
+	{
+		mac_field = _iso_has_second_bitmap() ? FI_NUM_FIELD_MAX : FI_NUM_FIELD_MAX / 2;
+		iso_mac_reset(mac);
+		iso_mac_update(mac, (const unsigned char *) message, position);
+	}
+
+	// Extract fixed fields before the first variable one from their plan offsets, their length was checked with the plan.
+	for(i = 0; i < plan->fixed_count; i++)
+	{
+		plan_field = &plan->fields[i];
+		start = position + plan_field->offset;
+
+		if(plan_field->field == mac_field)
+		{
+			iso_mac_final(mac, mac_value);
+		}
+
+		glb_fields[plan_field->field - 1] = _iso_field_alloc(plan_field->length);
+		if(glb_fields[plan_field->field - 1] == NULL)
+		{
+			iso_release();
+			return -1;
+		}
+
+		_iso_copy_data(message + start, glb_fields[plan_field->field - 1], plan_field->length, !plan_field->is_binary);
+		glb_field_lengths[plan_field->field - 1] = plan_field->length;
+
+		if(mac_field > plan_field->field)
 		{
-			if(fi_get_field_info(i, &_fi_field) == 0)
+			iso_mac_update(mac, (const unsigned char *) message + start, plan_field->length);
+		}
+	}
+
+	position += plan->fixed_length;
+	glb_fields_packed_size += plan->fixed_length;
+
+	// Extract other fields (skip field 1) in plan order.
+	for(i = plan->fixed_count; i < plan->field_count; i++)
+	{
+		plan_field = &plan->fields[i];
+		length = plan_field->length;
+		start = position;
+
+		if(plan_field->field == mac_field)
+		{
+			iso_mac_final(mac, mac_value);
+		}
+
+		if(plan_field->size_of_length > 0)
+		{
+			if(_iso_unpack_data(message, message_length, &position, buffer, plan_field->size_of_length, 1) != 0)
 			{
-				if(_fi_field.is_variable_field)
-				{
-					length = fi_get_size_length_of_variable_field(i);
-					_iso_extract_str_data(msg_to_decode, length, buffer);
-					length = strtol(buffer, NULL, 10);
-				}
-				else
-				{
-					length = _fi_field.length;
-				}
+				iso_release();
+				return -1;
+			}
 
-				glb_fields[i - 1] = (char *) malloc(length + 1);
-				if(glb_fields[i - 1] != NULL)
+			length = 0;
+			for(j = 0; j < plan_field->size_of_length; j++)
+			{
+				if(!isdigit((unsigned char) buffer[j]))
 				{
-					_iso_extract_str_data(msg_to_decode, length, buffer);
-					sprintf(glb_fields[i - 1], "%s", buffer);
+					debug_print("Error: [%s]: Invalid length of field (%d)!\n", __FUNCTION__, plan_field->field);
+					iso_release();
+					return -1;
 				}
+				length = (length * 10) + (buffer[j] - '0');
 			}
 		}
+
+		glb_fields[plan_field->field - 1] = _iso_field_alloc(length);
+		if(glb_fields[plan_field->field - 1] == NULL ||
+			_iso_unpack_data(message, message_length, &position, glb_fields[plan_field->field - 1], length, !plan_field->is_binary) != 0)
+		{
+			iso_release();
+			return -1;
+		}
+
+		glb_field_lengths[plan_field->field - 1] = length;
+		glb_fields_packed_size += plan_field->size_of_length + length;
+
+		if(mac_field > plan_field->field)
+		{
+			iso_mac_update(mac, (const unsigned char *) message + start, position - start);
+		}
+	}
+
+	return 0;
+}
+
+int iso_decode_message_bytes(const char *message, int message_length)
+{
+	return _iso_decode_message(message, message_length, NULL, NULL);
+}
+
+int iso_decode_message_mac(const char *message, int message_length, struct iso_mac *mac)
+{
+	unsigned char mac_value[ISO_MAC_BLOCK_MAX];
+	char expected[ISO_MAC_BLOCK_MAX * 2];
+	int mac_field = 0;
+
+	if(mac == NULL || mac->algorithm == NULL)
+	{
+		return -1;
+	}
+
+	if(_iso_decode_message(message, message_length, mac, mac_value) != 0)
+	{
+		return -1;
+	}
+
+	mac_field = _iso_has_second_bitmap() ? FI_NUM_FIELD_MAX : FI_NUM_FIELD_MAX / 2;
+	if(glb_fields[mac_field - 1] == NULL || iso_mac_format_field(mac, mac_value, glb_field_lengths[mac_field - 1], expected) != 0 ||
+		memcmp(expected, glb_fields[mac_field - 1], glb_field_lengths[mac_field - 1]) != 0)
+	{
+		debug_print("Error: [%s]: Invalid MAC of field (%d)!\n", __FUNCTION__, mac_field);
+		return 1;
+	}
+
+	return 0;
+}
+
+// Copy message (mti, bitmaps and fields), fields data buffers are shared.
+static void _iso_copy_message(struct iso_message *destination, const char *mti, const char *first_bitmap, const char *second_bitmap,
+	char *const *fields, const int *field_lengths, int fields_packed_size)
+{
+	int i = 0;
+
+	memcpy(destination->mti, mti, sizeof(destination->mti));
+	memcpy(destination->first_bitmap, first_bitmap, sizeof(destination->first_bitmap));
+	memcpy(destination->second_bitmap, second_bitmap, sizeof(destination->second_bitmap));
+
+	for(i = 0; i < FI_NUM_FIELD_MAX; i++)
+	{
+		destination->fields[i] = _iso_field_ref(fields[i]);
+		destination->field_lengths[i] = field_lengths[i];
+	}
+
+	destination->fields_packed_size = fields_packed_size;
+}
+
+int iso_message_save(struct iso_message *message)
+{
+	if(message == NULL)
+	{
+		return -1;
+	}
+
+	_iso_copy_message(message, glb_mti, glb_first_bitmap, glb_second_bitmap, glb_fields, glb_field_lengths, glb_fields_packed_size);
+
+	return 0;
+}
+
+int iso_message_load(const struct iso_message *message)
+{
+	struct iso_message current;
+	int i = 0;
+
+	if(message == NULL)
+	{
+		return -1;
+	}
+
+	// References are added before release, so message can be the saved copy of the current one.
+	_iso_copy_message(&current, message->mti, message->first_bitmap, message->second_bitmap,
+		message->fields, message->field_lengths, message->fields_packed_size);
+
+	iso_release();
+
+	memcpy(glb_mti, current.mti, sizeof(glb_mti));
+	memcpy(glb_first_bitmap, current.first_bitmap, sizeof(glb_first_bitmap));
+	memcpy(glb_second_bitmap, current.second_bitmap, sizeof(glb_second_bitmap));
+
+	for(i = 0; i < FI_NUM_FIELD_MAX; i++)
+	{
+		glb_fields[i] = current.fields[i];
+		glb_field_lengths[i] = current.field_lengths[i];
+	}
+
+	glb_fields_packed_size = current.fields_packed_size;
+
+	return 0;
+}
+
+int iso_message_clone(const struct iso_message *source, struct iso_message *clone)
+{
+	if(source == NULL || clone == NULL)
+	{
+		return -1;
+	}
+
+	_iso_copy_message(clone, source->mti, source->first_bitmap, source->second_bitmap,
+		source->fields, source->field_lengths, source->fields_packed_size);
+
+	return 0;
+}
+
+void iso_message_release(struct iso_message *message)
+{
+	int i = 0;
+
+	if(message == NULL)
+	{
+		return;
+	}
+
+	for(i = 0; i < FI_NUM_FIELD_MAX; i++)
+	{
+		_iso_field_unref(message->fields[i]);
+	}
+
+	memset(message, 0, sizeof(struct iso_message));
+}
+
+// Gets frame header length or -1 case frame is invalid.
+static int _iso_frame_header_length(int frame)
+{
+	switch(frame)
+	{
+		case ISO_FRAME_NONE:     return 0;
+		case ISO_FRAME_NEWLINE:  return 0;
+		case ISO_FRAME_BINARY_2: return 2;
+		case ISO_FRAME_BINARY_4: return 4;
+		case ISO_FRAME_ASCII_4:  return 4;
+		default:                 return -1;
+	}
+}
+
+// Write frame header of message length, returns -1 case length does not fit in the header.
+static int _iso_write_frame_header(char *header, int frame, int length)
+{
+	int i = 0;
+
+	switch(frame)
+	{
+		case ISO_FRAME_BINARY_2:
+			if(length > 0xFFFF)
+			{
+				return -1;
+			}
+			header[0] = (char) ((length >> 8) & 0xFF);
+			header[1] = (char) (length & 0xFF);
+			break;
+		case ISO_FRAME_BINARY_4:
+			for(i = 0; i < 4; i++)
+			{
+				header[i] = (char) ((length >> (24 - (i * 8))) & 0xFF);
+			}
+			break;
+		case ISO_FRAME_ASCII_4:
+			if(length > 9999)
+			{
+				return -1;
+			}
+			_iso_format_digits(length, header, 4);
+			break;
+		default:
+			break;
 	}
 
 	return 0;
 }
+
+int iso_generate_batch(const struct iso_message *messages, int count, int frame, char *buffer, int capacity, int *offsets)
+{
+	const struct fi_spec *spec = NULL;
+	const struct iso_message *message = NULL;
+	int header_length = _iso_frame_header_length(frame);
+	int trailer_length = (frame == ISO_FRAME_NEWLINE) ? 1 : 0;
+	int position = 0;
+	int size = 0;
+	int i = 0;
+
+	if(messages == NULL || count < 0 || buffer == NULL || header_length < 0)
+	{
+		return -1;
+	}
+
+	// One spec for the whole batch.
+	spec = fi_spec_acquire();
+
+	for(i = 0; i < count; i++)
+	{
+		message = &messages[i];
+		size = FI_MTI_LEN_BYTES + FI_BITMAP_HEX_BYTES + message->fields_packed_size;
+		size += (memcmp(message->second_bitmap, "\0\0\0\0\0\0\0\0", FI_BITMAP_LEN_BYTES) != 0) ? FI_BITMAP_HEX_BYTES : 0;
+
+		if(size > capacity - position - header_length - trailer_length ||
+			_iso_write_frame_header(buffer + position, frame, size) != 0 ||
+			_iso_pack_parts(spec, buffer + position + header_length, message->mti, message->first_bitmap, message->second_bitmap,
+				message->fields, message->field_lengths, NULL) != size)
+		{
+			debug_print("Error: [%s]: Could not pack message (%d)!\n", __FUNCTION__, i);
+			fi_spec_release(spec);
+			return -1;
+		}
+
+		if(offsets != NULL)
+		{
+			offsets[i] = position;
+		}
+
+		position += header_length + size;
+
+		if(trailer_length > 0)
+		{
+			buffer[position++] = '\n';
+		}
+	}
+
+	fi_spec_release(spec);
+
+	return position;
+}
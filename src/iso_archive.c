@@ -0,0 +1,1207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iso_archive.h"
+#include "iso_raw.h"
+#include "iso_8583.h"
+#include "fields_info.h"
+#include "debug.h"
+
+#define ISO_ARCHIVE_FIELD_TIME          7
+#define ISO_ARCHIVE_FIELD_STAN          11
+#define ISO_ARCHIVE_DICT_FIELDS         4
+#define ISO_ARCHIVE_DELTA_DIGITS_MAX    18
+
+// Record flags.
+#define ISO_ARCHIVE_RECORD_STAN         0x01
+#define ISO_ARCHIVE_RECORD_TIME         0x02
+#define ISO_ARCHIVE_RECORD_DICT         0x04 // Shifted by dictionary field index.
+#define ISO_ARCHIVE_RECORD_RAW          0x80
+
+// Block flags.
+#define ISO_ARCHIVE_BLOCK_STAN_RANGE    0x01
+#define ISO_ARCHIVE_BLOCK_TIME_RANGE    0x02
+#define ISO_ARCHIVE_BLOCK_MTI_OVERFLOW  0x04
+
+#define ISO_ARCHIVE_BLOCK_HEADER_LEN    (4 + 4 + (FI_BITMAP_LEN_BYTES * 4) + 1 + (8 * 4) + 1)
+#define ISO_ARCHIVE_HEX_MASK            (unsigned char) 8 // 1000
+
+static const int glb_dict_fields[ISO_ARCHIVE_DICT_FIELDS] = {18, 22, 41, 49};
+
+struct iso_archive_buffer
+{
+	unsigned char *data;
+	size_t length;
+	size_t capacity;
+};
+
+struct iso_archive_dict
+{
+	int count;
+	int offsets[ISO_ARCHIVE_DICT_MAX];
+	int lengths[ISO_ARCHIVE_DICT_MAX];
+	struct iso_archive_buffer values;
+};
+
+struct iso_archive_writer
+{
+	FILE *file;
+	struct iso_archive_block_info info;
+	struct iso_archive_dict dicts[ISO_ARCHIVE_DICT_FIELDS];
+	struct iso_archive_buffer records;
+	struct iso_archive_buffer residual;
+	unsigned long long last_stan;
+	unsigned long long last_time;
+	int stan_seen;
+	int time_seen;
+};
+
+struct iso_archive_reader
+{
+	FILE *file;
+	struct iso_archive_block_info info;
+	long next_block;
+	unsigned char *body;
+	size_t body_capacity;
+	int body_loaded;
+	size_t cursor;
+	int remaining;
+	const unsigned char *dict_values[ISO_ARCHIVE_DICT_FIELDS][ISO_ARCHIVE_DICT_MAX];
+	int dict_lengths[ISO_ARCHIVE_DICT_FIELDS][ISO_ARCHIVE_DICT_MAX];
+	int dict_counts[ISO_ARCHIVE_DICT_FIELDS];
+	unsigned long long last_stan;
+	unsigned long long last_time;
+};
+
+// Reserve space at the end of buffer.
+static int _iso_archive_reserve(struct iso_archive_buffer *buffer, size_t length)
+{
+	size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+	unsigned char *data = NULL;
+
+	if(buffer->length + length <= buffer->capacity)
+	{
+		return 0;
+	}
+
+	while(buffer->length + length > capacity)
+	{
+		capacity *= 2;
+	}
+
+	data = (unsigned char *) realloc(buffer->data, capacity);
+	if(data == NULL)
+	{
+		return -1;
+	}
+
+	buffer->data = data;
+	buffer->capacity = capacity;
+
+	return 0;
+}
+
+static int _iso_archive_append(struct iso_archive_buffer *buffer, const void *data, size_t length)
+{
+	if(_iso_archive_reserve(buffer, length) != 0)
+	{
+		return -1;
+	}
+
+	memcpy(buffer->data + buffer->length, data, length);
+	buffer->length += length;
+
+	return 0;
+}
+
+static int _iso_archive_append_varint(struct iso_archive_buffer *buffer, unsigned long long value)
+{
+	unsigned char bytes[10];
+	int length = 0;
+
+	do
+	{
+		bytes[length] = value & 0x7F;
+		value >>= 7;
+		if(value)
+		{
+			bytes[length] |= 0x80;
+		}
+		length++;
+	}
+	while(value);
+
+	return _iso_archive_append(buffer, bytes, length);
+}
+
+// Read varint from data, returns -1 case it exceeds the limit.
+static int _iso_archive_read_varint(const unsigned char *data, size_t length, size_t *cursor, unsigned long long *value)
+{
+	int shift = 0;
+
+	*value = 0;
+
+	while(*cursor < length && shift < 64)
+	{
+		*value |= (unsigned long long) (data[*cursor] & 0x7F) << shift;
+		if(!(data[(*cursor)++] & 0x80))
+		{
+			return 0;
+		}
+		shift += 7;
+	}
+
+	return -1;
+}
+
+static unsigned long long _iso_archive_zigzag(long long value)
+{
+	return ((unsigned long long) value << 1) ^ (unsigned long long) (value >> 63);
+}
+
+static long long _iso_archive_unzigzag(unsigned long long value)
+{
+	return (long long) (value >> 1) ^ -(long long) (value & 1);
+}
+
+static void _iso_archive_put_u32(unsigned char *data, unsigned int value)
+{
+	int i = 0;
+
+	for(i = 0; i < 4; i++)
+	{
+		data[i] = (value >> (i * 8)) & 0xFF;
+	}
+}
+
+static void _iso_archive_put_u64(unsigned char *data, unsigned long long value)
+{
+	int i = 0;
+
+	for(i = 0; i < 8; i++)
+	{
+		data[i] = (value >> (i * 8)) & 0xFF;
+	}
+}
+
+static unsigned int _iso_archive_get_u32(const unsigned char *data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int) data[3] << 24);
+}
+
+static unsigned long long _iso_archive_get_u64(const unsigned char *data)
+{
+	unsigned long long value = 0;
+	int i = 0;
+
+	for(i = 7; i >= 0; i--)
+	{
+		value = (value << 8) | data[i];
+	}
+
+	return value;
+}
+
+static int _iso_archive_hex_value(char c)
+{
+	if(c >= '0' && c <= '9')
+	{
+		return c - '0';
+	}
+	if(c >= 'A' && c <= 'F')
+	{
+		return c - 'A' + 10;
+	}
+	if(c >= 'a' && c <= 'f')
+	{
+		return c - 'a' + 10;
+	}
+
+	return -1;
+}
+
+// Fingerprint of spec (length and type of all fields), to check that archive is read with same spec.
+static unsigned long long _iso_archive_spec_fingerprint()
+{
+	struct fi_field_info fi_field;
+	unsigned long long hash = 14695981039346656037ULL;
+	int i = 0;
+	int j = 0;
+
+	for(i = 1; i <= FI_NUM_FIELD_MAX; i++)
+	{
+		memset(&fi_field, 0, sizeof(fi_field));
+		fi_get_field_info(i, &fi_field);
+		hash = (hash ^ (unsigned long long) fi_field.length) * 1099511628211ULL;
+		hash = (hash ^ (unsigned long long) fi_field.is_variable_field) * 1099511628211ULL;
+		for(j = 0; j < (int) sizeof(fi_field.type) && fi_field.type[j] != '\0'; j++)
+		{
+			hash = (hash ^ fi_field.type[j]) * 1099511628211ULL;
+		}
+	}
+
+	return hash;
+}
+
+// Gets numeric value of fixed length field, returns -1 case it can not be delta encoded.
+static int _iso_archive_numeric_value(int field, const char *data, int length, unsigned long long *value)
+{
+	int i = 0;
+
+	if(fi_is_variable_field_length(field) || length <= 0 || length > ISO_ARCHIVE_DELTA_DIGITS_MAX)
+	{
+		return -1;
+	}
+
+	*value = 0;
+	for(i = 0; i < length; i++)
+	{
+		if(data[i] < '0' || data[i] > '9')
+		{
+			return -1;
+		}
+		*value = (*value * 10) + (data[i] - '0');
+	}
+
+	return 0;
+}
+
+// Find value in dictionary or insert it, returns -1 case dictionary is full.
+static int _iso_archive_dict_index(struct iso_archive_dict *dict, const char *data, int length)
+{
+	int i = 0;
+
+	for(i = 0; i < dict->count; i++)
+	{
+		if(dict->lengths[i] == length && memcmp(dict->values.data + dict->offsets[i], data, length) == 0)
+		{
+			return i;
+		}
+	}
+
+	if(dict->count >= ISO_ARCHIVE_DICT_MAX)
+	{
+		return -1;
+	}
+
+	dict->offsets[dict->count] = (int) dict->values.length;
+	dict->lengths[dict->count] = length;
+	if(_iso_archive_append(&dict->values, data, length) != 0)
+	{
+		return -1;
+	}
+
+	return dict->count++;
+}
+
+// Find mti in block dictionary or insert it, returns -1 case dictionary is full.
+static int _iso_archive_mti_index(struct iso_archive_block_info *info, const char *mti)
+{
+	int i = 0;
+
+	for(i = 0; i < info->mti_count; i++)
+	{
+		if(memcmp(info->mtis[i], mti, FI_MTI_LEN_BYTES) == 0)
+		{
+			return i;
+		}
+	}
+
+	if(info->mti_count >= ISO_ARCHIVE_MTI_DICT_MAX)
+	{
+		info->mti_overflow = 1;
+		return -1;
+	}
+
+	memcpy(info->mtis[info->mti_count], mti, FI_MTI_LEN_BYTES);
+
+	return info->mti_count++;
+}
+
+// Start a new block in the writer.
+static void _iso_archive_reset_block(struct iso_archive_writer *writer)
+{
+	int i = 0;
+
+	memset(&writer->info, 0, sizeof(writer->info));
+	memset(writer->info.bitmap_and, 0xFF, sizeof(writer->info.bitmap_and));
+
+	for(i = 0; i < ISO_ARCHIVE_DICT_FIELDS; i++)
+	{
+		writer->dicts[i].count = 0;
+		writer->dicts[i].values.length = 0;
+	}
+
+	writer->records.length = 0;
+	writer->last_stan = 0;
+	writer->last_time = 0;
+	writer->stan_seen = 0;
+	writer->time_seen = 0;
+	writer->info.has_stan_range = 1;
+	writer->info.has_time_range = 1;
+}
+
+// Update min/max of delta encoded field in block summary.
+static void _iso_archive_update_range(int *seen, unsigned long long *min, unsigned long long *max, unsigned long long value)
+{
+	if(!*seen || value < *min)
+	{
+		*min = value;
+	}
+	if(!*seen || value > *max)
+	{
+		*max = value;
+	}
+	*seen = 1;
+}
+
+// Write block header and body.
+static int _iso_archive_flush_block(struct iso_archive_writer *writer)
+{
+	struct iso_archive_block_info *info = &writer->info;
+	struct iso_archive_buffer dicts;
+	unsigned char header[ISO_ARCHIVE_BLOCK_HEADER_LEN];
+	unsigned char *p = header;
+	int ret = -1;
+	int i = 0;
+	int j = 0;
+
+	if(info->message_count == 0)
+	{
+		return 0;
+	}
+
+	memset(&dicts, 0, sizeof(dicts));
+
+	for(i = 0; i < ISO_ARCHIVE_DICT_FIELDS; i++)
+	{
+		if(_iso_archive_append_varint(&dicts, writer->dicts[i].count) != 0)
+		{
+			goto end;
+		}
+		for(j = 0; j < writer->dicts[i].count; j++)
+		{
+			if(_iso_archive_append_varint(&dicts, writer->dicts[i].lengths[j]) != 0 ||
+				_iso_archive_append(&dicts, writer->dicts[i].values.data + writer->dicts[i].offsets[j], writer->dicts[i].lengths[j]) != 0)
+			{
+				goto end;
+			}
+		}
+	}
+
+	info->body_length = (int) (dicts.length + writer->records.length);
+
+	_iso_archive_put_u32(p, info->message_count); p += 4;
+	_iso_archive_put_u32(p, info->body_length); p += 4;
+	memcpy(p, info->bitmap_or, sizeof(info->bitmap_or)); p += sizeof(info->bitmap_or);
+	memcpy(p, info->bitmap_and, sizeof(info->bitmap_and)); p += sizeof(info->bitmap_and);
+	*p++ = (info->has_stan_range ? ISO_ARCHIVE_BLOCK_STAN_RANGE : 0) |
+		(info->has_time_range ? ISO_ARCHIVE_BLOCK_TIME_RANGE : 0) |
+		(info->mti_overflow ? ISO_ARCHIVE_BLOCK_MTI_OVERFLOW : 0);
+	_iso_archive_put_u64(p, info->stan_min); p += 8;
+	_iso_archive_put_u64(p, info->stan_max); p += 8;
+	_iso_archive_put_u64(p, info->time_min); p += 8;
+	_iso_archive_put_u64(p, info->time_max); p += 8;
+	*p++ = (unsigned char) info->mti_count;
+
+	if(fwrite(header, 1, sizeof(header), writer->file) != sizeof(header) ||
+		fwrite(info->mtis, FI_MTI_LEN_BYTES, info->mti_count, writer->file) != (size_t) info->mti_count ||
+		fwrite(dicts.data, 1, dicts.length, writer->file) != dicts.length ||
+		(writer->records.length > 0 && fwrite(writer->records.data, 1, writer->records.length, writer->file) != writer->records.length))
+	{
+		goto end;
+	}
+
+	_iso_archive_reset_block(writer);
+	ret = 0;
+
+end:
+	free(dicts.data);
+
+	return ret;
+}
+
+// Append message without encoding (it could not be parsed with current spec).
+static int _iso_archive_write_raw(struct iso_archive_writer *writer, const char *message, int length)
+{
+	unsigned char flags = ISO_ARCHIVE_RECORD_RAW;
+	size_t records_length = writer->records.length;
+
+	if(length < FI_MTI_LEN_BYTES || _iso_archive_mti_index(&writer->info, message) < 0)
+	{
+		writer->info.mti_overflow = 1;
+	}
+
+	// Any field may be set, with any value (fields 11 and 7 of raw messages are not in the ranges).
+	memset(writer->info.bitmap_or, 0xFF, sizeof(writer->info.bitmap_or));
+	memset(writer->info.bitmap_and, 0, sizeof(writer->info.bitmap_and));
+	writer->info.has_stan_range = 0;
+	writer->info.has_time_range = 0;
+
+	if(_iso_archive_append_varint(&writer->records, 0) != 0 ||
+		_iso_archive_append(&writer->records, &flags, 1) != 0 ||
+		_iso_archive_append_varint(&writer->records, length) != 0 ||
+		_iso_archive_append(&writer->records, message, length) != 0)
+	{
+		// Partial record would make the next ones unreadable.
+		writer->records.length = records_length;
+		return -1;
+	}
+
+	writer->info.message_count++;
+
+	return 0;
+}
+
+struct iso_archive_writer *iso_archive_create(const char *path)
+{
+	struct iso_archive_writer *writer = NULL;
+	unsigned char fingerprint[8];
+
+	writer = (struct iso_archive_writer *) calloc(1, sizeof(struct iso_archive_writer));
+	if(writer == NULL)
+	{
+		return NULL;
+	}
+
+	writer->file = fopen(path, "wb");
+	if(writer->file == NULL)
+	{
+		debug_print("Error: [%s]: Could not create archive [%s]\n", __FUNCTION__, path);
+		free(writer);
+		return NULL;
+	}
+
+	_iso_archive_put_u64(fingerprint, _iso_archive_spec_fingerprint());
+
+	if(fwrite(ISO_ARCHIVE_MAGIC, 1, ISO_ARCHIVE_MAGIC_LEN, writer->file) != ISO_ARCHIVE_MAGIC_LEN ||
+		fwrite(fingerprint, 1, sizeof(fingerprint), writer->file) != sizeof(fingerprint))
+	{
+		fclose(writer->file);
+		free(writer);
+		return NULL;
+	}
+
+	_iso_archive_reset_block(writer);
+
+	return writer;
+}
+
+int iso_archive_write(struct iso_archive_writer *writer, const char *message, int length)
+{
+	struct iso_archive_block_info *info = NULL;
+	struct iso_raw_field fields[FI_NUM_FIELD_MAX];
+	struct iso_raw_field *field = NULL;
+	unsigned char bitmaps[FI_BITMAP_LEN_BYTES * 2];
+	unsigned char removed[FI_NUM_FIELD_MAX];
+	unsigned long long value = 0;
+	unsigned long long stan_delta = 0;
+	unsigned long long time_delta = 0;
+	unsigned long long last_stan = 0;
+	unsigned long long last_time = 0;
+	size_t records_length = 0;
+	int dict_index[ISO_ARCHIVE_DICT_FIELDS];
+	unsigned char flags = 0;
+	int mti_index = 0;
+	int offset = 0;
+	int i = 0;
+
+	if(writer == NULL || message == NULL || length <= 0)
+	{
+		return -1;
+	}
+
+	info = &writer->info;
+
+	if(info->message_count >= ISO_ARCHIVE_BLOCK_MESSAGES && _iso_archive_flush_block(writer) != 0)
+	{
+		return -1;
+	}
+
+	// Restored case the record is not fully appended (summary and dictionaries may keep the message, they only make
+	// the block less selective).
+	records_length = writer->records.length;
+	last_stan = writer->last_stan;
+	last_time = writer->last_time;
+
+	if(length < FI_MTI_LEN_BYTES || iso_raw_index_message(message, length, FI_NUM_FIELD_MAX, fields) < 0)
+	{
+		return _iso_archive_write_raw(writer, message, length);
+	}
+
+	mti_index = _iso_archive_mti_index(info, message);
+	if(mti_index < 0)
+	{
+		return _iso_archive_write_raw(writer, message, length);
+	}
+
+	// Bitmaps summary.
+	memset(bitmaps, 0, sizeof(bitmaps));
+	iso_hex_str_to_bin(message + FI_MTI_LEN_BYTES, (fields[0].offset < 0) ? FI_BITMAP_HEX_BYTES : FI_BITMAP_HEX_BYTES * 2, bitmaps);
+	for(i = 0; i < (int) sizeof(bitmaps); i++)
+	{
+		info->bitmap_or[i] |= bitmaps[i];
+		info->bitmap_and[i] &= bitmaps[i];
+	}
+
+	memset(removed, 0, sizeof(removed));
+
+	// Delta encoded fields.
+	field = &fields[ISO_ARCHIVE_FIELD_STAN - 1];
+	if(field->offset >= 0)
+	{
+		if(_iso_archive_numeric_value(ISO_ARCHIVE_FIELD_STAN, message + field->offset, field->length, &value) == 0)
+		{
+			flags |= ISO_ARCHIVE_RECORD_STAN;
+			stan_delta = _iso_archive_zigzag((long long) (value - writer->last_stan));
+			writer->last_stan = value;
+			removed[ISO_ARCHIVE_FIELD_STAN - 1] = 1;
+			_iso_archive_update_range(&writer->stan_seen, &info->stan_min, &info->stan_max, value);
+		}
+		else
+		{
+			info->has_stan_range = 0;
+		}
+	}
+
+	field = &fields[ISO_ARCHIVE_FIELD_TIME - 1];
+	if(field->offset >= 0)
+	{
+		if(_iso_archive_numeric_value(ISO_ARCHIVE_FIELD_TIME, message + field->offset, field->length, &value) == 0)
+		{
+			flags |= ISO_ARCHIVE_RECORD_TIME;
+			time_delta = _iso_archive_zigzag((long long) (value - writer->last_time));
+			writer->last_time = value;
+			removed[ISO_ARCHIVE_FIELD_TIME - 1] = 1;
+			_iso_archive_update_range(&writer->time_seen, &info->time_min, &info->time_max, value);
+		}
+		else
+		{
+			info->has_time_range = 0;
+		}
+	}
+
+	// Dictionary encoded fields.
+	for(i = 0; i < ISO_ARCHIVE_DICT_FIELDS; i++)
+	{
+		field = &fields[glb_dict_fields[i] - 1];
+		dict_index[i] = -1;
+
+		if(field->offset >= 0)
+		{
+			dict_index[i] = _iso_archive_dict_index(&writer->dicts[i], message + field->offset, field->length);
+			if(dict_index[i] >= 0)
+			{
+				flags |= (ISO_ARCHIVE_RECORD_DICT << i);
+				removed[glb_dict_fields[i] - 1] = 1;
+			}
+		}
+	}
+
+	// Residual: message without mti and without the data of encoded fields (length prefixes are kept).
+	writer->residual.length = 0;
+	offset = FI_MTI_LEN_BYTES;
+	for(i = 0; i < FI_NUM_FIELD_MAX; i++)
+	{
+		if(removed[i])
+		{
+			if(_iso_archive_append(&writer->residual, message + offset, fields[i].offset - offset) != 0)
+			{
+				goto error;
+			}
+			offset = fields[i].offset + fields[i].length;
+		}
+	}
+	if(_iso_archive_append(&writer->residual, message + offset, length - offset) != 0)
+	{
+		goto error;
+	}
+
+	if(_iso_archive_append_varint(&writer->records, mti_index) != 0 ||
+		_iso_archive_append(&writer->records, &flags, 1) != 0 ||
+		((flags & ISO_ARCHIVE_RECORD_STAN) && _iso_archive_append_varint(&writer->records, stan_delta) != 0) ||
+		((flags & ISO_ARCHIVE_RECORD_TIME) && _iso_archive_append_varint(&writer->records, time_delta) != 0))
+	{
+		goto error;
+	}
+
+	for(i = 0; i < ISO_ARCHIVE_DICT_FIELDS; i++)
+	{
+		if(dict_index[i] >= 0 && _iso_archive_append_varint(&writer->records, dict_index[i]) != 0)
+		{
+			goto error;
+		}
+	}
+
+	if(_iso_archive_append_varint(&writer->records, writer->residual.length) != 0 ||
+		_iso_archive_append(&writer->records, writer->residual.data, writer->residual.length) != 0)
+	{
+		goto error;
+	}
+
+	info->message_count++;
+
+	return 0;
+
+error:
+	writer->records.length = records_length;
+	writer->last_stan = last_stan;
+	writer->last_time = last_time;
+
+	return -1;
+}
+
+int iso_archive_close(struct iso_archive_writer *writer)
+{
+	int ret = 0;
+	int i = 0;
+
+	if(writer == NULL)
+	{
+		return -1;
+	}
+
+	if(_iso_archive_flush_block(writer) != 0)
+	{
+		ret = -1;
+	}
+
+	if(fclose(writer->file) != 0)
+	{
+		ret = -1;
+	}
+
+	for(i = 0; i < ISO_ARCHIVE_DICT_FIELDS; i++)
+	{
+		free(writer->dicts[i].values.data);
+	}
+	free(writer->records.data);
+	free(writer->residual.data);
+	free(writer);
+
+	return ret;
+}
+
+struct iso_archive_reader *iso_archive_open(const char *path)
+{
+	struct iso_archive_reader *reader = NULL;
+	unsigned char header[ISO_ARCHIVE_MAGIC_LEN + 8];
+
+	reader = (struct iso_archive_reader *) calloc(1, sizeof(struct iso_archive_reader));
+	if(reader == NULL)
+	{
+		return NULL;
+	}
+
+	reader->file = fopen(path, "rb");
+	if(reader->file == NULL)
+	{
+		debug_print("Error: [%s]: Could not open archive [%s]\n", __FUNCTION__, path);
+		free(reader);
+		return NULL;
+	}
+
+	if(fread(header, 1, sizeof(header), reader->file) != sizeof(header) ||
+		memcmp(header, ISO_ARCHIVE_MAGIC, ISO_ARCHIVE_MAGIC_LEN) != 0 ||
+		_iso_archive_get_u64(header + ISO_ARCHIVE_MAGIC_LEN) != _iso_archive_spec_fingerprint())
+	{
+		debug_print("Error: [%s]: Invalid archive or different spec [%s]\n", __FUNCTION__, path);
+		iso_archive_close_reader(reader);
+		return NULL;
+	}
+
+	reader->next_block = (long) sizeof(header);
+
+	return reader;
+}
+
+int iso_archive_next_block(struct iso_archive_reader *reader, struct iso_archive_block_info *info)
+{
+	unsigned char header[ISO_ARCHIVE_BLOCK_HEADER_LEN];
+	const unsigned char *p = header;
+	struct iso_archive_block_info *current = NULL;
+	size_t ret = 0;
+	unsigned char flags = 0;
+
+	if(reader == NULL || info == NULL)
+	{
+		return -1;
+	}
+
+	current = &reader->info;
+
+	// Skip body of current block when it was not read.
+	if(fseek(reader->file, reader->next_block, SEEK_SET) != 0)
+	{
+		return -1;
+	}
+
+	ret = fread(header, 1, sizeof(header), reader->file);
+	if(ret == 0 && feof(reader->file))
+	{
+		return 0;
+	}
+	if(ret != sizeof(header))
+	{
+		return -1;
+	}
+
+	memset(current, 0, sizeof(*current));
+	current->message_count = (int) _iso_archive_get_u32(p); p += 4;
+	current->body_length = (int) _iso_archive_get_u32(p); p += 4;
+	memcpy(current->bitmap_or, p, sizeof(current->bitmap_or)); p += sizeof(current->bitmap_or);
+	memcpy(current->bitmap_and, p, sizeof(current->bitmap_and)); p += sizeof(current->bitmap_and);
+	flags = *p++;
+	current->has_stan_range = (flags & ISO_ARCHIVE_BLOCK_STAN_RANGE) ? 1 : 0;
+	current->has_time_range = (flags & ISO_ARCHIVE_BLOCK_TIME_RANGE) ? 1 : 0;
+	current->mti_overflow = (flags & ISO_ARCHIVE_BLOCK_MTI_OVERFLOW) ? 1 : 0;
+	current->stan_min = _iso_archive_get_u64(p); p += 8;
+	current->stan_max = _iso_archive_get_u64(p); p += 8;
+	current->time_min = _iso_archive_get_u64(p); p += 8;
+	current->time_max = _iso_archive_get_u64(p); p += 8;
+	current->mti_count = *p++;
+
+	if(current->mti_count > ISO_ARCHIVE_MTI_DICT_MAX || current->body_length < 0 ||
+		fread(current->mtis, FI_MTI_LEN_BYTES, current->mti_count, reader->file) != (size_t) current->mti_count)
+	{
+		return -1;
+	}
+
+	reader->next_block = ftell(reader->file) + current->body_length;
+	reader->body_loaded = 0;
+	reader->remaining = current->message_count;
+
+	*info = *current;
+
+	return 1;
+}
+
+// Read body of current block and its dictionaries.
+static int _iso_archive_load_body(struct iso_archive_reader *reader)
+{
+	unsigned long long value = 0;
+	unsigned char *body = NULL;
+	size_t length = reader->info.body_length;
+	int i = 0;
+	int j = 0;
+
+	if(length > reader->body_capacity)
+	{
+		body = (unsigned char *) realloc(reader->body, length);
+		if(body == NULL)
+		{
+			return -1;
+		}
+		reader->body = body;
+		reader->body_capacity = length;
+	}
+
+	if(fseek(reader->file, reader->next_block - (long) length, SEEK_SET) != 0 || fread(reader->body, 1, length, reader->file) != length)
+	{
+		return -1;
+	}
+
+	reader->cursor = 0;
+
+	for(i = 0; i < ISO_ARCHIVE_DICT_FIELDS; i++)
+	{
+		if(_iso_archive_read_varint(reader->body, length, &reader->cursor, &value) != 0 || value > ISO_ARCHIVE_DICT_MAX)
+		{
+			return -1;
+		}
+		reader->dict_counts[i] = (int) value;
+
+		for(j = 0; j < reader->dict_counts[i]; j++)
+		{
+			if(_iso_archive_read_varint(reader->body, length, &reader->cursor, &value) != 0 || value > length - reader->cursor)
+			{
+				return -1;
+			}
+			reader->dict_lengths[i][j] = (int) value;
+			reader->dict_values[i][j] = reader->body + reader->cursor;
+			reader->cursor += value;
+		}
+	}
+
+	reader->last_stan = 0;
+	reader->last_time = 0;
+	reader->body_loaded = 1;
+
+	return 0;
+}
+
+// Append data to the rebuilt message.
+static int _iso_archive_put(char *message, int capacity, int *length, const void *data, int data_length)
+{
+	if(data_length < 0 || *length + data_length > capacity)
+	{
+		return -1;
+	}
+
+	memcpy(message + *length, data, data_length);
+	*length += data_length;
+
+	return 0;
+}
+
+// Format delta decoded value with the field length.
+static int _iso_archive_put_numeric(char *message, int capacity, int *length, int field, unsigned long long value)
+{
+	int field_length = fi_get_field_length(field);
+	int i = 0;
+
+	if(field_length <= 0 || *length + field_length > capacity)
+	{
+		return -1;
+	}
+
+	for(i = field_length - 1; i >= 0; i--)
+	{
+		message[*length + i] = '0' + (char) (value % 10);
+		value /= 10;
+	}
+	*length += field_length;
+
+	return 0;
+}
+
+int iso_archive_read(struct iso_archive_reader *reader, char *message, int capacity)
+{
+	struct fi_field_info fi_field;
+	const unsigned char *residual = NULL;
+	const unsigned char *dict_values[ISO_ARCHIVE_DICT_FIELDS];
+	int dict_lengths[ISO_ARCHIVE_DICT_FIELDS];
+	unsigned long long value = 0;
+	unsigned long long mti_index = 0;
+	size_t body_length = 0;
+	int residual_length = 0;
+	int bitmaps_length = 0;
+	int size_of_length = 0;
+	int field_length = 0;
+	int position = 0;
+	int length = 0;
+	int dict = 0;
+	int hex = 0;
+	int i = 0;
+	int j = 0;
+	unsigned char flags = 0;
+
+	if(reader == NULL || message == NULL || reader->remaining < 0)
+	{
+		return -1;
+	}
+
+	if(reader->remaining == 0)
+	{
+		return 0;
+	}
+
+	if(!reader->body_loaded && _iso_archive_load_body(reader) != 0)
+	{
+		return -1;
+	}
+
+	body_length = reader->info.body_length;
+
+	// Corrupt record header stops the block (next records can not be located).
+	if(_iso_archive_read_varint(reader->body, body_length, &reader->cursor, &mti_index) != 0 || reader->cursor >= body_length)
+	{
+		reader->remaining = -1;
+		return -1;
+	}
+
+	flags = reader->body[reader->cursor++];
+
+	if(flags & ISO_ARCHIVE_RECORD_STAN)
+	{
+		if(_iso_archive_read_varint(reader->body, body_length, &reader->cursor, &value) != 0)
+		{
+			reader->remaining = -1;
+			return -1;
+		}
+		reader->last_stan += (unsigned long long) _iso_archive_unzigzag(value);
+	}
+	if(flags & ISO_ARCHIVE_RECORD_TIME)
+	{
+		if(_iso_archive_read_varint(reader->body, body_length, &reader->cursor, &value) != 0)
+		{
+			reader->remaining = -1;
+			return -1;
+		}
+		reader->last_time += (unsigned long long) _iso_archive_unzigzag(value);
+	}
+
+	for(i = 0; i < ISO_ARCHIVE_DICT_FIELDS; i++)
+	{
+		dict_values[i] = NULL;
+		dict_lengths[i] = 0;
+
+		if(flags & (ISO_ARCHIVE_RECORD_DICT << i))
+		{
+			if(_iso_archive_read_varint(reader->body, body_length, &reader->cursor, &value) != 0 || value >= (unsigned long long) reader->dict_counts[i])
+			{
+				reader->remaining = -1;
+				return -1;
+			}
+			dict_values[i] = reader->dict_values[i][value];
+			dict_lengths[i] = reader->dict_lengths[i][value];
+		}
+	}
+
+	if(_iso_archive_read_varint(reader->body, body_length, &reader->cursor, &value) != 0 || value > body_length - reader->cursor)
+	{
+		reader->remaining = -1;
+		return -1;
+	}
+
+	residual = reader->body + reader->cursor;
+	residual_length = (int) value;
+	reader->cursor += value;
+	reader->remaining--;
+
+	if(flags & ISO_ARCHIVE_RECORD_RAW)
+	{
+		return (_iso_archive_put(message, capacity, &length, residual, residual_length) == 0) ? length : -1;
+	}
+
+	if(mti_index >= (unsigned long long) reader->info.mti_count ||
+		_iso_archive_put(message, capacity, &length, reader->info.mtis[mti_index], FI_MTI_LEN_BYTES) != 0)
+	{
+		return -1;
+	}
+
+	// Bitmaps are the first bytes of residual.
+	if(residual_length < FI_BITMAP_HEX_BYTES || (hex = _iso_archive_hex_value(residual[0])) < 0)
+	{
+		return -1;
+	}
+	bitmaps_length = (hex & ISO_ARCHIVE_HEX_MASK) ? FI_BITMAP_HEX_BYTES * 2 : FI_BITMAP_HEX_BYTES;
+	if(_iso_archive_put(message, capacity, &length, residual, bitmaps_length) != 0)
+	{
+		return -1;
+	}
+	position = bitmaps_length;
+
+	for(i = 2; i <= bitmaps_length * 4; i++)
+	{
+		if((hex = _iso_archive_hex_value(residual[(i - 1) / 4])) < 0)
+		{
+			return -1;
+		}
+		if(!(hex & (ISO_ARCHIVE_HEX_MASK >> ((i - 1) % 4))))
+		{
+			continue;
+		}
+
+		fi_get_field_info(i, &fi_field);
+
+		// Length prefix is always kept in residual.
+		field_length = fi_field.length;
+		if(fi_field.is_variable_field)
+		{
+			size_of_length = fi_get_size_length_of_variable_field(i);
+			if(position + size_of_length > residual_length)
+			{
+				return -1;
+			}
+			field_length = 0;
+			for(j = 0; j < size_of_length; j++)
+			{
+				field_length = (field_length * 10) + (residual[position + j] - '0');
+			}
+			if(_iso_archive_put(message, capacity, &length, residual + position, size_of_length) != 0)
+			{
+				return -1;
+			}
+			position += size_of_length;
+		}
+
+		if(i == ISO_ARCHIVE_FIELD_STAN && (flags & ISO_ARCHIVE_RECORD_STAN))
+		{
+			if(_iso_archive_put_numeric(message, capacity, &length, i, reader->last_stan) != 0)
+			{
+				return -1;
+			}
+			continue;
+		}
+
+		if(i == ISO_ARCHIVE_FIELD_TIME && (flags & ISO_ARCHIVE_RECORD_TIME))
+		{
+			if(_iso_archive_put_numeric(message, capacity, &length, i, reader->last_time) != 0)
+			{
+				return -1;
+			}
+			continue;
+		}
+
+		for(dict = 0; dict < ISO_ARCHIVE_DICT_FIELDS; dict++)
+		{
+			if(glb_dict_fields[dict] == i && dict_values[dict] != NULL)
+			{
+				break;
+			}
+		}
+
+		if(dict < ISO_ARCHIVE_DICT_FIELDS)
+		{
+			if(_iso_archive_put(message, capacity, &length, dict_values[dict], dict_lengths[dict]) != 0)
+			{
+				return -1;
+			}
+			continue;
+		}
+
+		if(position + field_length > residual_length || _iso_archive_put(message, capacity, &length, residual + position, field_length) != 0)
+		{
+			return -1;
+		}
+		position += field_length;
+	}
+
+	// Trailing bytes after last field.
+	if(_iso_archive_put(message, capacity, &length, residual + position, residual_length - position) != 0)
+	{
+		return -1;
+	}
+
+	return length;
+}
+
+void iso_archive_close_reader(struct iso_archive_reader *reader)
+{
+	if(reader == NULL)
+	{
+		return;
+	}
+
+	if(reader->file != NULL)
+	{
+		fclose(reader->file);
+	}
+
+	free(reader->body);
+	free(reader);
+}
+
+// Check if field is set in summary bitmap.
+static int _iso_archive_bitmap_has(const unsigned char *bitmap, int field)
+{
+	field--;
+	return (bitmap[field / 8] >> (7 - (field % 8))) & 1;
+}
+
+// Check if numeric term value overlaps the block range.
+static int _iso_archive_range_may_match(const struct iso_filter_term *term, unsigned long long min, unsigned long long max)
+{
+	unsigned long long low = 0;
+	unsigned long long high = 0;
+
+	if(_iso_archive_numeric_value(term->field, term->value, term->value_length, &low) != 0)
+	{
+		return 1;
+	}
+
+	high = low;
+	if(term->op == ISO_FILTER_OP_RANGE && _iso_archive_numeric_value(term->field, term->value_max, term->value_max_length, &high) != 0)
+	{
+		return 1;
+	}
+
+	return !(high < min || low > max);
+}
+
+// Check if term may match some message of block.
+static int _iso_archive_term_may_match(const struct iso_archive_block_info *info, const struct iso_filter_term *term)
+{
+	int i = 0;
+	int j = 0;
+
+	switch(term->op)
+	{
+		case ISO_FILTER_OP_MTI:
+			if(term->negate || info->mti_overflow)
+			{
+				return 1;
+			}
+			for(i = 0; i < info->mti_count; i++)
+			{
+				for(j = 0; j < FI_MTI_LEN_BYTES; j++)
+				{
+					if(term->value[j] != 'x' && term->value[j] != info->mtis[i][j])
+					{
+						break;
+					}
+				}
+				if(j == FI_MTI_LEN_BYTES)
+				{
+					return 1;
+				}
+			}
+			return 0;
+		case ISO_FILTER_OP_HAS:
+			if(term->negate)
+			{
+				return !_iso_archive_bitmap_has(info->bitmap_and, term->field);
+			}
+			return _iso_archive_bitmap_has(info->bitmap_or, term->field);
+		default:
+			break;
+	}
+
+	if(term->negate)
+	{
+		return 1;
+	}
+
+	if(!_iso_archive_bitmap_has(info->bitmap_or, term->field))
+	{
+		return 0;
+	}
+
+	if(term->op == ISO_FILTER_OP_EQUAL || term->op == ISO_FILTER_OP_RANGE)
+	{
+		if(term->field == ISO_ARCHIVE_FIELD_STAN && info->has_stan_range)
+		{
+			return _iso_archive_range_may_match(term, info->stan_min, info->stan_max);
+		}
+		if(term->field == ISO_ARCHIVE_FIELD_TIME && info->has_time_range)
+		{
+			return _iso_archive_range_may_match(term, info->time_min, info->time_max);
+		}
+	}
+
+	return 1;
+}
+
+int iso_archive_block_may_match(const struct iso_archive_block_info *info, const struct iso_filter *filter)
+{
+	int clause_matched = 0;
+	int clause = 0;
+	int i = 0;
+
+	if(info == NULL || filter == NULL || filter->term_count == 0)
+	{
+		return 1;
+	}
+
+	for(i = 0; i < filter->term_count; i++)
+	{
+		if(filter->terms[i].clause != clause)
+		{
+			if(!clause_matched)
+			{
+				return 0;
+			}
+			clause = filter->terms[i].clause;
+			clause_matched = 0;
+		}
+
+		if(!clause_matched)
+		{
+			clause_matched = _iso_archive_term_may_match(info, &filter->terms[i]);
+		}
+	}
+
+	return clause_matched;
+}
@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "iso_capture.h"
+#include "debug.h"
+
+int iso_capture_open(const char *path, int format, struct iso_capture *capture)
+{
+	struct stat st;
+	void *data = NULL;
+
+	if(path == NULL || capture == NULL || (format != ISO_CAPTURE_ASCII && format != ISO_CAPTURE_BINARY))
+	{
+		return -1;
+	}
+
+	memset(capture, 0, sizeof(*capture));
+	capture->fd = -1;
+
+	capture->fd = open(path, O_RDONLY);
+	if(capture->fd < 0 || fstat(capture->fd, &st) != 0)
+	{
+		debug_print("Error: [%s]: Could not open capture [%s]\n", __FUNCTION__, path);
+		iso_capture_close(capture);
+		return -1;
+	}
+
+	capture->format = format;
+	capture->size = st.st_size;
+
+	// Empty file has nothing to map.
+	if(capture->size > 0)
+	{
+		data = mmap(NULL, capture->size, PROT_READ, MAP_PRIVATE, capture->fd, 0);
+		if(data == MAP_FAILED)
+		{
+			debug_print("Error: [%s]: Could not map capture [%s]\n", __FUNCTION__, path);
+			iso_capture_close(capture);
+			return -1;
+		}
+
+		// Captures are read from start to end.
+		madvise(data, capture->size, MADV_SEQUENTIAL);
+		capture->data = (const char *) data;
+	}
+
+	return 0;
+}
+
+void iso_capture_close(struct iso_capture *capture)
+{
+	if(capture == NULL)
+	{
+		return;
+	}
+
+	if(capture->data != NULL)
+	{
+		munmap((void *) capture->data, capture->size);
+	}
+
+	if(capture->fd >= 0)
+	{
+		close(capture->fd);
+	}
+
+	memset(capture, 0, sizeof(*capture));
+	capture->fd = -1;
+}
+
+// Gets offset after empty lines (ascii format).
+static long long _iso_capture_skip_empty_lines(const struct iso_capture *capture, long long offset)
+{
+	while(offset < (long long) capture->size && (capture->data[offset] == '\n' || capture->data[offset] == '\r'))
+	{
+		offset++;
+	}
+
+	return offset;
+}
+
+long long iso_capture_next(const struct iso_capture *capture, long long offset, const char **message, int *length)
+{
+	const char *start = NULL;
+	const char *end = NULL;
+	long long size = 0;
+
+	if(capture == NULL || message == NULL || length == NULL || offset < 0)
+	{
+		return -1;
+	}
+
+	size = (long long) capture->size;
+
+	if(capture->format == ISO_CAPTURE_BINARY)
+	{
+		if(offset >= size)
+		{
+			return 0;
+		}
+		if(offset + ISO_CAPTURE_BINARY_HEADER > size)
+		{
+			return -1;
+		}
+
+		*length = ((unsigned char) capture->data[offset] << 8) | (unsigned char) capture->data[offset + 1];
+		if(offset + ISO_CAPTURE_BINARY_HEADER + *length > size)
+		{
+			debug_print("Error: [%s]: Truncated message at offset %lld\n", __FUNCTION__, offset);
+			return -1;
+		}
+
+		*message = capture->data + offset + ISO_CAPTURE_BINARY_HEADER;
+
+		return offset + ISO_CAPTURE_BINARY_HEADER + *length;
+	}
+
+	offset = _iso_capture_skip_empty_lines(capture, offset);
+	if(offset >= size)
+	{
+		return 0;
+	}
+
+	start = capture->data + offset;
+	end = memchr(start, '\n', size - offset);
+	if(end == NULL)
+	{
+		end = capture->data + size;
+	}
+
+	*message = start;
+	*length = (int) (end - start);
+	if(*length > 0 && start[*length - 1] == '\r')
+	{
+		(*length)--;
+	}
+
+	// Next offset is the start of next message (empty lines are skipped), so it is never before a split point of its message.
+	return _iso_capture_skip_empty_lines(capture, (end - capture->data) + ((end < capture->data + size) ? 1 : 0));
+}
+
+int iso_capture_split(const struct iso_capture *capture, int chunks, long long *offsets)
+{
+	const char *end = NULL;
+	const char *message = NULL;
+	long long size = 0;
+	long long offset = 0;
+	long long next = 0;
+	int length = 0;
+	int i = 0;
+
+	if(capture == NULL || offsets == NULL || chunks <= 0)
+	{
+		return -1;
+	}
+
+	size = (long long) capture->size;
+	offsets[0] = 0;
+
+	if(capture->format == ISO_CAPTURE_BINARY)
+	{
+		// Boundaries are only known walking the length headers, it only touches 2 bytes per message.
+		i = 1;
+		while((next = iso_capture_next(capture, offset, &message, &length)) > 0)
+		{
+			offset = next;
+			while(i < chunks && offset >= (size * i) / chunks)
+			{
+				offsets[i++] = offset;
+			}
+		}
+		if(next < 0)
+		{
+			return -1;
+		}
+		while(i <= chunks)
+		{
+			offsets[i++] = size;
+		}
+		return 0;
+	}
+
+	// Move each split point to the start of next message: start of next line, after empty lines.
+	offsets[0] = _iso_capture_skip_empty_lines(capture, 0);
+	for(i = 1; i < chunks; i++)
+	{
+		offset = (size * i) / chunks;
+		if(offset < offsets[i - 1])
+		{
+			offset = offsets[i - 1];
+		}
+		else if(offset > 0 && offset < size && capture->data[offset - 1] != '\n')
+		{
+			end = memchr(capture->data + offset, '\n', size - offset);
+			offset = (end == NULL) ? size : (end - capture->data) + 1;
+		}
+		offsets[i] = _iso_capture_skip_empty_lines(capture, offset);
+	}
+	offsets[chunks] = size;
+
+	return 0;
+}
@@ -0,0 +1,471 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "iso_columnar.h"
+#include "iso_raw.h"
+#include "fields_info.h"
+#include "debug.h"
+
+#define ISO_COLUMNAR_ROWS_INIT  1024
+#define ISO_COLUMNAR_DATA_INIT  (1024 * 16)
+#define ISO_COLUMNAR_PAD        ' '
+
+// Grow rows dependent buffers (validity and offsets) of all columns.
+static int _iso_columnar_grow_rows(struct iso_columnar *columnar)
+{
+	struct iso_column *column = NULL;
+	int capacity = columnar->row_capacity ? columnar->row_capacity * 2 : ISO_COLUMNAR_ROWS_INIT;
+	unsigned char *validity = NULL;
+	unsigned int *offsets = NULL;
+	int i = 0;
+
+	for(i = 0; i < columnar->column_count; i++)
+	{
+		column = &columnar->columns[i];
+
+		validity = (unsigned char *) realloc(column->validity, (capacity + 7) / 8);
+		if(validity == NULL)
+		{
+			return -1;
+		}
+		memset(validity + (columnar->row_capacity + 7) / 8, 0, ((capacity + 7) / 8) - ((columnar->row_capacity + 7) / 8));
+		column->validity = validity;
+
+		if(column->fixed_length == 0)
+		{
+			offsets = (unsigned int *) realloc(column->offsets, (capacity + 1) * sizeof(unsigned int));
+			if(offsets == NULL)
+			{
+				return -1;
+			}
+			if(columnar->row_capacity == 0)
+			{
+				offsets[0] = 0;
+			}
+			column->offsets = offsets;
+		}
+	}
+
+	columnar->row_capacity = capacity;
+
+	return 0;
+}
+
+// Reserve space in column data.
+static int _iso_columnar_reserve(struct iso_column *column, size_t length)
+{
+	size_t capacity = column->data_capacity ? column->data_capacity : ISO_COLUMNAR_DATA_INIT;
+	char *data = NULL;
+
+	if(column->data_length + length <= column->data_capacity)
+	{
+		return 0;
+	}
+
+	while(column->data_length + length > capacity)
+	{
+		capacity *= 2;
+	}
+
+	data = (char *) realloc(column->data, capacity);
+	if(data == NULL)
+	{
+		return -1;
+	}
+
+	column->data = data;
+	column->data_capacity = capacity;
+
+	return 0;
+}
+
+// Append value to column (NULL data when field is not present).
+static int _iso_columnar_append_value(struct iso_column *column, int row, const char *data, int length)
+{
+	int size = column->fixed_length ? column->fixed_length : length;
+
+	// Offsets of variable length fields are u32 (binary format).
+	if(column->fixed_length == 0 && column->data_length + size > UINT_MAX)
+	{
+		debug_print("Error: [%s]: Column data of field (%d) exceeds 4 GB\n", __FUNCTION__, column->field);
+		return -1;
+	}
+
+	if(_iso_columnar_reserve(column, size) != 0)
+	{
+		return -1;
+	}
+
+	if(data != NULL)
+	{
+		column->validity[row / 8] |= (unsigned char) (1 << (row % 8));
+		memcpy(column->data + column->data_length, data, size);
+	}
+	else if(column->fixed_length)
+	{
+		memset(column->data + column->data_length, ISO_COLUMNAR_PAD, size);
+	}
+
+	column->data_length += size;
+
+	if(column->fixed_length == 0)
+	{
+		column->offsets[row + 1] = (unsigned int) column->data_length;
+	}
+
+	return 0;
+}
+
+// Remove row from first columns (the ones where the value was appended), so all columns keep the same rows.
+static void _iso_columnar_rollback_row(struct iso_columnar *columnar, int row, int column_count)
+{
+	struct iso_column *column = NULL;
+	int i = 0;
+
+	for(i = 0; i < column_count; i++)
+	{
+		column = &columnar->columns[i];
+		column->validity[row / 8] &= (unsigned char) ~(1 << (row % 8));
+		column->data_length = column->fixed_length ? (size_t) row * column->fixed_length : column->offsets[row];
+	}
+}
+
+static int _iso_columnar_is_valid(const struct iso_column *column, int row)
+{
+	return (column->validity[row / 8] >> (row % 8)) & 1;
+}
+
+// Gets value of row in column.
+static const char *_iso_columnar_get_value(const struct iso_column *column, int row, int *length)
+{
+	if(column->fixed_length)
+	{
+		*length = column->fixed_length;
+		return column->data + ((size_t) row * column->fixed_length);
+	}
+
+	*length = column->offsets[row + 1] - column->offsets[row];
+	return column->data + column->offsets[row];
+}
+
+static int _iso_columnar_write_u16(FILE *file, unsigned int value)
+{
+	unsigned char buffer[2];
+
+	buffer[0] = value & 0xFF;
+	buffer[1] = (value >> 8) & 0xFF;
+
+	return (fwrite(buffer, 1, sizeof(buffer), file) == sizeof(buffer)) ? 0 : -1;
+}
+
+static int _iso_columnar_write_u32(FILE *file, unsigned int value)
+{
+	unsigned char buffer[4];
+	int i = 0;
+
+	for(i = 0; i < 4; i++)
+	{
+		buffer[i] = (value >> (i * 8)) & 0xFF;
+	}
+
+	return (fwrite(buffer, 1, sizeof(buffer), file) == sizeof(buffer)) ? 0 : -1;
+}
+
+static int _iso_columnar_write_u64(FILE *file, unsigned long long value)
+{
+	unsigned char buffer[8];
+	int i = 0;
+
+	for(i = 0; i < 8; i++)
+	{
+		buffer[i] = (value >> (i * 8)) & 0xFF;
+	}
+
+	return (fwrite(buffer, 1, sizeof(buffer), file) == sizeof(buffer)) ? 0 : -1;
+}
+
+// Write csv value, quoted when it has separator, quote or line break.
+static void _iso_columnar_write_csv_value(FILE *file, const char *data, int length)
+{
+	int quoted = 0;
+	int i = 0;
+
+	for(i = 0; i < length && !quoted; i++)
+	{
+		quoted = (data[i] == ',' || data[i] == '"' || data[i] == '\r' || data[i] == '\n');
+	}
+
+	if(!quoted)
+	{
+		fwrite(data, 1, length, file);
+		return;
+	}
+
+	fputc('"', file);
+	for(i = 0; i < length; i++)
+	{
+		if(data[i] == '"')
+		{
+			fputc('"', file);
+		}
+		fputc(data[i], file);
+	}
+	fputc('"', file);
+}
+
+int iso_columnar_init(struct iso_columnar *columnar, const int *fields, int field_count)
+{
+	struct fi_field_info fi_field;
+	struct iso_column *column = NULL;
+	int i = 0;
+
+	if(columnar == NULL || (fields == NULL && field_count > 0) || field_count < 0 || field_count > FI_NUM_FIELD_MAX)
+	{
+		return -1;
+	}
+
+	memset(columnar, 0, sizeof(*columnar));
+
+	// First column is always the mti.
+	columnar->columns[0].field = ISO_COLUMNAR_MTI_FIELD;
+	columnar->columns[0].fixed_length = FI_MTI_LEN_BYTES;
+	columnar->column_count = 1;
+
+	for(i = 0; i < field_count; i++)
+	{
+		if(fields[i] < 2 || fi_get_field_info(fields[i], &fi_field) != 0)
+		{
+			debug_print("Error: [%s]: Invalid field number (%d)\n", __FUNCTION__, fields[i]);
+			return -1;
+		}
+
+		column = &columnar->columns[columnar->column_count++];
+		column->field = fields[i];
+		column->fixed_length = fi_field.is_variable_field ? 0 : fi_field.length;
+
+		if(fields[i] > columnar->last_field)
+		{
+			columnar->last_field = fields[i];
+		}
+	}
+
+	return 0;
+}
+
+void iso_columnar_release(struct iso_columnar *columnar)
+{
+	int i = 0;
+
+	if(columnar == NULL)
+	{
+		return;
+	}
+
+	for(i = 0; i < columnar->column_count; i++)
+	{
+		free(columnar->columns[i].validity);
+		free(columnar->columns[i].offsets);
+		free(columnar->columns[i].data);
+	}
+
+	memset(columnar, 0, sizeof(*columnar));
+}
+
+int iso_columnar_append(struct iso_columnar *columnar, const char *message, int length)
+{
+	struct iso_raw_field fields[FI_NUM_FIELD_MAX];
+	struct iso_raw_field *raw_field = NULL;
+	struct iso_column *column = NULL;
+	int row = 0;
+	int i = 0;
+
+	if(columnar == NULL || message == NULL)
+	{
+		return -1;
+	}
+
+	// Message is validated before any column is changed.
+	if(length < FI_MTI_LEN_BYTES || iso_raw_index_message(message, length, columnar->last_field, fields) < 0)
+	{
+		return -1;
+	}
+
+	if(columnar->row_count == columnar->row_capacity && _iso_columnar_grow_rows(columnar) != 0)
+	{
+		return -1;
+	}
+
+	row = columnar->row_count;
+
+	if(_iso_columnar_append_value(&columnar->columns[0], row, message, FI_MTI_LEN_BYTES) != 0)
+	{
+		return -1;
+	}
+
+	for(i = 1; i < columnar->column_count; i++)
+	{
+		column = &columnar->columns[i];
+		raw_field = &fields[column->field - 1];
+
+		// Fixed length fields always have the spec length (checked by iso_raw_index_message).
+		if(_iso_columnar_append_value(column, row, (raw_field->offset < 0) ? NULL : message + raw_field->offset, raw_field->length) != 0)
+		{
+			_iso_columnar_rollback_row(columnar, row, i);
+			return -1;
+		}
+	}
+
+	columnar->row_count++;
+
+	return 0;
+}
+
+int iso_columnar_concat(struct iso_columnar *columnar, const struct iso_columnar *other)
+{
+	const struct iso_column *src = NULL;
+	const char *data = NULL;
+	int length = 0;
+	int row = 0;
+	int i = 0;
+
+	if(columnar == NULL || other == NULL || columnar->column_count != other->column_count)
+	{
+		return -1;
+	}
+
+	for(i = 0; i < columnar->column_count; i++)
+	{
+		if(columnar->columns[i].field != other->columns[i].field)
+		{
+			return -1;
+		}
+	}
+
+	for(row = 0; row < other->row_count; row++)
+	{
+		if(columnar->row_count == columnar->row_capacity && _iso_columnar_grow_rows(columnar) != 0)
+		{
+			return -1;
+		}
+
+		for(i = 0; i < columnar->column_count; i++)
+		{
+			src = &other->columns[i];
+			data = _iso_columnar_get_value(src, row, &length);
+
+			if(_iso_columnar_append_value(&columnar->columns[i], columnar->row_count, _iso_columnar_is_valid(src, row) ? data : NULL, length) != 0)
+			{
+				_iso_columnar_rollback_row(columnar, columnar->row_count, i);
+				return -1;
+			}
+		}
+
+		columnar->row_count++;
+	}
+
+	return 0;
+}
+
+int iso_columnar_write_binary(const struct iso_columnar *columnar, FILE *file)
+{
+	const struct iso_column *column = NULL;
+	int i = 0;
+	int row = 0;
+
+	if(columnar == NULL || file == NULL)
+	{
+		return -1;
+	}
+
+	if(fwrite(ISO_COLUMNAR_MAGIC, 1, ISO_COLUMNAR_MAGIC_LEN, file) != ISO_COLUMNAR_MAGIC_LEN ||
+		_iso_columnar_write_u32(file, columnar->row_count) != 0 ||
+		_iso_columnar_write_u32(file, columnar->column_count) != 0)
+	{
+		return -1;
+	}
+
+	for(i = 0; i < columnar->column_count; i++)
+	{
+		column = &columnar->columns[i];
+
+		if(_iso_columnar_write_u16(file, column->field) != 0 ||
+			_iso_columnar_write_u16(file, column->fixed_length) != 0 ||
+			_iso_columnar_write_u64(file, column->data_length) != 0)
+		{
+			return -1;
+		}
+	}
+
+	for(i = 0; i < columnar->column_count; i++)
+	{
+		column = &columnar->columns[i];
+
+		if(columnar->row_count > 0 && fwrite(column->validity, 1, (columnar->row_count + 7) / 8, file) != (size_t) (columnar->row_count + 7) / 8)
+		{
+			return -1;
+		}
+
+		if(column->fixed_length == 0)
+		{
+			for(row = 0; row <= columnar->row_count; row++)
+			{
+				if(_iso_columnar_write_u32(file, columnar->row_capacity ? column->offsets[row] : 0) != 0)
+				{
+					return -1;
+				}
+			}
+		}
+
+		if(column->data_length > 0 && fwrite(column->data, 1, column->data_length, file) != column->data_length)
+		{
+			return -1;
+		}
+	}
+
+	return ferror(file) ? -1 : 0;
+}
+
+int iso_columnar_write_csv(const struct iso_columnar *columnar, FILE *file)
+{
+	const struct iso_column *column = NULL;
+	const char *data = NULL;
+	int length = 0;
+	int row = 0;
+	int i = 0;
+
+	if(columnar == NULL || file == NULL)
+	{
+		return -1;
+	}
+
+	fprintf(file, "mti");
+	for(i = 1; i < columnar->column_count; i++)
+	{
+		fprintf(file, ",%d", columnar->columns[i].field);
+	}
+	fputc('\n', file);
+
+	for(row = 0; row < columnar->row_count; row++)
+	{
+		for(i = 0; i < columnar->column_count; i++)
+		{
+			column = &columnar->columns[i];
+
+			if(i > 0)
+			{
+				fputc(',', file);
+			}
+
+			if(_iso_columnar_is_valid(column, row))
+			{
+				data = _iso_columnar_get_value(column, row, &length);
+				_iso_columnar_write_csv_value(file, data, length);
+			}
+		}
+		fputc('\n', file);
+	}
+
+	return ferror(file) ? -1 : 0;
+}
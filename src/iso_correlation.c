@@ -0,0 +1,617 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "iso_correlation.h"
+#include "iso_8583.h"
+#include "iso_raw.h"
+#include "fields_info.h"
+#include "debug.h"
+
+#define ISO_CORR_FNV_OFFSET     14695981039346656037ULL
+#define ISO_CORR_FNV_PRIME      1099511628211ULL
+#define ISO_CORR_SHARD_SHIFT    58 // Top 6 bits of hash select the shard (64 shards).
+#define ISO_CORR_KEY_SEPARATOR  '|'
+
+// Fields used to build the original data elements of reversal.
+#define ISO_CORR_FIELD_STAN             11
+#define ISO_CORR_FIELD_DATE_TIME        7
+#define ISO_CORR_FIELD_DATE_TIME_LOCAL  12
+#define ISO_CORR_FIELD_ACQUIRER         32
+#define ISO_CORR_FIELD_FORWARDING       33
+#define ISO_CORR_FIELD_ORIGINAL_1987    90
+#define ISO_CORR_FIELD_ORIGINAL_1993    56
+
+// Int Vector: Data elements copied from request to reversal (card security data as PIN block and tracks are never copied).
+static const int glb_reversal_fields[] = {2, 3, 4, 5, 6, 7, 11, 12, 13, 24, 32, 33, 37, 38, 41, 42, 49, 50, 51};
+
+struct iso_corr_entry
+{
+	struct iso_corr_entry *next;       // Next entry in the hash bucket.
+	struct iso_corr_entry *wheel_prev; // Previous entry in the wheel slot.
+	struct iso_corr_entry *wheel_next; // Next entry in the wheel slot.
+	unsigned long long deadline;
+	struct iso_corr_key key;
+	void *user_data;
+	int length;
+	char request[]; // Copy of packed request.
+};
+
+struct iso_corr_shard
+{
+	pthread_mutex_t lock;
+	struct iso_corr_entry **buckets;
+	unsigned int bucket_mask;
+	struct iso_corr_entry *wheel[ISO_CORR_WHEEL_SLOTS];
+	unsigned long long tick;
+	int count;
+};
+
+struct iso_corr_table
+{
+	int key_fields[ISO_CORR_MAX_KEY_FIELDS];
+	int key_field_count;
+	int last_key_field;
+	struct iso_corr_shard shards[ISO_CORR_SHARDS];
+};
+
+// Calculate key hash (FNV-1a).
+static unsigned long long _iso_corr_hash(const char *data, int length)
+{
+	unsigned long long hash = ISO_CORR_FNV_OFFSET;
+	int i = 0;
+
+	for(i = 0; i < length; i++)
+	{
+		hash ^= (unsigned char) data[i];
+		hash *= ISO_CORR_FNV_PRIME;
+	}
+
+	return hash;
+}
+
+// Start key with the mti class, request and response of same transaction have the same class (i.e. 0200 and 0210).
+static int _iso_corr_key_start(struct iso_corr_key *key, const char *mti)
+{
+	key->data[0] = mti[0];
+	key->data[1] = mti[1];
+	key->data[2] = (char) (mti[2] & ~1);
+	key->length = 3;
+
+	return 0;
+}
+
+// Append field value to key.
+static int _iso_corr_key_append(struct iso_corr_key *key, const char *data, int length)
+{
+	if(key->length + 1 + length > ISO_CORR_KEY_MAX)
+	{
+		debug_print("Error: [%s]: Key exceeds max length\n", __FUNCTION__);
+		return -1;
+	}
+
+	key->data[key->length++] = ISO_CORR_KEY_SEPARATOR;
+	memcpy(key->data + key->length, data, length);
+	key->length += length;
+
+	return 0;
+}
+
+static void _iso_corr_key_finish(struct iso_corr_key *key)
+{
+	key->hash = _iso_corr_hash(key->data, key->length);
+}
+
+static struct iso_corr_shard *_iso_corr_get_shard(struct iso_corr_table *table, const struct iso_corr_key *key)
+{
+	return &table->shards[key->hash >> ISO_CORR_SHARD_SHIFT];
+}
+
+static int _iso_corr_key_equals(const struct iso_corr_key *a, const struct iso_corr_key *b)
+{
+	return (a->hash == b->hash && a->length == b->length && memcmp(a->data, b->data, a->length) == 0);
+}
+
+// Add entry in the wheel slot of its deadline, shard must be locked.
+static void _iso_corr_wheel_add(struct iso_corr_shard *shard, struct iso_corr_entry *entry)
+{
+	struct iso_corr_entry **slot = &shard->wheel[entry->deadline % ISO_CORR_WHEEL_SLOTS];
+
+	entry->wheel_prev = NULL;
+	entry->wheel_next = *slot;
+	if(*slot != NULL)
+	{
+		(*slot)->wheel_prev = entry;
+	}
+	*slot = entry;
+}
+
+// Remove entry from its wheel slot, shard must be locked.
+static void _iso_corr_wheel_remove(struct iso_corr_shard *shard, struct iso_corr_entry *entry)
+{
+	if(entry->wheel_prev != NULL)
+	{
+		entry->wheel_prev->wheel_next = entry->wheel_next;
+	}
+	else
+	{
+		shard->wheel[entry->deadline % ISO_CORR_WHEEL_SLOTS] = entry->wheel_next;
+	}
+
+	if(entry->wheel_next != NULL)
+	{
+		entry->wheel_next->wheel_prev = entry->wheel_prev;
+	}
+}
+
+// Unlink entry from hash bucket, shard must be locked.
+static void _iso_corr_bucket_remove(struct iso_corr_shard *shard, struct iso_corr_entry *entry)
+{
+	struct iso_corr_entry **p = &shard->buckets[entry->key.hash & shard->bucket_mask];
+
+	while(*p != NULL)
+	{
+		if(*p == entry)
+		{
+			*p = entry->next;
+			return;
+		}
+		p = &(*p)->next;
+	}
+}
+
+struct iso_corr_table *iso_corr_create(int capacity, const int *key_fields, int key_field_count)
+{
+	struct iso_corr_table *table = NULL;
+	unsigned int buckets = 1;
+	int i = 0;
+
+	if(key_fields == NULL || key_field_count < 0 || key_field_count > ISO_CORR_MAX_KEY_FIELDS)
+	{
+		return NULL;
+	}
+
+	table = (struct iso_corr_table *) calloc(1, sizeof(struct iso_corr_table));
+	if(table == NULL)
+	{
+		return NULL;
+	}
+
+	for(i = 0; i < key_field_count; i++)
+	{
+		if(key_fields[i] < 2 || !fi_is_valid_field(key_fields[i]))
+		{
+			free(table);
+			return NULL;
+		}
+
+		table->key_fields[i] = key_fields[i];
+		if(key_fields[i] > table->last_key_field)
+		{
+			table->last_key_field = key_fields[i];
+		}
+	}
+	table->key_field_count = key_field_count;
+
+	// Buckets of each shard, power of two to use mask.
+	while(buckets * ISO_CORR_SHARDS < (unsigned int) capacity)
+	{
+		buckets <<= 1;
+	}
+
+	for(i = 0; i < ISO_CORR_SHARDS; i++)
+	{
+		pthread_mutex_init(&table->shards[i].lock, NULL);
+		table->shards[i].bucket_mask = buckets - 1;
+		table->shards[i].buckets = (struct iso_corr_entry **) calloc(buckets, sizeof(struct iso_corr_entry *));
+		if(table->shards[i].buckets == NULL)
+		{
+			iso_corr_destroy(table);
+			return NULL;
+		}
+	}
+
+	return table;
+}
+
+void iso_corr_destroy(struct iso_corr_table *table)
+{
+	struct iso_corr_entry *entry = NULL;
+	struct iso_corr_entry *next = NULL;
+	int i = 0;
+	int j = 0;
+
+	if(table == NULL)
+	{
+		return;
+	}
+
+	for(i = 0; i < ISO_CORR_SHARDS; i++)
+	{
+		for(j = 0; j < ISO_CORR_WHEEL_SLOTS; j++)
+		{
+			for(entry = table->shards[i].wheel[j]; entry != NULL; entry = next)
+			{
+				next = entry->wheel_next;
+				free(entry);
+			}
+		}
+
+		free(table->shards[i].buckets);
+		pthread_mutex_destroy(&table->shards[i].lock);
+	}
+
+	free(table);
+}
+
+int iso_corr_key_from_raw(const struct iso_corr_table *table, const char *message, int length, struct iso_corr_key *key)
+{
+	struct iso_raw_field fields[FI_NUM_FIELD_MAX];
+	struct iso_raw_field *field = NULL;
+	char mti[FI_MTI_LEN_BYTES + 1];
+	int i = 0;
+
+	if(table == NULL || key == NULL || iso_raw_get_mti(message, length, mti) != 0)
+	{
+		return -1;
+	}
+
+	if(iso_raw_index_message(message, length, table->last_key_field, fields) < 0)
+	{
+		return -1;
+	}
+
+	_iso_corr_key_start(key, mti);
+
+	for(i = 0; i < table->key_field_count; i++)
+	{
+		field = &fields[table->key_fields[i] - 1];
+		if(_iso_corr_key_append(key, (field->offset < 0) ? "" : message + field->offset, field->length) != 0)
+		{
+			return -1;
+		}
+	}
+
+	_iso_corr_key_finish(key);
+
+	return 0;
+}
+
+int iso_corr_key_from_message(const struct iso_corr_table *table, struct iso_corr_key *key)
+{
+	char mti[FI_MTI_LEN_BYTES + 1];
+	const char *data = NULL;
+	int length = 0;
+	int i = 0;
+
+	if(table == NULL || key == NULL || iso_get_mti(mti) != 0)
+	{
+		return -1;
+	}
+
+	_iso_corr_key_start(key, mti);
+
+	// Fields are appended with their explicit length (they may have zero bytes), as located by iso_corr_key_from_raw.
+	for(i = 0; i < table->key_field_count; i++)
+	{
+		if(iso_get_field_view(table->key_fields[i], &data, &length) != 0)
+		{
+			data = "";
+			length = 0;
+		}
+
+		if(_iso_corr_key_append(key, data, length) != 0)
+		{
+			return -1;
+		}
+	}
+
+	_iso_corr_key_finish(key);
+
+	return 0;
+}
+
+int iso_corr_insert(struct iso_corr_table *table, const struct iso_corr_key *key, const char *request, int length, unsigned long long now,
+	unsigned int timeout, void *user_data)
+{
+	struct iso_corr_shard *shard = NULL;
+	struct iso_corr_entry *entry = NULL;
+	struct iso_corr_entry **bucket = NULL;
+	struct iso_corr_entry *p = NULL;
+
+	if(table == NULL || key == NULL || request == NULL || length < 0)
+	{
+		return -1;
+	}
+
+	entry = (struct iso_corr_entry *) malloc(sizeof(struct iso_corr_entry) + length);
+	if(entry == NULL)
+	{
+		return -1;
+	}
+
+	entry->key = *key;
+	entry->user_data = user_data;
+	entry->length = length;
+	memcpy(entry->request, request, length);
+
+	shard = _iso_corr_get_shard(table, key);
+
+	pthread_mutex_lock(&shard->lock);
+
+	bucket = &shard->buckets[key->hash & shard->bucket_mask];
+	for(p = *bucket; p != NULL; p = p->next)
+	{
+		if(_iso_corr_key_equals(&p->key, key))
+		{
+			pthread_mutex_unlock(&shard->lock);
+			free(entry);
+			debug_print("Error: [%s]: Duplicated key\n", __FUNCTION__);
+			return -1;
+		}
+	}
+
+	entry->next = *bucket;
+	*bucket = entry;
+
+	// Expire at least one tick after current one (the wheel may be behind now case it was not advanced yet).
+	entry->deadline = ((now > shard->tick) ? now : shard->tick) + (timeout > 0 ? timeout : 1);
+	_iso_corr_wheel_add(shard, entry);
+
+	shard->count++;
+
+	pthread_mutex_unlock(&shard->lock);
+
+	return 0;
+}
+
+int iso_corr_match(struct iso_corr_table *table, const struct iso_corr_key *key, void **user_data)
+{
+	struct iso_corr_shard *shard = NULL;
+	struct iso_corr_entry **p = NULL;
+	struct iso_corr_entry *entry = NULL;
+
+	if(table == NULL || key == NULL)
+	{
+		return -1;
+	}
+
+	shard = _iso_corr_get_shard(table, key);
+
+	pthread_mutex_lock(&shard->lock);
+
+	for(p = &shard->buckets[key->hash & shard->bucket_mask]; *p != NULL; p = &(*p)->next)
+	{
+		if(_iso_corr_key_equals(&(*p)->key, key))
+		{
+			entry = *p;
+			*p = entry->next;
+			_iso_corr_wheel_remove(shard, entry);
+			shard->count--;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&shard->lock);
+
+	if(entry == NULL)
+	{
+		return -1;
+	}
+
+	if(user_data != NULL)
+	{
+		*user_data = entry->user_data;
+	}
+
+	free(entry);
+
+	return 0;
+}
+
+int iso_corr_advance(struct iso_corr_table *table, unsigned long long now, iso_corr_expired_cb callback, void *context)
+{
+	struct iso_corr_shard *shard = NULL;
+	struct iso_corr_entry *expired = NULL;
+	struct iso_corr_entry *entry = NULL;
+	struct iso_corr_entry *next = NULL;
+	unsigned long long tick = 0;
+	unsigned long long slots = 0;
+	int count = 0;
+	int i = 0;
+
+	if(table == NULL)
+	{
+		return 0;
+	}
+
+	for(i = 0; i < ISO_CORR_SHARDS; i++)
+	{
+		shard = &table->shards[i];
+
+		pthread_mutex_lock(&shard->lock);
+
+		if(now > shard->tick)
+		{
+			// Each slot is visited only once, even when many ticks have passed.
+			slots = now - shard->tick;
+			if(slots > ISO_CORR_WHEEL_SLOTS)
+			{
+				slots = ISO_CORR_WHEEL_SLOTS;
+			}
+
+			for(tick = shard->tick + 1; tick <= shard->tick + slots; tick++)
+			{
+				for(entry = shard->wheel[tick % ISO_CORR_WHEEL_SLOTS]; entry != NULL; entry = next)
+				{
+					next = entry->wheel_next;
+
+					// Entries from next rounds of wheel stay in the slot.
+					if(entry->deadline <= now)
+					{
+						_iso_corr_wheel_remove(shard, entry);
+						_iso_corr_bucket_remove(shard, entry);
+						shard->count--;
+
+						entry->wheel_next = expired;
+						expired = entry;
+					}
+				}
+			}
+
+			shard->tick = now;
+		}
+
+		pthread_mutex_unlock(&shard->lock);
+	}
+
+	// Callbacks are called without locks, so they can insert new requests (i.e. reversals).
+	for(entry = expired; entry != NULL; entry = next)
+	{
+		next = entry->wheel_next;
+
+		if(callback != NULL)
+		{
+			callback(&entry->key, entry->request, entry->length, entry->user_data, context);
+		}
+
+		free(entry);
+		count++;
+	}
+
+	return count;
+}
+
+int iso_corr_count(struct iso_corr_table *table)
+{
+	int count = 0;
+	int i = 0;
+
+	if(table == NULL)
+	{
+		return 0;
+	}
+
+	for(i = 0; i < ISO_CORR_SHARDS; i++)
+	{
+		pthread_mutex_lock(&table->shards[i].lock);
+		count += table->shards[i].count;
+		pthread_mutex_unlock(&table->shards[i].lock);
+	}
+
+	return count;
+}
+
+// Append field to buffer right justified with leading zeros (or truncated to length).
+static void _iso_corr_append_zero_padded(char *buffer, int field, int length)
+{
+	char value[FI_LEN_MAX_ISO];
+	int value_len = 0;
+	int offset = strlen(buffer);
+
+	if(iso_get_field(field, value) != 0)
+	{
+		value[0] = '\0';
+	}
+
+	value_len = strlen(value);
+	if(value_len > length)
+	{
+		value_len = length;
+	}
+
+	memset(buffer + offset, '0', length - value_len);
+	memcpy(buffer + offset + length - value_len, value, value_len);
+	buffer[offset + length] = '\0';
+}
+
+// Check if field is copied from request to reversal.
+static int _iso_corr_is_reversal_field(int field)
+{
+	int i = 0;
+
+	for(i = 0; i < (int) (sizeof(glb_reversal_fields) / sizeof(glb_reversal_fields[0])); i++)
+	{
+		if(glb_reversal_fields[i] == field)
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int iso_corr_make_reversal(const char *request, int length, char *reversal)
+{
+	char message[FI_LEN_MAX_ISO + 1];
+	char mti[FI_MTI_LEN_BYTES + 1];
+	char original[FI_LEN_MAX_ISO];
+	char value[FI_LEN_MAX_ISO];
+	int field = 0;
+
+	if(request == NULL || reversal == NULL || length <= 0 || length > FI_LEN_MAX_ISO)
+	{
+		return -1;
+	}
+
+	memcpy(message, request, length);
+	message[length] = '\0';
+
+	if(iso_decode_message(message) != 0 || iso_get_mti(mti) != 0)
+	{
+		return -1;
+	}
+
+	original[0] = '\0';
+	strcat(original, mti);
+	_iso_corr_append_zero_padded(original, ISO_CORR_FIELD_STAN, fi_get_field_length(ISO_CORR_FIELD_STAN));
+
+	if(fi_get_field_length(ISO_CORR_FIELD_ORIGINAL_1987) == 42 && !fi_is_variable_field_length(ISO_CORR_FIELD_ORIGINAL_1987))
+	{
+		// ISO8583:1987: mti, stan, transmission date and time, acquirer and forwarding institution.
+		_iso_corr_append_zero_padded(original, ISO_CORR_FIELD_DATE_TIME, fi_get_field_length(ISO_CORR_FIELD_DATE_TIME));
+		_iso_corr_append_zero_padded(original, ISO_CORR_FIELD_ACQUIRER, fi_get_field_length(ISO_CORR_FIELD_ACQUIRER));
+		_iso_corr_append_zero_padded(original, ISO_CORR_FIELD_FORWARDING, fi_get_field_length(ISO_CORR_FIELD_FORWARDING));
+
+		if(iso_add_field(ISO_CORR_FIELD_ORIGINAL_1987, original, strlen(original)) != 0)
+		{
+			return -1;
+		}
+	}
+	else
+	{
+		// ISO8583:1993: mti, stan, local date and time, acquirer institution (LLVAR).
+		_iso_corr_append_zero_padded(original, ISO_CORR_FIELD_DATE_TIME_LOCAL, fi_get_field_length(ISO_CORR_FIELD_DATE_TIME_LOCAL));
+		if(iso_get_field(ISO_CORR_FIELD_ACQUIRER, value) == 0)
+		{
+			snprintf(original + strlen(original), sizeof(original) - strlen(original), "%02d%s", (int) strlen(value), value);
+		}
+
+		if(!fi_is_valid_field_value(ISO_CORR_FIELD_ORIGINAL_1993, original) ||
+			iso_add_field(ISO_CORR_FIELD_ORIGINAL_1993, original, strlen(original)) != 0)
+		{
+			return -1;
+		}
+	}
+
+	// Other request fields are removed (field 1 follows the second bitmap).
+	for(field = 2; field <= FI_NUM_FIELD_MAX; field++)
+	{
+		if(field != ISO_CORR_FIELD_ORIGINAL_1987 && field != ISO_CORR_FIELD_ORIGINAL_1993 && !_iso_corr_is_reversal_field(field) &&
+			iso_is_set_field(field) && iso_remove_field(field) != 0)
+		{
+			return -1;
+		}
+	}
+
+	// Reversal keeps version and origin, i.e. 0200 -> 0400, 1100 -> 1400.
+	mti[1] = '4';
+	mti[2] = '0';
+	if(iso_set_mti(mti) != 0)
+	{
+		return -1;
+	}
+
+	return iso_generate_message(reversal);
+}
@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "iso_filter.h"
+#include "iso_raw.h"
+#include "fields_info.h"
+#include "debug.h"
+
+#define ISO_FILTER_MTI_ANY 'x'
+
+// Skip spaces of expression.
+static const char *_iso_filter_skip_spaces(const char *p)
+{
+	while(*p == ' ' || *p == '\t')
+	{
+		p++;
+	}
+	return p;
+}
+
+// Read value of term, stops at space, operators or range separator (when stop_at_range is set).
+static const char *_iso_filter_read_value(const char *p, char *value, int *value_length, int stop_at_range)
+{
+	int length = 0;
+
+	while(*p != '\0' && *p != ' ' && *p != '\t' && *p != '&' && *p != '|')
+	{
+		if(stop_at_range && p[0] == '.' && p[1] == '.')
+		{
+			break;
+		}
+		if(length >= ISO_FILTER_MAX_VALUE)
+		{
+			return NULL;
+		}
+		value[length++] = *p++;
+	}
+
+	value[length] = '\0';
+	*value_length = length;
+
+	return (length > 0) ? p : NULL;
+}
+
+// Read field number of term.
+static const char *_iso_filter_read_field(const char *p, int *field)
+{
+	char *end = NULL;
+
+	if(!isdigit((unsigned char) *p))
+	{
+		return NULL;
+	}
+
+	*field = (int) strtol(p, &end, 10);
+	if(*field < 2 || !fi_is_valid_field(*field))
+	{
+		return NULL;
+	}
+
+	return end;
+}
+
+// Parse one term of expression.
+static const char *_iso_filter_parse_term(const char *p, struct iso_filter_term *term)
+{
+	int i = 0;
+
+	memset(term, 0, sizeof(*term));
+
+	if(*p == '!')
+	{
+		term->negate = 1;
+		p = _iso_filter_skip_spaces(p + 1);
+	}
+
+	if(strncmp(p, "mti=", 4) == 0)
+	{
+		term->op = ISO_FILTER_OP_MTI;
+		p = _iso_filter_read_value(p + 4, term->value, &term->value_length, 0);
+		if(p == NULL || term->value_length != FI_MTI_LEN_BYTES)
+		{
+			return NULL;
+		}
+		for(i = 0; i < FI_MTI_LEN_BYTES; i++)
+		{
+			if(!isdigit((unsigned char) term->value[i]) && term->value[i] != ISO_FILTER_MTI_ANY)
+			{
+				return NULL;
+			}
+		}
+		return p;
+	}
+
+	if(strncmp(p, "has(", 4) == 0)
+	{
+		term->op = ISO_FILTER_OP_HAS;
+		p = _iso_filter_read_field(p + 4, &term->field);
+		if(p == NULL || *p != ')')
+		{
+			return NULL;
+		}
+		return p + 1;
+	}
+
+	p = _iso_filter_read_field(p, &term->field);
+	if(p == NULL)
+	{
+		return NULL;
+	}
+
+	switch(*p)
+	{
+		case '=':
+			term->op = ISO_FILTER_OP_EQUAL;
+			return _iso_filter_read_value(p + 1, term->value, &term->value_length, 0);
+		case '^':
+			term->op = ISO_FILTER_OP_PREFIX;
+			return _iso_filter_read_value(p + 1, term->value, &term->value_length, 0);
+		case ':':
+			term->op = ISO_FILTER_OP_RANGE;
+			p = _iso_filter_read_value(p + 1, term->value, &term->value_length, 1);
+			if(p == NULL || p[0] != '.' || p[1] != '.')
+			{
+				return NULL;
+			}
+			return _iso_filter_read_value(p + 2, term->value_max, &term->value_max_length, 0);
+		default:
+			break;
+	}
+
+	return NULL;
+}
+
+// Check if all characters are digits.
+static int _iso_filter_is_numeric(const char *data, int length)
+{
+	int i = 0;
+
+	for(i = 0; i < length; i++)
+	{
+		if(data[i] < '0' || data[i] > '9')
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+// Compare two values, numerically when both are digits, otherwise lexicographically.
+static int _iso_filter_compare(const char *a, int a_length, const char *b, int b_length)
+{
+	int ret = 0;
+
+	if(_iso_filter_is_numeric(a, a_length) && _iso_filter_is_numeric(b, b_length))
+	{
+		// Skip leading zeros, then the longer number is the greater one.
+		while(a_length > 1 && *a == '0')
+		{
+			a++;
+			a_length--;
+		}
+		while(b_length > 1 && *b == '0')
+		{
+			b++;
+			b_length--;
+		}
+		if(a_length != b_length)
+		{
+			return (a_length < b_length) ? -1 : 1;
+		}
+		return memcmp(a, b, a_length);
+	}
+
+	ret = memcmp(a, b, (a_length < b_length) ? a_length : b_length);
+	if(ret == 0)
+	{
+		ret = a_length - b_length;
+	}
+
+	return ret;
+}
+
+// Evaluate term without negation, returns 1 case match, 0 if not or -1 case message is invalid.
+static int _iso_filter_match_term(const struct iso_filter_term *term, const char *message, int length, int last_field, struct iso_raw_field *fields, int *is_indexed)
+{
+	int i = 0;
+	const char *data = NULL;
+	int data_length = 0;
+
+	switch(term->op)
+	{
+		case ISO_FILTER_OP_MTI:
+			for(i = 0; i < FI_MTI_LEN_BYTES; i++)
+			{
+				if(term->value[i] != ISO_FILTER_MTI_ANY && term->value[i] != message[i])
+				{
+					return 0;
+				}
+			}
+			return 1;
+		case ISO_FILTER_OP_HAS:
+			return iso_raw_is_set_field(message, length, term->field);
+		default:
+			break;
+	}
+
+	// Walk message only once, and only when some field data is needed.
+	if(!*is_indexed)
+	{
+		if(iso_raw_index_message(message, length, last_field, fields) < 0)
+		{
+			return -1;
+		}
+		*is_indexed = 1;
+	}
+
+	if(fields[term->field - 1].offset < 0)
+	{
+		return 0;
+	}
+
+	data = message + fields[term->field - 1].offset;
+	data_length = fields[term->field - 1].length;
+
+	switch(term->op)
+	{
+		case ISO_FILTER_OP_EQUAL:
+			return (data_length == term->value_length && memcmp(data, term->value, data_length) == 0);
+		case ISO_FILTER_OP_PREFIX:
+			return (data_length >= term->value_length && memcmp(data, term->value, term->value_length) == 0);
+		case ISO_FILTER_OP_RANGE:
+			return (_iso_filter_compare(data, data_length, term->value, term->value_length) >= 0 &&
+				_iso_filter_compare(data, data_length, term->value_max, term->value_max_length) <= 0);
+		default:
+			break;
+	}
+
+	return -1;
+}
+
+int iso_filter_compile(const char *expression, struct iso_filter *filter)
+{
+	const char *p = expression;
+	struct iso_filter_term *term = NULL;
+
+	if(expression == NULL || filter == NULL)
+	{
+		return -1;
+	}
+
+	memset(filter, 0, sizeof(*filter));
+
+	p = _iso_filter_skip_spaces(p);
+
+	// Empty expression matches all messages.
+	while(*p != '\0')
+	{
+		if(filter->term_count >= ISO_FILTER_MAX_TERMS)
+		{
+			debug_print("Error: [%s]: Too many terms in filter\n", __FUNCTION__);
+			return -1;
+		}
+
+		term = &filter->terms[filter->term_count];
+
+		p = _iso_filter_parse_term(p, term);
+		if(p == NULL)
+		{
+			debug_print("Error: [%s]: Invalid filter expression [%s]\n", __FUNCTION__, expression);
+			return -1;
+		}
+
+		term->clause = filter->clause_count;
+		filter->term_count++;
+
+		if(term->op != ISO_FILTER_OP_MTI && term->op != ISO_FILTER_OP_HAS && term->field > filter->last_field)
+		{
+			filter->last_field = term->field;
+		}
+
+		p = _iso_filter_skip_spaces(p);
+		if(*p == '\0')
+		{
+			break;
+		}
+
+		if(*p == '&')
+		{
+			filter->clause_count++;
+		}
+		else if(*p != '|')
+		{
+			debug_print("Error: [%s]: Invalid filter expression [%s]\n", __FUNCTION__, expression);
+			return -1;
+		}
+
+		// Expression can not finish with operator.
+		p = _iso_filter_skip_spaces(p + 1);
+		if(*p == '\0')
+		{
+			debug_print("Error: [%s]: Invalid filter expression [%s]\n", __FUNCTION__, expression);
+			return -1;
+		}
+	}
+
+	if(filter->term_count > 0)
+	{
+		filter->clause_count++;
+	}
+
+	return 0;
+}
+
+int iso_filter_match(const struct iso_filter *filter, const char *message, int length)
+{
+	int i = 0;
+	int ret = 0;
+	int clause = 0;
+	int clause_matched = 0;
+	int is_indexed = 0;
+	struct iso_raw_field fields[FI_NUM_FIELD_MAX];
+
+	if(filter == NULL || message == NULL || length < FI_MTI_LEN_BYTES + FI_BITMAP_HEX_BYTES)
+	{
+		return -1;
+	}
+
+	for(i = 0; i < filter->term_count; i++)
+	{
+		// New clause, previous one must be matched.
+		if(filter->terms[i].clause != clause)
+		{
+			if(!clause_matched)
+			{
+				return 0;
+			}
+			clause = filter->terms[i].clause;
+			clause_matched = 0;
+		}
+
+		// Clause already matched by other term.
+		if(clause_matched)
+		{
+			continue;
+		}
+
+		ret = _iso_filter_match_term(&filter->terms[i], message, length, filter->last_field, fields, &is_indexed);
+		if(ret < 0)
+		{
+			return -1;
+		}
+
+		clause_matched = filter->terms[i].negate ? !ret : ret;
+	}
+
+	return (filter->term_count == 0 || clause_matched) ? 1 : 0;
+}
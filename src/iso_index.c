@@ -0,0 +1,458 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "iso_index.h"
+#include "iso_capture.h"
+#include "iso_raw.h"
+#include "debug.h"
+
+#define ISO_INDEX_MIN_SLOTS     16
+#define ISO_INDEX_FNV_OFFSET    14695981039346656037ULL
+#define ISO_INDEX_FNV_PRIME     1099511628211ULL
+
+static unsigned long long _iso_index_hash(const char *key, int length)
+{
+	unsigned long long hash = ISO_INDEX_FNV_OFFSET;
+	int i = 0;
+
+	for(i = 0; i < length; i++)
+	{
+		hash = (hash ^ (unsigned char) key[i]) * ISO_INDEX_FNV_PRIME;
+	}
+
+	return hash;
+}
+
+static void _iso_index_put_u64(unsigned char *data, unsigned long long value)
+{
+	int i = 0;
+
+	for(i = 0; i < 8; i++)
+	{
+		data[i] = (value >> (i * 8)) & 0xFF;
+	}
+}
+
+static unsigned long long _iso_index_get_u64(const unsigned char *data)
+{
+	unsigned long long value = 0;
+	int i = 0;
+
+	for(i = 7; i >= 0; i--)
+	{
+		value = (value << 8) | data[i];
+	}
+
+	return value;
+}
+
+static void _iso_index_put_u32(unsigned char *data, unsigned int value)
+{
+	int i = 0;
+
+	for(i = 0; i < 4; i++)
+	{
+		data[i] = (value >> (i * 8)) & 0xFF;
+	}
+}
+
+static unsigned int _iso_index_get_u32(const unsigned char *data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int) data[3] << 24);
+}
+
+// Check key fields and gets the last one.
+static int _iso_index_last_key_field(const int *key_fields, int key_field_count)
+{
+	int last_field = 0;
+	int i = 0;
+
+	if(key_fields == NULL || key_field_count < 1 || key_field_count > ISO_INDEX_MAX_KEY_FIELDS)
+	{
+		return -1;
+	}
+
+	for(i = 0; i < key_field_count; i++)
+	{
+		if(key_fields[i] < 2 || !fi_is_valid_field(key_fields[i]))
+		{
+			debug_print("Error: [%s]: Invalid key field (%d)\n", __FUNCTION__, key_fields[i]);
+			return -1;
+		}
+		if(key_fields[i] > last_field)
+		{
+			last_field = key_fields[i];
+		}
+	}
+
+	return last_field;
+}
+
+int iso_index_key_from_raw(const int *key_fields, int key_field_count, const char *message, int length, char *key, int capacity)
+{
+	struct iso_raw_field fields[FI_NUM_FIELD_MAX];
+	struct iso_raw_field *field = NULL;
+	int last_field = 0;
+	int key_length = 0;
+	int i = 0;
+
+	last_field = _iso_index_last_key_field(key_fields, key_field_count);
+	if(last_field < 0 || message == NULL || key == NULL || iso_raw_index_message(message, length, last_field, fields) < 0)
+	{
+		return -1;
+	}
+
+	for(i = 0; i < key_field_count; i++)
+	{
+		field = &fields[key_fields[i] - 1];
+
+		if(field->offset < 0 || key_length + field->length + (i > 0) > capacity)
+		{
+			return -1;
+		}
+
+		if(i > 0)
+		{
+			key[key_length++] = ISO_INDEX_KEY_SEPARATOR;
+		}
+		memcpy(key + key_length, message + field->offset, field->length);
+		key_length += field->length;
+	}
+
+	return key_length;
+}
+
+long long iso_index_build(const char *capture_path, int format, const int *key_fields, int key_field_count, const char *index_path)
+{
+	struct iso_capture capture;
+	unsigned char *data = NULL;
+	unsigned char *slot = NULL;
+	const char *message = NULL;
+	char key[ISO_INDEX_MAX_KEY];
+	unsigned long long slot_count = ISO_INDEX_MIN_SLOTS;
+	unsigned long long messages = 0;
+	unsigned long long entries = 0;
+	unsigned long long position = 0;
+	unsigned long long hash = 0;
+	long long offset = 0;
+	long long start = 0;
+	long long next = 0;
+	size_t size = 0;
+	int key_length = 0;
+	int length = 0;
+	int fd = -1;
+	int i = 0;
+
+	if(_iso_index_last_key_field(key_fields, key_field_count) < 0 || index_path == NULL)
+	{
+		return -1;
+	}
+
+	if(iso_capture_open(capture_path, format, &capture) != 0)
+	{
+		return -1;
+	}
+
+	// Table is sized to be at most half full.
+	while((next = iso_capture_next(&capture, offset, &message, &length)) > 0)
+	{
+		offset = next;
+		messages++;
+	}
+	while(slot_count < messages * 2)
+	{
+		slot_count *= 2;
+	}
+
+	size = ISO_INDEX_HEADER_LEN + (size_t) (slot_count * ISO_INDEX_SLOT_LEN);
+
+	fd = open(index_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0 || ftruncate(fd, size) != 0)
+	{
+		debug_print("Error: [%s]: Could not create index [%s]\n", __FUNCTION__, index_path);
+		goto error;
+	}
+
+	data = (unsigned char *) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(data == (unsigned char *) MAP_FAILED)
+	{
+		data = NULL;
+		goto error;
+	}
+
+	offset = 0;
+	while((next = iso_capture_next(&capture, offset, &message, &length)) > 0)
+	{
+		// Slot has the start of message line (empty lines before it are skipped) or its length header.
+		start = (message - capture.data) - ((format == ISO_CAPTURE_BINARY) ? ISO_CAPTURE_BINARY_HEADER : 0);
+
+		key_length = iso_index_key_from_raw(key_fields, key_field_count, message, length, key, sizeof(key));
+		if(key_length >= 0)
+		{
+			hash = _iso_index_hash(key, key_length);
+
+			// Linear probing until an empty slot.
+			position = hash;
+			slot = data + ISO_INDEX_HEADER_LEN + ((position & (slot_count - 1)) * ISO_INDEX_SLOT_LEN);
+			while(_iso_index_get_u64(slot + 8) != 0)
+			{
+				position++;
+				slot = data + ISO_INDEX_HEADER_LEN + ((position & (slot_count - 1)) * ISO_INDEX_SLOT_LEN);
+			}
+
+			_iso_index_put_u64(slot, hash);
+			_iso_index_put_u64(slot + 8, (unsigned long long) start + 1);
+			entries++;
+		}
+
+		offset = next;
+	}
+
+	if(next < 0)
+	{
+		debug_print("Error: [%s]: Invalid capture [%s]\n", __FUNCTION__, capture_path);
+		goto error;
+	}
+
+	// Header is written last, so an interrupted build is not a valid index.
+	_iso_index_put_u32(data + 8, format);
+	_iso_index_put_u32(data + 12, key_field_count);
+	for(i = 0; i < key_field_count; i++)
+	{
+		data[16 + (i * 2)] = key_fields[i] & 0xFF;
+		data[17 + (i * 2)] = (key_fields[i] >> 8) & 0xFF;
+	}
+	_iso_index_put_u64(data + 32, slot_count);
+	_iso_index_put_u64(data + 40, entries);
+	_iso_index_put_u64(data + 48, capture.size);
+	memcpy(data, ISO_INDEX_MAGIC, ISO_INDEX_MAGIC_LEN);
+
+	if(msync(data, size, MS_SYNC) != 0)
+	{
+		goto error;
+	}
+
+	munmap(data, size);
+	close(fd);
+	iso_capture_close(&capture);
+
+	return (long long) entries;
+
+error:
+	if(data != NULL)
+	{
+		munmap(data, size);
+	}
+	if(fd >= 0)
+	{
+		close(fd);
+	}
+	iso_capture_close(&capture);
+
+	return -1;
+}
+
+int iso_index_open(const char *index_path, const char *capture_path, struct iso_index *index)
+{
+	struct stat st;
+	void *data = NULL;
+	int i = 0;
+
+	if(index_path == NULL || capture_path == NULL || index == NULL)
+	{
+		return -1;
+	}
+
+	memset(index, 0, sizeof(*index));
+	index->capture_fd = -1;
+
+	index->fd = open(index_path, O_RDONLY);
+	if(index->fd < 0 || fstat(index->fd, &st) != 0 || st.st_size < ISO_INDEX_HEADER_LEN)
+	{
+		debug_print("Error: [%s]: Could not open index [%s]\n", __FUNCTION__, index_path);
+		iso_index_close(index);
+		return -1;
+	}
+
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, index->fd, 0);
+	if(data == MAP_FAILED)
+	{
+		iso_index_close(index);
+		return -1;
+	}
+
+	// Lookups are random.
+	madvise(data, st.st_size, MADV_RANDOM);
+	index->data = (const unsigned char *) data;
+	index->size = st.st_size;
+
+	index->format = (int) _iso_index_get_u32(index->data + 8);
+	index->key_field_count = (int) _iso_index_get_u32(index->data + 12);
+	index->slot_count = _iso_index_get_u64(index->data + 32);
+	index->entry_count = _iso_index_get_u64(index->data + 40);
+
+	if(memcmp(index->data, ISO_INDEX_MAGIC, ISO_INDEX_MAGIC_LEN) != 0 ||
+		index->key_field_count < 1 || index->key_field_count > ISO_INDEX_MAX_KEY_FIELDS ||
+		index->slot_count == 0 || (index->slot_count & (index->slot_count - 1)) != 0 ||
+		index->slot_count > (index->size - ISO_INDEX_HEADER_LEN) / ISO_INDEX_SLOT_LEN)
+	{
+		debug_print("Error: [%s]: Invalid index [%s]\n", __FUNCTION__, index_path);
+		iso_index_close(index);
+		return -1;
+	}
+
+	for(i = 0; i < index->key_field_count; i++)
+	{
+		index->key_fields[i] = index->data[16 + (i * 2)] | (index->data[17 + (i * 2)] << 8);
+	}
+
+	index->last_field = _iso_index_last_key_field(index->key_fields, index->key_field_count);
+
+	// Capture may have grown after the index was built, but it can not be smaller.
+	index->capture_fd = open(capture_path, O_RDONLY);
+	if(index->last_field < 0 || index->capture_fd < 0 || fstat(index->capture_fd, &st) != 0 ||
+		(unsigned long long) st.st_size < _iso_index_get_u64(index->data + 48))
+	{
+		debug_print("Error: [%s]: Invalid capture [%s] for index [%s]\n", __FUNCTION__, capture_path, index_path);
+		iso_index_close(index);
+		return -1;
+	}
+
+	return 0;
+}
+
+void iso_index_close(struct iso_index *index)
+{
+	if(index == NULL)
+	{
+		return;
+	}
+
+	if(index->data != NULL)
+	{
+		munmap((void *) index->data, index->size);
+	}
+	if(index->fd >= 0)
+	{
+		close(index->fd);
+	}
+	if(index->capture_fd >= 0)
+	{
+		close(index->capture_fd);
+	}
+
+	memset(index, 0, sizeof(*index));
+	index->fd = -1;
+	index->capture_fd = -1;
+}
+
+int iso_index_read(const struct iso_index *index, long long offset, char *message, int capacity)
+{
+	ssize_t ret = 0;
+	int length = 0;
+
+	if(index == NULL || message == NULL || offset < 0 || capacity <= ISO_CAPTURE_BINARY_HEADER)
+	{
+		return -1;
+	}
+
+	ret = pread(index->capture_fd, message, capacity, offset);
+	if(ret <= 0)
+	{
+		return -1;
+	}
+
+	if(index->format == ISO_CAPTURE_BINARY)
+	{
+		if(ret < ISO_CAPTURE_BINARY_HEADER)
+		{
+			return -1;
+		}
+
+		length = ((unsigned char) message[0] << 8) | (unsigned char) message[1];
+		if(length + ISO_CAPTURE_BINARY_HEADER > ret)
+		{
+			return -1;
+		}
+
+		memmove(message, message + ISO_CAPTURE_BINARY_HEADER, length);
+
+		return length;
+	}
+
+	// Line ends at '\n' (or "\r\n") or at the end of file.
+	while(length < ret && message[length] != '\n')
+	{
+		length++;
+	}
+	if(length == ret && ret == capacity)
+	{
+		return -1;
+	}
+	if(length > 0 && message[length - 1] == '\r')
+	{
+		length--;
+	}
+
+	return length;
+}
+
+int iso_index_find(const struct iso_index *index, const char *key, int key_length, unsigned long long *cursor, char *message, int capacity, long long *offset)
+{
+	const unsigned char *slot = NULL;
+	char message_key[ISO_INDEX_MAX_KEY];
+	unsigned long long hash = 0;
+	unsigned long long value = 0;
+	int message_key_length = 0;
+	int length = 0;
+
+	if(index == NULL || key == NULL || key_length < 0 || cursor == NULL || message == NULL)
+	{
+		return -1;
+	}
+
+	hash = _iso_index_hash(key, key_length);
+
+	while(*cursor < index->slot_count)
+	{
+		slot = index->data + ISO_INDEX_HEADER_LEN + (((hash + *cursor) & (index->slot_count - 1)) * ISO_INDEX_SLOT_LEN);
+		(*cursor)++;
+
+		value = _iso_index_get_u64(slot + 8);
+		if(value == 0)
+		{
+			break;
+		}
+
+		if(_iso_index_get_u64(slot) != hash)
+		{
+			continue;
+		}
+
+		length = iso_index_read(index, (long long) value - 1, message, capacity);
+		if(length < 0)
+		{
+			return -1;
+		}
+
+		// Hash collision is checked with the key of message.
+		message_key_length = iso_index_key_from_raw(index->key_fields, index->key_field_count, message, length, message_key, sizeof(message_key));
+		if(message_key_length == key_length && memcmp(message_key, key, key_length) == 0)
+		{
+			if(offset != NULL)
+			{
+				*offset = (long long) value - 1;
+			}
+			return length;
+		}
+	}
+
+	// No more messages, next calls also return 0.
+	*cursor = index->slot_count;
+
+	return 0;
+}
@@ -0,0 +1,959 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "iso_journal.h"
+#include "iso_correlation.h"
+#include "debug.h"
+
+#define ISO_JOURNAL_RECORD_MESSAGE      1
+#define ISO_JOURNAL_RECORD_ACK          2
+#define ISO_JOURNAL_FILE_SUFFIX         ".jnl"
+#define ISO_JOURNAL_FILE_NAME_LEN       20 // 16 hex digits and suffix.
+#define ISO_JOURNAL_CRC_POLY            0xEDB88320U
+// Pending messages are never expired by the correlation table.
+#define ISO_JOURNAL_NO_TIMEOUT          0xFFFFFFFFU
+
+struct iso_journal_segment
+{
+	unsigned long long number;
+	int fd;
+	unsigned char *data;
+	size_t size;
+	size_t used;                  // Offset after the last record.
+	unsigned long long last_id;   // Id of the last message in segment, 0 case there is none.
+};
+
+struct iso_journal_entry
+{
+	unsigned long long id;
+	const char *message;          // Points into segment mapping.
+	int length;
+	unsigned char acked;
+	unsigned char correlated;     // Entry is in the correlation table (messages with duplicated keys are not).
+};
+
+// Range of segment to be synced by group commit.
+struct iso_journal_range
+{
+	unsigned char *data;
+	size_t length;
+};
+
+struct iso_journal
+{
+	char directory[PATH_MAX - ISO_JOURNAL_FILE_NAME_LEN - 1]; // Room for segment file names in PATH_MAX.
+	int directory_fd;
+	size_t segment_size;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct iso_corr_table *table;
+	struct iso_journal_segment *segments;  // Ordered by number, the last one is active.
+	int segment_count;
+	int segment_capacity;
+	unsigned long long next_id;
+	struct iso_journal_entry *entries;     // Ordered by id.
+	int entry_count;
+	int entry_capacity;
+	int head;                              // First entry not acknowledged.
+	int pending;
+	unsigned long long appended;           // Records appended.
+	unsigned long long durable;            // Records durable.
+	unsigned long long durable_segment;    // Segment number and offset until records are durable.
+	size_t durable_offset;
+	int syncing;
+};
+
+static pthread_once_t glb_crc_once = PTHREAD_ONCE_INIT;
+
+// Int Vector: CRC-32 of each byte.
+static unsigned int glb_crc_table[256];
+
+static void _iso_journal_crc_init()
+{
+	unsigned int crc = 0;
+	int i = 0;
+	int j = 0;
+
+	for(i = 0; i < 256; i++)
+	{
+		crc = (unsigned int) i;
+		for(j = 0; j < 8; j++)
+		{
+			crc = (crc & 1) ? (crc >> 1) ^ ISO_JOURNAL_CRC_POLY : (crc >> 1);
+		}
+		glb_crc_table[i] = crc;
+	}
+}
+
+static unsigned int _iso_journal_crc(unsigned int crc, const unsigned char *data, size_t length)
+{
+	size_t i = 0;
+
+	crc = ~crc;
+	for(i = 0; i < length; i++)
+	{
+		crc = glb_crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+
+	return ~crc;
+}
+
+static void _iso_journal_put_u32(unsigned char *data, unsigned int value)
+{
+	int i = 0;
+
+	for(i = 0; i < 4; i++)
+	{
+		data[i] = (value >> (i * 8)) & 0xFF;
+	}
+}
+
+static unsigned int _iso_journal_get_u32(const unsigned char *data)
+{
+	return (unsigned int) data[0] | ((unsigned int) data[1] << 8) | ((unsigned int) data[2] << 16) | ((unsigned int) data[3] << 24);
+}
+
+static void _iso_journal_put_u64(unsigned char *data, unsigned long long value)
+{
+	int i = 0;
+
+	for(i = 0; i < 8; i++)
+	{
+		data[i] = (value >> (i * 8)) & 0xFF;
+	}
+}
+
+static unsigned long long _iso_journal_get_u64(const unsigned char *data)
+{
+	unsigned long long value = 0;
+	int i = 0;
+
+	for(i = 7; i >= 0; i--)
+	{
+		value = (value << 8) | data[i];
+	}
+
+	return value;
+}
+
+static size_t _iso_journal_record_length(size_t length)
+{
+	return (ISO_JOURNAL_RECORD_HEADER_LEN + length + ISO_JOURNAL_ALIGN - 1) & ~((size_t) ISO_JOURNAL_ALIGN - 1);
+}
+
+static void _iso_journal_segment_path(const struct iso_journal *journal, unsigned long long number, char *path)
+{
+	snprintf(path, PATH_MAX, "%s/%016llx%s", journal->directory, number, ISO_JOURNAL_FILE_SUFFIX);
+}
+
+// Find entry by id (binary search), returns its index or -1.
+static int _iso_journal_find(const struct iso_journal *journal, unsigned long long id)
+{
+	int low = 0;
+	int high = journal->entry_count - 1;
+	int middle = 0;
+
+	while(low <= high)
+	{
+		middle = low + ((high - low) / 2);
+		if(journal->entries[middle].id == id)
+		{
+			return middle;
+		}
+		if(journal->entries[middle].id < id)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle - 1;
+		}
+	}
+
+	return -1;
+}
+
+static int _iso_journal_add_entry(struct iso_journal *journal, unsigned long long id, const char *message, int length)
+{
+	struct iso_journal_entry *entries = NULL;
+	int capacity = 0;
+
+	if(journal->entry_count == journal->entry_capacity)
+	{
+		capacity = journal->entry_capacity ? journal->entry_capacity * 2 : 1024;
+		entries = (struct iso_journal_entry *) realloc(journal->entries, capacity * sizeof(struct iso_journal_entry));
+		if(entries == NULL)
+		{
+			return -1;
+		}
+		journal->entries = entries;
+		journal->entry_capacity = capacity;
+	}
+
+	journal->entries[journal->entry_count].id = id;
+	journal->entries[journal->entry_count].message = message;
+	journal->entries[journal->entry_count].length = length;
+	journal->entries[journal->entry_count].acked = 0;
+	journal->entries[journal->entry_count].correlated = 0;
+	journal->entry_count++;
+	journal->pending++;
+
+	return 0;
+}
+
+static void _iso_journal_mark_acked(struct iso_journal *journal, int index)
+{
+	journal->entries[index].acked = 1;
+	journal->pending--;
+
+	while(journal->head < journal->entry_count && journal->entries[journal->head].acked)
+	{
+		journal->head++;
+	}
+}
+
+// Add pending entry in the correlation table, so its response can be matched.
+static void _iso_journal_correlate(struct iso_journal *journal, struct iso_journal_entry *entry)
+{
+	struct iso_corr_key key;
+
+	if(iso_corr_key_from_raw(journal->table, entry->message, entry->length, &key) == 0 &&
+		iso_corr_insert(journal->table, &key, entry->message, 0, 0, ISO_JOURNAL_NO_TIMEOUT, (void *) (size_t) entry->id) == 0)
+	{
+		entry->correlated = 1;
+	}
+}
+
+static int _iso_journal_map_segment(struct iso_journal_segment *segment, int fd, size_t size)
+{
+	void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	if(data == MAP_FAILED)
+	{
+		return -1;
+	}
+
+	segment->fd = fd;
+	segment->data = (unsigned char *) data;
+	segment->size = size;
+
+	return 0;
+}
+
+static void _iso_journal_unmap_segment(struct iso_journal_segment *segment)
+{
+	if(segment->data != NULL)
+	{
+		munmap(segment->data, segment->size);
+	}
+	if(segment->fd >= 0)
+	{
+		close(segment->fd);
+	}
+}
+
+static struct iso_journal_segment *_iso_journal_push_segment(struct iso_journal *journal)
+{
+	struct iso_journal_segment *segments = NULL;
+	int capacity = 0;
+
+	if(journal->segment_count == journal->segment_capacity)
+	{
+		capacity = journal->segment_capacity ? journal->segment_capacity * 2 : 16;
+		segments = (struct iso_journal_segment *) realloc(journal->segments, capacity * sizeof(struct iso_journal_segment));
+		if(segments == NULL)
+		{
+			return NULL;
+		}
+		journal->segments = segments;
+		journal->segment_capacity = capacity;
+	}
+
+	memset(&journal->segments[journal->segment_count], 0, sizeof(struct iso_journal_segment));
+	journal->segments[journal->segment_count].fd = -1;
+
+	return &journal->segments[journal->segment_count++];
+}
+
+// Create new active segment, its file is preallocated and made durable (with directory entry) before use.
+static int _iso_journal_create_segment(struct iso_journal *journal)
+{
+	struct iso_journal_segment *segment = NULL;
+	unsigned long long number = journal->segment_count ? journal->segments[journal->segment_count - 1].number + 1 : 1;
+	char path[PATH_MAX];
+	int fd = -1;
+
+	_iso_journal_segment_path(journal, number, path);
+
+	fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if(fd < 0 || ftruncate(fd, journal->segment_size) != 0 || fsync(fd) != 0 || fsync(journal->directory_fd) != 0)
+	{
+		debug_print("Error: [%s]: Could not create segment [%s]\n", __FUNCTION__, path);
+		if(fd >= 0)
+		{
+			close(fd);
+			unlink(path);
+		}
+		return -1;
+	}
+
+	segment = _iso_journal_push_segment(journal);
+	if(segment == NULL || _iso_journal_map_segment(segment, fd, journal->segment_size) != 0)
+	{
+		if(segment != NULL)
+		{
+			journal->segment_count--;
+		}
+		close(fd);
+		unlink(path);
+		return -1;
+	}
+
+	segment->number = number;
+	segment->used = ISO_JOURNAL_HEADER_LEN;
+	memcpy(segment->data, ISO_JOURNAL_MAGIC, ISO_JOURNAL_MAGIC_LEN);
+	_iso_journal_put_u64(segment->data + 8, number);
+	_iso_journal_put_u64(segment->data + 16, journal->next_id);
+
+	return 0;
+}
+
+// Write record in the active segment (a new one is created case it is full), journal must be locked.
+static unsigned char *_iso_journal_write_record(struct iso_journal *journal, int type, unsigned long long id, const char *data, int length)
+{
+	struct iso_journal_segment *segment = &journal->segments[journal->segment_count - 1];
+	size_t record_length = _iso_journal_record_length(length);
+	unsigned char *record = NULL;
+
+	// Zero length record marks the end of segment, so there is room for its header.
+	if(record_length + ISO_JOURNAL_RECORD_HEADER_LEN > journal->segment_size - ISO_JOURNAL_HEADER_LEN)
+	{
+		debug_print("Error: [%s]: Record exceeds segment size\n", __FUNCTION__);
+		return NULL;
+	}
+
+	if(segment->used + record_length + ISO_JOURNAL_RECORD_HEADER_LEN > segment->size)
+	{
+		if(_iso_journal_create_segment(journal) != 0)
+		{
+			return NULL;
+		}
+		segment = &journal->segments[journal->segment_count - 1];
+	}
+
+	record = segment->data + segment->used;
+	_iso_journal_put_u64(record + 8, id);
+	_iso_journal_put_u32(record + 16, (unsigned int) type);
+	_iso_journal_put_u32(record + 20, 0);
+	if(length > 0)
+	{
+		memcpy(record + ISO_JOURNAL_RECORD_HEADER_LEN, data, length);
+	}
+	_iso_journal_put_u32(record + 4, _iso_journal_crc(0, record + 8, ISO_JOURNAL_RECORD_HEADER_LEN - 8 + length));
+	_iso_journal_put_u32(record, (unsigned int) (ISO_JOURNAL_RECORD_HEADER_LEN + length));
+
+	segment->used += record_length;
+	if(type == ISO_JOURNAL_RECORD_MESSAGE)
+	{
+		segment->last_id = id;
+	}
+	journal->appended++;
+
+	return record;
+}
+
+// Clear segment from offset to its end, pages that are already zero are not written (so they are not synced again).
+static void _iso_journal_clear_tail(struct iso_journal_segment *segment, size_t offset)
+{
+	size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+	size_t end = 0;
+
+	while(offset < segment->size)
+	{
+		end = offset - (offset % page_size) + page_size;
+		if(end > segment->size)
+		{
+			end = segment->size;
+		}
+
+		if(segment->data[offset] != 0 || memcmp(segment->data + offset, segment->data + offset + 1, end - offset - 1) != 0)
+		{
+			memset(segment->data + offset, 0, end - offset);
+		}
+
+		offset = end;
+	}
+}
+
+// Replay records of segment, returns 0 to success or -1 case error.
+static int _iso_journal_replay_segment(struct iso_journal *journal, struct iso_journal_segment *segment)
+{
+	const unsigned char *record = NULL;
+	unsigned long long id = 0;
+	size_t offset = ISO_JOURNAL_HEADER_LEN;
+	size_t length = 0;
+	int index = 0;
+
+	if(memcmp(segment->data, ISO_JOURNAL_MAGIC, ISO_JOURNAL_MAGIC_LEN) != 0 || _iso_journal_get_u64(segment->data + 8) != segment->number)
+	{
+		return -1;
+	}
+
+	if(journal->next_id < _iso_journal_get_u64(segment->data + 16))
+	{
+		journal->next_id = _iso_journal_get_u64(segment->data + 16);
+	}
+
+	while(offset + ISO_JOURNAL_RECORD_HEADER_LEN <= segment->size)
+	{
+		record = segment->data + offset;
+		length = _iso_journal_get_u32(record);
+		if(length == 0)
+		{
+			break;
+		}
+
+		// Torn record of last write.
+		if(length < ISO_JOURNAL_RECORD_HEADER_LEN || length > segment->size - offset ||
+			_iso_journal_get_u32(record + 4) != _iso_journal_crc(0, record + 8, length - 8))
+		{
+			debug_print("Error: [%s]: Torn record at offset %zu of segment %llu\n", __FUNCTION__, offset, segment->number);
+			break;
+		}
+
+		id = _iso_journal_get_u64(record + 8);
+		switch(_iso_journal_get_u32(record + 16))
+		{
+			case ISO_JOURNAL_RECORD_MESSAGE:
+				if(id >= journal->next_id)
+				{
+					if(_iso_journal_add_entry(journal, id, (const char *) record + ISO_JOURNAL_RECORD_HEADER_LEN, (int) (length - ISO_JOURNAL_RECORD_HEADER_LEN)) != 0)
+					{
+						return -1;
+					}
+					journal->next_id = id + 1;
+					segment->last_id = id;
+				}
+				break;
+			case ISO_JOURNAL_RECORD_ACK:
+				// Acks of messages in removed segments are ignored.
+				index = _iso_journal_find(journal, id);
+				if(index >= 0 && !journal->entries[index].acked)
+				{
+					journal->entries[index].acked = 1;
+					journal->pending--;
+				}
+				break;
+		}
+
+		offset += _iso_journal_record_length(length - ISO_JOURNAL_RECORD_HEADER_LEN);
+	}
+
+	// Records after the end may be valid ones of writes that reached the disk while a previous one did not, the rest
+	// of segment is cleared so they are never replayed after next appends (with reused ids).
+	_iso_journal_clear_tail(segment, offset);
+	segment->used = offset;
+
+	return 0;
+}
+
+static int _iso_journal_compare_numbers(const void *a, const void *b)
+{
+	unsigned long long x = *(const unsigned long long *) a;
+	unsigned long long y = *(const unsigned long long *) b;
+
+	return (x > y) - (x < y);
+}
+
+// Open existing segments in order and replay them.
+static int _iso_journal_replay(struct iso_journal *journal)
+{
+	struct iso_journal_segment *segment = NULL;
+	unsigned long long *numbers = NULL;
+	unsigned long long *grown = NULL;
+	struct dirent *directory_entry = NULL;
+	struct stat st;
+	DIR *directory = NULL;
+	char path[PATH_MAX];
+	int count = 0;
+	int capacity = 0;
+	int result = 0;
+	int fd = -1;
+	int i = 0;
+
+	directory = opendir(journal->directory);
+	if(directory == NULL)
+	{
+		return -1;
+	}
+
+	while((directory_entry = readdir(directory)) != NULL)
+	{
+		if(strlen(directory_entry->d_name) != ISO_JOURNAL_FILE_NAME_LEN ||
+			strcmp(directory_entry->d_name + 16, ISO_JOURNAL_FILE_SUFFIX) != 0 ||
+			strspn(directory_entry->d_name, "0123456789abcdef") != 16)
+		{
+			continue;
+		}
+
+		if(count == capacity)
+		{
+			capacity = capacity ? capacity * 2 : 16;
+			grown = (unsigned long long *) realloc(numbers, capacity * sizeof(unsigned long long));
+			if(grown == NULL)
+			{
+				result = -1;
+				break;
+			}
+			numbers = grown;
+		}
+		numbers[count++] = strtoull(directory_entry->d_name, NULL, 16);
+	}
+	closedir(directory);
+
+	if(count > 0)
+	{
+		qsort(numbers, count, sizeof(unsigned long long), _iso_journal_compare_numbers);
+	}
+
+	for(i = 0; result == 0 && i < count; i++)
+	{
+		_iso_journal_segment_path(journal, numbers[i], path);
+
+		fd = open(path, O_RDWR);
+		if(fd < 0 || fstat(fd, &st) != 0 || st.st_size < ISO_JOURNAL_SEGMENT_MIN)
+		{
+			debug_print("Error: [%s]: Invalid segment [%s]\n", __FUNCTION__, path);
+			if(fd >= 0)
+			{
+				close(fd);
+			}
+			result = -1;
+			break;
+		}
+
+		segment = _iso_journal_push_segment(journal);
+		if(segment == NULL || _iso_journal_map_segment(segment, fd, st.st_size) != 0)
+		{
+			if(segment != NULL)
+			{
+				journal->segment_count--;
+			}
+			close(fd);
+			result = -1;
+			break;
+		}
+
+		segment->number = numbers[i];
+		if(_iso_journal_replay_segment(journal, segment) != 0)
+		{
+			debug_print("Error: [%s]: Invalid segment [%s]\n", __FUNCTION__, path);
+			result = -1;
+		}
+		// Replayed records may be only in page cache (i.e. process crashed before its commit), and the cleared tail too.
+		else if(fsync(fd) != 0)
+		{
+			debug_print("Error: [%s]: Could not sync segment [%s]\n", __FUNCTION__, path);
+			result = -1;
+		}
+	}
+
+	free(numbers);
+
+	return result;
+}
+
+struct iso_journal *iso_journal_open(const char *directory, size_t segment_size, const int *key_fields, int key_field_count)
+{
+	struct iso_journal *journal = NULL;
+	struct iso_journal_segment *active = NULL;
+	int i = 0;
+
+	if(directory == NULL || strlen(directory) >= PATH_MAX - ISO_JOURNAL_FILE_NAME_LEN - 1 ||
+		(segment_size != 0 && segment_size < ISO_JOURNAL_SEGMENT_MIN))
+	{
+		return NULL;
+	}
+
+	pthread_once(&glb_crc_once, _iso_journal_crc_init);
+
+	journal = (struct iso_journal *) calloc(1, sizeof(struct iso_journal));
+	if(journal == NULL)
+	{
+		return NULL;
+	}
+
+	strcpy(journal->directory, directory);
+	journal->segment_size = segment_size ? segment_size : ISO_JOURNAL_SEGMENT_DEFAULT;
+	journal->next_id = 1;
+	pthread_mutex_init(&journal->lock, NULL);
+	pthread_cond_init(&journal->cond, NULL);
+
+	if(mkdir(directory, 0755) != 0 && errno != EEXIST)
+	{
+		debug_print("Error: [%s]: Could not create directory [%s]\n", __FUNCTION__, directory);
+		journal->directory_fd = -1;
+		iso_journal_close(journal);
+		return NULL;
+	}
+
+	journal->directory_fd = open(directory, O_RDONLY | O_DIRECTORY);
+	journal->table = iso_corr_create(1024, key_fields, key_field_count);
+	if(journal->directory_fd < 0 || journal->table == NULL || _iso_journal_replay(journal) != 0 ||
+		(journal->segment_count == 0 && _iso_journal_create_segment(journal) != 0))
+	{
+		iso_journal_close(journal);
+		return NULL;
+	}
+
+	while(journal->head < journal->entry_count && journal->entries[journal->head].acked)
+	{
+		journal->head++;
+	}
+	for(i = journal->head; i < journal->entry_count; i++)
+	{
+		if(!journal->entries[i].acked)
+		{
+			_iso_journal_correlate(journal, &journal->entries[i]);
+		}
+	}
+
+	// Replayed records are durable (segments were synced by replay), appends continue in the last segment.
+	active = &journal->segments[journal->segment_count - 1];
+	journal->durable_segment = active->number;
+	journal->durable_offset = active->used;
+
+	return journal;
+}
+
+int iso_journal_close(struct iso_journal *journal)
+{
+	int result = 0;
+	int i = 0;
+
+	if(journal == NULL)
+	{
+		return -1;
+	}
+
+	if(journal->segment_count > 0)
+	{
+		result = iso_journal_commit(journal);
+	}
+
+	for(i = 0; i < journal->segment_count; i++)
+	{
+		_iso_journal_unmap_segment(&journal->segments[i]);
+	}
+	if(journal->directory_fd >= 0)
+	{
+		close(journal->directory_fd);
+	}
+
+	iso_corr_destroy(journal->table);
+	pthread_mutex_destroy(&journal->lock);
+	pthread_cond_destroy(&journal->cond);
+	free(journal->segments);
+	free(journal->entries);
+	free(journal);
+
+	return result;
+}
+
+unsigned long long iso_journal_append(struct iso_journal *journal, const char *message, int length)
+{
+	unsigned char *record = NULL;
+	unsigned long long id = 0;
+
+	if(journal == NULL || message == NULL || length <= 0)
+	{
+		return 0;
+	}
+
+	pthread_mutex_lock(&journal->lock);
+
+	record = _iso_journal_write_record(journal, ISO_JOURNAL_RECORD_MESSAGE, journal->next_id, message, length);
+	if(record != NULL && _iso_journal_add_entry(journal, journal->next_id, (const char *) record + ISO_JOURNAL_RECORD_HEADER_LEN, length) == 0)
+	{
+		id = journal->next_id++;
+		_iso_journal_correlate(journal, &journal->entries[journal->entry_count - 1]);
+	}
+
+	pthread_mutex_unlock(&journal->lock);
+
+	return id;
+}
+
+int iso_journal_commit(struct iso_journal *journal)
+{
+	struct iso_journal_range *ranges = NULL;
+	struct iso_journal_segment *segment = NULL;
+	unsigned long long target = 0;
+	unsigned long long sync_to = 0;
+	unsigned long long end_segment = 0;
+	size_t end_offset = 0;
+	size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+	size_t start = 0;
+	int range_count = 0;
+	int result = 0;
+	int i = 0;
+
+	if(journal == NULL)
+	{
+		return -1;
+	}
+
+	pthread_mutex_lock(&journal->lock);
+
+	target = journal->appended;
+	while(result == 0 && journal->durable < target)
+	{
+		// Other thread is syncing, its msync may cover our records.
+		if(journal->syncing)
+		{
+			pthread_cond_wait(&journal->cond, &journal->lock);
+			continue;
+		}
+
+		journal->syncing = 1;
+		sync_to = journal->appended;
+		end_segment = journal->segments[journal->segment_count - 1].number;
+		end_offset = journal->segments[journal->segment_count - 1].used;
+
+		ranges = (struct iso_journal_range *) malloc(journal->segment_count * sizeof(struct iso_journal_range));
+		range_count = 0;
+		for(i = 0; ranges != NULL && i < journal->segment_count; i++)
+		{
+			segment = &journal->segments[i];
+			if(segment->number < journal->durable_segment)
+			{
+				continue;
+			}
+
+			start = (segment->number == journal->durable_segment) ? journal->durable_offset : 0;
+			start -= start % page_size;
+			ranges[range_count].data = segment->data + start;
+			ranges[range_count].length = ((segment->number == end_segment) ? end_offset : segment->used) - start;
+			range_count++;
+		}
+
+		// Segments being synced are not removed by compaction (they are not older than the durable segment).
+		pthread_mutex_unlock(&journal->lock);
+		for(i = 0; i < range_count; i++)
+		{
+			if(msync(ranges[i].data, ranges[i].length, MS_SYNC) != 0)
+			{
+				debug_print("Error: [%s]: Could not sync journal [%s]\n", __FUNCTION__, journal->directory);
+				result = -1;
+				break;
+			}
+		}
+		free(ranges);
+		pthread_mutex_lock(&journal->lock);
+
+		if(ranges == NULL)
+		{
+			result = -1;
+		}
+		if(result == 0)
+		{
+			journal->durable = sync_to;
+			journal->durable_segment = end_segment;
+			journal->durable_offset = end_offset;
+		}
+		journal->syncing = 0;
+		pthread_cond_broadcast(&journal->cond);
+	}
+
+	pthread_mutex_unlock(&journal->lock);
+
+	return result;
+}
+
+// Acknowledge entry, journal must be locked.
+static int _iso_journal_ack_entry(struct iso_journal *journal, int index)
+{
+	if(_iso_journal_write_record(journal, ISO_JOURNAL_RECORD_ACK, journal->entries[index].id, NULL, 0) == NULL)
+	{
+		return -1;
+	}
+
+	_iso_journal_mark_acked(journal, index);
+
+	return 0;
+}
+
+int iso_journal_ack(struct iso_journal *journal, unsigned long long id)
+{
+	struct iso_journal_entry *entry = NULL;
+	struct iso_corr_key key;
+	int index = 0;
+	int result = -1;
+
+	if(journal == NULL)
+	{
+		return -1;
+	}
+
+	pthread_mutex_lock(&journal->lock);
+
+	index = _iso_journal_find(journal, id);
+	if(index >= 0 && !journal->entries[index].acked)
+	{
+		entry = &journal->entries[index];
+		if(entry->correlated && iso_corr_key_from_raw(journal->table, entry->message, entry->length, &key) == 0)
+		{
+			iso_corr_match(journal->table, &key, NULL);
+		}
+		result = _iso_journal_ack_entry(journal, index);
+	}
+
+	pthread_mutex_unlock(&journal->lock);
+
+	return result;
+}
+
+int iso_journal_ack_response(struct iso_journal *journal, const char *response, int length, unsigned long long *id)
+{
+	struct iso_corr_key key;
+	void *user_data = NULL;
+	int index = 0;
+	int result = 0;
+
+	if(journal == NULL || response == NULL || iso_corr_key_from_raw(journal->table, response, length, &key) != 0)
+	{
+		return -1;
+	}
+
+	pthread_mutex_lock(&journal->lock);
+
+	if(iso_corr_match(journal->table, &key, &user_data) == 0)
+	{
+		index = _iso_journal_find(journal, (unsigned long long) (size_t) user_data);
+		if(index >= 0 && !journal->entries[index].acked)
+		{
+			result = (_iso_journal_ack_entry(journal, index) == 0) ? 1 : -1;
+			if(result == 1 && id != NULL)
+			{
+				*id = journal->entries[index].id;
+			}
+		}
+	}
+
+	pthread_mutex_unlock(&journal->lock);
+
+	return result;
+}
+
+int iso_journal_next_pending(struct iso_journal *journal, unsigned long long after_id, const char **message, int *length, unsigned long long *id)
+{
+	int result = 0;
+	int i = 0;
+
+	if(journal == NULL || message == NULL || length == NULL || id == NULL)
+	{
+		return -1;
+	}
+
+	pthread_mutex_lock(&journal->lock);
+
+	for(i = journal->head; i < journal->entry_count; i++)
+	{
+		if(journal->entries[i].id > after_id && !journal->entries[i].acked)
+		{
+			*message = journal->entries[i].message;
+			*length = journal->entries[i].length;
+			*id = journal->entries[i].id;
+			result = 1;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&journal->lock);
+
+	return result;
+}
+
+int iso_journal_pending_count(struct iso_journal *journal)
+{
+	int pending = 0;
+
+	if(journal == NULL)
+	{
+		return 0;
+	}
+
+	pthread_mutex_lock(&journal->lock);
+	pending = journal->pending;
+	pthread_mutex_unlock(&journal->lock);
+
+	return pending;
+}
+
+int iso_journal_compact(struct iso_journal *journal)
+{
+	struct iso_journal_segment *segment = NULL;
+	unsigned long long first_pending = 0;
+	char path[PATH_MAX];
+	int removed = 0;
+	int result = 0;
+
+	if(journal == NULL)
+	{
+		return -1;
+	}
+
+	pthread_mutex_lock(&journal->lock);
+
+	first_pending = (journal->head < journal->entry_count) ? journal->entries[journal->head].id : journal->next_id;
+
+	// The active segment is kept, so journal always has the next message id in a header.
+	while(journal->segment_count - removed > 1)
+	{
+		segment = &journal->segments[removed];
+		if(segment->number >= journal->durable_segment || segment->last_id >= first_pending)
+		{
+			break;
+		}
+
+		_iso_journal_segment_path(journal, segment->number, path);
+		_iso_journal_unmap_segment(segment);
+		if(unlink(path) != 0)
+		{
+			debug_print("Error: [%s]: Could not remove segment [%s]\n", __FUNCTION__, path);
+			result = -1;
+		}
+		removed++;
+	}
+
+	if(removed > 0)
+	{
+		memmove(journal->segments, journal->segments + removed, (journal->segment_count - removed) * sizeof(struct iso_journal_segment));
+		journal->segment_count -= removed;
+		if(fsync(journal->directory_fd) != 0)
+		{
+			result = -1;
+		}
+	}
+
+	// Acknowledged entries before the first pending one are not needed anymore (their segments may be removed).
+	if(journal->head > 0)
+	{
+		memmove(journal->entries, journal->entries + journal->head, (journal->entry_count - journal->head) * sizeof(struct iso_journal_entry));
+		journal->entry_count -= journal->head;
+		journal->head = 0;
+	}
+
+	pthread_mutex_unlock(&journal->lock);
+
+	return (result == 0) ? removed : -1;
+}
@@ -0,0 +1,487 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "iso_json.h"
+#include "iso_raw.h"
+#include "iso_8583.h"
+#include "fields_info.h"
+#include "debug.h"
+
+// Field values are decoded into stack buffer, sized to the hex string (double length) of the longest 'b' LLLVAR field.
+#define ISO_JSON_FIELD_MAX  999
+#define ISO_JSON_VALUE_MAX  ((ISO_JSON_FIELD_MAX * 2) + 1)
+#define ISO_JSON_KEY_MAX    16
+
+// Struct: Json output buffer.
+struct _iso_json_writer
+{
+	char *json;
+	int capacity;
+	int position;
+};
+
+// Struct: Json input cursor.
+struct _iso_json_reader
+{
+	const char *json;
+	int length;
+	int position;
+};
+
+// String: Hex digits.
+static const char glb_json_hex[] = "0123456789ABCDEF";
+
+// Append data into json, returns -1 case it exceeds capacity (one byte is kept to null terminator).
+static int _iso_json_append(struct _iso_json_writer *writer, const char *data, int length)
+{
+	if(length >= writer->capacity - writer->position)
+	{
+		return -1;
+	}
+
+	memcpy(writer->json + writer->position, data, length);
+	writer->position += length;
+
+	return 0;
+}
+
+// Append string escaped, runs of characters without escape are copied at once.
+static int _iso_json_append_escaped(struct _iso_json_writer *writer, const char *data, int length)
+{
+	char escaped[6] = {'\\', 'u', '0', '0', 0, 0};
+	unsigned char c = 0;
+	int start = 0;
+	int i = 0;
+
+	for(i = 0; i < length; i++)
+	{
+		c = (unsigned char) data[i];
+		if(c >= 0x20 && c < 0x7F && c != '"' && c != '\\')
+		{
+			continue;
+		}
+
+		// Quote and backslash have short escapes, other characters are \u00XX.
+		escaped[1] = (c == '"' || c == '\\') ? (char) c : 'u';
+		escaped[4] = glb_json_hex[c >> 4];
+		escaped[5] = glb_json_hex[c & 0x0F];
+
+		if(_iso_json_append(writer, data + start, i - start) != 0 || _iso_json_append(writer, escaped, (escaped[1] == 'u') ? 6 : 2) != 0)
+		{
+			return -1;
+		}
+
+		start = i + 1;
+	}
+
+	return _iso_json_append(writer, data + start, length - start);
+}
+
+// Append data as hex string.
+static int _iso_json_append_hex(struct _iso_json_writer *writer, const char *data, int length)
+{
+	char *output = NULL;
+	int i = 0;
+
+	if(length * 2 >= writer->capacity - writer->position)
+	{
+		return -1;
+	}
+
+	output = writer->json + writer->position;
+	for(i = 0; i < length; i++)
+	{
+		output[i * 2] = glb_json_hex[(unsigned char) data[i] >> 4];
+		output[(i * 2) + 1] = glb_json_hex[(unsigned char) data[i] & 0x0F];
+	}
+
+	writer->position += length * 2;
+
+	return 0;
+}
+
+// Format key of field, i.e. ,"41":
+static int _iso_json_format_key(char *key, int field)
+{
+	int length = 0;
+
+	key[length++] = ',';
+	key[length++] = '"';
+
+	if(field >= 100)
+	{
+		key[length++] = (char) ('0' + (field / 100));
+	}
+	if(field >= 10)
+	{
+		key[length++] = (char) ('0' + ((field / 10) % 10));
+	}
+	key[length++] = (char) ('0' + (field % 10));
+
+	key[length++] = '"';
+	key[length++] = ':';
+
+	return length;
+}
+
+int iso_json_from_message(const char *message, int length, char *json, int capacity, int flags)
+{
+	struct iso_raw_field raw_fields[FI_NUM_FIELD_MAX];
+	struct _iso_json_writer writer = {json, capacity, 0};
+	struct fi_field_info fi_field;
+	const struct fi_spec *spec = NULL;
+	char mti[FI_MTI_LEN_BYTES + 1];
+	char key[ISO_JSON_KEY_MAX];
+	int ret = 0;
+	int i = 0;
+
+	if(json == NULL || capacity <= 0 || iso_raw_get_mti(message, length, mti) != 0)
+	{
+		debug_print("Error: [%s]: Invalid ISO message!\n", __FUNCTION__);
+		return -1;
+	}
+
+	// One spec for the whole message, fields are located and read with the same one.
+	spec = fi_spec_acquire();
+
+	if(iso_raw_spec_index_message(spec, message, length, FI_NUM_FIELD_MAX, raw_fields) != length)
+	{
+		debug_print("Error: [%s]: Invalid ISO message!\n", __FUNCTION__);
+		fi_spec_release(spec);
+		return -1;
+	}
+
+	ret |= _iso_json_append(&writer, "{\"mti\":\"", 8);
+	ret |= _iso_json_append_escaped(&writer, mti, FI_MTI_LEN_BYTES);
+	ret |= _iso_json_append(&writer, "\"", 1);
+
+	// Field 1 (second bitmap) is implied by the fields.
+	for(i = 2; i <= FI_NUM_FIELD_MAX && ret == 0; i++)
+	{
+		if(raw_fields[i - 1].offset < 0 || fi_spec_get_field_info(spec, i, &fi_field) != 0)
+		{
+			continue;
+		}
+
+		ret |= _iso_json_append(&writer, key, _iso_json_format_key(key, i));
+		ret |= _iso_json_append(&writer, (flags & ISO_JSON_DESCRIPTIONS) ? "{\"value\":\"" : "\"", (flags & ISO_JSON_DESCRIPTIONS) ? 10 : 1);
+
+		if(strcmp((const char *) fi_field.type, FI_TYPE__B) == 0)
+		{
+			ret |= _iso_json_append_hex(&writer, message + raw_fields[i - 1].offset, raw_fields[i - 1].length);
+		}
+		else
+		{
+			ret |= _iso_json_append_escaped(&writer, message + raw_fields[i - 1].offset, raw_fields[i - 1].length);
+		}
+
+		if(flags & ISO_JSON_DESCRIPTIONS)
+		{
+			ret |= _iso_json_append(&writer, "\",\"description\":\"", 17);
+			ret |= _iso_json_append_escaped(&writer, (const char *) fi_field.description, strlen((const char *) fi_field.description));
+			ret |= _iso_json_append(&writer, "\"}", 2);
+		}
+		else
+		{
+			ret |= _iso_json_append(&writer, "\"", 1);
+		}
+	}
+
+	fi_spec_release(spec);
+
+	ret |= _iso_json_append(&writer, "}", 1);
+	if(ret != 0)
+	{
+		debug_print("Error: [%s]: Json exceeds capacity (%d)!\n", __FUNCTION__, capacity);
+		return -1;
+	}
+
+	json[writer.position] = '\0';
+
+	return writer.position;
+}
+
+// Skip json white spaces.
+static void _iso_json_skip_spaces(struct _iso_json_reader *reader)
+{
+	while(reader->position < reader->length &&
+		(reader->json[reader->position] == ' ' || reader->json[reader->position] == '\t' ||
+		reader->json[reader->position] == '\n' || reader->json[reader->position] == '\r'))
+	{
+		reader->position++;
+	}
+}
+
+// Consume character (after white spaces), returns -1 case it is other one.
+static int _iso_json_expect(struct _iso_json_reader *reader, char c)
+{
+	_iso_json_skip_spaces(reader);
+
+	if(reader->position < reader->length && reader->json[reader->position] == c)
+	{
+		reader->position++;
+		return 0;
+	}
+
+	return -1;
+}
+
+// Gets value of hex character or -1 case invalid.
+static int _iso_json_hex_value(char c)
+{
+	const char *digit = (c != '\0') ? strchr(glb_json_hex, (c >= 'a' && c <= 'f') ? c - 'a' + 'A' : c) : NULL;
+
+	return (digit != NULL) ? (int) (digit - glb_json_hex) : -1;
+}
+
+// Parse json string (after white spaces) into output, \u escapes must be up to \u00FF (one byte).
+// Returns the string length or -1 case error.
+static int _iso_json_parse_string(struct _iso_json_reader *reader, char *output, int capacity)
+{
+	const char *json = reader->json;
+	int length = 0;
+	int value = 0;
+	int i = 0;
+	char c = 0;
+
+	if(_iso_json_expect(reader, '"') != 0)
+	{
+		return -1;
+	}
+
+	while(reader->position < reader->length)
+	{
+		c = json[reader->position++];
+		if(c == '"')
+		{
+			return length;
+		}
+
+		if(c == '\\')
+		{
+			if(reader->position >= reader->length)
+			{
+				return -1;
+			}
+
+			switch(json[reader->position++])
+			{
+				case '"':  c = '"';  break;
+				case '\\': c = '\\'; break;
+				case '/':  c = '/';  break;
+				case 'b':  c = '\b'; break;
+				case 'f':  c = '\f'; break;
+				case 'n':  c = '\n'; break;
+				case 'r':  c = '\r'; break;
+				case 't':  c = '\t'; break;
+				case 'u':
+					if(reader->length - reader->position < 4)
+					{
+						return -1;
+					}
+
+					for(i = 0, value = 0; i < 4; i++)
+					{
+						if(_iso_json_hex_value(json[reader->position + i]) < 0)
+						{
+							return -1;
+						}
+						value = (value << 4) | _iso_json_hex_value(json[reader->position + i]);
+					}
+
+					if(value > 0xFF)
+					{
+						return -1;
+					}
+
+					reader->position += 4;
+					c = (char) value;
+					break;
+				default:
+					return -1;
+			}
+		}
+
+		if(length >= capacity)
+		{
+			return -1;
+		}
+
+		output[length++] = c;
+	}
+
+	return -1;
+}
+
+// Parse field value: string or object with "value" (other members are ignored). Returns the value length or -1 case error.
+static int _iso_json_parse_value(struct _iso_json_reader *reader, char *output, int capacity)
+{
+	char key[ISO_JSON_KEY_MAX];
+	char ignored[ISO_JSON_VALUE_MAX];
+	int length = -1;
+	int key_length = 0;
+
+	if(_iso_json_expect(reader, '{') != 0)
+	{
+		return _iso_json_parse_string(reader, output, capacity);
+	}
+
+	if(_iso_json_expect(reader, '}') == 0)
+	{
+		return -1;
+	}
+
+	do
+	{
+		key_length = _iso_json_parse_string(reader, key, sizeof(key));
+		if(key_length < 0 || _iso_json_expect(reader, ':') != 0)
+		{
+			return -1;
+		}
+
+		if(key_length == 5 && memcmp(key, "value", 5) == 0)
+		{
+			length = _iso_json_parse_string(reader, output, capacity);
+		}
+		else if(_iso_json_parse_string(reader, ignored, sizeof(ignored)) < 0)
+		{
+			return -1;
+		}
+	}
+	while(_iso_json_expect(reader, ',') == 0);
+
+	return (_iso_json_expect(reader, '}') == 0) ? length : -1;
+}
+
+// Convert hex string into bytes (in place), returns bytes length or -1 case error.
+static int _iso_json_hex_to_bytes(char *data, int length)
+{
+	int high = 0;
+	int low = 0;
+	int i = 0;
+
+	if(length % 2 != 0)
+	{
+		return -1;
+	}
+
+	for(i = 0; i < length / 2; i++)
+	{
+		high = _iso_json_hex_value(data[i * 2]);
+		low = _iso_json_hex_value(data[(i * 2) + 1]);
+		if(high < 0 || low < 0)
+		{
+			return -1;
+		}
+
+		data[i] = (char) ((high << 4) | low);
+	}
+
+	return length / 2;
+}
+
+// Parse json members into the internal fields.
+static int _iso_json_parse_members(struct _iso_json_reader *reader)
+{
+	struct fi_field_info fi_field;
+	char key[ISO_JSON_KEY_MAX];
+	char value[ISO_JSON_VALUE_MAX];
+	int key_length = 0;
+	int length = 0;
+	int field = 0;
+	int i = 0;
+
+	if(_iso_json_expect(reader, '{') != 0)
+	{
+		return -1;
+	}
+
+	if(_iso_json_expect(reader, '}') == 0)
+	{
+		return 0;
+	}
+
+	do
+	{
+		key_length = _iso_json_parse_string(reader, key, sizeof(key) - 1);
+		if(key_length <= 0 || _iso_json_expect(reader, ':') != 0)
+		{
+			return -1;
+		}
+
+		key[key_length] = '\0';
+
+		length = _iso_json_parse_value(reader, value, sizeof(value) - 1);
+		if(length < 0)
+		{
+			return -1;
+		}
+
+		value[length] = '\0';
+
+		if(strcmp(key, "mti") == 0)
+		{
+			if(length != FI_MTI_LEN_BYTES || iso_set_mti(value) != 0)
+			{
+				return -1;
+			}
+			continue;
+		}
+
+		for(i = 0, field = 0; i < key_length; i++)
+		{
+			if(key[i] < '0' || key[i] > '9' || field > FI_NUM_FIELD_MAX)
+			{
+				return -1;
+			}
+			field = (field * 10) + (key[i] - '0');
+		}
+
+		if(fi_get_field_info(field, &fi_field) != 0)
+		{
+			return -1;
+		}
+
+		if(strcmp((const char *) fi_field.type, FI_TYPE__B) == 0)
+		{
+			length = _iso_json_hex_to_bytes(value, length);
+		}
+
+		if(length < 0 || iso_add_field_bytes(field, value, length) != 0)
+		{
+			debug_print("Error: [%s]: Invalid field (%d)!\n", __FUNCTION__, field);
+			return -1;
+		}
+	}
+	while(_iso_json_expect(reader, ',') == 0);
+
+	return _iso_json_expect(reader, '}');
+}
+
+int iso_json_to_message(const char *json, int length)
+{
+	struct _iso_json_reader reader = {json, length, 0};
+
+	if(json == NULL || length < 0)
+	{
+		return -1;
+	}
+
+	iso_release();
+
+	if(_iso_json_parse_members(&reader) != 0)
+	{
+		debug_print("Error: [%s]: Invalid json at position (%d)!\n", __FUNCTION__, reader.position);
+		iso_release();
+		return -1;
+	}
+
+	_iso_json_skip_spaces(&reader);
+	if(reader.position != reader.length)
+	{
+		iso_release();
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,583 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "iso_mac.h"
+#include "iso_8583.h"
+#include "debug.h"
+
+#define ISO_MAC_DES_BLOCK_LEN       8
+#define ISO_MAC_DES_ROUNDS          16
+#define ISO_MAC_DES_KEY_WORDS       (ISO_MAC_DES_ROUNDS * 2) // Subkey of each round is 8 groups of 6 bits, 4 per word.
+#define ISO_MAC_RETAIL_KEY_LEN      16
+#define ISO_MAC_AES_BLOCK_LEN       16
+#define ISO_MAC_CMAC_RB             0x87
+
+// DES tables, bit positions are 1-indexed from the most significant bit (FIPS 46-3).
+static const unsigned char glb_des_ip[64] =
+{
+	58, 50, 42, 34, 26, 18, 10, 2, 60, 52, 44, 36, 28, 20, 12, 4,
+	62, 54, 46, 38, 30, 22, 14, 6, 64, 56, 48, 40, 32, 24, 16, 8,
+	57, 49, 41, 33, 25, 17,  9, 1, 59, 51, 43, 35, 27, 19, 11, 3,
+	61, 53, 45, 37, 29, 21, 13, 5, 63, 55, 47, 39, 31, 23, 15, 7
+};
+
+static const unsigned char glb_des_pc1[56] =
+{
+	57, 49, 41, 33, 25, 17,  9,  1, 58, 50, 42, 34, 26, 18,
+	10,  2, 59, 51, 43, 35, 27, 19, 11,  3, 60, 52, 44, 36,
+	63, 55, 47, 39, 31, 23, 15,  7, 62, 54, 46, 38, 30, 22,
+	14,  6, 61, 53, 45, 37, 29, 21, 13,  5, 28, 20, 12,  4
+};
+
+static const unsigned char glb_des_pc2[48] =
+{
+	14, 17, 11, 24,  1,  5,  3, 28, 15,  6, 21, 10,
+	23, 19, 12,  4, 26,  8, 16,  7, 27, 20, 13,  2,
+	41, 52, 31, 37, 47, 55, 30, 40, 51, 45, 33, 48,
+	44, 49, 39, 56, 34, 53, 46, 42, 50, 36, 29, 32
+};
+
+static const unsigned char glb_des_shifts[ISO_MAC_DES_ROUNDS] = {1, 1, 2, 2, 2, 2, 2, 2, 1, 2, 2, 2, 2, 2, 2, 1};
+
+static const unsigned char glb_des_p[32] =
+{
+	16,  7, 20, 21, 29, 12, 28, 17,  1, 15, 23, 26,  5, 18, 31, 10,
+	 2,  8, 24, 14, 32, 27,  3,  9, 19, 13, 30,  6, 22, 11,  4, 25
+};
+
+static const unsigned char glb_des_s[8][64] =
+{
+	{
+		14,  4, 13,  1,  2, 15, 11,  8,  3, 10,  6, 12,  5,  9,  0,  7,
+		 0, 15,  7,  4, 14,  2, 13,  1, 10,  6, 12, 11,  9,  5,  3,  8,
+		 4,  1, 14,  8, 13,  6,  2, 11, 15, 12,  9,  7,  3, 10,  5,  0,
+		15, 12,  8,  2,  4,  9,  1,  7,  5, 11,  3, 14, 10,  0,  6, 13
+	},
+	{
+		15,  1,  8, 14,  6, 11,  3,  4,  9,  7,  2, 13, 12,  0,  5, 10,
+		 3, 13,  4,  7, 15,  2,  8, 14, 12,  0,  1, 10,  6,  9, 11,  5,
+		 0, 14,  7, 11, 10,  4, 13,  1,  5,  8, 12,  6,  9,  3,  2, 15,
+		13,  8, 10,  1,  3, 15,  4,  2, 11,  6,  7, 12,  0,  5, 14,  9
+	},
+	{
+		10,  0,  9, 14,  6,  3, 15,  5,  1, 13, 12,  7, 11,  4,  2,  8,
+		13,  7,  0,  9,  3,  4,  6, 10,  2,  8,  5, 14, 12, 11, 15,  1,
+		13,  6,  4,  9,  8, 15,  3,  0, 11,  1,  2, 12,  5, 10, 14,  7,
+		 1, 10, 13,  0,  6,  9,  8,  7,  4, 15, 14,  3, 11,  5,  2, 12
+	},
+	{
+		 7, 13, 14,  3,  0,  6,  9, 10,  1,  2,  8,  5, 11, 12,  4, 15,
+		13,  8, 11,  5,  6, 15,  0,  3,  4,  7,  2, 12,  1, 10, 14,  9,
+		10,  6,  9,  0, 12, 11,  7, 13, 15,  1,  3, 14,  5,  2,  8,  4,
+		 3, 15,  0,  6, 10,  1, 13,  8,  9,  4,  5, 11, 12,  7,  2, 14
+	},
+	{
+		 2, 12,  4,  1,  7, 10, 11,  6,  8,  5,  3, 15, 13,  0, 14,  9,
+		14, 11,  2, 12,  4,  7, 13,  1,  5,  0, 15, 10,  3,  9,  8,  6,
+		 4,  2,  1, 11, 10, 13,  7,  8, 15,  9, 12,  5,  6,  3,  0, 14,
+		11,  8, 12,  7,  1, 14,  2, 13,  6, 15,  0,  9, 10,  4,  5,  3
+	},
+	{
+		12,  1, 10, 15,  9,  2,  6,  8,  0, 13,  3,  4, 14,  7,  5, 11,
+		10, 15,  4,  2,  7, 12,  9,  5,  6,  1, 13, 14,  0, 11,  3,  8,
+		 9, 14, 15,  5,  2,  8, 12,  3,  7,  0,  4, 10,  1, 13, 11,  6,
+		 4,  3,  2, 12,  9,  5, 15, 10, 11, 14,  1,  7,  6,  0,  8, 13
+	},
+	{
+		 4, 11,  2, 14, 15,  0,  8, 13,  3, 12,  9,  7,  5, 10,  6,  1,
+		13,  0, 11,  7,  4,  9,  1, 10, 14,  3,  5, 12,  2, 15,  8,  6,
+		 1,  4, 11, 13, 12,  3,  7, 14, 10, 15,  6,  8,  0,  5,  9,  2,
+		 6, 11, 13,  8,  1,  4, 10,  7,  9,  5,  0, 15, 14,  2,  3, 12
+	},
+	{
+		13,  2,  8,  4,  6, 15, 11,  1, 10,  9,  3, 14,  5,  0, 12,  7,
+		 1, 15, 13,  8, 10,  3,  7,  4, 12,  5,  6, 11,  0, 14,  9,  2,
+		 7, 11,  4,  1,  9, 12, 14,  2,  0,  6, 10, 13, 15,  3,  5,  8,
+		 2,  1, 14,  7,  4, 10,  8, 13, 15, 12,  9,  0,  3,  5,  6, 11
+	}
+};
+
+static pthread_once_t glb_mac_once = PTHREAD_ONCE_INIT;
+
+// Int Vector: DES final permutation (inverse of initial permutation).
+static unsigned char glb_des_fp[64];
+
+// Int Matrix: DES S-boxes combined with permutation P, indexed by the 6 bits input of each box.
+static unsigned int glb_des_sp[8][64];
+
+// Byte Vector: AES S-box.
+static unsigned char glb_aes_sbox[256];
+
+// Int Matrix: AES round tables (SubBytes, ShiftRows and MixColumns of one byte in each column position).
+static unsigned int glb_aes_te[4][256];
+
+// Apply bit permutation, output bit i is input bit table[i] (bits are 1-indexed from the most significant of input_bits).
+static unsigned long long _iso_mac_permute(unsigned long long input, int input_bits, const unsigned char *table, int output_bits)
+{
+	unsigned long long output = 0;
+	int i = 0;
+
+	for(i = 0; i < output_bits; i++)
+	{
+		output = (output << 1) | ((input >> (input_bits - table[i])) & 1);
+	}
+
+	return output;
+}
+
+static unsigned char _iso_mac_xtime(unsigned char value)
+{
+	return (unsigned char) ((value << 1) ^ ((value & 0x80) ? 0x1B : 0));
+}
+
+// Build DES and AES tables derived from the standard ones.
+static void _iso_mac_tables_init()
+{
+	unsigned char inverse[256];
+	unsigned char p = 1;
+	unsigned char q = 1;
+	unsigned char s = 0;
+	unsigned char s2 = 0;
+	unsigned int word = 0;
+	int row = 0;
+	int column = 0;
+	int i = 0;
+	int j = 0;
+
+	for(i = 0; i < 64; i++)
+	{
+		glb_des_fp[glb_des_ip[i] - 1] = (unsigned char) (i + 1);
+	}
+
+	for(i = 0; i < 8; i++)
+	{
+		for(j = 0; j < 64; j++)
+		{
+			// Outer bits select the row, inner bits the column.
+			row = ((j >> 4) & 2) | (j & 1);
+			column = (j >> 1) & 0xF;
+			word = (unsigned int) glb_des_s[i][(row * 16) + column] << (28 - (i * 4));
+			glb_des_sp[i][j] = (unsigned int) _iso_mac_permute(word, 32, glb_des_p, 32);
+		}
+	}
+
+	// Multiplicative inverses in GF(2^8), walking powers of generator 3 and its inverse.
+	inverse[0] = 0;
+	do
+	{
+		p = p ^ _iso_mac_xtime(p);
+		q ^= q << 1;
+		q ^= q << 2;
+		q ^= q << 4;
+		q ^= (q & 0x80) ? 0x09 : 0;
+		inverse[p] = q;
+	}
+	while(p != 1);
+	inverse[1] = 1;
+
+	for(i = 0; i < 256; i++)
+	{
+		q = inverse[i];
+		s = q ^ (unsigned char) ((q << 1) | (q >> 7)) ^ (unsigned char) ((q << 2) | (q >> 6)) ^
+			(unsigned char) ((q << 3) | (q >> 5)) ^ (unsigned char) ((q << 4) | (q >> 4)) ^ 0x63;
+		glb_aes_sbox[i] = s;
+
+		s2 = _iso_mac_xtime(s);
+		word = ((unsigned int) s2 << 24) | ((unsigned int) s << 16) | ((unsigned int) s << 8) | (unsigned int) (s2 ^ s);
+		for(j = 0; j < 4; j++)
+		{
+			glb_aes_te[j][i] = (word >> (j * 8)) | (word << ((32 - (j * 8)) & 31));
+		}
+	}
+}
+
+static unsigned long long _iso_mac_get_u64(const unsigned char *data)
+{
+	unsigned long long value = 0;
+	int i = 0;
+
+	for(i = 0; i < 8; i++)
+	{
+		value = (value << 8) | data[i];
+	}
+
+	return value;
+}
+
+static void _iso_mac_put_u64(unsigned char *data, unsigned long long value)
+{
+	int i = 0;
+
+	for(i = 7; i >= 0; i--)
+	{
+		data[i] = (unsigned char) (value & 0xFF);
+		value >>= 8;
+	}
+}
+
+static unsigned int _iso_mac_get_u32(const unsigned char *data)
+{
+	return ((unsigned int) data[0] << 24) | ((unsigned int) data[1] << 16) | ((unsigned int) data[2] << 8) | (unsigned int) data[3];
+}
+
+static void _iso_mac_put_u32(unsigned char *data, unsigned int value)
+{
+	data[0] = (unsigned char) (value >> 24);
+	data[1] = (unsigned char) (value >> 16);
+	data[2] = (unsigned char) (value >> 8);
+	data[3] = (unsigned char) value;
+}
+
+// Compute DES subkeys of 8 bytes key, each round subkey is stored as 8 groups of 6 bits in 2 words.
+static void _iso_mac_des_set_key(unsigned int *subkeys, const unsigned char *key)
+{
+	unsigned long long cd = _iso_mac_permute(_iso_mac_get_u64(key), 64, glb_des_pc1, 56);
+	unsigned long long c = cd >> 28;
+	unsigned long long d = cd & 0xFFFFFFF;
+	unsigned long long subkey = 0;
+	int round = 0;
+	int i = 0;
+
+	for(round = 0; round < ISO_MAC_DES_ROUNDS; round++)
+	{
+		for(i = 0; i < glb_des_shifts[round]; i++)
+		{
+			c = ((c << 1) | (c >> 27)) & 0xFFFFFFF;
+			d = ((d << 1) | (d >> 27)) & 0xFFFFFFF;
+		}
+
+		subkey = _iso_mac_permute((c << 28) | d, 56, glb_des_pc2, 48);
+		subkeys[round * 2] = 0;
+		subkeys[(round * 2) + 1] = 0;
+		for(i = 0; i < 8; i++)
+		{
+			subkeys[(round * 2) + (i / 4)] |= (unsigned int) ((subkey >> (42 - (i * 6))) & 0x3F) << (24 - ((i % 4) * 8));
+		}
+	}
+}
+
+// DES f function: expansion, subkey, S-boxes and P.
+static unsigned int _iso_mac_des_f(unsigned int r, const unsigned int *subkey)
+{
+	unsigned int output = 0;
+	unsigned int group = 0;
+	int shift = 0;
+	int i = 0;
+
+	for(i = 0; i < 8; i++)
+	{
+		// Expansion group i is bits 4i to 4i + 5 of r (1-indexed, bit 0 is bit 32), rotated to the low bits.
+		shift = (27 - (i * 4)) & 31;
+		group = ((r >> shift) | (r << ((32 - shift) & 31))) & 0x3F;
+		output ^= glb_des_sp[i][group ^ ((subkey[i / 4] >> (24 - ((i % 4) * 8))) & 0x3F)];
+	}
+
+	return output;
+}
+
+// DES of one block, decryption uses subkeys in reverse order.
+static unsigned long long _iso_mac_des(const unsigned int *subkeys, unsigned long long block, int decrypt)
+{
+	unsigned long long permuted = _iso_mac_permute(block, 64, glb_des_ip, 64);
+	unsigned int l = (unsigned int) (permuted >> 32);
+	unsigned int r = (unsigned int) permuted;
+	unsigned int t = 0;
+	int round = 0;
+
+	for(round = 0; round < ISO_MAC_DES_ROUNDS; round++)
+	{
+		t = r;
+		r = l ^ _iso_mac_des_f(r, subkeys + ((decrypt ? ISO_MAC_DES_ROUNDS - 1 - round : round) * 2));
+		l = t;
+	}
+
+	return _iso_mac_permute(((unsigned long long) r << 32) | l, 64, glb_des_fp, 64);
+}
+
+static int _iso_mac_retail_set_key(struct iso_mac *mac, const unsigned char *key, int length)
+{
+	if(length != ISO_MAC_RETAIL_KEY_LEN)
+	{
+		return -1;
+	}
+
+	_iso_mac_des_set_key(mac->schedule, key);
+	_iso_mac_des_set_key(mac->schedule + ISO_MAC_DES_KEY_WORDS, key + ISO_MAC_DES_BLOCK_LEN);
+
+	return 0;
+}
+
+// CBC with left key.
+static void _iso_mac_retail_update(struct iso_mac *mac, const unsigned char *data, int length)
+{
+	unsigned long long chain = _iso_mac_get_u64(mac->chain);
+	int i = 0;
+
+	for(i = 0; i < length; i += ISO_MAC_DES_BLOCK_LEN)
+	{
+		chain = _iso_mac_des(mac->schedule, chain ^ _iso_mac_get_u64(data + i), 0);
+	}
+
+	_iso_mac_put_u64(mac->chain, chain);
+}
+
+// Last block padded with zeros (padding method 1), then decrypted with right key and encrypted with left key.
+static void _iso_mac_retail_final(struct iso_mac *mac, const unsigned char *block, int length, unsigned char *output)
+{
+	unsigned char last[ISO_MAC_DES_BLOCK_LEN];
+	unsigned long long chain = _iso_mac_get_u64(mac->chain);
+
+	memset(last, 0, sizeof(last));
+	memcpy(last, block, length);
+
+	chain = _iso_mac_des(mac->schedule, chain ^ _iso_mac_get_u64(last), 0);
+	chain = _iso_mac_des(mac->schedule + ISO_MAC_DES_KEY_WORDS, chain, 1);
+	chain = _iso_mac_des(mac->schedule, chain, 0);
+
+	_iso_mac_put_u64(output, chain);
+}
+
+// Encrypt AES block with round keys of mac.
+static void _iso_mac_aes_encrypt(const struct iso_mac *mac, const unsigned char *input, unsigned char *output)
+{
+	const unsigned int *rk = mac->schedule;
+	unsigned int s[4];
+	unsigned int t[4];
+	int round = 0;
+	int i = 0;
+
+	for(i = 0; i < 4; i++)
+	{
+		s[i] = _iso_mac_get_u32(input + (i * 4)) ^ rk[i];
+	}
+
+	for(round = 1; round < mac->rounds; round++)
+	{
+		rk += 4;
+		for(i = 0; i < 4; i++)
+		{
+			t[i] = glb_aes_te[0][s[i] >> 24] ^ glb_aes_te[1][(s[(i + 1) % 4] >> 16) & 0xFF] ^
+				glb_aes_te[2][(s[(i + 2) % 4] >> 8) & 0xFF] ^ glb_aes_te[3][s[(i + 3) % 4] & 0xFF] ^ rk[i];
+		}
+		memcpy(s, t, sizeof(s));
+	}
+
+	// Last round has no MixColumns.
+	rk += 4;
+	for(i = 0; i < 4; i++)
+	{
+		t[i] = ((unsigned int) glb_aes_sbox[s[i] >> 24] << 24) | ((unsigned int) glb_aes_sbox[(s[(i + 1) % 4] >> 16) & 0xFF] << 16) |
+			((unsigned int) glb_aes_sbox[(s[(i + 2) % 4] >> 8) & 0xFF] << 8) | (unsigned int) glb_aes_sbox[s[(i + 3) % 4] & 0xFF];
+		_iso_mac_put_u32(output + (i * 4), t[i] ^ rk[i]);
+	}
+}
+
+// Shift block left one bit, xor Rb case the most significant bit was set (CMAC subkeys).
+static void _iso_mac_cmac_double(const unsigned char *input, unsigned char *output)
+{
+	unsigned char carry = input[0] & 0x80;
+	int i = 0;
+
+	for(i = 0; i < ISO_MAC_AES_BLOCK_LEN - 1; i++)
+	{
+		output[i] = (unsigned char) ((input[i] << 1) | (input[i + 1] >> 7));
+	}
+	output[ISO_MAC_AES_BLOCK_LEN - 1] = (unsigned char) (input[ISO_MAC_AES_BLOCK_LEN - 1] << 1);
+
+	if(carry)
+	{
+		output[ISO_MAC_AES_BLOCK_LEN - 1] ^= ISO_MAC_CMAC_RB;
+	}
+}
+
+static int _iso_mac_cmac_set_key(struct iso_mac *mac, const unsigned char *key, int length)
+{
+	static const unsigned char rcon[10] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36};
+	unsigned char zero[ISO_MAC_AES_BLOCK_LEN];
+	unsigned char l[ISO_MAC_AES_BLOCK_LEN];
+	unsigned int *rk = mac->schedule;
+	unsigned int t = 0;
+	int nk = length / 4;
+	int i = 0;
+
+	if(length != 16 && length != 24 && length != 32)
+	{
+		return -1;
+	}
+
+	mac->rounds = nk + 6;
+
+	for(i = 0; i < nk; i++)
+	{
+		rk[i] = _iso_mac_get_u32(key + (i * 4));
+	}
+
+	for(i = nk; i < 4 * (mac->rounds + 1); i++)
+	{
+		t = rk[i - 1];
+		if(i % nk == 0)
+		{
+			// RotWord, SubWord and round constant.
+			t = ((unsigned int) glb_aes_sbox[(t >> 16) & 0xFF] << 24) | ((unsigned int) glb_aes_sbox[(t >> 8) & 0xFF] << 16) |
+				((unsigned int) glb_aes_sbox[t & 0xFF] << 8) | (unsigned int) glb_aes_sbox[t >> 24];
+			t ^= (unsigned int) rcon[(i / nk) - 1] << 24;
+		}
+		else if(nk > 6 && i % nk == 4)
+		{
+			t = ((unsigned int) glb_aes_sbox[t >> 24] << 24) | ((unsigned int) glb_aes_sbox[(t >> 16) & 0xFF] << 16) |
+				((unsigned int) glb_aes_sbox[(t >> 8) & 0xFF] << 8) | (unsigned int) glb_aes_sbox[t & 0xFF];
+		}
+		rk[i] = rk[i - nk] ^ t;
+	}
+
+	memset(zero, 0, sizeof(zero));
+	_iso_mac_aes_encrypt(mac, zero, l);
+	_iso_mac_cmac_double(l, mac->subkeys[0]);
+	_iso_mac_cmac_double(mac->subkeys[0], mac->subkeys[1]);
+
+	return 0;
+}
+
+static void _iso_mac_cmac_update(struct iso_mac *mac, const unsigned char *data, int length)
+{
+	int i = 0;
+	int j = 0;
+
+	for(i = 0; i < length; i += ISO_MAC_AES_BLOCK_LEN)
+	{
+		for(j = 0; j < ISO_MAC_AES_BLOCK_LEN; j++)
+		{
+			mac->chain[j] ^= data[i + j];
+		}
+		_iso_mac_aes_encrypt(mac, mac->chain, mac->chain);
+	}
+}
+
+// Complete last block is masked with first subkey, partial one is padded (0x80 and zeros) and masked with second subkey.
+static void _iso_mac_cmac_final(struct iso_mac *mac, const unsigned char *block, int length, unsigned char *output)
+{
+	const unsigned char *subkey = mac->subkeys[(length == ISO_MAC_AES_BLOCK_LEN) ? 0 : 1];
+	unsigned char last[ISO_MAC_AES_BLOCK_LEN];
+	int i = 0;
+
+	memset(last, 0, sizeof(last));
+	memcpy(last, block, length);
+	if(length < ISO_MAC_AES_BLOCK_LEN)
+	{
+		last[length] = 0x80;
+	}
+
+	for(i = 0; i < ISO_MAC_AES_BLOCK_LEN; i++)
+	{
+		last[i] ^= mac->chain[i] ^ subkey[i];
+	}
+
+	_iso_mac_aes_encrypt(mac, last, output);
+}
+
+const struct iso_mac_algorithm iso_mac_retail =
+{
+	"retail", ISO_MAC_DES_BLOCK_LEN, ISO_MAC_DES_BLOCK_LEN, _iso_mac_retail_set_key, _iso_mac_retail_update, _iso_mac_retail_final
+};
+
+const struct iso_mac_algorithm iso_mac_aes_cmac =
+{
+	"aes-cmac", ISO_MAC_AES_BLOCK_LEN, ISO_MAC_AES_BLOCK_LEN, _iso_mac_cmac_set_key, _iso_mac_cmac_update, _iso_mac_cmac_final
+};
+
+int iso_mac_init(struct iso_mac *mac, const struct iso_mac_algorithm *algorithm, const unsigned char *key, int length)
+{
+	if(mac == NULL || algorithm == NULL || key == NULL || algorithm->block_length > ISO_MAC_BLOCK_MAX ||
+		algorithm->mac_length > ISO_MAC_BLOCK_MAX || length > ISO_MAC_KEY_MAX)
+	{
+		return -1;
+	}
+
+	pthread_once(&glb_mac_once, _iso_mac_tables_init);
+
+	memset(mac, 0, sizeof(*mac));
+	mac->algorithm = algorithm;
+	if(algorithm->set_key(mac, key, length) != 0)
+	{
+		debug_print("Error: [%s]: Invalid key length of %s\n", __FUNCTION__, algorithm->name);
+		mac->algorithm = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+void iso_mac_reset(struct iso_mac *mac)
+{
+	memset(mac->chain, 0, sizeof(mac->chain));
+	mac->buffered = 0;
+}
+
+void iso_mac_update(struct iso_mac *mac, const unsigned char *data, int length)
+{
+	int block_length = mac->algorithm->block_length;
+	int fill = 0;
+	int blocks = 0;
+
+	if(mac->buffered + length <= block_length)
+	{
+		memcpy(mac->buffer + mac->buffered, data, length);
+		mac->buffered += length;
+		return;
+	}
+
+	if(mac->buffered > 0)
+	{
+		fill = block_length - mac->buffered;
+		memcpy(mac->buffer + mac->buffered, data, fill);
+		mac->algorithm->update(mac, mac->buffer, block_length);
+		data += fill;
+		length -= fill;
+	}
+
+	// Whole blocks are absorbed from data, the last one (complete or not) is kept for final.
+	blocks = ((length - 1) / block_length) * block_length;
+	mac->algorithm->update(mac, data, blocks);
+
+	memcpy(mac->buffer, data + blocks, length - blocks);
+	mac->buffered = length - blocks;
+}
+
+int iso_mac_final(struct iso_mac *mac, unsigned char *output)
+{
+	mac->algorithm->final(mac, mac->buffer, mac->buffered, output);
+	iso_mac_reset(mac);
+
+	return mac->algorithm->mac_length;
+}
+
+int iso_mac_compute(struct iso_mac *mac, const unsigned char *data, int length, unsigned char *output)
+{
+	iso_mac_reset(mac);
+	iso_mac_update(mac, data, length);
+
+	return iso_mac_final(mac, output);
+}
+
+int iso_mac_format_field(const struct iso_mac *mac, const unsigned char *value, int field_length, char *data)
+{
+	char hex[(ISO_MAC_BLOCK_MAX * 2) + 1];
+
+	if(field_length <= 0 || field_length > mac->algorithm->mac_length * 2)
+	{
+		return -1;
+	}
+
+	if(field_length <= mac->algorithm->mac_length)
+	{
+		memcpy(data, value, field_length);
+	}
+	else
+	{
+		iso_bin_to_hex_str(value, mac->algorithm->mac_length, hex);
+		memcpy(data, hex, field_length);
+	}
+
+	return 0;
+}
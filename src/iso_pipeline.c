@@ -0,0 +1,483 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "iso_pipeline.h"
+#include "iso_8583.h"
+#include "debug.h"
+
+struct iso_pipeline_job
+{
+	int connection;
+	unsigned long long sequence;
+	unsigned long long submit_ns;
+	unsigned long long done_ns;
+	char *response;      // Packed response, NULL case there is no response.
+	int response_length;
+	int length;
+	char request[];      // Copy of packed request.
+};
+
+struct iso_pipeline_worker
+{
+	pthread_t thread;
+	int started;
+	int index;
+	struct iso_pipeline *pipeline;
+	pthread_mutex_t lock;
+	struct iso_pipeline_job *queue[ISO_PIPELINE_QUEUE_LEN];
+	int head;
+	int count;
+	// Counters written only by the worker thread.
+	unsigned long long delivered;
+	unsigned long long decode_errors;
+	unsigned long long handle_errors;
+	unsigned long long stolen;
+	unsigned long long stage_count[ISO_PIPELINE_STAGES];
+	unsigned long long stage_total_ns[ISO_PIPELINE_STAGES];
+	unsigned long long stage_max_ns[ISO_PIPELINE_STAGES];
+};
+
+struct iso_pipeline_connection
+{
+	pthread_mutex_t lock;
+	unsigned long long submitted; // Next sequence to be submitted (written only by submitter).
+	unsigned long long delivered; // Next sequence to be delivered.
+	int delivering;               // Some worker is delivering responses of this connection.
+	struct iso_pipeline_job *window[ISO_PIPELINE_WINDOW]; // Completed jobs, by sequence.
+};
+
+struct iso_pipeline
+{
+	struct iso_pipeline_worker *workers;
+	int worker_count;
+	struct iso_pipeline_connection *connections;
+	int connection_count;
+	iso_pipeline_handler_cb handler;
+	iso_pipeline_output_cb output;
+	void *user_data;
+	pthread_mutex_t lock; // Protects sleep of idle workers.
+	pthread_cond_t cond;
+	int idle;
+	int stop;
+	int pending;          // Jobs queued and not taken by workers.
+	int charset;          // Charset of the creator thread, used by the workers.
+};
+
+// Gets monotonic time in nanoseconds.
+static unsigned long long _iso_pipeline_now()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return ((unsigned long long) now.tv_sec * 1000000000ULL) + (unsigned long long) now.tv_nsec;
+}
+
+// Add to counter written by one thread and read by others (no locked instruction is needed).
+static void _iso_pipeline_add(unsigned long long *counter, unsigned long long value)
+{
+	__atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+}
+
+// Account stage latency of worker.
+static void _iso_pipeline_stage(struct iso_pipeline_worker *worker, int stage, unsigned long long start, unsigned long long end)
+{
+	unsigned long long elapsed = (end > start) ? end - start : 0;
+
+	_iso_pipeline_add(&worker->stage_count[stage], 1);
+	_iso_pipeline_add(&worker->stage_total_ns[stage], elapsed);
+	if(elapsed > worker->stage_max_ns[stage])
+	{
+		__atomic_store_n(&worker->stage_max_ns[stage], elapsed, __ATOMIC_RELAXED);
+	}
+}
+
+// Take oldest job of worker queue.
+static struct iso_pipeline_job *_iso_pipeline_pop(struct iso_pipeline_worker *worker)
+{
+	struct iso_pipeline_job *job = NULL;
+
+	pthread_mutex_lock(&worker->lock);
+	if(worker->count > 0)
+	{
+		job = worker->queue[worker->head];
+		worker->head = (worker->head + 1) % ISO_PIPELINE_QUEUE_LEN;
+		worker->count--;
+	}
+	pthread_mutex_unlock(&worker->lock);
+
+	return job;
+}
+
+// Take job from own queue or steal from the other workers.
+static struct iso_pipeline_job *_iso_pipeline_take(struct iso_pipeline_worker *worker)
+{
+	struct iso_pipeline *pipeline = worker->pipeline;
+	struct iso_pipeline_job *job = NULL;
+	int i = 0;
+
+	job = _iso_pipeline_pop(worker);
+	for(i = 1; job == NULL && i < pipeline->worker_count; i++)
+	{
+		job = _iso_pipeline_pop(&pipeline->workers[(worker->index + i) % pipeline->worker_count]);
+		if(job != NULL)
+		{
+			_iso_pipeline_add(&worker->stolen, 1);
+		}
+	}
+
+	if(job != NULL)
+	{
+		__atomic_sub_fetch(&pipeline->pending, 1, __ATOMIC_SEQ_CST);
+	}
+
+	return job;
+}
+
+// Store completed job in the window of its connection and deliver responses in order, only one worker delivers
+// responses of a connection at time (the others just store their jobs).
+static void _iso_pipeline_complete(struct iso_pipeline_worker *worker, struct iso_pipeline_job *job)
+{
+	struct iso_pipeline *pipeline = worker->pipeline;
+	struct iso_pipeline_connection *connection = &pipeline->connections[job->connection];
+
+	pthread_mutex_lock(&connection->lock);
+
+	connection->window[job->sequence % ISO_PIPELINE_WINDOW] = job;
+	if(connection->delivering)
+	{
+		pthread_mutex_unlock(&connection->lock);
+		return;
+	}
+
+	connection->delivering = 1;
+	while((job = connection->window[connection->delivered % ISO_PIPELINE_WINDOW]) != NULL)
+	{
+		connection->window[connection->delivered % ISO_PIPELINE_WINDOW] = NULL;
+		pthread_mutex_unlock(&connection->lock);
+
+		if(job->response != NULL)
+		{
+			_iso_pipeline_stage(worker, ISO_PIPELINE_STAGE_REORDER, job->done_ns, _iso_pipeline_now());
+			pipeline->output(job->connection, job->sequence, job->response, job->response_length, pipeline->user_data);
+			_iso_pipeline_add(&worker->delivered, 1);
+			free(job->response);
+		}
+		free(job);
+
+		pthread_mutex_lock(&connection->lock);
+		__atomic_store_n(&connection->delivered, connection->delivered + 1, __ATOMIC_RELEASE);
+	}
+	connection->delivering = 0;
+
+	pthread_mutex_unlock(&connection->lock);
+}
+
+// Run decode, handle and encode stages in the current message of worker thread.
+static void _iso_pipeline_run(struct iso_pipeline_worker *worker, struct iso_pipeline_job *job)
+{
+	struct iso_pipeline *pipeline = worker->pipeline;
+	struct iso_pipeline_context context;
+	unsigned long long start = _iso_pipeline_now();
+	unsigned long long end = 0;
+	int result = 0;
+	int size = 0;
+
+	_iso_pipeline_stage(worker, ISO_PIPELINE_STAGE_QUEUE, job->submit_ns, start);
+
+	result = iso_decode_message_bytes(job->request, job->length);
+	end = _iso_pipeline_now();
+	_iso_pipeline_stage(worker, ISO_PIPELINE_STAGE_DECODE, start, end);
+	if(result != 0)
+	{
+		_iso_pipeline_add(&worker->decode_errors, 1);
+		job->done_ns = end;
+		return;
+	}
+
+	context.connection = job->connection;
+	context.sequence = job->sequence;
+	context.request = job->request;
+	context.request_length = job->length;
+	context.worker = worker->index;
+
+	start = end;
+	result = pipeline->handler(&context, pipeline->user_data);
+	end = _iso_pipeline_now();
+	_iso_pipeline_stage(worker, ISO_PIPELINE_STAGE_HANDLE, start, end);
+
+	if(result == 1)
+	{
+		start = end;
+		size = iso_packed_size();
+		job->response = (char *) malloc(size + 1);
+		if(job->response != NULL)
+		{
+			job->response_length = iso_generate_message_bounded(job->response, size + 1);
+		}
+		if(job->response == NULL || job->response_length < 0)
+		{
+			free(job->response);
+			job->response = NULL;
+			result = -1;
+		}
+		end = _iso_pipeline_now();
+		_iso_pipeline_stage(worker, ISO_PIPELINE_STAGE_ENCODE, start, end);
+	}
+	if(result < 0)
+	{
+		_iso_pipeline_add(&worker->handle_errors, 1);
+	}
+
+	job->done_ns = end;
+}
+
+static void *_iso_pipeline_worker_run(void *arg)
+{
+	struct iso_pipeline_worker *worker = (struct iso_pipeline_worker *) arg;
+	struct iso_pipeline *pipeline = worker->pipeline;
+	struct iso_pipeline_job *job = NULL;
+	int stop = 0;
+
+	iso_set_charset(pipeline->charset);
+
+	while(!stop)
+	{
+		job = _iso_pipeline_take(worker);
+		if(job != NULL)
+		{
+			_iso_pipeline_run(worker, job);
+			_iso_pipeline_complete(worker, job);
+			continue;
+		}
+
+		// Sleep until there are jobs, submitters signal only when some worker is idle.
+		pthread_mutex_lock(&pipeline->lock);
+		__atomic_add_fetch(&pipeline->idle, 1, __ATOMIC_SEQ_CST);
+		while(__atomic_load_n(&pipeline->pending, __ATOMIC_SEQ_CST) == 0 && !pipeline->stop)
+		{
+			pthread_cond_wait(&pipeline->cond, &pipeline->lock);
+		}
+		__atomic_sub_fetch(&pipeline->idle, 1, __ATOMIC_SEQ_CST);
+		stop = (pipeline->stop && __atomic_load_n(&pipeline->pending, __ATOMIC_SEQ_CST) == 0);
+		pthread_mutex_unlock(&pipeline->lock);
+	}
+
+	// Release fields of the worker thread current message.
+	iso_release();
+
+	return NULL;
+}
+
+struct iso_pipeline *iso_pipeline_create(int workers, int connections, iso_pipeline_handler_cb handler, iso_pipeline_output_cb output, void *user_data)
+{
+	struct iso_pipeline *pipeline = NULL;
+	int i = 0;
+
+	if(workers < 1 || workers > ISO_PIPELINE_WORKERS_MAX || connections < 1 || handler == NULL || output == NULL)
+	{
+		return NULL;
+	}
+
+	pipeline = (struct iso_pipeline *) calloc(1, sizeof(struct iso_pipeline));
+	if(pipeline == NULL)
+	{
+		return NULL;
+	}
+
+	pipeline->worker_count = workers;
+	pipeline->connection_count = connections;
+	pipeline->handler = handler;
+	pipeline->output = output;
+	pipeline->user_data = user_data;
+	pipeline->charset = iso_get_charset();
+	pthread_mutex_init(&pipeline->lock, NULL);
+	pthread_cond_init(&pipeline->cond, NULL);
+
+	pipeline->workers = (struct iso_pipeline_worker *) calloc(workers, sizeof(struct iso_pipeline_worker));
+	pipeline->connections = (struct iso_pipeline_connection *) calloc(connections, sizeof(struct iso_pipeline_connection));
+	if(pipeline->workers == NULL || pipeline->connections == NULL)
+	{
+		debug_print("Error: [%s]: Could not allocate pipeline\n", __FUNCTION__);
+		free(pipeline->workers);
+		free(pipeline->connections);
+		pthread_mutex_destroy(&pipeline->lock);
+		pthread_cond_destroy(&pipeline->cond);
+		free(pipeline);
+		return NULL;
+	}
+
+	for(i = 0; i < connections; i++)
+	{
+		pthread_mutex_init(&pipeline->connections[i].lock, NULL);
+	}
+	for(i = 0; i < workers; i++)
+	{
+		pipeline->workers[i].index = i;
+		pipeline->workers[i].pipeline = pipeline;
+		pthread_mutex_init(&pipeline->workers[i].lock, NULL);
+	}
+
+	for(i = 0; i < workers; i++)
+	{
+		if(pthread_create(&pipeline->workers[i].thread, NULL, _iso_pipeline_worker_run, &pipeline->workers[i]) != 0)
+		{
+			debug_print("Error: [%s]: Could not start worker %d\n", __FUNCTION__, i);
+			iso_pipeline_destroy(pipeline);
+			return NULL;
+		}
+		pipeline->workers[i].started = 1;
+	}
+
+	return pipeline;
+}
+
+void iso_pipeline_destroy(struct iso_pipeline *pipeline)
+{
+	int i = 0;
+
+	if(pipeline == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&pipeline->lock);
+	pipeline->stop = 1;
+	pthread_cond_broadcast(&pipeline->cond);
+	pthread_mutex_unlock(&pipeline->lock);
+
+	for(i = 0; i < pipeline->worker_count; i++)
+	{
+		if(pipeline->workers[i].started)
+		{
+			pthread_join(pipeline->workers[i].thread, NULL);
+		}
+	}
+
+	// Workers steal from the others queues, so their locks are destroyed only after all of them stopped.
+	for(i = 0; i < pipeline->worker_count; i++)
+	{
+		pthread_mutex_destroy(&pipeline->workers[i].lock);
+	}
+	for(i = 0; i < pipeline->connection_count; i++)
+	{
+		pthread_mutex_destroy(&pipeline->connections[i].lock);
+	}
+
+	pthread_mutex_destroy(&pipeline->lock);
+	pthread_cond_destroy(&pipeline->cond);
+	free(pipeline->workers);
+	free(pipeline->connections);
+	free(pipeline);
+}
+
+int iso_pipeline_submit(struct iso_pipeline *pipeline, int connection, const char *request, int length)
+{
+	struct iso_pipeline_connection *state = NULL;
+	struct iso_pipeline_worker *worker = NULL;
+	struct iso_pipeline_job *job = NULL;
+
+	if(pipeline == NULL || connection < 0 || connection >= pipeline->connection_count || request == NULL || length <= 0)
+	{
+		return -1;
+	}
+
+	state = &pipeline->connections[connection];
+	if(state->submitted - __atomic_load_n(&state->delivered, __ATOMIC_ACQUIRE) >= ISO_PIPELINE_WINDOW)
+	{
+		return 1;
+	}
+
+	job = (struct iso_pipeline_job *) malloc(sizeof(struct iso_pipeline_job) + length);
+	if(job == NULL)
+	{
+		return -1;
+	}
+
+	job->connection = connection;
+	job->response = NULL;
+	job->response_length = 0;
+	job->length = length;
+	memcpy(job->request, request, length);
+
+	// Requests of a connection are queued to the same worker (other workers steal them when they are idle).
+	worker = &pipeline->workers[connection % pipeline->worker_count];
+	pthread_mutex_lock(&worker->lock);
+	if(worker->count == ISO_PIPELINE_QUEUE_LEN)
+	{
+		pthread_mutex_unlock(&worker->lock);
+		free(job);
+		return 1;
+	}
+	job->sequence = state->submitted;
+	job->submit_ns = _iso_pipeline_now();
+	__atomic_store_n(&state->submitted, state->submitted + 1, __ATOMIC_RELAXED);
+
+	// Counted before it is published, so a worker that takes it never makes pending negative.
+	__atomic_add_fetch(&pipeline->pending, 1, __ATOMIC_SEQ_CST);
+	worker->queue[(worker->head + worker->count) % ISO_PIPELINE_QUEUE_LEN] = job;
+	worker->count++;
+	pthread_mutex_unlock(&worker->lock);
+
+	if(__atomic_load_n(&pipeline->idle, __ATOMIC_SEQ_CST) > 0)
+	{
+		pthread_mutex_lock(&pipeline->lock);
+		pthread_cond_signal(&pipeline->cond);
+		pthread_mutex_unlock(&pipeline->lock);
+	}
+
+	return 0;
+}
+
+int iso_pipeline_get_stats(struct iso_pipeline *pipeline, struct iso_pipeline_stats *stats)
+{
+	struct iso_pipeline_worker *worker = NULL;
+	unsigned long long submitted = 0;
+	unsigned long long delivered = 0;
+	unsigned long long value = 0;
+	int i = 0;
+	int j = 0;
+
+	if(pipeline == NULL || stats == NULL)
+	{
+		return -1;
+	}
+
+	memset(stats, 0, sizeof(*stats));
+
+	for(i = 0; i < pipeline->worker_count; i++)
+	{
+		worker = &pipeline->workers[i];
+		stats->delivered += __atomic_load_n(&worker->delivered, __ATOMIC_RELAXED);
+		stats->decode_errors += __atomic_load_n(&worker->decode_errors, __ATOMIC_RELAXED);
+		stats->handle_errors += __atomic_load_n(&worker->handle_errors, __ATOMIC_RELAXED);
+		stats->stolen += __atomic_load_n(&worker->stolen, __ATOMIC_RELAXED);
+
+		for(j = 0; j < ISO_PIPELINE_STAGES; j++)
+		{
+			stats->stage_count[j] += __atomic_load_n(&worker->stage_count[j], __ATOMIC_RELAXED);
+			stats->stage_total_ns[j] += __atomic_load_n(&worker->stage_total_ns[j], __ATOMIC_RELAXED);
+			value = __atomic_load_n(&worker->stage_max_ns[j], __ATOMIC_RELAXED);
+			if(value > stats->stage_max_ns[j])
+			{
+				stats->stage_max_ns[j] = value;
+			}
+		}
+	}
+
+	for(i = 0; i < pipeline->connection_count; i++)
+	{
+		// Delivered is read before submitted, so it is not greater.
+		delivered = __atomic_load_n(&pipeline->connections[i].delivered, __ATOMIC_ACQUIRE);
+		submitted = __atomic_load_n(&pipeline->connections[i].submitted, __ATOMIC_RELAXED);
+		stats->submitted += submitted;
+		stats->reorder_depth += (int) (submitted - delivered);
+	}
+
+	stats->queue_depth = __atomic_load_n(&pipeline->pending, __ATOMIC_RELAXED);
+
+	return 0;
+}
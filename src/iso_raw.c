@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "iso_raw.h"
+#include "fields_info.h"
+#include "debug.h"
+
+#define ISO_RAW_BITMAP_OFFSET   FI_MTI_LEN_BYTES
+#define ISO_RAW_HEX_MASK        (unsigned char) 8 // 1000
+
+// Convert one hex character to its value, returns -1 case invalid.
+static int _iso_raw_hex_value(char c)
+{
+	if(c >= '0' && c <= '9')
+	{
+		return c - '0';
+	}
+	if(c >= 'A' && c <= 'F')
+	{
+		return c - 'A' + 10;
+	}
+	if(c >= 'a' && c <= 'f')
+	{
+		return c - 'a' + 10;
+	}
+
+	return -1;
+}
+
+// Gets the length of bitmaps in the packed message (one or two hex bitmaps), returns -1 case error.
+static int _iso_raw_bitmaps_length(const char *message, int length)
+{
+	int value = 0;
+
+	if(message == NULL || length < FI_MTI_LEN_BYTES + FI_BITMAP_HEX_BYTES)
+	{
+		return -1;
+	}
+
+	value = _iso_raw_hex_value(message[ISO_RAW_BITMAP_OFFSET]);
+	if(value < 0)
+	{
+		return -1;
+	}
+
+	if(value & ISO_RAW_HEX_MASK)
+	{
+		if(length < FI_MTI_LEN_BYTES + (FI_BITMAP_HEX_BYTES * 2))
+		{
+			return -1;
+		}
+		return FI_BITMAP_HEX_BYTES * 2;
+	}
+
+	return FI_BITMAP_HEX_BYTES;
+}
+
+// Check if field is up in the hex bitmaps, both bitmaps are seen as one hex string of 128 bits.
+static int _iso_raw_is_up_field(const char *bitmaps, int bitmaps_length, int field)
+{
+	int position = (field - 1) / 4;
+	int value = 0;
+
+	if(position >= bitmaps_length)
+	{
+		return 0;
+	}
+
+	value = _iso_raw_hex_value(bitmaps[position]);
+	if(value < 0)
+	{
+		return -1;
+	}
+
+	return (value & (ISO_RAW_HEX_MASK >> ((field - 1) % 4))) ? 1 : 0;
+}
+
+// Parse decimal length prefix, returns -1 case invalid.
+static int _iso_raw_parse_length(const char *data, int size_of_length)
+{
+	int i = 0;
+	int value = 0;
+
+	for(i = 0; i < size_of_length; i++)
+	{
+		if(data[i] < '0' || data[i] > '9')
+		{
+			return -1;
+		}
+		value = (value * 10) + (data[i] - '0');
+	}
+
+	return value;
+}
+
+int iso_raw_get_mti(const char *message, int length, char *mti)
+{
+	if(mti == NULL || message == NULL || length < FI_MTI_LEN_BYTES)
+	{
+		return -1;
+	}
+
+	memcpy(mti, message, FI_MTI_LEN_BYTES);
+	mti[FI_MTI_LEN_BYTES] = '\0';
+
+	return fi_is_valid_mti(mti) ? 0 : -1;
+}
+
+int iso_raw_is_set_field(const char *message, int length, int field)
+{
+	int bitmaps_length = _iso_raw_bitmaps_length(message, length);
+
+	if(bitmaps_length < 0 || !fi_is_valid_field(field))
+	{
+		return -1;
+	}
+
+	return _iso_raw_is_up_field(message + ISO_RAW_BITMAP_OFFSET, bitmaps_length, field);
+}
+
+// Locate fields with spec (acquired once for the whole message).
+static int _iso_raw_index_fields(const struct fi_spec *spec, const char *message, int length, int last_field, struct iso_raw_field *fields)
+{
+	int i = 0;
+	int is_up = 0;
+	int offset = 0;
+	int size_of_length = 0;
+	int field_length = 0;
+	int bitmaps_length = _iso_raw_bitmaps_length(message, length);
+	struct fi_field_info fi_field;
+
+	if(bitmaps_length < 0 || fields == NULL)
+	{
+		return -1;
+	}
+
+	if(last_field > FI_NUM_FIELD_MAX)
+	{
+		last_field = FI_NUM_FIELD_MAX;
+	}
+
+	for(i = 0; i < FI_NUM_FIELD_MAX; i++)
+	{
+		fields[i].offset = -1;
+		fields[i].length = 0;
+	}
+
+	// Second bitmap is stored as field 1.
+	if(bitmaps_length > FI_BITMAP_HEX_BYTES)
+	{
+		fields[0].offset = ISO_RAW_BITMAP_OFFSET + FI_BITMAP_HEX_BYTES;
+		fields[0].length = FI_BITMAP_HEX_BYTES;
+	}
+
+	offset = ISO_RAW_BITMAP_OFFSET + bitmaps_length;
+
+	for(i = 2; i <= last_field; i++)
+	{
+		is_up = _iso_raw_is_up_field(message + ISO_RAW_BITMAP_OFFSET, bitmaps_length, i);
+		if(is_up < 0)
+		{
+			return -1;
+		}
+		if(!is_up)
+		{
+			continue;
+		}
+
+		if(fi_spec_get_field_info(spec, i, &fi_field) != 0)
+		{
+			return -1;
+		}
+
+		if(fi_field.is_variable_field)
+		{
+			size_of_length = fi_field_size_of_length(&fi_field);
+			if(offset + size_of_length > length)
+			{
+				return -1;
+			}
+
+			field_length = _iso_raw_parse_length(message + offset, size_of_length);
+			if(field_length < 0)
+			{
+				debug_print("Error: [%s]: Invalid length of field (%d)\n", __FUNCTION__, i);
+				return -1;
+			}
+
+			offset += size_of_length;
+		}
+		else
+		{
+			field_length = fi_field.length;
+		}
+
+		if(offset + field_length > length)
+		{
+			debug_print("Error: [%s]: Field (%d) exceeds message length\n", __FUNCTION__, i);
+			return -1;
+		}
+
+		fields[i - 1].offset = offset;
+		fields[i - 1].length = field_length;
+
+		offset += field_length;
+	}
+
+	return offset;
+}
+
+int iso_raw_index_message(const char *message, int length, int last_field, struct iso_raw_field *fields)
+{
+	const struct fi_spec *spec = fi_spec_acquire();
+	int offset = _iso_raw_index_fields(spec, message, length, last_field, fields);
+
+	fi_spec_release(spec);
+
+	return offset;
+}
+
+int iso_raw_spec_index_message(const struct fi_spec *spec, const char *message, int length, int last_field, struct iso_raw_field *fields)
+{
+	if(spec == NULL)
+	{
+		return -1;
+	}
+
+	return _iso_raw_index_fields(spec, message, length, last_field, fields);
+}
+
+int iso_raw_find_field(const char *message, int length, int field, struct iso_raw_field *raw_field)
+{
+	struct iso_raw_field fields[FI_NUM_FIELD_MAX];
+
+	if(raw_field == NULL || !fi_is_valid_field(field))
+	{
+		return -1;
+	}
+
+	if(iso_raw_index_message(message, length, field, fields) < 0)
+	{
+		return -1;
+	}
+
+	*raw_field = fields[field - 1];
+
+	return (raw_field->offset >= 0) ? 1 : 0;
+}
@@ -0,0 +1,475 @@
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "iso_shm_ring.h"
+#include "iso_raw.h"
+#include "debug.h"
+
+// Offsets of header members (counters are in host byte order, the ring is not shared between hosts).
+#define ISO_SHM_RING_SLOT_COUNT_OFFSET      8
+#define ISO_SHM_RING_SLOT_SIZE_OFFSET       12
+#define ISO_SHM_RING_HEAD_OFFSET            (ISO_SHM_RING_LINE * 1)
+#define ISO_SHM_RING_TAIL_OFFSET            (ISO_SHM_RING_LINE * 2)
+#define ISO_SHM_RING_ITEM_SIGNAL_OFFSET     (ISO_SHM_RING_LINE * 3)
+#define ISO_SHM_RING_SPACE_SIGNAL_OFFSET    (ISO_SHM_RING_LINE * 4)
+
+// Offsets of slot members.
+#define ISO_SHM_RING_LENGTH_OFFSET          8
+#define ISO_SHM_RING_OFFSETS_OFFSET         12
+#define ISO_SHM_RING_LENGTHS_OFFSET         (ISO_SHM_RING_OFFSETS_OFFSET + (FI_NUM_FIELD_MAX * 2))
+
+#define ISO_SHM_RING_MIN_SLOTS              2
+// Field offsets are stored in 16 bits.
+#define ISO_SHM_RING_MESSAGE_MAX            0xFFFE
+
+// Gets pointer to 64 bits counter of header.
+static unsigned long long *_iso_shm_ring_u64(const struct iso_shm_ring *ring, size_t offset)
+{
+	return (unsigned long long *) (ring->data + offset);
+}
+
+// Gets pointer to 32 bits counter of header.
+static unsigned int *_iso_shm_ring_u32(const struct iso_shm_ring *ring, size_t offset)
+{
+	return (unsigned int *) (ring->data + offset);
+}
+
+// Gets slot of position.
+static unsigned char *_iso_shm_ring_slot(const struct iso_shm_ring *ring, unsigned long long position)
+{
+	return ring->data + ISO_SHM_RING_HEADER_LEN + ((size_t) (position & (ring->slot_count - 1)) * ring->slot_size);
+}
+
+// Wait while futex word has the value, until timeout (deadline is null to wait forever).
+static void _iso_shm_ring_futex_wait(unsigned int *word, unsigned int value, const struct timespec *deadline)
+{
+	struct timespec now;
+	struct timespec timeout;
+
+	if(deadline == NULL)
+	{
+		syscall(SYS_futex, word, FUTEX_WAIT, value, NULL, NULL, 0);
+		return;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	timeout.tv_sec = deadline->tv_sec - now.tv_sec;
+	timeout.tv_nsec = deadline->tv_nsec - now.tv_nsec;
+	if(timeout.tv_nsec < 0)
+	{
+		timeout.tv_sec--;
+		timeout.tv_nsec += 1000000000L;
+	}
+	if(timeout.tv_sec < 0)
+	{
+		return;
+	}
+
+	// Interrupted and spurious wake ups are handled by callers, they check the ring again.
+	syscall(SYS_futex, word, FUTEX_WAIT, value, &timeout, NULL, 0);
+}
+
+// Wake up processes waiting on futex word.
+static void _iso_shm_ring_futex_wake(unsigned int *word, int count)
+{
+	syscall(SYS_futex, word, FUTEX_WAKE, count, NULL, NULL, 0);
+}
+
+// Computes deadline of timeout, returns null to wait forever.
+static const struct timespec *_iso_shm_ring_deadline(int timeout_ms, struct timespec *deadline)
+{
+	if(timeout_ms < 0)
+	{
+		return NULL;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, deadline);
+	deadline->tv_sec += timeout_ms / 1000;
+	deadline->tv_nsec += (long) (timeout_ms % 1000) * 1000000L;
+	if(deadline->tv_nsec >= 1000000000L)
+	{
+		deadline->tv_sec++;
+		deadline->tv_nsec -= 1000000000L;
+	}
+
+	return deadline;
+}
+
+// Check if deadline has passed.
+static int _iso_shm_ring_expired(const struct timespec *deadline)
+{
+	struct timespec now;
+
+	if(deadline == NULL)
+	{
+		return 0;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec > deadline->tv_sec || (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec));
+}
+
+// Check if slot of head position is still used by consumer.
+static int _iso_shm_ring_is_full(const struct iso_shm_ring *ring)
+{
+	unsigned long long position = __atomic_load_n(_iso_shm_ring_u64(ring, ISO_SHM_RING_HEAD_OFFSET), __ATOMIC_RELAXED);
+	unsigned long long sequence = __atomic_load_n((unsigned long long *) _iso_shm_ring_slot(ring, position), __ATOMIC_ACQUIRE);
+
+	return ((long long) (sequence - position) < 0);
+}
+
+// Check if slot of tail position is published.
+static int _iso_shm_ring_is_empty(const struct iso_shm_ring *ring)
+{
+	unsigned long long position = __atomic_load_n(_iso_shm_ring_u64(ring, ISO_SHM_RING_TAIL_OFFSET), __ATOMIC_RELAXED);
+	unsigned long long sequence = __atomic_load_n((unsigned long long *) _iso_shm_ring_slot(ring, position), __ATOMIC_ACQUIRE);
+
+	return (sequence != position + 1);
+}
+
+// Check ring geometry.
+static int _iso_shm_ring_is_valid(unsigned long long slot_count, unsigned long long slot_size, size_t size)
+{
+	return (slot_count >= ISO_SHM_RING_MIN_SLOTS && (slot_count & (slot_count - 1)) == 0 &&
+		slot_size > ISO_SHM_RING_SLOT_HEADER && (slot_size % ISO_SHM_RING_LINE) == 0 &&
+		size >= ISO_SHM_RING_HEADER_LEN && slot_count <= (size - ISO_SHM_RING_HEADER_LEN) / slot_size);
+}
+
+int iso_shm_ring_create(const char *name, unsigned int slot_count, unsigned int slot_size, struct iso_shm_ring *ring)
+{
+	unsigned long long count = ISO_SHM_RING_MIN_SLOTS;
+	unsigned long long size = 0;
+	void *data = NULL;
+	unsigned int i = 0;
+
+	if(name == NULL || ring == NULL || slot_count == 0 || slot_size <= ISO_SHM_RING_SLOT_HEADER)
+	{
+		return -1;
+	}
+
+	memset(ring, 0, sizeof(*ring));
+	ring->fd = -1;
+
+	while(count < slot_count)
+	{
+		count *= 2;
+	}
+	size = ((unsigned long long) slot_size + ISO_SHM_RING_LINE - 1) & ~((unsigned long long) ISO_SHM_RING_LINE - 1);
+	if(count > UINT_MAX || size > UINT_MAX)
+	{
+		return -1;
+	}
+
+	ring->slot_count = (unsigned int) count;
+	ring->slot_size = (unsigned int) size;
+	ring->size = ISO_SHM_RING_HEADER_LEN + (size_t) (count * size);
+
+	// Processes which mapped the old ring keep it, new ones open this one.
+	shm_unlink(name);
+	ring->fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if(ring->fd < 0 || ftruncate(ring->fd, ring->size) != 0)
+	{
+		debug_print("Error: [%s]: Could not create ring [%s]\n", __FUNCTION__, name);
+		iso_shm_ring_close(ring);
+		return -1;
+	}
+
+	data = mmap(NULL, ring->size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+	if(data == MAP_FAILED)
+	{
+		iso_shm_ring_close(ring);
+		return -1;
+	}
+	ring->data = (unsigned char *) data;
+
+	// Shared memory is zeroed, so head, tail and signals start at 0 and slots are free for the first lap.
+	for(i = 0; i < ring->slot_count; i++)
+	{
+		*(unsigned long long *) _iso_shm_ring_slot(ring, i) = i;
+	}
+
+	*_iso_shm_ring_u32(ring, ISO_SHM_RING_SLOT_COUNT_OFFSET) = ring->slot_count;
+	*_iso_shm_ring_u32(ring, ISO_SHM_RING_SLOT_SIZE_OFFSET) = ring->slot_size;
+	memcpy(ring->data, ISO_SHM_RING_MAGIC, ISO_SHM_RING_MAGIC_LEN);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	return 0;
+}
+
+int iso_shm_ring_open(const char *name, struct iso_shm_ring *ring)
+{
+	struct stat st;
+	void *data = NULL;
+
+	if(name == NULL || ring == NULL)
+	{
+		return -1;
+	}
+
+	memset(ring, 0, sizeof(*ring));
+
+	ring->fd = shm_open(name, O_RDWR, 0);
+	if(ring->fd < 0 || fstat(ring->fd, &st) != 0 || st.st_size < ISO_SHM_RING_HEADER_LEN)
+	{
+		debug_print("Error: [%s]: Could not open ring [%s]\n", __FUNCTION__, name);
+		iso_shm_ring_close(ring);
+		return -1;
+	}
+
+	data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+	if(data == MAP_FAILED)
+	{
+		iso_shm_ring_close(ring);
+		return -1;
+	}
+	ring->data = (unsigned char *) data;
+	ring->size = st.st_size;
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	ring->slot_count = *_iso_shm_ring_u32(ring, ISO_SHM_RING_SLOT_COUNT_OFFSET);
+	ring->slot_size = *_iso_shm_ring_u32(ring, ISO_SHM_RING_SLOT_SIZE_OFFSET);
+
+	if(memcmp(ring->data, ISO_SHM_RING_MAGIC, ISO_SHM_RING_MAGIC_LEN) != 0 ||
+		!_iso_shm_ring_is_valid(ring->slot_count, ring->slot_size, ring->size))
+	{
+		debug_print("Error: [%s]: Invalid ring [%s]\n", __FUNCTION__, name);
+		iso_shm_ring_close(ring);
+		return -1;
+	}
+
+	return 0;
+}
+
+void iso_shm_ring_close(struct iso_shm_ring *ring)
+{
+	if(ring == NULL)
+	{
+		return;
+	}
+
+	if(ring->data != NULL)
+	{
+		munmap(ring->data, ring->size);
+	}
+	if(ring->fd >= 0)
+	{
+		close(ring->fd);
+	}
+
+	memset(ring, 0, sizeof(*ring));
+	ring->fd = -1;
+}
+
+int iso_shm_ring_unlink(const char *name)
+{
+	if(name == NULL)
+	{
+		return -1;
+	}
+
+	return (shm_unlink(name) == 0) ? 0 : -1;
+}
+
+int iso_shm_ring_push(struct iso_shm_ring *ring, const char *message, int length, int timeout_ms)
+{
+	struct iso_raw_field fields[FI_NUM_FIELD_MAX];
+	struct timespec deadline_buffer;
+	const struct timespec *deadline = NULL;
+	unsigned long long *head = NULL;
+	unsigned int *space_signal = NULL;
+	unsigned int *producers_waiting = NULL;
+	unsigned int *item_signal = NULL;
+	unsigned long long position = 0;
+	unsigned long long sequence = 0;
+	unsigned char *slot = NULL;
+	unsigned short *offsets = NULL;
+	unsigned short *lengths = NULL;
+	unsigned int signal = 0;
+	int i = 0;
+
+	if(ring == NULL || ring->data == NULL || message == NULL || length <= 0 || length > ISO_SHM_RING_MESSAGE_MAX ||
+		(unsigned int) length > ring->slot_size - ISO_SHM_RING_SLOT_HEADER)
+	{
+		return -1;
+	}
+
+	// Fields are located before the slot is reserved, so the slot is held only for the copy.
+	if(iso_raw_index_message(message, length, FI_NUM_FIELD_MAX, fields) < 0)
+	{
+		debug_print("Error: [%s]: Invalid message\n", __FUNCTION__);
+		return -1;
+	}
+
+	head = _iso_shm_ring_u64(ring, ISO_SHM_RING_HEAD_OFFSET);
+	space_signal = _iso_shm_ring_u32(ring, ISO_SHM_RING_SPACE_SIGNAL_OFFSET);
+	producers_waiting = space_signal + 1;
+
+	// Reserve slot: it is free when its sequence is the head position.
+	position = __atomic_load_n(head, __ATOMIC_RELAXED);
+	while(1)
+	{
+		slot = _iso_shm_ring_slot(ring, position);
+		sequence = __atomic_load_n((unsigned long long *) slot, __ATOMIC_ACQUIRE);
+
+		if(sequence == position)
+		{
+			if(__atomic_compare_exchange_n(head, &position, position + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			{
+				break;
+			}
+		}
+		else if((long long) (sequence - position) > 0)
+		{
+			// Other producer got this position.
+			position = __atomic_load_n(head, __ATOMIC_RELAXED);
+		}
+		else
+		{
+			// Full, the slot is from previous lap and was not released by consumer.
+			if(timeout_ms == 0)
+			{
+				return 1;
+			}
+			if(deadline == NULL && timeout_ms > 0)
+			{
+				deadline = _iso_shm_ring_deadline(timeout_ms, &deadline_buffer);
+			}
+			if(_iso_shm_ring_expired(deadline))
+			{
+				return 1;
+			}
+
+			signal = __atomic_load_n(space_signal, __ATOMIC_ACQUIRE);
+			__atomic_add_fetch(producers_waiting, 1, __ATOMIC_SEQ_CST);
+			if(_iso_shm_ring_is_full(ring))
+			{
+				_iso_shm_ring_futex_wait(space_signal, signal, deadline);
+			}
+			__atomic_sub_fetch(producers_waiting, 1, __ATOMIC_RELAXED);
+
+			position = __atomic_load_n(head, __ATOMIC_RELAXED);
+		}
+	}
+
+	offsets = (unsigned short *) (slot + ISO_SHM_RING_OFFSETS_OFFSET);
+	lengths = (unsigned short *) (slot + ISO_SHM_RING_LENGTHS_OFFSET);
+	for(i = 0; i < FI_NUM_FIELD_MAX; i++)
+	{
+		offsets[i] = (fields[i].offset >= 0) ? (unsigned short) fields[i].offset : ISO_SHM_RING_NO_FIELD;
+		lengths[i] = (fields[i].offset >= 0) ? (unsigned short) fields[i].length : 0;
+	}
+	*(unsigned int *) (slot + ISO_SHM_RING_LENGTH_OFFSET) = (unsigned int) length;
+	memcpy(slot + ISO_SHM_RING_SLOT_HEADER, message, length);
+
+	// Publish, then wake up consumer only if it is sleeping (the fence orders the publish before the flag load).
+	__atomic_store_n((unsigned long long *) slot, position + 1, __ATOMIC_RELEASE);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	item_signal = _iso_shm_ring_u32(ring, ISO_SHM_RING_ITEM_SIGNAL_OFFSET);
+	if(__atomic_load_n(item_signal + 1, __ATOMIC_RELAXED) != 0)
+	{
+		__atomic_add_fetch(item_signal, 1, __ATOMIC_RELEASE);
+		_iso_shm_ring_futex_wake(item_signal, 1);
+	}
+
+	return 0;
+}
+
+int iso_shm_ring_peek(struct iso_shm_ring *ring, struct iso_shm_message *message, int timeout_ms)
+{
+	struct timespec deadline_buffer;
+	const struct timespec *deadline = NULL;
+	unsigned int *item_signal = NULL;
+	unsigned int *consumer_waiting = NULL;
+	unsigned long long position = 0;
+	unsigned char *slot = NULL;
+	unsigned int signal = 0;
+
+	if(ring == NULL || ring->data == NULL || message == NULL)
+	{
+		return -1;
+	}
+
+	item_signal = _iso_shm_ring_u32(ring, ISO_SHM_RING_ITEM_SIGNAL_OFFSET);
+	consumer_waiting = item_signal + 1;
+	deadline = _iso_shm_ring_deadline(timeout_ms, &deadline_buffer);
+
+	while(_iso_shm_ring_is_empty(ring))
+	{
+		if(timeout_ms == 0 || _iso_shm_ring_expired(deadline))
+		{
+			return 0;
+		}
+
+		signal = __atomic_load_n(item_signal, __ATOMIC_ACQUIRE);
+		__atomic_store_n(consumer_waiting, 1, __ATOMIC_SEQ_CST);
+		if(_iso_shm_ring_is_empty(ring))
+		{
+			_iso_shm_ring_futex_wait(item_signal, signal, deadline);
+		}
+		__atomic_store_n(consumer_waiting, 0, __ATOMIC_RELAXED);
+	}
+
+	// Only the consumer moves the tail.
+	position = __atomic_load_n(_iso_shm_ring_u64(ring, ISO_SHM_RING_TAIL_OFFSET), __ATOMIC_RELAXED);
+	slot = _iso_shm_ring_slot(ring, position);
+
+	message->position = position;
+	message->length = (int) *(unsigned int *) (slot + ISO_SHM_RING_LENGTH_OFFSET);
+	message->offsets = (const unsigned short *) (slot + ISO_SHM_RING_OFFSETS_OFFSET);
+	message->lengths = (const unsigned short *) (slot + ISO_SHM_RING_LENGTHS_OFFSET);
+	message->message = (const char *) (slot + ISO_SHM_RING_SLOT_HEADER);
+
+	return 1;
+}
+
+void iso_shm_ring_release(struct iso_shm_ring *ring, const struct iso_shm_message *message)
+{
+	unsigned int *space_signal = NULL;
+	unsigned char *slot = NULL;
+
+	if(ring == NULL || ring->data == NULL || message == NULL)
+	{
+		return;
+	}
+
+	// Free the slot for the next lap, then wake up producers only if some is sleeping.
+	slot = _iso_shm_ring_slot(ring, message->position);
+	__atomic_store_n(_iso_shm_ring_u64(ring, ISO_SHM_RING_TAIL_OFFSET), message->position + 1, __ATOMIC_RELAXED);
+	__atomic_store_n((unsigned long long *) slot, message->position + ring->slot_count, __ATOMIC_RELEASE);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	space_signal = _iso_shm_ring_u32(ring, ISO_SHM_RING_SPACE_SIGNAL_OFFSET);
+	if(__atomic_load_n(space_signal + 1, __ATOMIC_RELAXED) != 0)
+	{
+		__atomic_add_fetch(space_signal, 1, __ATOMIC_RELEASE);
+		_iso_shm_ring_futex_wake(space_signal, INT_MAX);
+	}
+}
+
+int iso_shm_ring_get_field(const struct iso_shm_message *message, int field, const char **data, int *length)
+{
+	if(message == NULL || message->offsets == NULL || data == NULL || length == NULL || !fi_is_valid_field(field))
+	{
+		return -1;
+	}
+
+	if(message->offsets[field - 1] == ISO_SHM_RING_NO_FIELD)
+	{
+		return 0;
+	}
+
+	*data = message->message + message->offsets[field - 1];
+	*length = message->lengths[field - 1];
+
+	return 1;
+}
@@ -0,0 +1,24 @@
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <stdio.h>
+
+// Minimal checks of behavior tests, each test is one executable run by ctest (exit code 0 to success).
+
+// Int: Number of failed checks.
+static int glb_test_failures = 0;
+
+#define TEST_CHECK(condition) \
+	do \
+	{ \
+		if(!(condition)) \
+		{ \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			glb_test_failures++; \
+		} \
+	} \
+	while(0)
+
+#define TEST_RESULT() (glb_test_failures == 0 ? 0 : 1)
+
+#endif
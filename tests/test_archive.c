@@ -0,0 +1,235 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "iso_8583.h"
+#include "iso_archive.h"
+#include "iso_filter.h"
+
+#define TEST_ARCHIVE_PATH   "test_archive.arc"
+#define TEST_MESSAGES       5000 // More than one block.
+#define TEST_MESSAGE_MAX    256
+
+// Int: Allocation failures injected while set (realloc is wrapped by the linker, see CMakeLists.txt).
+static int glb_fail_realloc = 0;
+
+// Messages written and expected back.
+static char glb_messages[TEST_MESSAGES][TEST_MESSAGE_MAX];
+static int glb_lengths[TEST_MESSAGES];
+
+void *__real_realloc(void *data, size_t size);
+
+void *__wrap_realloc(void *data, size_t size)
+{
+	return glb_fail_realloc ? NULL : __real_realloc(data, size);
+}
+
+// Distinct valid mti by index (up to 384).
+static void _test_mti(int index, char *mti)
+{
+	mti[0] = '0';
+	mti[1] = "12345678"[(index / 48) % 8];
+	mti[2] = "01234567"[(index / 6) % 8];
+	mti[3] = "012345"[index % 6];
+	mti[4] = '\0';
+}
+
+// Pack message with the encoded fields (stan, time and dictionary fields) and a residual one.
+static int _test_message(const char *mti, int stan, int time, const char *terminal, char *message)
+{
+	char value[16];
+
+	iso_release();
+	iso_set_mti(mti);
+	iso_add_field(3, "000000", 6);
+	snprintf(value, sizeof(value), "10%02d%06d", time % 30 + 1, time % 1000000);
+	iso_add_field(7, value, 10);
+	snprintf(value, sizeof(value), "%06d", stan % 1000000);
+	iso_add_field(11, value, 6);
+	iso_add_field(18, "5411", 4);
+	iso_add_field(22, "051", 3);
+	iso_add_field(41, terminal, 8);
+	iso_add_field(49, "986", 3);
+
+	return iso_generate_message_bounded(message, TEST_MESSAGE_MAX);
+}
+
+// Read all messages of archive and compare them with the expected ones, byte by byte.
+static void _test_read_back(int count)
+{
+	struct iso_archive_reader *reader = iso_archive_open(TEST_ARCHIVE_PATH);
+	struct iso_archive_block_info info;
+	char message[TEST_MESSAGE_MAX];
+	int blocks = 0;
+	int read = 0;
+	int length = 0;
+
+	TEST_CHECK(reader != NULL);
+	if(reader == NULL)
+	{
+		return;
+	}
+
+	while(iso_archive_next_block(reader, &info) == 1)
+	{
+		blocks++;
+		while((length = iso_archive_read(reader, message, sizeof(message))) > 0)
+		{
+			TEST_CHECK(read < count && length == glb_lengths[read] && memcmp(message, glb_messages[read], length) == 0);
+			read++;
+		}
+		TEST_CHECK(length == 0);
+	}
+
+	TEST_CHECK(read == count);
+	TEST_CHECK(blocks == (count + ISO_ARCHIVE_BLOCK_MESSAGES - 1) / ISO_ARCHIVE_BLOCK_MESSAGES);
+
+	iso_archive_close_reader(reader);
+}
+
+// Encoded, raw (truncated and garbage) and mti dictionary overflow records are read back exactly as written.
+static void _test_round_trip()
+{
+	struct iso_archive_writer *writer = iso_archive_create(TEST_ARCHIVE_PATH);
+	char mti[FI_MTI_LEN_BYTES + 1];
+	int i = 0;
+
+	TEST_CHECK(writer != NULL);
+	if(writer == NULL)
+	{
+		return;
+	}
+
+	for(i = 0; i < TEST_MESSAGES; i++)
+	{
+		// First block has more mtis than its dictionary.
+		_test_mti((i < ISO_ARCHIVE_BLOCK_MESSAGES) ? i % (ISO_ARCHIVE_MTI_DICT_MAX + 8) : i % 4, mti);
+		glb_lengths[i] = _test_message(mti, i * 7, i * 3, (i % 3) ? "TERM0001" : "TERM0002", glb_messages[i]);
+
+		if(i % 11 == 5)
+		{
+			glb_lengths[i] = snprintf(glb_messages[i], TEST_MESSAGE_MAX, "NOT AN ISO MESSAGE %d", i);
+		}
+		else if(i % 13 == 7)
+		{
+			glb_lengths[i] -= 5;
+		}
+
+		TEST_CHECK(iso_archive_write(writer, glb_messages[i], glb_lengths[i]) == 0);
+	}
+
+	TEST_CHECK(iso_archive_close(writer) == 0);
+
+	_test_read_back(TEST_MESSAGES);
+}
+
+// Summary of block never skips a block with matching message, raw records included.
+static void _test_block_skip()
+{
+	struct iso_archive_writer *writer = NULL;
+	struct iso_archive_reader *reader = NULL;
+	struct iso_archive_block_info info;
+	struct iso_filter filter;
+	struct iso_filter present;
+	char message[TEST_MESSAGE_MAX];
+	char mti[FI_MTI_LEN_BYTES + 1];
+	int matches = 0;
+	int length = 0;
+	int i = 0;
+
+	TEST_CHECK(iso_filter_compile("11=999999", &filter) == 0);
+	TEST_CHECK(iso_filter_compile("11=000005", &present) == 0);
+
+	// Encoded messages only: blocks with stan out of range are skipped.
+	writer = iso_archive_create(TEST_ARCHIVE_PATH);
+	TEST_CHECK(writer != NULL);
+	for(i = 0; writer != NULL && i < 10; i++)
+	{
+		length = _test_message("0200", i + 1, i, "TERM0001", message);
+		TEST_CHECK(iso_archive_write(writer, message, length) == 0);
+	}
+	TEST_CHECK(iso_archive_close(writer) == 0);
+
+	reader = iso_archive_open(TEST_ARCHIVE_PATH);
+	TEST_CHECK(reader != NULL && iso_archive_next_block(reader, &info) == 1);
+	TEST_CHECK(iso_archive_block_may_match(&info, &present) == 1);
+	TEST_CHECK(iso_archive_block_may_match(&info, &filter) == 0);
+	iso_archive_close_reader(reader);
+
+	// Last message does not fit the mti dictionary, it is stored raw with the only stan 999999.
+	writer = iso_archive_create(TEST_ARCHIVE_PATH);
+	TEST_CHECK(writer != NULL);
+	for(i = 0; writer != NULL && i <= ISO_ARCHIVE_MTI_DICT_MAX; i++)
+	{
+		_test_mti(i, mti);
+		length = _test_message(mti, (i == ISO_ARCHIVE_MTI_DICT_MAX) ? 999999 : 1, i, "TERM0001", message);
+		TEST_CHECK(iso_archive_write(writer, message, length) == 0);
+	}
+	TEST_CHECK(iso_archive_close(writer) == 0);
+
+	reader = iso_archive_open(TEST_ARCHIVE_PATH);
+	TEST_CHECK(reader != NULL && iso_archive_next_block(reader, &info) == 1);
+	TEST_CHECK(info.mti_overflow);
+	TEST_CHECK(iso_archive_block_may_match(&info, &filter) == 1);
+	while(reader != NULL && (length = iso_archive_read(reader, message, sizeof(message))) > 0)
+	{
+		matches += iso_filter_match(&filter, message, length);
+	}
+	TEST_CHECK(matches == 1);
+	iso_archive_close_reader(reader);
+}
+
+// Write that fails while appending its record leaves the block readable.
+static void _test_failed_write()
+{
+	struct iso_archive_writer *writer = iso_archive_create(TEST_ARCHIVE_PATH);
+	int written = 0;
+	int failures = 0;
+	int retry = 0;
+	int i = 0;
+
+	TEST_CHECK(writer != NULL);
+	if(writer == NULL)
+	{
+		return;
+	}
+
+	for(i = 0; i < TEST_MESSAGES && written < 1000; i++)
+	{
+		glb_lengths[written] = _test_message("0200", i * 5, i, "TERM0001", glb_messages[written]);
+
+		// Buffers can not grow, except to retry the failed message: writes fail after part of record was appended.
+		glb_fail_realloc = !retry;
+		retry = (iso_archive_write(writer, glb_messages[written], glb_lengths[written]) != 0);
+		glb_fail_realloc = 0;
+
+		if(retry)
+		{
+			failures++;
+		}
+		else
+		{
+			written++;
+		}
+	}
+
+	TEST_CHECK(failures > 0);
+	TEST_CHECK(iso_archive_close(writer) == 0);
+
+	_test_read_back(written);
+}
+
+int main()
+{
+	iso_init(FI_ISO8583_1987);
+
+	_test_round_trip();
+	_test_block_skip();
+	_test_failed_write();
+
+	remove(TEST_ARCHIVE_PATH);
+	iso_release();
+
+	return TEST_RESULT();
+}
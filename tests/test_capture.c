@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "iso_capture.h"
+
+#define TEST_CAPTURE_PATH   "test_capture.txt"
+#define TEST_CHUNKS_MAX     16
+
+// Walk chunks as parallel workers do (each one until its end offset) and check each message is read once, in order.
+static void _test_split(const char *content, const char *expected)
+{
+	struct iso_capture capture;
+	long long offsets[TEST_CHUNKS_MAX + 1];
+	long long offset = 0;
+	long long next = 0;
+	const char *message = NULL;
+	char walked[256];
+	int length = 0;
+	int chunks = 0;
+	int i = 0;
+	FILE *file = fopen(TEST_CAPTURE_PATH, "wb");
+
+	TEST_CHECK(file != NULL && fwrite(content, 1, strlen(content), file) == strlen(content) && fclose(file) == 0);
+	TEST_CHECK(iso_capture_open(TEST_CAPTURE_PATH, ISO_CAPTURE_ASCII, &capture) == 0);
+
+	for(chunks = 1; chunks <= TEST_CHUNKS_MAX; chunks++)
+	{
+		TEST_CHECK(iso_capture_split(&capture, chunks, offsets) == 0);
+
+		walked[0] = '\0';
+		for(i = 0; i < chunks; i++)
+		{
+			offset = offsets[i];
+			while(offset < offsets[i + 1] && (next = iso_capture_next(&capture, offset, &message, &length)) > 0)
+			{
+				offset = next;
+				strncat(walked, message, length);
+				strcat(walked, ",");
+			}
+		}
+
+		if(strcmp(walked, expected) != 0)
+		{
+			fprintf(stderr, "chunks %d: [%s]\n", chunks, walked);
+		}
+		TEST_CHECK(strcmp(walked, expected) == 0);
+	}
+
+	iso_capture_close(&capture);
+	remove(TEST_CAPTURE_PATH);
+}
+
+int main()
+{
+	_test_split("MSG1\nMSG2\nMSG3\n", "MSG1,MSG2,MSG3,");
+	_test_split("MSG1\n\nMSG2\n\n", "MSG1,MSG2,");
+	_test_split("\n\nMSG1\n\n\n\nMSG2\r\n\r\nMSG3", "MSG1,MSG2,MSG3,");
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "test.h"
+#include "iso_8583.h"
+#include "iso_charset.h"
+
+// Binary pin block (field 52), with bytes that are not valid text.
+static const char glb_pin_block[8] = {'\x00', '\xFF', '\x40', '\xF0', '\x30', '\x0A', '\x81', '\x00'};
+
+// Pack 0200 message with text fields and the binary field 52.
+static int _test_message(char *message, int capacity)
+{
+	iso_release();
+	iso_set_mti("0200");
+	iso_add_field(2, "4111111111111111", 16);
+	iso_add_field(3, "000000", 6);
+	iso_add_field(41, "TERM0001", 8);
+	iso_add_field_bytes(52, glb_pin_block, sizeof(glb_pin_block));
+
+	return iso_generate_message_bounded(message, capacity);
+}
+
+// Mti, bitmap, length prefixes and text fields are EBCDIC, the 'b' field is copied unchanged both ways.
+static void _test_ebcdic_round_trip()
+{
+	char message[512];
+	char expected[32];
+	const char *data = NULL;
+	int length = 0;
+	int found = 0;
+	int i = 0;
+
+	TEST_CHECK(iso_set_charset(ISO_CHARSET_EBCDIC) == 0);
+	TEST_CHECK(iso_get_charset() == ISO_CHARSET_EBCDIC);
+
+	length = _test_message(message, sizeof(message));
+	TEST_CHECK(length > 0);
+	TEST_CHECK(memcmp(message, "\xF0\xF2\xF0\xF0", FI_MTI_LEN_BYTES) == 0);
+
+	// Length prefix and pan of field 2 right after the bitmap.
+	iso_charset_ascii_to_ebcdic("164111111111111111", expected, 18);
+	TEST_CHECK(memcmp(message + FI_MTI_LEN_BYTES + FI_BITMAP_HEX_BYTES, expected, 18) == 0);
+
+	// Pin block is the last field.
+	TEST_CHECK(length > (int) sizeof(glb_pin_block) && memcmp(message + length - sizeof(glb_pin_block), glb_pin_block, sizeof(glb_pin_block)) == 0);
+	for(i = 0; i + FI_MTI_LEN_BYTES <= length; i++)
+	{
+		found += (memcmp(message + i, "0200", FI_MTI_LEN_BYTES) == 0);
+	}
+	TEST_CHECK(found == 0);
+
+	iso_release();
+	TEST_CHECK(iso_decode_message_bytes(message, length) == 0);
+	TEST_CHECK(iso_get_field_view(2, &data, &length) == 0 && length == 16 && memcmp(data, "4111111111111111", 16) == 0);
+	TEST_CHECK(iso_get_field_view(41, &data, &length) == 0 && length == 8 && memcmp(data, "TERM0001", 8) == 0);
+	TEST_CHECK(iso_get_field_view(52, &data, &length) == 0 && length == sizeof(glb_pin_block) && memcmp(data, glb_pin_block, sizeof(glb_pin_block)) == 0);
+
+	TEST_CHECK(iso_set_charset(ISO_CHARSET_ASCII) == 0);
+}
+
+static void *_test_thread_run(void *arg)
+{
+	char message[512];
+	int *result = (int *) arg;
+
+	*result = (iso_get_charset() == ISO_CHARSET_ASCII && _test_message(message, sizeof(message)) > 0 && memcmp(message, "0200", FI_MTI_LEN_BYTES) == 0);
+
+	iso_release();
+
+	return NULL;
+}
+
+// Charset set by a thread does not change the messages of the others.
+static void _test_per_thread()
+{
+	pthread_t thread;
+	int result = 0;
+
+	TEST_CHECK(iso_set_charset(ISO_CHARSET_EBCDIC) == 0);
+	TEST_CHECK(pthread_create(&thread, NULL, _test_thread_run, &result) == 0 && pthread_join(thread, NULL) == 0);
+	TEST_CHECK(result == 1);
+	TEST_CHECK(iso_get_charset() == ISO_CHARSET_EBCDIC);
+	TEST_CHECK(iso_set_charset(ISO_CHARSET_ASCII) == 0);
+}
+
+int main()
+{
+	iso_init(FI_ISO8583_1987);
+
+	_test_ebcdic_round_trip();
+	_test_per_thread();
+
+	iso_release();
+
+	return TEST_RESULT();
+}
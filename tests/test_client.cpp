@@ -0,0 +1,106 @@
+#include <string>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "iso_client.hpp"
+
+extern "C"
+{
+#include "test.h"
+#include "iso_8583.h"
+}
+
+namespace
+{
+
+iso::exchange_result<> glb_result;
+
+bool glb_resumed = false;
+
+iso::task authorize(iso::client<> &client, iso::message<> request)
+{
+	glb_result = co_await client.send(request);
+	glb_resumed = true;
+}
+
+// Read framed request written by the client (it is written by run_once, the socket is non-blocking).
+std::string read_request(int socket)
+{
+	std::string input;
+	char buffer[1024];
+	ssize_t received = 0;
+
+	while((received = read(socket, buffer, sizeof(buffer))) > 0)
+	{
+		input.append(buffer, static_cast<std::size_t>(received));
+	}
+
+	return (input.size() > iso::client<>::frame_header_length) ? input.substr(iso::client<>::frame_header_length) : std::string();
+}
+
+// Response arrives together with the end of stream: it is matched before the connection is closed.
+void test_response_before_eof()
+{
+	iso::message<> request;
+	iso::message<> response;
+	std::string packed;
+	std::string frame;
+	int sockets[2] = {-1, -1};
+	int i = 0;
+
+	TEST_CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0);
+	fcntl(sockets[0], F_SETFL, fcntl(sockets[0], F_GETFL) | O_NONBLOCK);
+	fcntl(sockets[1], F_SETFL, fcntl(sockets[1], F_GETFL) | O_NONBLOCK);
+
+	{
+		iso::client<> client({sockets[0]}, 1000);
+
+		request.set_mti("0200");
+		request.set<11>("000001");
+		request.set<37>("000000000001");
+		request.set<41>("TERM0001");
+		authorize(client, request);
+
+		TEST_CHECK(client.run_once(0) == 0);
+		TEST_CHECK(iso::message<>().decode(read_request(sockets[1])));
+
+		response = request;
+		response.set_mti("0210");
+		response.set<39>("00");
+		packed = response.encode();
+		frame.push_back(static_cast<char>((packed.size() >> 8) & 0xFF));
+		frame.push_back(static_cast<char>(packed.size() & 0xFF));
+		frame.append(packed);
+
+		TEST_CHECK(write(sockets[1], frame.data(), frame.size()) == static_cast<ssize_t>(frame.size()));
+		close(sockets[1]);
+
+		for(i = 0; i < 10 && !glb_resumed; i++)
+		{
+			client.run_once(10);
+		}
+
+		TEST_CHECK(glb_resumed);
+		TEST_CHECK(glb_result.status == iso::exchange_status::ok);
+		TEST_CHECK(glb_result.response.mti() == "0210");
+		TEST_CHECK(client.in_flight() == 0);
+
+		// Connection is closed after the frames are matched.
+		TEST_CHECK(client.run_once(0) == -1);
+	}
+
+	close(sockets[0]);
+}
+
+}
+
+int main()
+{
+	iso_init(FI_ISO8583_1987);
+
+	test_response_before_eof();
+
+	return TEST_RESULT();
+}
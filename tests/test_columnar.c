@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "iso_8583.h"
+#include "iso_columnar.h"
+
+#define TEST_OUTPUT_MAX     4096
+
+// Int: Allocation failures injected while set (realloc is wrapped by the linker, see CMakeLists.txt).
+static int glb_fail_realloc = 0;
+
+void *__real_realloc(void *data, size_t size);
+
+void *__wrap_realloc(void *data, size_t size)
+{
+	return glb_fail_realloc ? NULL : __real_realloc(data, size);
+}
+
+// Pack message with fields 3, 41 and 48 (NULL fields are not set).
+static int _test_message(const char *mti, const char *field_3, const char *field_41, const char *field_48, char *message, int capacity)
+{
+	iso_release();
+	iso_set_mti(mti);
+	if(field_3 != NULL)
+	{
+		iso_add_field(3, field_3, strlen(field_3));
+	}
+	if(field_41 != NULL)
+	{
+		iso_add_field(41, field_41, strlen(field_41));
+	}
+	if(field_48 != NULL)
+	{
+		iso_add_field(48, field_48, strlen(field_48));
+	}
+
+	return iso_generate_message_bounded(message, capacity);
+}
+
+static int _test_append(struct iso_columnar *columnar, const char *mti, const char *field_3, const char *field_41, const char *field_48)
+{
+	char message[2048];
+	int length = _test_message(mti, field_3, field_41, field_48, message, sizeof(message));
+
+	return (length > 0) ? iso_columnar_append(columnar, message, length) : -1;
+}
+
+// Write output of columnar (csv or binary) into buffer, returns its length.
+static int _test_output(const struct iso_columnar *columnar, int csv, char *output)
+{
+	FILE *file = tmpfile();
+	int length = 0;
+
+	TEST_CHECK(file != NULL);
+	if(file == NULL)
+	{
+		return 0;
+	}
+
+	TEST_CHECK((csv ? iso_columnar_write_csv(columnar, file) : iso_columnar_write_binary(columnar, file)) == 0);
+	rewind(file);
+	length = (int) fread(output, 1, TEST_OUTPUT_MAX, file);
+	fclose(file);
+
+	return length;
+}
+
+// Binary format of two rows: mti, fixed length and variable length columns, with missing fields.
+static void _test_binary()
+{
+	const int fields[] = {3, 48};
+	struct iso_columnar columnar;
+	char output[TEST_OUTPUT_MAX];
+	static const char expected[] =
+		"ISOCOL01" "\x02\x00\x00\x00" "\x03\x00\x00\x00"
+		"\x00\x00" "\x04\x00" "\x08\x00\x00\x00\x00\x00\x00\x00"
+		"\x03\x00" "\x06\x00" "\x0C\x00\x00\x00\x00\x00\x00\x00"
+		"\x30\x00" "\x00\x00" "\x03\x00\x00\x00\x00\x00\x00\x00"
+		"\x03" "02000210"
+		"\x01" "000000      "
+		"\x01" "\x00\x00\x00\x00" "\x03\x00\x00\x00" "\x03\x00\x00\x00" "abc";
+	int length = 0;
+
+	TEST_CHECK(iso_columnar_init(&columnar, fields, 2) == 0);
+	TEST_CHECK(_test_append(&columnar, "0200", "000000", NULL, "abc") == 0);
+	TEST_CHECK(_test_append(&columnar, "0210", NULL, NULL, NULL) == 0);
+
+	length = _test_output(&columnar, 0, output);
+	TEST_CHECK(length == sizeof(expected) - 1 && memcmp(output, expected, length) == 0);
+
+	iso_columnar_release(&columnar);
+}
+
+// Csv values with separator, quote or line break are quoted, missing fields are empty.
+static void _test_csv()
+{
+	const int fields[] = {3, 41, 48};
+	struct iso_columnar columnar;
+	char output[TEST_OUTPUT_MAX];
+	static const char expected[] =
+		"mti,3,41,48\n"
+		"0200,000000,TERM0001,plain\n"
+		"0210,,\"TE,\"\"M001\",\n"
+		"0400,000000,,\"two\nlines\"\n";
+	int length = 0;
+
+	TEST_CHECK(iso_columnar_init(&columnar, fields, 3) == 0);
+	TEST_CHECK(_test_append(&columnar, "0200", "000000", "TERM0001", "plain") == 0);
+	TEST_CHECK(_test_append(&columnar, "0210", NULL, "TE,\"M001", NULL) == 0);
+	TEST_CHECK(_test_append(&columnar, "0400", "000000", NULL, "two\nlines") == 0);
+
+	length = _test_output(&columnar, 1, output);
+	TEST_CHECK(length == sizeof(expected) - 1 && memcmp(output, expected, length) == 0);
+
+	iso_columnar_release(&columnar);
+}
+
+// Row that fails in a later column is removed from the previous ones, so all columns keep the same rows.
+static void _test_failed_append()
+{
+	const int fields[] = {48};
+	struct iso_columnar columnar;
+	char output[TEST_OUTPUT_MAX];
+	char field_48[1000];
+	char message[2048];
+	FILE *file = NULL;
+	int length = 0;
+	int rows = 0;
+
+	memset(field_48, 'A', sizeof(field_48) - 1);
+	field_48[sizeof(field_48) - 1] = '\0';
+	length = _test_message("0200", NULL, NULL, field_48, message, sizeof(message));
+
+	TEST_CHECK(iso_columnar_init(&columnar, fields, 1) == 0);
+	TEST_CHECK(iso_columnar_append(&columnar, message, length) == 0);
+
+	// Column of field 48 grows before the mti one, so the row fails after its mti was appended.
+	glb_fail_realloc = 1;
+	for(rows = 1; rows < 1000 && iso_columnar_append(&columnar, message, length) == 0; rows++)
+	{
+	}
+	glb_fail_realloc = 0;
+
+	TEST_CHECK(rows < 1000 && columnar.row_count == rows);
+	TEST_CHECK(columnar.columns[0].data_length == (size_t) rows * FI_MTI_LEN_BYTES);
+	TEST_CHECK(columnar.columns[1].data_length == (size_t) rows * (sizeof(field_48) - 1));
+	TEST_CHECK(((columnar.columns[0].validity[rows / 8] >> (rows % 8)) & 1) == 0);
+
+	// Next row is stored in the same position of all columns.
+	TEST_CHECK(_test_append(&columnar, "0210", NULL, NULL, "last") == 0);
+	TEST_CHECK(columnar.row_count == rows + 1);
+	TEST_CHECK(columnar.columns[0].data_length == (size_t) (rows + 1) * FI_MTI_LEN_BYTES);
+	TEST_CHECK(memcmp(columnar.columns[0].data + (size_t) rows * FI_MTI_LEN_BYTES, "0210", FI_MTI_LEN_BYTES) == 0);
+	TEST_CHECK(columnar.columns[1].offsets[rows + 1] - columnar.columns[1].offsets[rows] == 4);
+
+	file = tmpfile();
+	TEST_CHECK(file != NULL && iso_columnar_write_csv(&columnar, file) == 0);
+	if(file != NULL)
+	{
+		fseek(file, -10, SEEK_END);
+		TEST_CHECK(fread(output, 1, 10, file) == 10 && memcmp(output, "0210,last\n", 10) == 0);
+		fclose(file);
+	}
+
+	iso_columnar_release(&columnar);
+}
+
+// Rows of other export are appended after the current ones.
+static void _test_concat()
+{
+	const int fields[] = {3, 41};
+	const int other_fields[] = {3, 42};
+	struct iso_columnar columnar;
+	struct iso_columnar other;
+	struct iso_columnar mismatched;
+	char output[TEST_OUTPUT_MAX];
+	static const char expected[] =
+		"mti,3,41\n"
+		"0200,000000,TERM0001\n"
+		"0210,,TERM0002\n"
+		"0400,000001,\n";
+	int length = 0;
+
+	TEST_CHECK(iso_columnar_init(&columnar, fields, 2) == 0);
+	TEST_CHECK(iso_columnar_init(&other, fields, 2) == 0);
+	TEST_CHECK(iso_columnar_init(&mismatched, other_fields, 2) == 0);
+	TEST_CHECK(_test_append(&columnar, "0200", "000000", "TERM0001", NULL) == 0);
+	TEST_CHECK(_test_append(&other, "0210", NULL, "TERM0002", NULL) == 0);
+	TEST_CHECK(_test_append(&other, "0400", "000001", NULL, NULL) == 0);
+
+	TEST_CHECK(iso_columnar_concat(&columnar, &other) == 0);
+	TEST_CHECK(iso_columnar_concat(&columnar, &mismatched) == -1);
+
+	length = _test_output(&columnar, 1, output);
+	TEST_CHECK(length == sizeof(expected) - 1 && memcmp(output, expected, length) == 0);
+
+	iso_columnar_release(&columnar);
+	iso_columnar_release(&other);
+	iso_columnar_release(&mismatched);
+}
+
+int main()
+{
+	iso_init(FI_ISO8583_1987);
+
+	_test_binary();
+	_test_csv();
+	_test_failed_append();
+	_test_concat();
+
+	iso_release();
+
+	return TEST_RESULT();
+}
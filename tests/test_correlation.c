@@ -0,0 +1,125 @@
+#include <string.h>
+
+#include "test.h"
+#include "iso_8583.h"
+#include "iso_correlation.h"
+
+static int glb_expired = 0;
+
+static void _test_expired(const struct iso_corr_key *key, const char *request, int length, void *user_data, void *context)
+{
+	glb_expired++;
+}
+
+// Pack 0200 request with stan, card security data and routing fields.
+static int _test_request(const char *stan, char *message)
+{
+	iso_release();
+	iso_set_mti("0200");
+	iso_add_field(2, "4761739001010010", 16);
+	iso_add_field(3, "000000", 6);
+	iso_add_field(4, "000000001000", 12);
+	iso_add_field(7, "1019120000", 10);
+	iso_add_field(11, stan, 6);
+	iso_add_field(32, "123456", 6);
+	iso_add_field(33, "654321", 6);
+	iso_add_field(35, "4761739001010010=25122011143804400000", 37);
+	iso_add_field(37, "000000000001", 12);
+	iso_add_field(41, "TERM0001", 8);
+	iso_add_field(52, "\x12\x34\x56\x78\x9A\xBC\xDE\xF0", 8);
+
+	return iso_generate_message(message);
+}
+
+static void _test_deadlines()
+{
+	const int key_fields[] = {11, 37, 41};
+	struct iso_corr_table *table = iso_corr_create(64, key_fields, 3);
+	struct iso_corr_key key;
+	char message[1024];
+	void *user_data = NULL;
+
+	TEST_CHECK(table != NULL);
+
+	// Deadline is relative to the insertion tick, even before the first advance.
+	TEST_CHECK(_test_request("000001", message) == 0);
+	TEST_CHECK(iso_corr_key_from_raw(table, message, strlen(message), &key) == 0);
+	TEST_CHECK(iso_corr_insert(table, &key, message, strlen(message), 100000, 30, (void *) 1) == 0);
+	TEST_CHECK(iso_corr_insert(table, &key, message, strlen(message), 100000, 30, NULL) == -1);
+	TEST_CHECK(iso_corr_advance(table, 100000, _test_expired, NULL) == 0);
+	TEST_CHECK(iso_corr_advance(table, 100029, _test_expired, NULL) == 0);
+	TEST_CHECK(iso_corr_advance(table, 100030, _test_expired, NULL) == 1);
+	TEST_CHECK(glb_expired == 1);
+	TEST_CHECK(iso_corr_count(table) == 0);
+
+	// Matched requests do not expire, the ones further than the wheel size expire in later rounds.
+	TEST_CHECK(_test_request("000002", message) == 0);
+	TEST_CHECK(iso_corr_key_from_raw(table, message, strlen(message), &key) == 0);
+	TEST_CHECK(iso_corr_insert(table, &key, message, strlen(message), 100030, 10, (void *) 2) == 0);
+	TEST_CHECK(iso_corr_match(table, &key, &user_data) == 0 && user_data == (void *) 2);
+	TEST_CHECK(iso_corr_match(table, &key, &user_data) == -1);
+
+	TEST_CHECK(iso_corr_insert(table, &key, message, strlen(message), 100030, ISO_CORR_WHEEL_SLOTS * 2 + 5, NULL) == 0);
+	TEST_CHECK(iso_corr_advance(table, 100030 + ISO_CORR_WHEEL_SLOTS * 2, NULL, NULL) == 0);
+	TEST_CHECK(iso_corr_advance(table, 100030 + ISO_CORR_WHEEL_SLOTS * 2 + 5, NULL, NULL) == 1);
+
+	iso_corr_destroy(table);
+}
+
+static void _test_reversal()
+{
+	char message[1024];
+	char reversal[1024];
+	char mti[FI_MTI_LEN_BYTES + 1];
+	char value[128];
+
+	TEST_CHECK(_test_request("000003", message) == 0);
+	TEST_CHECK(iso_corr_make_reversal(message, strlen(message), reversal) == 0);
+	TEST_CHECK(iso_decode_message(reversal) == 0);
+	TEST_CHECK(iso_get_mti(mti) == 0 && strcmp(mti, "0400") == 0);
+	TEST_CHECK(iso_get_field(90, value) == 0 && strcmp(value, "020000000310191200000000012345600000654321") == 0);
+	TEST_CHECK(iso_is_set_field(2) && iso_is_set_field(4) && iso_is_set_field(11) && iso_is_set_field(41));
+	TEST_CHECK(!iso_is_set_field(35) && !iso_is_set_field(52));
+}
+
+// Key fields with zero bytes are not truncated, keys of current message and packed message are the same.
+static void _test_binary_key()
+{
+	const int key_fields[] = {11, 52};
+	struct iso_corr_table *table = iso_corr_create(64, key_fields, 2);
+	struct iso_corr_key first;
+	struct iso_corr_key second;
+	struct iso_corr_key raw;
+	char message[1024];
+	int length = 0;
+
+	TEST_CHECK(table != NULL);
+
+	iso_release();
+	iso_set_mti("0200");
+	iso_add_field(11, "000001", 6);
+	iso_add_field_bytes(52, "\x00\x01\x02\x03\x04\x05\x06\x07", 8);
+	TEST_CHECK(iso_corr_key_from_message(table, &first) == 0);
+	length = iso_generate_message_bounded(message, sizeof(message));
+	TEST_CHECK(iso_corr_key_from_raw(table, message, length, &raw) == 0);
+	TEST_CHECK(raw.length == first.length && memcmp(raw.data, first.data, raw.length) == 0);
+
+	iso_add_field_bytes(52, "\x00\x09\x02\x03\x04\x05\x06\x07", 8);
+	TEST_CHECK(iso_corr_key_from_message(table, &second) == 0);
+	TEST_CHECK(second.length != first.length || memcmp(second.data, first.data, first.length) != 0);
+
+	iso_corr_destroy(table);
+}
+
+int main()
+{
+	iso_init(FI_ISO8583_1987);
+
+	_test_deadlines();
+	_test_reversal();
+	_test_binary_key();
+
+	iso_release();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "iso_8583.h"
+#include "fields_info.h"
+
+// Pack 0200 with fixed fields 3, 4 and 11, variable field 32 and fixed field 41 (of length of the current spec).
+static int _test_message(const char *terminal, char *message, int capacity)
+{
+	iso_release();
+	iso_set_mti("0200");
+	iso_add_field(3, "000000", 6);
+	iso_add_field(4, "000000002500", 12);
+	iso_add_field(11, "000123", 6);
+	iso_add_field(32, "12345", 5);
+	iso_add_field(41, terminal, strlen(terminal));
+
+	return iso_generate_message_bounded(message, capacity);
+}
+
+// Field of current message is the expected value.
+static int _test_field(int field, const char *expected)
+{
+	const char *data = NULL;
+	int length = 0;
+
+	return iso_get_field_view(field, &data, &length) == 0 && length == (int) strlen(expected) && memcmp(data, expected, length) == 0;
+}
+
+// Fixed fields before the first variable one are read from their plan offsets, the others in order.
+static void _test_fixed_prefix()
+{
+	char message[512];
+	int length = _test_message("TERM0001", message, sizeof(message));
+
+	TEST_CHECK(length > 0 && iso_decode_message_bytes(message, length) == 0);
+	TEST_CHECK(_test_field(3, "000000") && _test_field(4, "000000002500") && _test_field(11, "000123"));
+	TEST_CHECK(_test_field(32, "12345") && _test_field(41, "TERM0001"));
+	TEST_CHECK(iso_packed_size() == length);
+
+	// Truncated in the fixed prefix and after it.
+	TEST_CHECK(iso_decode_message_bytes(message, FI_MTI_LEN_BYTES + FI_BITMAP_HEX_BYTES + 20) == -1);
+	TEST_CHECK(iso_decode_message_bytes(message, length - 1) == -1);
+}
+
+// Cached plan of bitmaps is rebuilt when fields info changes (new generation).
+static void _test_plan_generation()
+{
+	struct fi_field_info terminal;
+	struct fi_field_info longer;
+	char message[512];
+	unsigned int generation = 0;
+	int length = 0;
+
+	// Plan of these bitmaps is cached with field 41 of 8 bytes.
+	length = _test_message("TERM0001", message, sizeof(message));
+	TEST_CHECK(length > 0 && iso_decode_message_bytes(message, length) == 0 && _test_field(41, "TERM0001"));
+
+	TEST_CHECK(fi_get_field_info(41, &terminal) == 0);
+	longer = fi_mount_field_info(FI_TYPE__ANS, FI_VARIABLE_FIELD_FALSE, 10, "card acceptor terminal identification", "");
+	generation = fi_get_generation();
+	TEST_CHECK(fi_set_field_info(41, &longer) == 0);
+	TEST_CHECK(fi_get_generation() != generation);
+
+	length = _test_message("TERM000001", message, sizeof(message));
+	TEST_CHECK(length > 0 && iso_decode_message_bytes(message, length) == 0 && _test_field(41, "TERM000001"));
+
+	// Message of the previous layout is now short.
+	TEST_CHECK(fi_set_field_info(41, &terminal) == 0);
+	length = _test_message("TERM0001", message, sizeof(message));
+	TEST_CHECK(fi_set_field_info(41, &longer) == 0);
+	TEST_CHECK(iso_decode_message_bytes(message, length) == -1);
+
+	TEST_CHECK(fi_set_field_info(41, &terminal) == 0);
+	TEST_CHECK(iso_decode_message_bytes(message, length) == 0 && _test_field(41, "TERM0001"));
+}
+
+int main()
+{
+	iso_init(FI_ISO8583_1987);
+
+	_test_fixed_prefix();
+	_test_plan_generation();
+
+	iso_release();
+
+	return TEST_RESULT();
+}
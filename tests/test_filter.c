@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "iso_8583.h"
+#include "iso_filter.h"
+
+// Packed test message with fields 2, 3, 4 and 41.
+static char glb_message[512];
+static int glb_length = 0;
+
+static void _test_pack(const char *mti, const char *pan, const char *amount)
+{
+	iso_release();
+	iso_set_mti(mti);
+	iso_add_field(2, pan, strlen(pan));
+	iso_add_field(3, "000000", 6);
+	iso_add_field(4, amount, 12);
+	iso_add_field(41, "TERM0001", 8);
+	glb_length = iso_generate_message_bounded(glb_message, sizeof(glb_message));
+	TEST_CHECK(glb_length > 0);
+}
+
+// Result of expression on the test message (-2 case expression does not compile).
+static int _test_match(const char *expression)
+{
+	struct iso_filter filter;
+
+	if(iso_filter_compile(expression, &filter) != 0)
+	{
+		return -2;
+	}
+
+	return iso_filter_match(&filter, glb_message, glb_length);
+}
+
+static void _test_operators()
+{
+	_test_pack("0200", "4111111111111111", "000000002500");
+
+	TEST_CHECK(_test_match("") == 1);
+	TEST_CHECK(_test_match("mti=0200") == 1);
+	TEST_CHECK(_test_match("mti=0210") == 0);
+	TEST_CHECK(_test_match("has(41)") == 1);
+	TEST_CHECK(_test_match("has(55)") == 0);
+	TEST_CHECK(_test_match("3=000000") == 1);
+	TEST_CHECK(_test_match("3=00000") == 0);
+	TEST_CHECK(_test_match("41=TERM0001") == 1);
+	TEST_CHECK(_test_match("2^411111") == 1);
+	TEST_CHECK(_test_match("2^522222") == 0);
+	TEST_CHECK(_test_match("42=X") == 0);
+
+	// Numeric ranges ignore leading zeros, the others are compared lexicographically.
+	TEST_CHECK(_test_match("4:000000001000..000000005000") == 1);
+	TEST_CHECK(_test_match("4:1000..5000") == 1);
+	TEST_CHECK(_test_match("4:2501..5000") == 0);
+	TEST_CHECK(_test_match("4:2500..2500") == 1);
+	TEST_CHECK(_test_match("41:TERM..TERM1") == 1);
+	TEST_CHECK(_test_match("41:TERM1..TERM2") == 0);
+}
+
+static void _test_wildcards()
+{
+	_test_pack("0210", "4111111111111111", "000000002500");
+
+	TEST_CHECK(_test_match("mti=02x0") == 1);
+	TEST_CHECK(_test_match("mti=xxxx") == 1);
+	TEST_CHECK(_test_match("mti=x1x0") == 0);
+	TEST_CHECK(_test_match("mti=04x0") == 0);
+}
+
+static void _test_negation()
+{
+	_test_pack("0200", "4111111111111111", "000000002500");
+
+	TEST_CHECK(_test_match("!has(55)") == 1);
+	TEST_CHECK(_test_match("!has(41)") == 0);
+	TEST_CHECK(_test_match("!mti=0200") == 0);
+	TEST_CHECK(_test_match("! 2^5") == 1);
+	TEST_CHECK(_test_match("!42=X") == 1);
+}
+
+// Terms joined by '|' are a clause, clauses are joined by '&'.
+static void _test_cnf()
+{
+	_test_pack("0200", "5222222222222222", "000000002500");
+
+	TEST_CHECK(_test_match("mti=02x0 & 3^00 & 2^411111|2^522222 & !has(55)") == 1);
+	TEST_CHECK(_test_match("2^411111|2^522222") == 1);
+	TEST_CHECK(_test_match("2^411111|2^533333") == 0);
+	TEST_CHECK(_test_match("3=999999 & 2^5") == 0);
+	TEST_CHECK(_test_match("2^5 & 3=999999") == 0);
+	TEST_CHECK(_test_match("3=999999|mti=0200 & 41=TERM0001|has(55)") == 1);
+	TEST_CHECK(_test_match("3=999999|mti=0210 & 41=TERM0001") == 0);
+}
+
+static void _test_invalid_expressions()
+{
+	TEST_CHECK(_test_match("mti=") == -2);
+	TEST_CHECK(_test_match("mti=020") == -2);
+	TEST_CHECK(_test_match("mti=02a0") == -2);
+	TEST_CHECK(_test_match("has(200)") == -2);
+	TEST_CHECK(_test_match("has(1)") == -2);
+	TEST_CHECK(_test_match("3=") == -2);
+	TEST_CHECK(_test_match("3~000000") == -2);
+	TEST_CHECK(_test_match("4:1000") == -2);
+	TEST_CHECK(_test_match("3=000000 &") == -2);
+	TEST_CHECK(_test_match("3=000000 3=000000") == -2);
+}
+
+// Messages that can not be walked until the needed fields are invalid.
+static void _test_invalid_messages()
+{
+	struct iso_filter filter;
+	char corrupted[512];
+
+	_test_pack("0200", "4111111111111111", "000000002500");
+
+	TEST_CHECK(iso_filter_compile("41=TERM0001", &filter) == 0);
+	TEST_CHECK(iso_filter_match(&filter, glb_message, glb_length) == 1);
+	TEST_CHECK(iso_filter_match(&filter, glb_message, glb_length - 4) == -1);
+	TEST_CHECK(iso_filter_match(&filter, glb_message, 10) == -1);
+	TEST_CHECK(iso_filter_match(&filter, NULL, glb_length) == -1);
+
+	// Length prefix of field 2 is not a number.
+	memcpy(corrupted, glb_message, glb_length);
+	corrupted[FI_MTI_LEN_BYTES + FI_BITMAP_HEX_BYTES] = 'X';
+	TEST_CHECK(iso_filter_match(&filter, corrupted, glb_length) == -1);
+
+	// Only mti and bitmap are needed by these filters.
+	TEST_CHECK(iso_filter_compile("mti=0200 & has(41)", &filter) == 0);
+	TEST_CHECK(iso_filter_match(&filter, glb_message, glb_length - 4) == 1);
+}
+
+int main()
+{
+	iso_init(FI_ISO8583_1987);
+
+	_test_operators();
+	_test_wildcards();
+	_test_negation();
+	_test_cnf();
+	_test_invalid_expressions();
+	_test_invalid_messages();
+
+	iso_release();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "iso_8583.h"
+#include "iso_capture.h"
+#include "iso_index.h"
+
+#define TEST_CAPTURE_PATH   "test_index.txt"
+#define TEST_INDEX_PATH     "test_index.idx"
+#define TEST_MESSAGES       5
+
+// Write capture with separator before each message (i.e. empty lines).
+static void _test_write_capture(const char *separator)
+{
+	FILE *file = fopen(TEST_CAPTURE_PATH, "wb");
+	char message[512];
+	char stan[8];
+	int i = 0;
+
+	TEST_CHECK(file != NULL);
+
+	for(i = 1; i <= TEST_MESSAGES; i++)
+	{
+		snprintf(stan, sizeof(stan), "%06d", i);
+		iso_release();
+		iso_set_mti("0200");
+		iso_add_field(3, "000000", 6);
+		iso_add_field(11, stan, 6);
+		iso_add_field(41, "TERM0001", 8);
+		TEST_CHECK(iso_generate_message(message) == 0);
+		fprintf(file, "%s%s\n", separator, message);
+	}
+
+	TEST_CHECK(fclose(file) == 0);
+}
+
+// Each key is found once and the found message has the key.
+static void _test_lookup(const char *separator)
+{
+	const int key_fields[] = {11};
+	struct iso_index index;
+	unsigned long long cursor = 0;
+	char message[FI_LEN_MAX_ISO + ISO_CAPTURE_BINARY_HEADER];
+	char key[8];
+	char value[16];
+	int hits = 0;
+	int length = 0;
+	int i = 0;
+
+	_test_write_capture(separator);
+	TEST_CHECK(iso_index_build(TEST_CAPTURE_PATH, ISO_CAPTURE_ASCII, key_fields, 1, TEST_INDEX_PATH) == TEST_MESSAGES);
+	TEST_CHECK(iso_index_open(TEST_INDEX_PATH, TEST_CAPTURE_PATH, &index) == 0);
+
+	for(i = 1; i <= TEST_MESSAGES; i++)
+	{
+		snprintf(key, sizeof(key), "%06d", i);
+		cursor = 0;
+		hits = 0;
+		while((length = iso_index_find(&index, key, 6, &cursor, message, sizeof(message), NULL)) > 0)
+		{
+			TEST_CHECK(iso_decode_message_bytes(message, length) == 0 && iso_get_field(11, value) == 0 && strcmp(value, key) == 0);
+			hits++;
+		}
+		TEST_CHECK(length == 0);
+		TEST_CHECK(hits == 1);
+	}
+
+	iso_index_close(&index);
+	remove(TEST_INDEX_PATH);
+	remove(TEST_CAPTURE_PATH);
+}
+
+int main()
+{
+	iso_init(FI_ISO8583_1987);
+
+	_test_lookup("");
+	_test_lookup("\n");
+	_test_lookup("\n\n\n");
+	_test_lookup("\r\n");
+
+	iso_release();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "test.h"
+#include "iso_8583.h"
+#include "iso_journal.h"
+
+#define TEST_JOURNAL_PATH   "test_journal.dir"
+#define TEST_SEGMENT_PATH   TEST_JOURNAL_PATH "/0000000000000001.jnl"
+
+// Int: Key fields of responses.
+static const int glb_key_fields[] = {11, 37, 41};
+
+// Remove segments of previous runs.
+static void _test_clear_journal()
+{
+	struct dirent *entry = NULL;
+	char path[512];
+	DIR *directory = opendir(TEST_JOURNAL_PATH);
+
+	while(directory != NULL && (entry = readdir(directory)) != NULL)
+	{
+		if(entry->d_name[0] != '.')
+		{
+			snprintf(path, sizeof(path), "%s/%s", TEST_JOURNAL_PATH, entry->d_name);
+			remove(path);
+		}
+	}
+
+	if(directory != NULL)
+	{
+		closedir(directory);
+	}
+	rmdir(TEST_JOURNAL_PATH);
+}
+
+// Generate 0220 advice with stan, all advices have the same length.
+static int _test_advice(int stan, char *message, int capacity)
+{
+	char value[8];
+
+	snprintf(value, sizeof(value), "%06d", stan);
+	iso_release();
+	iso_set_mti("0220");
+	iso_add_field(11, value, 6);
+	iso_add_field(37, "000000000001", 12);
+	iso_add_field(41, "TERM0001", 8);
+
+	return iso_generate_message_bounded(message, capacity);
+}
+
+static struct iso_journal *_test_open()
+{
+	return iso_journal_open(TEST_JOURNAL_PATH, ISO_JOURNAL_SEGMENT_MIN, glb_key_fields, 3);
+}
+
+// Pending message after_id is the expected one.
+static void _test_check_next(struct iso_journal *journal, unsigned long long after_id, unsigned long long expected_id, int stan)
+{
+	char expected[256];
+	const char *message = NULL;
+	unsigned long long id = 0;
+	int expected_length = _test_advice(stan, expected, sizeof(expected));
+	int length = 0;
+
+	TEST_CHECK(iso_journal_next_pending(journal, after_id, &message, &length, &id) == 1);
+	TEST_CHECK(id == expected_id);
+	TEST_CHECK(length == expected_length && memcmp(message, expected, length) == 0);
+}
+
+// Process exits without closing journal: committed messages and acks are replayed, ids are not reused.
+static void _test_crash_reopen()
+{
+	struct iso_journal *journal = NULL;
+	char message[256];
+	int status = -1;
+	int length = 0;
+	int i = 0;
+	pid_t child = 0;
+
+	_test_clear_journal();
+
+	child = fork();
+	if(child == 0)
+	{
+		journal = _test_open();
+		for(i = 1; journal != NULL && i <= 3; i++)
+		{
+			length = _test_advice(i, message, sizeof(message));
+			iso_journal_append(journal, message, length);
+		}
+		iso_journal_commit(journal);
+		iso_journal_ack(journal, 2);
+		iso_journal_commit(journal);
+		_exit(0);
+	}
+
+	TEST_CHECK(child > 0 && waitpid(child, &status, 0) == child && status == 0);
+
+	journal = _test_open();
+	TEST_CHECK(journal != NULL);
+	if(journal == NULL)
+	{
+		return;
+	}
+
+	TEST_CHECK(iso_journal_pending_count(journal) == 2);
+	_test_check_next(journal, 0, 1, 1);
+	_test_check_next(journal, 1, 3, 3);
+
+	length = _test_advice(4, message, sizeof(message));
+	TEST_CHECK(iso_journal_append(journal, message, length) == 4);
+
+	TEST_CHECK(iso_journal_close(journal) == 0);
+}
+
+// Record lost before a later one reached the disk: the later one is cleared on open, it is not replayed after the
+// lost id is appended again.
+static void _test_stale_tail()
+{
+	struct iso_journal *journal = NULL;
+	unsigned char segment[ISO_JOURNAL_SEGMENT_MIN];
+	unsigned char zero[4] = {0, 0, 0, 0};
+	char message[256];
+	FILE *file = NULL;
+	size_t size = 0;
+	size_t offset = 0;
+	int length = 0;
+	int i = 0;
+
+	_test_clear_journal();
+
+	journal = _test_open();
+	TEST_CHECK(journal != NULL);
+	if(journal == NULL)
+	{
+		return;
+	}
+	for(i = 1; i <= 3; i++)
+	{
+		length = _test_advice(i, message, sizeof(message));
+		TEST_CHECK(iso_journal_append(journal, message, length) == (unsigned long long) i);
+	}
+	TEST_CHECK(iso_journal_close(journal) == 0);
+
+	// Zero the record length of message 2.
+	file = fopen(TEST_SEGMENT_PATH, "r+b");
+	TEST_CHECK(file != NULL);
+	if(file == NULL)
+	{
+		return;
+	}
+	size = fread(segment, 1, sizeof(segment), file);
+	length = _test_advice(2, message, sizeof(message));
+	for(offset = ISO_JOURNAL_HEADER_LEN; offset + length <= size && memcmp(segment + offset, message, length) != 0; offset++)
+	{
+	}
+	TEST_CHECK(offset + length <= size);
+	fseek(file, (long) (offset - ISO_JOURNAL_RECORD_HEADER_LEN), SEEK_SET);
+	TEST_CHECK(fwrite(zero, 1, sizeof(zero), file) == sizeof(zero));
+	TEST_CHECK(fclose(file) == 0);
+
+	journal = _test_open();
+	TEST_CHECK(journal != NULL && iso_journal_pending_count(journal) == 1);
+	if(journal == NULL)
+	{
+		return;
+	}
+	length = _test_advice(4, message, sizeof(message));
+	TEST_CHECK(iso_journal_append(journal, message, length) == 2);
+	TEST_CHECK(iso_journal_close(journal) == 0);
+
+	journal = _test_open();
+	TEST_CHECK(journal != NULL && iso_journal_pending_count(journal) == 2);
+	if(journal == NULL)
+	{
+		return;
+	}
+	_test_check_next(journal, 0, 1, 1);
+	_test_check_next(journal, 1, 2, 4);
+	TEST_CHECK(iso_journal_close(journal) == 0);
+}
+
+int main()
+{
+	iso_init(FI_ISO8583_1987);
+
+	_test_crash_reopen();
+	_test_stale_tail();
+
+	_test_clear_journal();
+	iso_release();
+
+	return TEST_RESULT();
+}
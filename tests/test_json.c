@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "iso_8583.h"
+#include "iso_json.h"
+
+// Longest 'b' field of 1993 (key management data, b LLLVAR 999).
+#define TEST_BINARY_FIELD   96
+#define TEST_BINARY_LENGTH  999
+
+// Json has the hex string of binary field (double length) plus the other fields.
+#define TEST_JSON_CAPACITY  (TEST_BINARY_LENGTH * 2 + 1024)
+
+// Message -> json -> message gives the same packed message, in both json forms.
+static void _test_round_trip(int flags)
+{
+	char binary[TEST_BINARY_LENGTH];
+	char message[FI_LEN_MAX_ISO];
+	char again[FI_LEN_MAX_ISO];
+	char json[TEST_JSON_CAPACITY];
+	const char *data = NULL;
+	int message_length = 0;
+	int json_length = 0;
+	int length = 0;
+	int i = 0;
+
+	for(i = 0; i < TEST_BINARY_LENGTH; i++)
+	{
+		binary[i] = (char) (i % 256);
+	}
+
+	iso_release();
+	TEST_CHECK(iso_set_mti("1800") == 0);
+	TEST_CHECK(iso_add_field(11, "000001", 6) == 0);
+	TEST_CHECK(iso_add_field_bytes(TEST_BINARY_FIELD, binary, TEST_BINARY_LENGTH) == 0);
+	message_length = iso_generate_message_bounded(message, sizeof(message));
+	TEST_CHECK(message_length > TEST_BINARY_LENGTH);
+
+	json_length = iso_json_from_message(message, message_length, json, sizeof(json), flags);
+	TEST_CHECK(json_length > TEST_BINARY_LENGTH * 2);
+
+	TEST_CHECK(iso_json_to_message(json, json_length) == 0);
+	TEST_CHECK(iso_get_field_view(TEST_BINARY_FIELD, &data, &length) == 0);
+	TEST_CHECK(length == TEST_BINARY_LENGTH && memcmp(data, binary, TEST_BINARY_LENGTH) == 0);
+
+	TEST_CHECK(iso_generate_message_bounded(again, sizeof(again)) == message_length);
+	TEST_CHECK(memcmp(again, message, message_length) == 0);
+}
+
+int main()
+{
+	iso_init(FI_ISO8583_1993);
+
+	_test_round_trip(0);
+	_test_round_trip(ISO_JSON_DESCRIPTIONS);
+
+	iso_release();
+
+	return TEST_RESULT();
+}
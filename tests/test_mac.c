@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "iso_8583.h"
+#include "iso_mac.h"
+
+// AES-128 key of RFC 4493 examples.
+static const unsigned char glb_aes_key[16] =
+{
+	0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+// Message of RFC 4493 examples (examples use its first 0, 16, 40 and 64 bytes).
+static const unsigned char glb_aes_message[64] =
+{
+	0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+	0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+	0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+	0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10
+};
+
+// Double length DES key of ANSI X9.19 example.
+static const unsigned char glb_retail_key[16] =
+{
+	0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef, 0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10
+};
+
+// Compare MAC of data with expected one, computed in one call and absorbed by chunks of 3 bytes.
+static int _test_vector(struct iso_mac *mac, const unsigned char *data, int length, const char *expected, int expected_length)
+{
+	unsigned char output[ISO_MAC_BLOCK_MAX];
+	unsigned char chunked[ISO_MAC_BLOCK_MAX];
+	int i = 0;
+
+	if(iso_mac_compute(mac, data, length, output) != expected_length || memcmp(output, expected, expected_length) != 0)
+	{
+		return 0;
+	}
+
+	iso_mac_reset(mac);
+	for(i = 0; i < length; i += 3)
+	{
+		iso_mac_update(mac, data + i, (length - i < 3) ? length - i : 3);
+	}
+
+	return (iso_mac_final(mac, chunked) == expected_length && memcmp(chunked, expected, expected_length) == 0);
+}
+
+static void _test_aes_cmac_vectors()
+{
+	struct iso_mac mac;
+
+	TEST_CHECK(iso_mac_init(&mac, &iso_mac_aes_cmac, glb_aes_key, sizeof(glb_aes_key)) == 0);
+
+	TEST_CHECK(_test_vector(&mac, glb_aes_message, 0, "\xbb\x1d\x69\x29\xe9\x59\x37\x28\x7f\xa3\x7d\x12\x9b\x75\x67\x46", 16));
+	TEST_CHECK(_test_vector(&mac, glb_aes_message, 16, "\x07\x0a\x16\xb4\x6b\x4d\x41\x44\xf7\x9b\xdd\x9d\xd0\x4a\x28\x7c", 16));
+	TEST_CHECK(_test_vector(&mac, glb_aes_message, 40, "\xdf\xa6\x67\x47\xde\x9a\xe6\x30\x30\xca\x32\x61\x14\x97\xc8\x27", 16));
+	TEST_CHECK(_test_vector(&mac, glb_aes_message, 64, "\x51\xf0\xbe\xbf\x7e\x3b\x9d\x92\xfc\x49\x74\x17\x79\x36\x3c\xfe", 16));
+
+	TEST_CHECK(iso_mac_init(&mac, &iso_mac_aes_cmac, glb_aes_key, 15) == -1);
+}
+
+static void _test_retail_vectors()
+{
+	struct iso_mac mac;
+
+	TEST_CHECK(iso_mac_init(&mac, &iso_mac_retail, glb_retail_key, sizeof(glb_retail_key)) == 0);
+
+	TEST_CHECK(_test_vector(&mac, (const unsigned char *) "Now is the time for all ", 24, "\xa1\xc7\x2e\x74\xea\x3f\xa9\xb6", 8));
+
+	// Last block is padded with zeros.
+	TEST_CHECK(_test_vector(&mac, (const unsigned char *) "Now is the time for it", 22, "\x2e\x2b\x14\x28\xcc\x78\x25\x4f", 8));
+
+	TEST_CHECK(iso_mac_init(&mac, &iso_mac_retail, glb_retail_key, 8) == -1);
+}
+
+// Struct: Layout of MAC test message by version.
+struct test_layout
+{
+	int version;
+	const char *mti;
+	int second_bitmap; // Field 70 is set, so MAC is in field 128.
+	int mac_field;
+	int mac_field_length;
+};
+
+// MAC field is 16 hex digits in 1987 version and 8 bytes in 1993 version.
+static const struct test_layout glb_layouts[] =
+{
+	{FI_ISO8583_1987, "0200", 0, 64, 16},
+	{FI_ISO8583_1993, "1200", 0, 64, 8},
+	{FI_ISO8583_1993, "1200", 1, 128, 8}
+};
+
+// Pack message of layout and MAC.
+static int _test_message(struct iso_mac *mac, const struct test_layout *layout, char *message, int capacity)
+{
+	iso_release();
+	iso_set_mti(layout->mti);
+	iso_add_field(3, "000000", 6);
+	iso_add_field(4, "000000002500", 12);
+	iso_add_field(11, "000123", 6);
+	iso_add_field(41, "TERM0001", 8);
+	if(layout->second_bitmap)
+	{
+		iso_add_field(70, "301", 3);
+	}
+
+	return iso_generate_message_mac(message, capacity, mac);
+}
+
+// Generated MAC is verified by decode, changed bytes are rejected.
+static void _test_round_trip(const struct iso_mac_algorithm *algorithm, const unsigned char *key, int key_length)
+{
+	const struct test_layout *layout = NULL;
+	struct iso_mac mac;
+	char message[512];
+	char tampered[512];
+	const char *data = NULL;
+	int length = 0;
+	int field_length = 0;
+	int i = 0;
+
+	TEST_CHECK(iso_mac_init(&mac, algorithm, key, key_length) == 0);
+
+	for(i = 0; i < (int) (sizeof(glb_layouts) / sizeof(glb_layouts[0])); i++)
+	{
+		layout = &glb_layouts[i];
+		iso_init(layout->version);
+
+		length = _test_message(&mac, layout, message, sizeof(message));
+		TEST_CHECK(length > 0 && length == iso_packed_size());
+		TEST_CHECK(iso_get_field_view(layout->mac_field, &data, &field_length) == 0 && field_length == layout->mac_field_length);
+		TEST_CHECK(length > field_length && memcmp(message + length - field_length, data, field_length) == 0);
+
+		TEST_CHECK(iso_decode_message_mac(message, length, &mac) == 0);
+		TEST_CHECK(iso_get_field_view(41, &data, &field_length) == 0 && memcmp(data, "TERM0001", 8) == 0);
+
+		// Field data.
+		memcpy(tampered, message, length);
+		tampered[length - layout->mac_field_length - 1] ^= 0x01;
+		TEST_CHECK(iso_decode_message_mac(tampered, length, &mac) == 1);
+
+		// Mti.
+		memcpy(tampered, message, length);
+		tampered[2] = '2';
+		TEST_CHECK(iso_decode_message_mac(tampered, length, &mac) == 1);
+
+		// MAC field.
+		memcpy(tampered, message, length);
+		tampered[length - 1] ^= 0x01;
+		TEST_CHECK(iso_decode_message_mac(tampered, length, &mac) == 1);
+	}
+
+	iso_init(FI_ISO8583_1987);
+}
+
+// Message without room to the MAC is not generated and the current message keeps its fields.
+static void _test_capacity()
+{
+	struct iso_mac mac;
+	char message[512];
+	const char *data = NULL;
+	int length = 0;
+	int size = 0;
+
+	TEST_CHECK(iso_mac_init(&mac, &iso_mac_retail, glb_retail_key, sizeof(glb_retail_key)) == 0);
+
+	iso_release();
+	iso_set_mti("0200");
+	iso_add_field(3, "000000", 6);
+	iso_add_field(41, "TERM0001", 8);
+	size = iso_packed_size();
+
+	// Capacity without the MAC field.
+	TEST_CHECK(iso_generate_message_mac(message, size + 15, &mac) == -1);
+	TEST_CHECK(iso_get_field_view(64, &data, &length) == -1);
+	TEST_CHECK(iso_packed_size() == size);
+
+	length = iso_generate_message_mac(message, size + 16, &mac);
+	TEST_CHECK(length == size + 16);
+
+	// MAC field is replaced, so the same capacity is enough.
+	TEST_CHECK(iso_generate_message_mac(message, length, &mac) == length);
+	TEST_CHECK(iso_decode_message_mac(message, length, &mac) == 0);
+
+	TEST_CHECK(iso_add_field(48, "X", 1) == 0);
+	TEST_CHECK(iso_generate_message_mac(message, length, &mac) == -1);
+	TEST_CHECK(iso_get_field_view(64, &data, &length) == 0 && length == 16);
+}
+
+int main()
+{
+	iso_init(FI_ISO8583_1987);
+
+	_test_aes_cmac_vectors();
+	_test_retail_vectors();
+	_test_round_trip(&iso_mac_retail, glb_retail_key, sizeof(glb_retail_key));
+	_test_round_trip(&iso_mac_aes_cmac, glb_aes_key, sizeof(glb_aes_key));
+	_test_capacity();
+
+	iso_release();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "test.h"
+#include "iso_8583.h"
+#include "iso_raw.h"
+#include "iso_pipeline.h"
+
+#define TEST_WORKERS            4
+#define TEST_CONNECTIONS        6
+#define TEST_CONNECTIONS_MAX    8
+#define TEST_REQUESTS           3000 // By connection.
+
+// Struct: Responses seen by output callback.
+struct test_output
+{
+	unsigned long long next[TEST_CONNECTIONS_MAX]; // Next expected sequence of connection.
+	int invalid;                                    // Responses out of order or not matching their request.
+	int delivered;
+	int gate_closed;                                // Handler waits while set.
+};
+
+// Pack 0200 with stan of sequence.
+static int _test_request(unsigned long long sequence, char *message, int capacity)
+{
+	char value[16];
+
+	snprintf(value, sizeof(value), "%06llu", sequence % 1000000);
+	iso_release();
+	iso_set_mti("0200");
+	iso_add_field(3, "000000", 6);
+	iso_add_field(11, value, 6);
+	iso_add_field(41, "TERM0001", 8);
+
+	return iso_generate_message_bounded(message, capacity);
+}
+
+// Sleep microseconds.
+static void _test_sleep_us(long microseconds)
+{
+	struct timespec delay;
+
+	delay.tv_sec = 0;
+	delay.tv_nsec = microseconds * 1000L;
+	nanosleep(&delay, NULL);
+}
+
+// Approves request, latency varies by request so later requests often finish first.
+static int _test_handler(const struct iso_pipeline_context *context, void *user_data)
+{
+	struct test_output *output = (struct test_output *) user_data;
+	unsigned long long hash = (context->sequence + 1) * 2654435761ULL + (unsigned long long) context->connection;
+
+	while(__atomic_load_n(&output->gate_closed, __ATOMIC_ACQUIRE))
+	{
+		_test_sleep_us(100);
+	}
+
+	if((hash >> 7) % 8 == 0)
+	{
+		_test_sleep_us((long) ((hash >> 10) % 200));
+	}
+
+	iso_set_mti("0210");
+	iso_add_field(39, "00", 2);
+
+	return 1;
+}
+
+// Responses of connection arrive in the order of their requests, each one with the stan of its request.
+static void _test_output(int connection, unsigned long long sequence, const char *response, int length, void *user_data)
+{
+	struct test_output *output = (struct test_output *) user_data;
+	struct iso_raw_field stan;
+	char expected[16];
+
+	snprintf(expected, sizeof(expected), "%06llu", sequence % 1000000);
+
+	if(connection < 0 || connection >= TEST_CONNECTIONS_MAX || sequence != output->next[connection] ||
+		iso_raw_find_field(response, length, 11, &stan) != 1 || stan.length != 6 || memcmp(response + stan.offset, expected, 6) != 0 ||
+		iso_raw_is_set_field(response, length, 39) != 1)
+	{
+		__atomic_add_fetch(&output->invalid, 1, __ATOMIC_RELAXED);
+	}
+
+	if(connection >= 0 && connection < TEST_CONNECTIONS_MAX)
+	{
+		output->next[connection] = sequence + 1;
+	}
+	__atomic_add_fetch(&output->delivered, 1, __ATOMIC_RELAXED);
+}
+
+// Submit request, retrying while the window of connection is full.
+static int _test_submit(struct iso_pipeline *pipeline, int connection, unsigned long long sequence)
+{
+	char request[256];
+	int length = _test_request(sequence, request, sizeof(request));
+	int result = 0;
+
+	while((result = iso_pipeline_submit(pipeline, connection, request, length)) == 1)
+	{
+		_test_sleep_us(50);
+	}
+
+	return result;
+}
+
+// Many workers and connections with varying latency: no response is lost and each connection gets them in order.
+static void _test_order()
+{
+	struct test_output output;
+	struct iso_pipeline_stats stats;
+	struct iso_pipeline *pipeline = NULL;
+	unsigned long long sequence = 0;
+	int connection = 0;
+	int failures = 0;
+
+	memset(&output, 0, sizeof(output));
+	pipeline = iso_pipeline_create(TEST_WORKERS, TEST_CONNECTIONS, _test_handler, _test_output, &output);
+	TEST_CHECK(pipeline != NULL);
+	if(pipeline == NULL)
+	{
+		return;
+	}
+
+	for(sequence = 0; sequence < TEST_REQUESTS; sequence++)
+	{
+		for(connection = 0; connection < TEST_CONNECTIONS; connection++)
+		{
+			failures += (_test_submit(pipeline, connection, sequence) != 0);
+		}
+	}
+
+	// Submitted requests are drained.
+	iso_pipeline_get_stats(pipeline, &stats);
+	TEST_CHECK(stats.submitted == TEST_REQUESTS * TEST_CONNECTIONS);
+	iso_pipeline_destroy(pipeline);
+
+	TEST_CHECK(failures == 0);
+	TEST_CHECK(output.invalid == 0);
+	TEST_CHECK(output.delivered == TEST_REQUESTS * TEST_CONNECTIONS);
+	for(connection = 0; connection < TEST_CONNECTIONS; connection++)
+	{
+		TEST_CHECK(output.next[connection] == TEST_REQUESTS);
+	}
+}
+
+// Connection with ISO_PIPELINE_WINDOW requests in flight is refused, destroy runs the queued ones.
+static void _test_window_and_drain()
+{
+	struct test_output output;
+	struct iso_pipeline *pipeline = NULL;
+	char request[256];
+	int length = 0;
+	int i = 0;
+
+	memset(&output, 0, sizeof(output));
+	output.gate_closed = 1;
+	pipeline = iso_pipeline_create(2, 2, _test_handler, _test_output, &output);
+	TEST_CHECK(pipeline != NULL);
+	if(pipeline == NULL)
+	{
+		return;
+	}
+
+	for(i = 0; i < ISO_PIPELINE_WINDOW; i++)
+	{
+		length = _test_request(i, request, sizeof(request));
+		TEST_CHECK(iso_pipeline_submit(pipeline, 0, request, length) == 0);
+	}
+	length = _test_request(i, request, sizeof(request));
+	TEST_CHECK(iso_pipeline_submit(pipeline, 0, request, length) == 1);
+
+	// Other connection has its own window.
+	length = _test_request(0, request, sizeof(request));
+	TEST_CHECK(iso_pipeline_submit(pipeline, 1, request, length) == 0);
+	TEST_CHECK(iso_pipeline_submit(pipeline, 2, request, length) == -1);
+	TEST_CHECK(__atomic_load_n(&output.delivered, __ATOMIC_RELAXED) == 0);
+
+	__atomic_store_n(&output.gate_closed, 0, __ATOMIC_RELEASE);
+	iso_pipeline_destroy(pipeline);
+
+	TEST_CHECK(output.invalid == 0);
+	TEST_CHECK(output.delivered == ISO_PIPELINE_WINDOW + 1);
+	TEST_CHECK(output.next[0] == ISO_PIPELINE_WINDOW && output.next[1] == 1);
+}
+
+int main()
+{
+	iso_init(FI_ISO8583_1987);
+
+	_test_order();
+	_test_window_and_drain();
+
+	iso_release();
+
+	return TEST_RESULT();
+}
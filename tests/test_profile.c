@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "iso_8583.h"
+#include "iso_profile_response_0210.h"
+
+// Fields of the 0210 test response.
+static void _test_fill(struct iso_profile_response_0210 *response)
+{
+	memset(response, 0, sizeof(*response));
+	strcpy(response->field_2, "4111111111111111");
+	response->field_2_length = 16;
+	strcpy(response->field_3, "000000");
+	strcpy(response->field_4, "000000002500");
+	strcpy(response->field_7, "1019120000");
+	strcpy(response->field_11, "000123");
+	strcpy(response->field_12, "120000");
+	strcpy(response->field_13, "1019");
+	strcpy(response->field_32, "12345");
+	response->field_32_length = 5;
+	strcpy(response->field_37, "000000000001");
+	strcpy(response->field_38, "A1B2C3");
+	strcpy(response->field_39, "00");
+	strcpy(response->field_41, "TERM0001");
+	strcpy(response->field_49, "986");
+}
+
+// Set the fields of response in the current message (fields 38 and 39 only case with_result).
+static void _test_set_fields(const struct iso_profile_response_0210 *response, int with_result)
+{
+	iso_release();
+	iso_set_mti("0210");
+	iso_add_field(2, response->field_2, response->field_2_length);
+	iso_add_field(3, response->field_3, 6);
+	iso_add_field(4, response->field_4, 12);
+	iso_add_field(7, response->field_7, 10);
+	iso_add_field(11, response->field_11, 6);
+	iso_add_field(12, response->field_12, 6);
+	iso_add_field(13, response->field_13, 4);
+	iso_add_field(32, response->field_32, response->field_32_length);
+	iso_add_field(37, response->field_37, 12);
+	if(with_result)
+	{
+		iso_add_field(38, response->field_38, 6);
+		iso_add_field(39, response->field_39, 2);
+	}
+	iso_add_field(41, response->field_41, 8);
+	iso_add_field(49, response->field_49, 3);
+}
+
+// Generated encoder writes the same bytes of the generic codec, its decoder reads them back.
+static void _test_same_bytes()
+{
+	struct iso_profile_response_0210 response;
+	struct iso_profile_response_0210 decoded;
+	char generated[ISO_PROFILE_RESPONSE_0210_MAX_LEN];
+	char expected[512];
+	int generated_length = 0;
+	int expected_length = 0;
+
+	_test_fill(&response);
+	generated_length = iso_profile_response_0210_encode(&response, generated, sizeof(generated));
+
+	_test_set_fields(&response, 1);
+	expected_length = iso_generate_message_bounded(expected, sizeof(expected));
+
+	TEST_CHECK(generated_length > 0 && generated_length == expected_length && memcmp(generated, expected, expected_length) == 0);
+
+	memset(&decoded, 0, sizeof(decoded));
+	TEST_CHECK(iso_profile_response_0210_decode(expected, expected_length, &decoded) == 0);
+	TEST_CHECK(memcmp(&decoded, &response, sizeof(response)) == 0);
+
+	// Capacity and variable field lengths are checked.
+	TEST_CHECK(iso_profile_response_0210_encode(&response, generated, generated_length - 1) == -1);
+	response.field_32_length = 12;
+	TEST_CHECK(iso_profile_response_0210_encode(&response, generated, sizeof(generated)) == -1);
+}
+
+// Messages with other bitmap or mti than the profile are decoded by the generic codec.
+static void _test_generic_fallback()
+{
+	struct iso_profile_response_0210 response;
+	struct iso_profile_response_0210 decoded;
+	char message[512];
+	const char *data = NULL;
+	int length = 0;
+
+	_test_fill(&response);
+
+	// Decline without fields 38 and 39.
+	_test_set_fields(&response, 0);
+	length = iso_generate_message_bounded(message, sizeof(message));
+	iso_release();
+	TEST_CHECK(length > 0 && iso_profile_response_0210_decode(message, length, &decoded) == ISO_PROFILE_GENERIC);
+	TEST_CHECK(iso_get_field_view(41, &data, &length) == 0 && length == 8 && memcmp(data, "TERM0001", 8) == 0);
+	TEST_CHECK(iso_get_field_view(38, &data, &length) == -1);
+
+	// Extra field 54.
+	_test_set_fields(&response, 1);
+	iso_add_field(54, "1002986C000000001000", 20);
+	length = iso_generate_message_bounded(message, sizeof(message));
+	iso_release();
+	TEST_CHECK(length > 0 && iso_profile_response_0210_decode(message, length, &decoded) == ISO_PROFILE_GENERIC);
+	TEST_CHECK(iso_get_field_view(54, &data, &length) == 0 && length == 20);
+
+	// Same fields with other mti.
+	_test_set_fields(&response, 1);
+	iso_set_mti("0110");
+	length = iso_generate_message_bounded(message, sizeof(message));
+	iso_release();
+	TEST_CHECK(length > 0 && iso_profile_response_0210_decode(message, length, &decoded) == ISO_PROFILE_GENERIC);
+	TEST_CHECK(iso_get_field_view(39, &data, &length) == 0 && length == 2 && memcmp(data, "00", 2) == 0);
+
+	// Invalid for both codecs.
+	TEST_CHECK(iso_profile_response_0210_decode(message, 10, &decoded) == -1);
+}
+
+int main()
+{
+	iso_init(FI_ISO8583_1987);
+
+	_test_same_bytes();
+	_test_generic_fallback();
+
+	iso_release();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,323 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "test.h"
+#include "iso_8583.h"
+#include "iso_shm_ring.h"
+
+#define TEST_PRODUCERS      4
+#define TEST_SLOTS          8
+#define TEST_MESSAGES       5000 // By producer.
+#define TEST_SLOT_SIZE      (ISO_SHM_RING_SLOT_HEADER + 512)
+#define TEST_TIMEOUT_MS     50
+
+// Name of test ring (by process).
+static char glb_name[64];
+
+// Pack 0200 of producer with its sequence in field 11.
+static int _test_message(int producer, int sequence, char *message, int capacity)
+{
+	char value[16];
+
+	iso_release();
+	iso_set_mti("0200");
+	iso_add_field(2, "4111111111111111", 16);
+	iso_add_field(3, "000000", 6);
+	snprintf(value, sizeof(value), "%06d", sequence);
+	iso_add_field(11, value, 6);
+	snprintf(value, sizeof(value), "PROD%04d", producer);
+	iso_add_field(41, value, 8);
+	iso_add_field(48, "private data", 12);
+
+	return iso_generate_message_bounded(message, capacity);
+}
+
+// Number of field view (it is not null terminated).
+static int _test_number(const char *data, int length)
+{
+	int number = 0;
+	int i = 0;
+
+	for(i = 0; i < length; i++)
+	{
+		number = (number * 10) + (data[i] - '0');
+	}
+
+	return number;
+}
+
+// Gets elapsed milliseconds since start.
+static long _test_elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) * 1000L + (now.tv_nsec - start->tv_nsec) / 1000000L;
+}
+
+// Field views of ring message are the ones of the decoded message.
+static int _test_same_fields(const struct iso_shm_message *message)
+{
+	const char *ring_data = NULL;
+	const char *data = NULL;
+	int ring_length = 0;
+	int length = 0;
+	int field = 0;
+	int set = 0;
+
+	if(iso_decode_message_bytes(message->message, message->length) != 0)
+	{
+		return 0;
+	}
+
+	for(field = 2; field <= FI_NUM_FIELD_MAX; field++)
+	{
+		set = iso_shm_ring_get_field(message, field, &ring_data, &ring_length);
+		if(set != (iso_get_field_view(field, &data, &length) == 0) ||
+			(set == 1 && (ring_length != length || memcmp(ring_data, data, length) != 0)))
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+// Producer pushes its messages in sequence through its own mapping of the ring.
+static void *_test_producer_run(void *arg)
+{
+	struct iso_shm_ring ring;
+	char message[512];
+	int producer = (int) (long) arg;
+	int length = 0;
+	int failures = 0;
+	int i = 0;
+
+	if(iso_shm_ring_open(glb_name, &ring) != 0)
+	{
+		return (void *) 1L;
+	}
+
+	for(i = 0; i < TEST_MESSAGES; i++)
+	{
+		length = _test_message(producer, i, message, sizeof(message));
+		failures += (length <= 0 || iso_shm_ring_push(&ring, message, length, -1) != 0);
+	}
+
+	iso_shm_ring_close(&ring);
+	iso_release();
+
+	return (void *) (long) failures;
+}
+
+// Messages of each producer arrive in order and none is lost, with the ring full most of time.
+static void _test_producers_order()
+{
+	struct iso_shm_ring ring;
+	struct iso_shm_message message;
+	pthread_t producers[TEST_PRODUCERS];
+	int next[TEST_PRODUCERS];
+	const char *data = NULL;
+	void *failures = NULL;
+	int received = 0;
+	int invalid = 0;
+	int producer = 0;
+	int length = 0;
+	int created = 0;
+	int i = 0;
+
+	TEST_CHECK(iso_shm_ring_create(glb_name, TEST_SLOTS, TEST_SLOT_SIZE, &ring) == 0);
+	if(ring.data == NULL)
+	{
+		return;
+	}
+	TEST_CHECK(ring.slot_count == TEST_SLOTS);
+
+	memset(next, 0, sizeof(next));
+	for(created = 0; created < TEST_PRODUCERS; created++)
+	{
+		if(pthread_create(&producers[created], NULL, _test_producer_run, (void *) (long) created) != 0)
+		{
+			break;
+		}
+	}
+	TEST_CHECK(created == TEST_PRODUCERS);
+
+	while(received < created * TEST_MESSAGES && iso_shm_ring_peek(&ring, &message, 5000) == 1)
+	{
+		producer = -1;
+		if(iso_shm_ring_get_field(&message, 41, &data, &length) == 1 && length == 8)
+		{
+			producer = _test_number(data + 4, 4);
+		}
+
+		if(producer < 0 || producer >= created || iso_shm_ring_get_field(&message, 11, &data, &length) != 1 ||
+			_test_number(data, length) != next[producer] || (received % 97 == 0 && !_test_same_fields(&message)))
+		{
+			invalid++;
+		}
+		else
+		{
+			next[producer]++;
+		}
+
+		iso_shm_ring_release(&ring, &message);
+		received++;
+	}
+
+	for(i = 0; i < created; i++)
+	{
+		pthread_join(producers[i], &failures);
+		TEST_CHECK(failures == NULL);
+		TEST_CHECK(next[i] == TEST_MESSAGES);
+	}
+
+	TEST_CHECK(invalid == 0);
+	TEST_CHECK(received == created * TEST_MESSAGES);
+	TEST_CHECK(iso_shm_ring_peek(&ring, &message, 0) == 0);
+
+	iso_shm_ring_close(&ring);
+}
+
+// Offsets table locates each field in the packed message, fields not set are reported.
+static void _test_offsets()
+{
+	struct iso_shm_ring ring;
+	struct iso_shm_message message;
+	char packed[512];
+	const char *data = NULL;
+	int length = _test_message(7, 123, packed, sizeof(packed));
+	int position = FI_MTI_LEN_BYTES + FI_BITMAP_HEX_BYTES;
+
+	TEST_CHECK(iso_shm_ring_create(glb_name, TEST_SLOTS, TEST_SLOT_SIZE, &ring) == 0);
+	if(ring.data == NULL)
+	{
+		return;
+	}
+
+	TEST_CHECK(iso_shm_ring_push(&ring, packed, length, 0) == 0);
+	TEST_CHECK(iso_shm_ring_peek(&ring, &message, 0) == 1);
+	TEST_CHECK(message.length == length && memcmp(message.message, packed, length) == 0);
+
+	// Field 2 (LLVAR), 3, 11, 41 and 48 (LLLVAR) follow the bitmap.
+	TEST_CHECK(message.offsets[1] == position + 2 && message.lengths[1] == 16);
+	position += 2 + 16;
+	TEST_CHECK(message.offsets[2] == position && message.lengths[2] == 6);
+	position += 6;
+	TEST_CHECK(message.offsets[10] == position && message.lengths[10] == 6);
+	position += 6;
+	TEST_CHECK(message.offsets[40] == position && message.lengths[40] == 8);
+	position += 8;
+	TEST_CHECK(message.offsets[47] == position + 3 && message.lengths[47] == 12);
+	TEST_CHECK(position + 3 + 12 == length);
+
+	TEST_CHECK(iso_shm_ring_get_field(&message, 41, &data, &length) == 1 && length == 8 && memcmp(data, "PROD0007", 8) == 0);
+	TEST_CHECK(iso_shm_ring_get_field(&message, 4, &data, &length) == 0);
+	TEST_CHECK(message.offsets[3] == ISO_SHM_RING_NO_FIELD);
+	TEST_CHECK(iso_shm_ring_get_field(&message, FI_NUM_FIELD_MAX + 1, &data, &length) == -1);
+	TEST_CHECK(_test_same_fields(&message));
+
+	iso_shm_ring_release(&ring, &message);
+
+	// Invalid messages and messages larger than slot are not pushed.
+	TEST_CHECK(iso_shm_ring_push(&ring, "0200", 4, 0) == -1);
+	TEST_CHECK(iso_shm_ring_push(&ring, packed, TEST_SLOT_SIZE, 0) == -1);
+
+	iso_shm_ring_close(&ring);
+}
+
+// Producer blocked on full ring.
+static void *_test_blocked_run(void *arg)
+{
+	struct iso_shm_ring ring;
+	char message[512];
+	int length = _test_message(1, 0, message, sizeof(message));
+	long result = -1;
+
+	(void) arg;
+
+	if(iso_shm_ring_open(glb_name, &ring) == 0)
+	{
+		result = iso_shm_ring_push(&ring, message, length, -1);
+		iso_shm_ring_close(&ring);
+	}
+	iso_release();
+
+	return (void *) result;
+}
+
+// Push on full ring and peek on empty ring wait until their timeout, release wakes up a blocked producer.
+static void _test_timeouts()
+{
+	struct iso_shm_ring ring;
+	struct iso_shm_message message;
+	struct timespec start;
+	pthread_t thread;
+	char packed[512];
+	void *result = NULL;
+	int length = _test_message(0, 0, packed, sizeof(packed));
+	int i = 0;
+
+	TEST_CHECK(iso_shm_ring_create(glb_name, TEST_SLOTS, TEST_SLOT_SIZE, &ring) == 0);
+	if(ring.data == NULL)
+	{
+		return;
+	}
+
+	// Empty.
+	TEST_CHECK(iso_shm_ring_peek(&ring, &message, 0) == 0);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	TEST_CHECK(iso_shm_ring_peek(&ring, &message, TEST_TIMEOUT_MS) == 0);
+	TEST_CHECK(_test_elapsed_ms(&start) >= TEST_TIMEOUT_MS - 1);
+
+	// Full.
+	for(i = 0; i < TEST_SLOTS; i++)
+	{
+		TEST_CHECK(iso_shm_ring_push(&ring, packed, length, 0) == 0);
+	}
+	TEST_CHECK(iso_shm_ring_push(&ring, packed, length, 0) == 1);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	TEST_CHECK(iso_shm_ring_push(&ring, packed, length, TEST_TIMEOUT_MS) == 1);
+	TEST_CHECK(_test_elapsed_ms(&start) >= TEST_TIMEOUT_MS - 1);
+
+	// Producer waiting forever is woken up by release.
+	TEST_CHECK(pthread_create(&thread, NULL, _test_blocked_run, NULL) == 0);
+	usleep(TEST_TIMEOUT_MS * 1000);
+	TEST_CHECK(iso_shm_ring_peek(&ring, &message, 0) == 1);
+	iso_shm_ring_release(&ring, &message);
+	pthread_join(thread, &result);
+	TEST_CHECK(result == NULL);
+
+	for(i = 0; i < TEST_SLOTS; i++)
+	{
+		TEST_CHECK(iso_shm_ring_peek(&ring, &message, 0) == 1);
+		iso_shm_ring_release(&ring, &message);
+	}
+	TEST_CHECK(iso_shm_ring_peek(&ring, &message, 0) == 0);
+
+	iso_shm_ring_close(&ring);
+}
+
+int main()
+{
+	struct iso_shm_ring ring;
+
+	iso_init(FI_ISO8583_1987);
+
+	snprintf(glb_name, sizeof(glb_name), "/iso_test_ring_%d", (int) getpid());
+
+	_test_offsets();
+	_test_timeouts();
+	_test_producers_order();
+
+	TEST_CHECK(iso_shm_ring_unlink(glb_name) == 0);
+	TEST_CHECK(iso_shm_ring_open(glb_name, &ring) == -1);
+
+	iso_release();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "test.h"
+#include "iso_8583.h"
+#include "fields_info.h"
+
+#define TEST_READERS        4
+#define TEST_READS          20000
+#define TEST_WRITES         2000
+#define TEST_SHORT_THREADS  200
+
+// Int: Set by writer after its last replace.
+static int glb_writer_done = 0;
+
+// Int: Invalid reads seen by readers (field info of neither spec).
+static int glb_invalid_reads = 0;
+
+// Field 41 is one of the two lengths set by the writer.
+static int _test_valid_terminal(const struct fi_field_info *fi_field)
+{
+	return fi_field->length == 8 || fi_field->length == 10;
+}
+
+// Reads through the thread cached spec and acquired specs, field 41 is the same during an acquired spec.
+static void *_test_reader_run(void *arg)
+{
+	struct fi_field_info first;
+	struct fi_field_info second;
+	const struct fi_spec *spec = NULL;
+	int i = 0;
+
+	(void) arg;
+
+	for(i = 0; i < TEST_READS || !__atomic_load_n(&glb_writer_done, __ATOMIC_ACQUIRE); i++)
+	{
+		if(fi_get_field_info(41, &first) != 0 || !_test_valid_terminal(&first))
+		{
+			__atomic_add_fetch(&glb_invalid_reads, 1, __ATOMIC_RELAXED);
+		}
+
+		spec = fi_spec_acquire();
+		if(fi_spec_get_field_info(spec, 41, &first) != 0 || fi_spec_get_field_info(spec, 41, &second) != 0 ||
+			!_test_valid_terminal(&first) || first.length != second.length)
+		{
+			__atomic_add_fetch(&glb_invalid_reads, 1, __ATOMIC_RELAXED);
+		}
+		fi_spec_release(spec);
+	}
+
+	return NULL;
+}
+
+// Exits holding the thread cached spec, it is released by the thread destructor.
+static void *_test_short_run(void *arg)
+{
+	struct fi_field_info fi_field;
+
+	(void) arg;
+
+	if(fi_get_field_info(41, &fi_field) != 0 || !_test_valid_terminal(&fi_field))
+	{
+		__atomic_add_fetch(&glb_invalid_reads, 1, __ATOMIC_RELAXED);
+	}
+
+	return NULL;
+}
+
+// Readers (long and short lived) run while the writer replaces the spec (run with -DISO_SANITIZER=thread or address).
+static void _test_replace_while_reading()
+{
+	pthread_t readers[TEST_READERS];
+	pthread_t thread;
+	struct fi_field_info terminal;
+	struct fi_field_info longer;
+	int created = 0;
+	int i = 0;
+
+	TEST_CHECK(fi_get_field_info(41, &terminal) == 0 && terminal.length == 8);
+	longer = terminal;
+	longer.length = 10;
+
+	for(created = 0; created < TEST_READERS; created++)
+	{
+		if(pthread_create(&readers[created], NULL, _test_reader_run, NULL) != 0)
+		{
+			break;
+		}
+	}
+	TEST_CHECK(created == TEST_READERS);
+
+	for(i = 0; i < TEST_WRITES; i++)
+	{
+		TEST_CHECK(fi_set_field_info(41, (i % 2) ? &terminal : &longer) == 0);
+
+		if(i % (TEST_WRITES / TEST_SHORT_THREADS) == 0 && pthread_create(&thread, NULL, _test_short_run, NULL) == 0)
+		{
+			pthread_join(thread, NULL);
+		}
+	}
+	TEST_CHECK(fi_set_field_info(41, &terminal) == 0);
+	__atomic_store_n(&glb_writer_done, 1, __ATOMIC_RELEASE);
+
+	for(i = 0; i < created; i++)
+	{
+		pthread_join(readers[i], NULL);
+	}
+
+	TEST_CHECK(glb_invalid_reads == 0);
+	TEST_CHECK(fi_get_field_info(41, &terminal) == 0 && terminal.length == 8);
+}
+
+int main()
+{
+	iso_init(FI_ISO8583_1987);
+
+	_test_replace_while_reading();
+
+	iso_release();
+
+	return TEST_RESULT();
+}
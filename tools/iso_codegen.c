@@ -0,0 +1,428 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+
+#include "fields_info.h"
+#include "iso_8583.h"
+
+#define CODEGEN_NAME_LEN    64
+#define CODEGEN_PATH_LEN    1024
+#define CODEGEN_HEADER_LEN  (FI_MTI_LEN_BYTES + (FI_BITMAP_HEX_BYTES * 2))
+
+struct codegen_field
+{
+	int number;
+	int is_variable;
+	int length;
+	int size_of_length;
+	char type[32];
+	char description[64];
+};
+
+struct codegen_profile
+{
+	char name[CODEGEN_NAME_LEN];
+	char upper_name[CODEGEN_NAME_LEN];
+	char mti[FI_MTI_LEN_BYTES + 1];
+	int iso_version;
+	struct codegen_field fields[FI_NUM_FIELD_MAX];
+	int field_count;
+	char header[CODEGEN_HEADER_LEN + 1];
+	int header_length;
+	int fixed_length;
+	int max_length;
+};
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [options] <output_dir>\n", name);
+	fprintf(stderr, "Generates iso_profile_<name>.h and iso_profile_<name>.c with encoder/decoder of one mti and field set.\n");
+	fprintf(stderr, "Options:\n");
+	fprintf(stderr, "  -n <name>    Profile name, i.e. \"request_0200\"\n");
+	fprintf(stderr, "  -m <mti>     Profile mti, i.e. \"0200\"\n");
+	fprintf(stderr, "  -f <fields>  Profile fields, i.e. \"2,3,4,11,41\"\n");
+	fprintf(stderr, "  -v <version> ISO version: 1987 or 1993 (default: 1987)\n");
+}
+
+// Parse list of fields into profile, i.e. "2,3,4".
+static int parse_fields(const char *list, struct codegen_profile *profile)
+{
+	struct fi_field_info fi_field;
+	char set[FI_NUM_FIELD_MAX + 1];
+	char *end = NULL;
+	long field = 0;
+	int i = 0;
+
+	memset(set, 0, sizeof(set));
+
+	while(*list != '\0')
+	{
+		field = strtol(list, &end, 10);
+		if(end == list || field < 2 || field > FI_NUM_FIELD_MAX)
+		{
+			return -1;
+		}
+
+		set[field] = 1;
+
+		list = end;
+		if(*list == ',')
+		{
+			list++;
+		}
+	}
+
+	// Fields are packed in ascending order.
+	for(i = 2; i <= FI_NUM_FIELD_MAX; i++)
+	{
+		if(set[i])
+		{
+			if(fi_get_field_info(i, &fi_field) != 0)
+			{
+				return -1;
+			}
+
+			profile->fields[profile->field_count].number = i;
+			profile->fields[profile->field_count].is_variable = fi_field.is_variable_field;
+			profile->fields[profile->field_count].length = fi_field.length;
+			profile->fields[profile->field_count].size_of_length = fi_field.is_variable_field ? fi_get_size_length_of_variable_field(i) : 0;
+			snprintf(profile->fields[profile->field_count].type, sizeof(profile->fields[0].type), "%s", (const char *) fi_field.type);
+			snprintf(profile->fields[profile->field_count].description, sizeof(profile->fields[0].description), "%s", (const char *) fi_field.description);
+			profile->field_count++;
+		}
+	}
+
+	return (profile->field_count > 0) ? 0 : -1;
+}
+
+// Build mti and bitmaps header and lengths of profile.
+static void build_profile(struct codegen_profile *profile)
+{
+	unsigned char bitmaps[FI_BITMAP_LEN_BYTES * 2];
+	const struct codegen_field *field = NULL;
+	int i = 0;
+
+	memset(bitmaps, 0, sizeof(bitmaps));
+
+	for(i = 0; i < profile->field_count; i++)
+	{
+		field = &profile->fields[i];
+
+		bitmaps[(field->number - 1) / 8] |= (unsigned char) (0x80 >> ((field->number - 1) % 8));
+		if(field->number > FI_BITMAP_LEN_BITS)
+		{
+			bitmaps[0] |= 0x80;
+		}
+
+		profile->fixed_length += field->is_variable ? field->size_of_length : field->length;
+		profile->max_length += field->size_of_length + field->length;
+	}
+
+	memcpy(profile->header, profile->mti, FI_MTI_LEN_BYTES);
+	iso_bin_to_hex_str(bitmaps, (bitmaps[0] & 0x80) ? sizeof(bitmaps) : FI_BITMAP_LEN_BYTES, profile->header + FI_MTI_LEN_BYTES);
+	profile->header_length = strlen(profile->header);
+
+	profile->fixed_length += profile->header_length;
+	profile->max_length += profile->header_length;
+}
+
+// Gets minimum length of the fields after field index (fixed fields and length prefixes).
+static int fixed_length_after(const struct codegen_profile *profile, int index)
+{
+	int length = 0;
+	int i = 0;
+
+	for(i = index + 1; i < profile->field_count; i++)
+	{
+		length += profile->fields[i].is_variable ? profile->fields[i].size_of_length : profile->fields[i].length;
+	}
+
+	return length;
+}
+
+// Write statements of length prefix digits.
+static void write_length_prefix(FILE *file, const char *position, const char *length, int size_of_length)
+{
+	int divisor = 1;
+	int i = 0;
+
+	for(i = 1; i < size_of_length; i++)
+	{
+		divisor *= 10;
+	}
+
+	for(i = 0; i < size_of_length; i++, divisor /= 10)
+	{
+		if(divisor == 1)
+		{
+			fprintf(file, "\t%s[%d] = (char) ('0' + (%s %% 10));\n", position, i, length);
+		}
+		else
+		{
+			fprintf(file, "\t%s[%d] = (char) ('0' + ((%s / %d) %% 10));\n", position, i, length, divisor);
+		}
+	}
+}
+
+static int write_header(FILE *file, const struct codegen_profile *profile)
+{
+	const struct codegen_field *field = NULL;
+	int i = 0;
+
+	fprintf(file, "// Generated by iso_codegen, do not edit.\n");
+	fprintf(file, "// Profile: %s, mti %s, ISO 8583 %d.\n\n", profile->name, profile->mti, (profile->iso_version == FI_ISO8583_1993) ? 1993 : 1987);
+	fprintf(file, "#ifndef ISO_PROFILE_%s_H_\n#define ISO_PROFILE_%s_H_\n\n", profile->upper_name, profile->upper_name);
+	fprintf(file, "#define ISO_PROFILE_%s_MAX_LEN %d\n\n", profile->upper_name, profile->max_length);
+	fprintf(file, "#ifndef ISO_PROFILE_GENERIC\n");
+	fprintf(file, "#define ISO_PROFILE_GENERIC 1 // Message does not match the profile, it was decoded by iso_decode_message_bytes.\n");
+	fprintf(file, "#endif\n\n");
+
+	fprintf(file, "// Fields of profile (null terminated), fixed fields must be filled with their whole length.\n");
+	fprintf(file, "struct iso_profile_%s\n{\n", profile->name);
+	for(i = 0; i < profile->field_count; i++)
+	{
+		field = &profile->fields[i];
+		fprintf(file, "\tchar field_%d[%d]; // %s %s%d: %s\n", field->number, field->length + 1, field->type,
+			field->is_variable ? (field->size_of_length == 2 ? "..LL" : "..LLL") : "", field->length, field->description);
+		if(field->is_variable)
+		{
+			fprintf(file, "\tint field_%d_length;\n", field->number);
+		}
+	}
+	fprintf(file, "};\n\n");
+
+	fprintf(file, "/**\n");
+	fprintf(file, " * @brief Encode message of profile (ASCII charset), without null terminator.\n");
+	fprintf(file, " * @param[in] message The message fields.\n");
+	fprintf(file, " * @param[out] buffer The buffer where the message will be stored.\n");
+	fprintf(file, " * @param[in] capacity The buffer capacity.\n");
+	fprintf(file, " * @return Returns the message length or -1 case error (invalid variable field length or message exceeds capacity).\n");
+	fprintf(file, " */\n");
+	fprintf(file, "int iso_profile_%s_encode(const struct iso_profile_%s *message, char *buffer, int capacity);\n\n", profile->name, profile->name);
+
+	fprintf(file, "/**\n");
+	fprintf(file, " * @brief Decode message of profile (ASCII charset), other messages are decoded by the generic codec (iso_decode_message_bytes).\n");
+	fprintf(file, " * @param[in] buffer The message.\n");
+	fprintf(file, " * @param[in] length The message length.\n");
+	fprintf(file, " * @param[out] message The message fields.\n");
+	fprintf(file, " * @return Returns 0 case message was decoded into fields, ISO_PROFILE_GENERIC case it was decoded by generic codec or -1 case error.\n");
+	fprintf(file, " */\n");
+	fprintf(file, "int iso_profile_%s_decode(const char *buffer, int length, struct iso_profile_%s *message);\n\n", profile->name, profile->name);
+
+	fprintf(file, "#endif\n");
+
+	return ferror(file) ? -1 : 0;
+}
+
+static int write_source(FILE *file, const struct codegen_profile *profile)
+{
+	const struct codegen_field *field = NULL;
+	char length_name[64];
+	int i = 0;
+	int j = 0;
+
+	fprintf(file, "// Generated by iso_codegen, do not edit.\n\n");
+	fprintf(file, "#include <string.h>\n\n");
+	fprintf(file, "#include \"iso_8583.h\"\n");
+	fprintf(file, "#include \"iso_profile_%s.h\"\n\n", profile->name);
+	fprintf(file, "// Mti and bitmaps of profile.\n");
+	fprintf(file, "static const char glb_header[] = \"%s\";\n\n", profile->header);
+
+	// Encoder: capacity and variable lengths are checked once, then fields are copied without branches.
+	fprintf(file, "int iso_profile_%s_encode(const struct iso_profile_%s *message, char *buffer, int capacity)\n{\n", profile->name, profile->name);
+	fprintf(file, "\tchar *position = buffer + %d;\n", profile->header_length);
+	fprintf(file, "\tint length = %d", profile->fixed_length);
+	for(i = 0; i < profile->field_count; i++)
+	{
+		if(profile->fields[i].is_variable)
+		{
+			fprintf(file, " + message->field_%d_length", profile->fields[i].number);
+		}
+	}
+	fprintf(file, ";\n\n");
+
+	fprintf(file, "\tif(length > capacity");
+	for(i = 0; i < profile->field_count; i++)
+	{
+		field = &profile->fields[i];
+		if(field->is_variable)
+		{
+			fprintf(file, " ||\n\t\t(unsigned int) message->field_%d_length > %d", field->number, field->length);
+		}
+	}
+	fprintf(file, ")\n\t{\n\t\treturn -1;\n\t}\n\n");
+
+	fprintf(file, "\tmemcpy(buffer, glb_header, %d);\n", profile->header_length);
+	for(i = 0; i < profile->field_count; i++)
+	{
+		field = &profile->fields[i];
+		fprintf(file, "\n\t// Field %d.\n", field->number);
+		if(field->is_variable)
+		{
+			snprintf(length_name, sizeof(length_name), "message->field_%d_length", field->number);
+			write_length_prefix(file, "position", length_name, field->size_of_length);
+			fprintf(file, "\tmemcpy(position + %d, message->field_%d, message->field_%d_length);\n", field->size_of_length, field->number, field->number);
+			fprintf(file, "\tposition += %d + message->field_%d_length;\n", field->size_of_length, field->number);
+		}
+		else
+		{
+			fprintf(file, "\tmemcpy(position, message->field_%d, %d);\n", field->number, field->length);
+			fprintf(file, "\tposition += %d;\n", field->length);
+		}
+	}
+	fprintf(file, "\n\treturn length;\n}\n\n");
+
+	// Decoder: mti and bitmaps are compared once, variable fields check their length prefix and remaining data.
+	fprintf(file, "int iso_profile_%s_decode(const char *buffer, int length, struct iso_profile_%s *message)\n{\n", profile->name, profile->name);
+	fprintf(file, "\tconst char *position = buffer + %d;\n", profile->header_length);
+	fprintf(file, "\tconst char *end = buffer + length;\n");
+	fprintf(file, "\tunsigned int digits = 0;\n");
+	fprintf(file, "\tint field_length = 0;\n\n");
+	fprintf(file, "\t(void) digits;\n");
+	fprintf(file, "\t(void) field_length;\n\n");
+	fprintf(file, "\tif(buffer == NULL || message == NULL || length < %d || memcmp(buffer, glb_header, %d) != 0)\n", profile->fixed_length, profile->header_length);
+	fprintf(file, "\t{\n\t\tgoto generic;\n\t}\n");
+
+	for(i = 0; i < profile->field_count; i++)
+	{
+		field = &profile->fields[i];
+		fprintf(file, "\n\t// Field %d.\n", field->number);
+		if(field->is_variable)
+		{
+			fprintf(file, "\tdigits = 0");
+			for(j = 0; j < field->size_of_length; j++)
+			{
+				fprintf(file, " | ((unsigned int) (position[%d] - '0') > 9)", j);
+			}
+			fprintf(file, ";\n\tfield_length = ");
+			for(j = 0; j < field->size_of_length; j++)
+			{
+				fprintf(file, "%s(position[%d] - '0')", (j == 0) ? "" : " * 10 + ", j);
+			}
+			fprintf(file, ";\n");
+			fprintf(file, "\tif(digits || field_length > %d || end - position < %d + field_length + %d)\n", field->length, field->size_of_length, fixed_length_after(profile, i));
+			fprintf(file, "\t{\n\t\tgoto generic;\n\t}\n");
+			fprintf(file, "\tmemcpy(message->field_%d, position + %d, field_length);\n", field->number, field->size_of_length);
+			fprintf(file, "\tmessage->field_%d[field_length] = '\\0';\n", field->number);
+			fprintf(file, "\tmessage->field_%d_length = field_length;\n", field->number);
+			fprintf(file, "\tposition += %d + field_length;\n", field->size_of_length);
+		}
+		else
+		{
+			fprintf(file, "\tmemcpy(message->field_%d, position, %d);\n", field->number, field->length);
+			fprintf(file, "\tmessage->field_%d[%d] = '\\0';\n", field->number, field->length);
+			fprintf(file, "\tposition += %d;\n", field->length);
+		}
+	}
+
+	fprintf(file, "\n\tif(position == end)\n\t{\n\t\treturn 0;\n\t}\n\n");
+	fprintf(file, "generic:\n");
+	fprintf(file, "\tif(buffer == NULL || iso_decode_message_bytes(buffer, length) != 0)\n\t{\n\t\treturn -1;\n\t}\n\n");
+	fprintf(file, "\treturn ISO_PROFILE_GENERIC;\n}\n");
+
+	return ferror(file) ? -1 : 0;
+}
+
+// Write generated file into output directory.
+static int write_file(const char *output_dir, const struct codegen_profile *profile, const char *extension,
+	int (*writer)(FILE *, const struct codegen_profile *))
+{
+	char path[CODEGEN_PATH_LEN];
+	FILE *file = NULL;
+	int result = 0;
+
+	snprintf(path, sizeof(path), "%s/iso_profile_%s.%s", output_dir, profile->name, extension);
+
+	file = fopen(path, "w");
+	if(file == NULL)
+	{
+		fprintf(stderr, "Could not create file: [%s]\n", path);
+		return -1;
+	}
+
+	result = writer(file, profile);
+	if(fclose(file) != 0 || result != 0)
+	{
+		fprintf(stderr, "Could not write file: [%s]\n", path);
+		return -1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct codegen_profile profile;
+	const char *field_list = NULL;
+	int opt = 0;
+	int i = 0;
+
+	memset(&profile, 0, sizeof(profile));
+	profile.iso_version = FI_ISO8583_1987;
+
+	while((opt = getopt(argc, argv, "n:m:f:v:")) != -1)
+	{
+		switch(opt)
+		{
+			case 'n':
+				snprintf(profile.name, sizeof(profile.name), "%s", optarg);
+				break;
+			case 'm':
+				snprintf(profile.mti, sizeof(profile.mti), "%s", optarg);
+				break;
+			case 'f':
+				field_list = optarg;
+				break;
+			case 'v':
+				profile.iso_version = (atoi(optarg) == 1993) ? FI_ISO8583_1993 : FI_ISO8583_1987;
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if(optind + 1 > argc || profile.name[0] == '\0' || field_list == NULL)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	// Profile name is part of identifiers.
+	for(i = 0; profile.name[i] != '\0'; i++)
+	{
+		if(!isalnum((unsigned char) profile.name[i]) && profile.name[i] != '_')
+		{
+			fprintf(stderr, "Invalid profile name: [%s]\n", profile.name);
+			return 1;
+		}
+		profile.upper_name[i] = (char) toupper((unsigned char) profile.name[i]);
+	}
+
+	iso_init(profile.iso_version);
+
+	if(!fi_is_valid_mti(profile.mti) || strlen(profile.mti) != FI_MTI_LEN_BYTES)
+	{
+		fprintf(stderr, "Invalid mti: [%s]\n", profile.mti);
+		return 1;
+	}
+
+	if(parse_fields(field_list, &profile) != 0)
+	{
+		fprintf(stderr, "Invalid fields: [%s]\n", field_list);
+		return 1;
+	}
+
+	build_profile(&profile);
+
+	if(write_file(argv[optind], &profile, "h", write_header) != 0 || write_file(argv[optind], &profile, "c", write_source) != 0)
+	{
+		return 1;
+	}
+
+	iso_release();
+
+	return 0;
+}
@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fields_info.h"
+#include "iso_8583.h"
+#include "iso_capture.h"
+#include "iso_index.h"
+
+#define INDEX_MESSAGE_LEN   (FI_LEN_MAX_ISO + ISO_CAPTURE_BINARY_HEADER + 1)
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [options] <capture_file> <index_file>\n", name);
+	fprintf(stderr, "Options:\n");
+	fprintf(stderr, "  -b           Capture with 2 bytes length header (default: one message per line)\n");
+	fprintf(stderr, "  -v <version> ISO version: 1987 or 1993 (default: 1987)\n");
+	fprintf(stderr, "  -k <fields>  Build index with key fields, i.e. \"37\" or \"11,41\"\n");
+	fprintf(stderr, "  -l <key>     Lookup messages with key (values separated by '|'), i.e. \"000123|TERM0001\"\n");
+}
+
+// Parse list of fields, i.e. "11,41".
+static int parse_fields(const char *list, int *fields, int *field_count)
+{
+	char *end = NULL;
+	long field = 0;
+
+	*field_count = 0;
+
+	while(*list != '\0')
+	{
+		field = strtol(list, &end, 10);
+		if(end == list || *field_count >= ISO_INDEX_MAX_KEY_FIELDS)
+		{
+			return -1;
+		}
+
+		fields[(*field_count)++] = (int) field;
+
+		list = end;
+		if(*list == ',')
+		{
+			list++;
+		}
+	}
+
+	return (*field_count > 0) ? 0 : -1;
+}
+
+// Print decoded message.
+static void print_message(long long offset, char *message, int length)
+{
+	char mti[FI_MTI_LEN_BYTES + 1];
+	char *field_str = NULL;
+	int i = 0;
+
+	printf("Offset: %lld\n", offset);
+
+	message[length] = '\0';
+	if(iso_decode_message(message) != 0)
+	{
+		printf("Invalid message: [%s]\n", message);
+		return;
+	}
+
+	field_str = (char *) malloc(FI_LEN_MAX_ISO + 1);
+	if(field_str == NULL)
+	{
+		return;
+	}
+
+	memset(mti, 0, sizeof(mti));
+	if(iso_get_mti(mti) == 0)
+	{
+		printf("MTI: [%s]\n", mti);
+	}
+
+	for(i = 2; i <= FI_NUM_FIELD_MAX; i++)
+	{
+		if(iso_is_set_field(i) && iso_get_field(i, field_str) == 0)
+		{
+			printf("Field %03d: [%s]\n", i, field_str);
+		}
+	}
+
+	free(field_str);
+}
+
+int main(int argc, char *argv[])
+{
+	struct iso_index index;
+	char *message = NULL;
+	const char *key_list = NULL;
+	const char *key = NULL;
+	unsigned long long cursor = 0;
+	long long indexed = 0;
+	long long offset = 0;
+	int key_fields[ISO_INDEX_MAX_KEY_FIELDS];
+	int key_field_count = 0;
+	int format = ISO_CAPTURE_ASCII;
+	int iso_version = FI_ISO8583_1987;
+	int found = 0;
+	int length = 0;
+	int opt = 0;
+
+	while((opt = getopt(argc, argv, "bv:k:l:")) != -1)
+	{
+		switch(opt)
+		{
+			case 'b':
+				format = ISO_CAPTURE_BINARY;
+				break;
+			case 'v':
+				iso_version = (atoi(optarg) == 1993) ? FI_ISO8583_1993 : FI_ISO8583_1987;
+				break;
+			case 'k':
+				key_list = optarg;
+				break;
+			case 'l':
+				key = optarg;
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if(optind + 2 > argc || (key_list == NULL) == (key == NULL))
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	iso_init(iso_version);
+
+	if(key_list != NULL)
+	{
+		if(parse_fields(key_list, key_fields, &key_field_count) != 0)
+		{
+			fprintf(stderr, "Invalid key fields: [%s]\n", key_list);
+			return 1;
+		}
+
+		indexed = iso_index_build(argv[optind], format, key_fields, key_field_count, argv[optind + 1]);
+		if(indexed < 0)
+		{
+			fprintf(stderr, "Could not build index: [%s]\n", argv[optind + 1]);
+			return 1;
+		}
+
+		fprintf(stderr, "Indexed messages: %lld\n", indexed);
+		return 0;
+	}
+
+	if(iso_index_open(argv[optind + 1], argv[optind], &index) != 0)
+	{
+		fprintf(stderr, "Could not open index: [%s]\n", argv[optind + 1]);
+		return 1;
+	}
+
+	message = (char *) malloc(INDEX_MESSAGE_LEN);
+	if(message == NULL)
+	{
+		iso_index_close(&index);
+		return 1;
+	}
+
+	while((length = iso_index_find(&index, key, strlen(key), &cursor, message, INDEX_MESSAGE_LEN - 1, &offset)) > 0)
+	{
+		print_message(offset, message, length);
+		found++;
+	}
+
+	if(length < 0)
+	{
+		fprintf(stderr, "Could not read capture: [%s]\n", argv[optind]);
+	}
+
+	fprintf(stderr, "Found messages: %d\n", found);
+
+	free(message);
+	iso_index_close(&index);
+	iso_release();
+
+	return (found > 0) ? 0 : 2;
+}
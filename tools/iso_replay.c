@@ -0,0 +1,449 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "fields_info.h"
+#include "iso_raw.h"
+#include "iso_filter.h"
+#include "iso_capture.h"
+#include "iso_columnar.h"
+
+#define REPLAY_MAX_THREADS  64
+#define REPLAY_OUTPUT_INIT  (1024 * 64)
+
+struct replay_options
+{
+	int format;
+	int iso_version;
+	int threads;
+	int count_only;
+	const char *export_binary;
+	const char *export_csv;
+	int fields[FI_NUM_FIELD_MAX];
+	int field_count;
+	struct iso_filter filter;
+};
+
+struct replay_worker
+{
+	pthread_t thread;
+	const struct iso_capture *capture;
+	const struct replay_options *options;
+	long long start;
+	long long end;
+	long long messages;
+	long long matched;
+	long long invalid;
+	char *output;
+	size_t output_len;
+	size_t output_cap;
+	struct iso_columnar columnar;
+};
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [options] <capture_file>\n", name);
+	fprintf(stderr, "Options:\n");
+	fprintf(stderr, "  -b           Capture with 2 bytes length header (default: one message per line)\n");
+	fprintf(stderr, "  -v <version> ISO version: 1987 or 1993 (default: 1987)\n");
+	fprintf(stderr, "  -j <threads> Number of threads (default: number of cpus)\n");
+	fprintf(stderr, "  -f <filter>  Filter expression, i.e. \"mti=0200 & 3^00 & has(55)\"\n");
+	fprintf(stderr, "  -p <fields>  Fields to print, i.e. \"2,3,4,11\" (default: all set fields)\n");
+	fprintf(stderr, "  -c           Only count matched messages\n");
+	fprintf(stderr, "  -x <file>    Export printed fields of matched messages to columnar binary file\n");
+	fprintf(stderr, "  -X <file>    Export printed fields of matched messages to csv file\n");
+}
+
+// Append data to worker output buffer.
+static int output_append(struct replay_worker *worker, const char *data, size_t length)
+{
+	char *output = NULL;
+	size_t cap = worker->output_cap;
+
+	if(worker->output_len + length > cap)
+	{
+		if(cap == 0)
+		{
+			cap = REPLAY_OUTPUT_INIT;
+		}
+		while(worker->output_len + length > cap)
+		{
+			cap *= 2;
+		}
+
+		output = (char *) realloc(worker->output, cap);
+		if(output == NULL)
+		{
+			return -1;
+		}
+		worker->output = output;
+		worker->output_cap = cap;
+	}
+
+	memcpy(worker->output + worker->output_len, data, length);
+	worker->output_len += length;
+
+	return 0;
+}
+
+// Print one field as "NNN=[value]".
+static int output_field(struct replay_worker *worker, const char *message, int field, const struct iso_raw_field *raw_field)
+{
+	char header[16];
+
+	if(raw_field->offset < 0)
+	{
+		return 0;
+	}
+
+	snprintf(header, sizeof(header), " %03d=[", field);
+
+	if(output_append(worker, header, strlen(header)) != 0 ||
+		output_append(worker, message + raw_field->offset, raw_field->length) != 0 ||
+		output_append(worker, "]", 1) != 0)
+	{
+		return -1;
+	}
+
+	return 0;
+}
+
+static void *replay_worker_run(void *arg)
+{
+	struct replay_worker *worker = (struct replay_worker *) arg;
+	const struct replay_options *options = worker->options;
+	struct iso_raw_field fields[FI_NUM_FIELD_MAX];
+	const char *message = NULL;
+	long long offset = worker->start;
+	long long next = 0;
+	int length = 0;
+	int last_field = FI_NUM_FIELD_MAX;
+	int i = 0;
+
+	// Walk messages only until the last printed field.
+	if(options->field_count > 0)
+	{
+		last_field = 0;
+		for(i = 0; i < options->field_count; i++)
+		{
+			if(options->fields[i] > last_field)
+			{
+				last_field = options->fields[i];
+			}
+		}
+	}
+
+	while(offset < worker->end && (next = iso_capture_next(worker->capture, offset, &message, &length)) > 0)
+	{
+		offset = next;
+		worker->messages++;
+
+		switch(iso_filter_match(&options->filter, message, length))
+		{
+			case 1:
+				break;
+			case 0:
+				continue;
+			default:
+				worker->invalid++;
+				continue;
+		}
+
+		if(options->count_only)
+		{
+			worker->matched++;
+			continue;
+		}
+
+		if(options->export_binary != NULL || options->export_csv != NULL)
+		{
+			if(iso_columnar_append(&worker->columnar, message, length) != 0)
+			{
+				worker->invalid++;
+				continue;
+			}
+			worker->matched++;
+			continue;
+		}
+
+		if(iso_raw_index_message(message, length, last_field, fields) < 0)
+		{
+			worker->invalid++;
+			continue;
+		}
+
+		worker->matched++;
+
+		output_append(worker, "MTI=[", 5);
+		output_append(worker, message, FI_MTI_LEN_BYTES);
+		output_append(worker, "]", 1);
+
+		if(options->field_count > 0)
+		{
+			for(i = 0; i < options->field_count; i++)
+			{
+				output_field(worker, message, options->fields[i], &fields[options->fields[i] - 1]);
+			}
+		}
+		else
+		{
+			for(i = 2; i <= FI_NUM_FIELD_MAX; i++)
+			{
+				output_field(worker, message, i, &fields[i - 1]);
+			}
+		}
+
+		output_append(worker, "\n", 1);
+	}
+
+	if(next < 0)
+	{
+		worker->invalid++;
+	}
+
+	return NULL;
+}
+
+// Parse list of fields, i.e. "2,3,4,11".
+static int parse_fields(const char *list, struct replay_options *options)
+{
+	char *end = NULL;
+	long field = 0;
+
+	while(*list != '\0')
+	{
+		field = strtol(list, &end, 10);
+		if(end == list || field < 2 || !fi_is_valid_field(field) || options->field_count >= FI_NUM_FIELD_MAX)
+		{
+			return -1;
+		}
+
+		options->fields[options->field_count++] = (int) field;
+
+		list = end;
+		if(*list == ',')
+		{
+			list++;
+		}
+	}
+
+	return 0;
+}
+
+// Write columnar export to file.
+static int export_columnar(const struct iso_columnar *columnar, const char *path, int (*write)(const struct iso_columnar *, FILE *))
+{
+	FILE *file = fopen(path, "wb");
+	int ret = -1;
+
+	if(file != NULL)
+	{
+		ret = write(columnar, file);
+		if(fclose(file) != 0)
+		{
+			ret = -1;
+		}
+	}
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	struct replay_options options;
+	struct replay_worker workers[REPLAY_MAX_THREADS];
+	struct iso_capture capture;
+	long long offsets[REPLAY_MAX_THREADS + 1];
+	long long messages = 0;
+	long long matched = 0;
+	long long invalid = 0;
+	const char *filter = "";
+	const char *fields = NULL;
+	struct fi_field_info fi_field;
+	int export_fields[FI_NUM_FIELD_MAX];
+	int export_field_count = 0;
+	int started = 0;
+	int opt = 0;
+	int i = 0;
+
+	memset(&options, 0, sizeof(options));
+	options.format = ISO_CAPTURE_ASCII;
+	options.iso_version = FI_ISO8583_1987;
+	options.threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+	while((opt = getopt(argc, argv, "bv:j:f:p:cx:X:")) != -1)
+	{
+		switch(opt)
+		{
+			case 'b':
+				options.format = ISO_CAPTURE_BINARY;
+				break;
+			case 'v':
+				options.iso_version = (atoi(optarg) == 1993) ? FI_ISO8583_1993 : FI_ISO8583_1987;
+				break;
+			case 'j':
+				options.threads = atoi(optarg);
+				break;
+			case 'f':
+				filter = optarg;
+				break;
+			case 'p':
+				fields = optarg;
+				break;
+			case 'c':
+				options.count_only = 1;
+				break;
+			case 'x':
+				options.export_binary = optarg;
+				break;
+			case 'X':
+				options.export_csv = optarg;
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if(optind >= argc)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	if(options.threads < 1)
+	{
+		options.threads = 1;
+	}
+	if(options.threads > REPLAY_MAX_THREADS)
+	{
+		options.threads = REPLAY_MAX_THREADS;
+	}
+
+	fi_init_field_info(options.iso_version);
+
+	if(iso_filter_compile(filter, &options.filter) != 0)
+	{
+		fprintf(stderr, "Invalid filter: [%s]\n", filter);
+		return 1;
+	}
+
+	if(fields != NULL && parse_fields(fields, &options) != 0)
+	{
+		fprintf(stderr, "Invalid fields: [%s]\n", fields);
+		return 1;
+	}
+
+	if(iso_capture_open(argv[optind], options.format, &capture) != 0)
+	{
+		fprintf(stderr, "Could not open capture: [%s]\n", argv[optind]);
+		return 1;
+	}
+
+	if(iso_capture_split(&capture, options.threads, offsets) != 0)
+	{
+		fprintf(stderr, "Invalid capture: [%s]\n", argv[optind]);
+		iso_capture_close(&capture);
+		return 1;
+	}
+
+	// Export has the printed fields, all fields of spec by default.
+	export_field_count = options.field_count;
+	memcpy(export_fields, options.fields, sizeof(export_fields));
+	for(i = 2; options.field_count == 0 && i <= FI_NUM_FIELD_MAX; i++)
+	{
+		if(fi_get_field_info(i, &fi_field) == 0)
+		{
+			export_fields[export_field_count++] = i;
+		}
+	}
+
+	memset(workers, 0, sizeof(workers));
+
+	for(i = 0; i < options.threads; i++)
+	{
+		if(iso_columnar_init(&workers[i].columnar, export_fields, export_field_count) != 0)
+		{
+			fprintf(stderr, "Could not initialize export\n");
+			while(--i >= 0)
+			{
+				iso_columnar_release(&workers[i].columnar);
+			}
+			iso_capture_close(&capture);
+			return 1;
+		}
+
+		workers[i].capture = &capture;
+		workers[i].options = &options;
+		workers[i].start = offsets[i];
+		workers[i].end = offsets[i + 1];
+	}
+
+	for(started = 0; started < options.threads; started++)
+	{
+		if(pthread_create(&workers[started].thread, NULL, replay_worker_run, &workers[started]) != 0)
+		{
+			break;
+		}
+	}
+
+	if(started < options.threads)
+	{
+		fprintf(stderr, "Could not start worker threads\n");
+		for(i = 0; i < options.threads; i++)
+		{
+			if(i < started)
+			{
+				pthread_join(workers[i].thread, NULL);
+			}
+			free(workers[i].output);
+			iso_columnar_release(&workers[i].columnar);
+		}
+		iso_capture_close(&capture);
+		return 1;
+	}
+
+	// Output is printed in capture order.
+	for(i = 0; i < options.threads; i++)
+	{
+		pthread_join(workers[i].thread, NULL);
+
+		if(workers[i].output_len > 0)
+		{
+			fwrite(workers[i].output, 1, workers[i].output_len, stdout);
+		}
+		free(workers[i].output);
+
+		messages += workers[i].messages;
+		matched += workers[i].matched;
+		invalid += workers[i].invalid;
+
+		// Rows of all workers are exported in capture order.
+		if(i > 0)
+		{
+			iso_columnar_concat(&workers[0].columnar, &workers[i].columnar);
+			iso_columnar_release(&workers[i].columnar);
+		}
+	}
+
+	if(options.export_binary != NULL && export_columnar(&workers[0].columnar, options.export_binary, iso_columnar_write_binary) != 0)
+	{
+		fprintf(stderr, "Could not export to: [%s]\n", options.export_binary);
+	}
+
+	if(options.export_csv != NULL && export_columnar(&workers[0].columnar, options.export_csv, iso_columnar_write_csv) != 0)
+	{
+		fprintf(stderr, "Could not export to: [%s]\n", options.export_csv);
+	}
+
+	iso_columnar_release(&workers[0].columnar);
+
+	fflush(stdout);
+	fprintf(stderr, "Messages: %lld, matched: %lld, invalid: %lld\n", messages, matched, invalid);
+
+	iso_capture_close(&capture);
+
+	return 0;
+}